@@ -16,12 +16,18 @@
 
 #include "apr.h"
 #include "apr_atomic.h"
+#include "apr_thread_mutex.h"
 
 #include <stdlib.h>
 
+/* the 64 bit operations have no native support here */
+static apr_thread_mutex_t *mutex64;
+
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *pool)
 {
-    return APR_SUCCESS;
+    if (mutex64 != NULL)
+        return APR_SUCCESS;
+    return apr_thread_mutex_create(&mutex64, APR_THREAD_MUTEX_DEFAULT, pool);
 }
 
 APR_DECLARE(apr_uint32_t) apr_atomic_add32(volatile apr_uint32_t *mem, apr_uint32_t val)
@@ -73,3 +79,163 @@ APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem, void *with)
 {
     return (void*)atomic_xchg((unsigned long *)mem,(unsigned long)with);
 }
+
+#define LOCK64()    if (apr_thread_mutex_lock(mutex64) != APR_SUCCESS) abort()
+#define UNLOCK64()  apr_thread_mutex_unlock(mutex64)
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem)
+{
+    apr_uint64_t val;
+
+    LOCK64();
+    val = *mem;
+    UNLOCK64();
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    LOCK64();
+    *mem = val;
+    UNLOCK64();
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t old;
+
+    LOCK64();
+    old = *mem;
+    *mem += val;
+    UNLOCK64();
+    return old;
+}
+
+APR_DECLARE(void) apr_atomic_sub64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    LOCK64();
+    *mem -= val;
+    UNLOCK64();
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_inc64(volatile apr_uint64_t *mem)
+{
+    return apr_atomic_add64(mem, 1);
+}
+
+APR_DECLARE(int) apr_atomic_dec64(volatile apr_uint64_t *mem)
+{
+    apr_uint64_t val;
+
+    LOCK64();
+    val = --*mem;
+    UNLOCK64();
+    return val != 0;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                           apr_uint64_t cmp)
+{
+    apr_uint64_t prev;
+
+    LOCK64();
+    prev = *mem;
+    if (prev == cmp)
+        *mem = with;
+    UNLOCK64();
+    return prev;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t prev;
+
+    LOCK64();
+    prev = *mem;
+    *mem = val;
+    UNLOCK64();
+    return prev;
+}
+
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+    /* the cmpxchg of a private word is a full barrier */
+    unsigned long dummy = 0;
+
+    if (order != APR_ATOMIC_RELAXED)
+        atomic_cmpxchg(&dummy, 0, 0);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order)
+{
+    apr_uint32_t val;
+
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    val = apr_atomic_read32(mem);
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_RELEASE)
+        apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order)
+{
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_ACQUIRE)
+        apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_set32(mem, val);
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add32(mem, val);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas32(mem, with, cmp);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order)
+{
+    apr_uint64_t val;
+
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    val = apr_atomic_read64(mem);
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_RELEASE)
+        apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order)
+{
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_ACQUIRE)
+        apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_set64(mem, val);
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add64(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas64(mem, with, cmp);
+}
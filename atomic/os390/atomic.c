@@ -135,3 +135,141 @@ APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem_ptr, void *new_ptr)
 
     return old_ptr;
 }
+
+apr_uint64_t apr_atomic_read64(volatile apr_uint64_t *mem)
+{
+    return *mem;
+}
+
+void apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    *mem = val;
+}
+
+apr_uint64_t apr_atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t old, new_val;
+
+    old = *mem;   /* old is automatically updated on csg failure */
+    do {
+        new_val = old + val;
+    } while (__csg(&old, (void *)mem, &new_val));
+    return old;
+}
+
+void apr_atomic_sub64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_atomic_add64(mem, -val);
+}
+
+apr_uint64_t apr_atomic_inc64(volatile apr_uint64_t *mem)
+{
+    return apr_atomic_add64(mem, 1);
+}
+
+int apr_atomic_dec64(volatile apr_uint64_t *mem)
+{
+    return apr_atomic_add64(mem, -1) != 1;
+}
+
+apr_uint64_t apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint64_t swap,
+                              apr_uint64_t cmp)
+{
+    apr_uint64_t old = cmp;
+
+    __csg(&old, (void *)mem, &swap);
+    return old; /* old is automatically updated from mem on csg failure */
+}
+
+apr_uint64_t apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t old;
+
+    old = *mem;   /* old is automatically updated on csg failure */
+    do {
+    } while (__csg(&old, (void *)mem, &val));
+    return old;
+}
+
+void apr_atomic_fence(apr_atomic_order_e order)
+{
+    /* compare and swap serializes; swapping a private word does no harm */
+    apr_uint32_t dummy = 0, zero = 0;
+
+    if (order != APR_ATOMIC_RELAXED)
+        __cs(&zero, (cs_t *)&dummy, 0);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order)
+{
+    apr_uint32_t val;
+
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    val = apr_atomic_read32(mem);
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_RELEASE)
+        apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order)
+{
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_ACQUIRE)
+        apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_set32(mem, val);
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add32(mem, val);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas32(mem, with, cmp);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order)
+{
+    apr_uint64_t val;
+
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    val = apr_atomic_read64(mem);
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_RELEASE)
+        apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order)
+{
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_ACQUIRE)
+        apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_set64(mem, val);
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add64(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas64(mem, with, cmp);
+}
@@ -20,7 +20,11 @@
 
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p)
 {
+#if defined(USE_ATOMICS_GENERIC64)
+    return apr__atomic_generic64_init(p);
+#else
     return APR_SUCCESS;
+#endif
 }
 
 APR_DECLARE(apr_uint32_t) apr_atomic_read32(volatile apr_uint32_t *mem)
@@ -78,4 +82,46 @@ APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem, void *with)
     return (void*) __sync_lock_test_and_set(mem, with);
 }
 
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+#ifdef USE_ATOMICS_BUILTINS_ORDERED
+    if (order != APR_ATOMIC_RELAXED)
+        __atomic_thread_fence(apr__atomic_order(order));
+#else
+    if (order != APR_ATOMIC_RELAXED)
+        __sync_synchronize();
+#endif
+}
+
+#ifdef USE_ATOMICS_BUILTINS_ORDERED
+
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order)
+{
+    return __atomic_load_n(mem, apr__atomic_load_order(order));
+}
+
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order)
+{
+    __atomic_store_n(mem, val, apr__atomic_store_order(order));
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order)
+{
+    return __atomic_fetch_add(mem, val, apr__atomic_order(order));
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order)
+{
+    __atomic_compare_exchange_n(mem, &cmp, with, 0, apr__atomic_order(order),
+                                apr__atomic_load_order(order));
+    return cmp;
+}
+
+#endif /* USE_ATOMICS_BUILTINS_ORDERED */
+
 #endif /* USE_ATOMICS_BUILTINS */
@@ -0,0 +1,111 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_arch_atomic.h"
+
+#ifdef USE_ATOMICS_BUILTINS64
+
+#ifdef USE_ATOMICS_BUILTINS64_ORDERED
+APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem)
+{
+    return __atomic_load_n(mem, __ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(void) apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    __atomic_store_n(mem, val, __ATOMIC_SEQ_CST);
+}
+#else
+/* a plain access may tear where a 64 bit word takes two registers */
+APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem)
+{
+    return __sync_fetch_and_add(mem, 0);
+}
+
+APR_DECLARE(void) apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t prev = *mem;
+
+    while (!__sync_bool_compare_and_swap(mem, prev, val))
+        prev = *mem;
+}
+#endif
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    return __sync_fetch_and_add(mem, val);
+}
+
+APR_DECLARE(void) apr_atomic_sub64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    __sync_fetch_and_sub(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_inc64(volatile apr_uint64_t *mem)
+{
+    return __sync_fetch_and_add(mem, 1);
+}
+
+APR_DECLARE(int) apr_atomic_dec64(volatile apr_uint64_t *mem)
+{
+    return __sync_sub_and_fetch(mem, 1) != 0;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                           apr_uint64_t cmp)
+{
+    return __sync_val_compare_and_swap(mem, cmp, with);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    __sync_synchronize();
+
+    return __sync_lock_test_and_set(mem, val);
+}
+
+#ifdef USE_ATOMICS_BUILTINS64_ORDERED
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order)
+{
+    return __atomic_load_n(mem, apr__atomic_load_order(order));
+}
+
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order)
+{
+    __atomic_store_n(mem, val, apr__atomic_store_order(order));
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order)
+{
+    return __atomic_fetch_add(mem, val, apr__atomic_order(order));
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order)
+{
+    __atomic_compare_exchange_n(mem, &cmp, with, 0, apr__atomic_order(order),
+                                apr__atomic_load_order(order));
+    return cmp;
+}
+
+#endif /* USE_ATOMICS_BUILTINS64_ORDERED */
+
+#endif /* USE_ATOMICS_BUILTINS64 */
@@ -20,7 +20,11 @@
 
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p)
 {
+#if defined(USE_ATOMICS_GENERIC64)
+    return apr__atomic_generic64_init(p);
+#else
     return APR_SUCCESS;
+#endif
 }
 
 APR_DECLARE(apr_uint32_t) apr_atomic_read32(volatile apr_uint32_t *mem)
@@ -124,4 +128,89 @@ APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem, void *with)
     return prev;
 }
 
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+    /* only a store followed by a load can be reordered on x86 */
+    if (order == APR_ATOMIC_SEQ_CST) {
+#if defined(__x86_64__)
+        asm volatile ("mfence" : : : "memory");
+#else
+        asm volatile ("lock; addl $0,0(%%esp)" : : : "memory", "cc");
+#endif
+    }
+    else if (order != APR_ATOMIC_RELAXED) {
+        asm volatile ("" : : : "memory");
+    }
+}
+
+#ifdef USE_ATOMICS_IA32_64
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem)
+{
+    return *mem;
+}
+
+APR_DECLARE(void) apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    *mem = val;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    asm volatile ("lock; xaddq %0,%1"
+                  : "=r" (val), "=m" (*mem)
+                  : "0" (val), "m" (*mem)
+                  : "memory", "cc");
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_sub64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    asm volatile ("lock; subq %1, %0"
+                  : /* no output */
+                  : "m" (*(mem)), "r" (val)
+                  : "memory", "cc");
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_inc64(volatile apr_uint64_t *mem)
+{
+    return apr_atomic_add64(mem, 1);
+}
+
+APR_DECLARE(int) apr_atomic_dec64(volatile apr_uint64_t *mem)
+{
+    unsigned char prev;
+
+    asm volatile ("lock; decq %0; setnz %1"
+                  : "=m" (*mem), "=qm" (prev)
+                  : "m" (*mem)
+                  : "memory");
+
+    return prev;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                           apr_uint64_t cmp)
+{
+    apr_uint64_t prev;
+
+    asm volatile ("lock; cmpxchgq %1, %2"
+                  : "=a" (prev)
+                  : "r" (with), "m" (*(mem)), "0"(cmp)
+                  : "memory", "cc");
+    return prev;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t prev = val;
+
+    asm volatile ("xchgq %0, %1"
+                  : "=r" (prev), "+m" (*mem)
+                  : "0" (prev));
+    return prev;
+}
+
+#endif /* USE_ATOMICS_IA32_64 */
+
 #endif /* USE_ATOMICS_IA32 */
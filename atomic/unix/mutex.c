@@ -55,6 +55,9 @@ APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p)
     int i;
     apr_status_t rv;
 
+    if ((rv = apr__atomic_generic64_init(p)) != APR_SUCCESS)
+        return rv;
+
     if (hash_mutex != NULL)
         return APR_SUCCESS;
 
@@ -88,7 +91,7 @@ static APR_INLINE apr_thread_mutex_t *mutex_hash(volatile apr_uint32_t *mem)
 
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p)
 {
-    return APR_SUCCESS;
+    return apr__atomic_generic64_init(p);
 }
 
 #endif /* APR_HAS_THREADS */
@@ -202,4 +205,20 @@ APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem, void *with)
     return prev;
 }
 
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+    if (order == APR_ATOMIC_RELAXED)
+        return;
+#if HAVE_ATOMIC_BUILTINS
+    __sync_synchronize();
+#elif APR_HAS_THREADS
+    /* taking and releasing a lock is a full barrier */
+    if (hash_mutex != NULL) {
+        if (apr_thread_mutex_lock(hash_mutex[0]) != APR_SUCCESS)
+            abort();
+        MUTEX_UNLOCK(hash_mutex[0]);
+    }
+#endif
+}
+
 #endif /* USE_ATOMICS_GENERIC */
@@ -0,0 +1,105 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_arch_atomic.h"
+
+/*
+ * The ordered variants, where the backend has no cheaper way to provide
+ * them: the read-modify-write operations are already full barriers, and
+ * a read or a set gets a fence on the side the ordering asks for.
+ */
+
+#if !defined(USE_ATOMICS_BUILTINS_ORDERED)
+
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order)
+{
+    apr_uint32_t val;
+
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    val = apr_atomic_read32(mem);
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_RELEASE)
+        apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order)
+{
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_ACQUIRE)
+        apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_set32(mem, val);
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add32(mem, val);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas32(mem, with, cmp);
+}
+
+#endif /* !USE_ATOMICS_BUILTINS_ORDERED */
+
+#if !defined(USE_ATOMICS_BUILTINS64_ORDERED)
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order)
+{
+    apr_uint64_t val;
+
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    val = apr_atomic_read64(mem);
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_RELEASE)
+        apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order)
+{
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_ACQUIRE)
+        apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_set64(mem, val);
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add64(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas64(mem, with, cmp);
+}
+
+#endif /* !USE_ATOMICS_BUILTINS64_ORDERED */
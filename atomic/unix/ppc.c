@@ -26,7 +26,11 @@
 
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p)
 {
+#if defined(USE_ATOMICS_GENERIC64)
+    return apr__atomic_generic64_init(p);
+#else
     return APR_SUCCESS;
+#endif
 }
 
 APR_DECLARE(apr_uint32_t) apr_atomic_read32(volatile apr_uint32_t *mem)
@@ -204,4 +208,97 @@ APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem, void *with)
     return prev;
 }
 
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+    if (order == APR_ATOMIC_RELAXED)
+        return;
+#ifdef __powerpc64__
+    if (order != APR_ATOMIC_SEQ_CST) {
+        asm volatile ("lwsync" : : : "memory");
+        return;
+    }
+#endif
+    asm volatile ("sync" : : : "memory");
+}
+
+#ifdef USE_ATOMICS_PPC64
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem)
+{
+    return *mem;
+}
+
+APR_DECLARE(void) apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    *mem = val;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t prev, temp;
+
+    asm volatile ("loop_%=:\n"                 /* lost reservation     */
+                  "    ldarx   %0,0,%3\n"      /* load and reserve     */
+                  "    add     %1,%0,%4\n"     /* add val and prev     */
+                  "    stdcx.  %1,0,%3\n"      /* store new value      */
+                  "    bne-    loop_%=\n"      /* loop if lost         */
+                  : "=&r" (prev), "=&r" (temp), "=m" (*mem)
+                  : "b" (mem), "r" (val)
+                  : "cc", "memory");
+
+    return prev;
+}
+
+APR_DECLARE(void) apr_atomic_sub64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_atomic_add64(mem, -val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_inc64(volatile apr_uint64_t *mem)
+{
+    return apr_atomic_add64(mem, 1);
+}
+
+APR_DECLARE(int) apr_atomic_dec64(volatile apr_uint64_t *mem)
+{
+    return apr_atomic_add64(mem, -1) != 1;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                           apr_uint64_t cmp)
+{
+    apr_uint64_t prev;
+
+    asm volatile ("loop_%=:\n"                 /* lost reservation     */
+                  "    ldarx   %0,0,%1\n"      /* load and reserve     */
+                  "    cmpd    %0,%3\n"        /* compare operands     */
+                  "    bne-    exit_%=\n"      /* skip if not equal    */
+                  "    stdcx.  %2,0,%1\n"      /* store new value      */
+                  "    bne-    loop_%=\n"      /* loop if lost         */
+                  "exit_%=:\n"                 /* not equal            */
+                  : "=&r" (prev)
+                  : "b" (mem), "r" (with), "r" (cmp)
+                  : "cc", "memory");
+
+    return prev;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t prev;
+
+    asm volatile ("loop_%=:\n"                 /* lost reservation     */
+                  "    ldarx   %0,0,%1\n"      /* load and reserve     */
+                  "    stdcx.  %2,0,%1\n"      /* store new value      */
+                  "    bne-    loop_%=\n"      /* loop if lost         */
+                  "    isync\n"                /* memory barrier       */
+                  : "=&r" (prev)
+                  : "b" (mem), "r" (val)
+                  : "cc", "memory");
+
+    return prev;
+}
+
+#endif /* USE_ATOMICS_PPC64 */
+
 #endif /* USE_ATOMICS_PPC */
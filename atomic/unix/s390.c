@@ -20,7 +20,11 @@
 
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p)
 {
+#if defined(USE_ATOMICS_GENERIC64)
+    return apr__atomic_generic64_init(p);
+#else
     return APR_SUCCESS;
+#endif
 }
 
 APR_DECLARE(apr_uint32_t) apr_atomic_read32(volatile apr_uint32_t *mem)
@@ -152,4 +156,88 @@ APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem, void *with)
     return prev;
 }
 
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+    /* as on x86, only a store followed by a load can be reordered */
+    if (order == APR_ATOMIC_SEQ_CST)
+        asm volatile ("bcr 15,0" : : : "memory");
+    else if (order != APR_ATOMIC_RELAXED)
+        asm volatile ("" : : : "memory");
+}
+
+#ifdef USE_ATOMICS_S390_64
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem)
+{
+    return *mem;
+}
+
+APR_DECLARE(void) apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    *mem = val;
+}
+
+static APR_INLINE apr_uint64_t atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t prev = *mem, temp;
+
+    asm volatile ("loop_%=:\n"
+                  "    lgr  %1,%0\n"
+                  "    algr %1,%3\n"
+                  "    csg  %0,%1,%2\n"
+                  "    jl   loop_%=\n"
+                  : "+d" (prev), "+d" (temp), "=Q" (*mem)
+                  : "d" (val), "m" (*mem)
+                  : "cc", "memory");
+
+    return prev;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    return atomic_add64(mem, val);
+}
+
+APR_DECLARE(void) apr_atomic_sub64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    atomic_add64(mem, -val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_inc64(volatile apr_uint64_t *mem)
+{
+    return atomic_add64(mem, 1);
+}
+
+APR_DECLARE(int) apr_atomic_dec64(volatile apr_uint64_t *mem)
+{
+    return atomic_add64(mem, -1) != 1;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                           apr_uint64_t cmp)
+{
+    asm volatile ("    csg %0,%2,%1\n"
+                  : "+d" (cmp), "=Q" (*mem)
+                  : "d" (with), "m" (*mem)
+                  : "cc", "memory");
+
+    return cmp;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    apr_uint64_t prev = *mem;
+
+    asm volatile ("loop_%=:\n"
+                  "    csg %0,%2,%1\n"
+                  "    jl  loop_%=\n"
+                  : "+d" (prev), "=Q" (*mem)
+                  : "d" (val), "m" (*mem)
+                  : "cc", "memory");
+
+    return prev;
+}
+
+#endif /* USE_ATOMICS_S390_64 */
+
 #endif /* USE_ATOMICS_S390 */
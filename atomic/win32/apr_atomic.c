@@ -18,6 +18,10 @@
 #include "apr_atomic.h"
 #include "apr_thread_mutex.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>   /* for _ReadWriteBarrier() */
+#endif
+
 APR_DECLARE(apr_status_t) apr_atomic_init(apr_pool_t *p)
 {
     return APR_SUCCESS;
@@ -152,3 +156,138 @@ APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem, void *with)
     return ((apr_atomic_win32_ptr_ptr_fn)InterlockedExchange)(mem, with);
 #endif
 }
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem)
+{
+#if defined(_M_IA64) || defined(_M_AMD64)
+    return *mem;
+#else
+    /* a plain 64 bit read may tear on a 32 bit processor */
+    return InterlockedCompareExchange64((volatile LONG64 *)mem, 0, 0);
+#endif
+}
+
+APR_DECLARE(void) apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    InterlockedExchange64((volatile LONG64 *)mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    return InterlockedExchangeAdd64((volatile LONG64 *)mem, val);
+}
+
+APR_DECLARE(void) apr_atomic_sub64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    InterlockedExchangeAdd64((volatile LONG64 *)mem, -val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_inc64(volatile apr_uint64_t *mem)
+{
+    /* we return old value, win32 returns new value :( */
+    return InterlockedIncrement64((volatile LONG64 *)mem) - 1;
+}
+
+APR_DECLARE(int) apr_atomic_dec64(volatile apr_uint64_t *mem)
+{
+    return InterlockedDecrement64((volatile LONG64 *)mem) != 0;
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                           apr_uint64_t cmp)
+{
+    return InterlockedCompareExchange64((volatile LONG64 *)mem, with, cmp);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val)
+{
+    return InterlockedExchange64((volatile LONG64 *)mem, val);
+}
+
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order)
+{
+    if (order == APR_ATOMIC_RELAXED)
+        return;
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_AMD64))
+    /* only a store followed by a load can be reordered on x86 */
+    if (order != APR_ATOMIC_SEQ_CST) {
+        _ReadWriteBarrier();
+        return;
+    }
+#endif
+    MemoryBarrier();
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order)
+{
+    apr_uint32_t val;
+
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    val = apr_atomic_read32(mem);
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_RELEASE)
+        apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order)
+{
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_ACQUIRE)
+        apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_set32(mem, val);
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add32(mem, val);
+}
+
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas32(mem, with, cmp);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order)
+{
+    apr_uint64_t val;
+
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+    val = apr_atomic_read64(mem);
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_RELEASE)
+        apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+
+    return val;
+}
+
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order)
+{
+    if (order != APR_ATOMIC_RELAXED && order != APR_ATOMIC_ACQUIRE)
+        apr_atomic_fence(APR_ATOMIC_RELEASE);
+    apr_atomic_set64(mem, val);
+    if (order == APR_ATOMIC_SEQ_CST)
+        apr_atomic_fence(APR_ATOMIC_SEQ_CST);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_add64(mem, val);
+}
+
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order)
+{
+    return apr_atomic_cas64(mem, with, cmp);
+}
@@ -140,6 +140,82 @@ static apr_xlate_t *xlate_ebcdic_to_ascii; /* used in apr_md5_encode() */
  (a) += (b); \
   }
 
+/* The 64 steps of the MD5 transform on state a, b, c, d and the input
+ * words x[]; expanded for both the scalar and the multi-lane transform.
+ */
+#define MD5_ROUNDS(a, b, c, d, x) \
+    /* Round 1 */                                        \
+    FF(a, b, c, d, x[0],  S11, 0xd76aa478); /* 1 */      \
+    FF(d, a, b, c, x[1],  S12, 0xe8c7b756); /* 2 */      \
+    FF(c, d, a, b, x[2],  S13, 0x242070db); /* 3 */      \
+    FF(b, c, d, a, x[3],  S14, 0xc1bdceee); /* 4 */      \
+    FF(a, b, c, d, x[4],  S11, 0xf57c0faf); /* 5 */      \
+    FF(d, a, b, c, x[5],  S12, 0x4787c62a); /* 6 */      \
+    FF(c, d, a, b, x[6],  S13, 0xa8304613); /* 7 */      \
+    FF(b, c, d, a, x[7],  S14, 0xfd469501); /* 8 */      \
+    FF(a, b, c, d, x[8],  S11, 0x698098d8); /* 9 */      \
+    FF(d, a, b, c, x[9],  S12, 0x8b44f7af); /* 10 */     \
+    FF(c, d, a, b, x[10], S13, 0xffff5bb1); /* 11 */     \
+    FF(b, c, d, a, x[11], S14, 0x895cd7be); /* 12 */     \
+    FF(a, b, c, d, x[12], S11, 0x6b901122); /* 13 */     \
+    FF(d, a, b, c, x[13], S12, 0xfd987193); /* 14 */     \
+    FF(c, d, a, b, x[14], S13, 0xa679438e); /* 15 */     \
+    FF(b, c, d, a, x[15], S14, 0x49b40821); /* 16 */     \
+    \
+    /* Round 2 */                                        \
+    GG(a, b, c, d, x[1],  S21, 0xf61e2562); /* 17 */     \
+    GG(d, a, b, c, x[6],  S22, 0xc040b340); /* 18 */     \
+    GG(c, d, a, b, x[11], S23, 0x265e5a51); /* 19 */     \
+    GG(b, c, d, a, x[0],  S24, 0xe9b6c7aa); /* 20 */     \
+    GG(a, b, c, d, x[5],  S21, 0xd62f105d); /* 21 */     \
+    GG(d, a, b, c, x[10], S22, 0x2441453);  /* 22 */     \
+    GG(c, d, a, b, x[15], S23, 0xd8a1e681); /* 23 */     \
+    GG(b, c, d, a, x[4],  S24, 0xe7d3fbc8); /* 24 */     \
+    GG(a, b, c, d, x[9],  S21, 0x21e1cde6); /* 25 */     \
+    GG(d, a, b, c, x[14], S22, 0xc33707d6); /* 26 */     \
+    GG(c, d, a, b, x[3],  S23, 0xf4d50d87); /* 27 */     \
+    GG(b, c, d, a, x[8],  S24, 0x455a14ed); /* 28 */     \
+    GG(a, b, c, d, x[13], S21, 0xa9e3e905); /* 29 */     \
+    GG(d, a, b, c, x[2],  S22, 0xfcefa3f8); /* 30 */     \
+    GG(c, d, a, b, x[7],  S23, 0x676f02d9); /* 31 */     \
+    GG(b, c, d, a, x[12], S24, 0x8d2a4c8a); /* 32 */     \
+    \
+    /* Round 3 */                                        \
+    HH(a, b, c, d, x[5],  S31, 0xfffa3942); /* 33 */     \
+    HH(d, a, b, c, x[8],  S32, 0x8771f681); /* 34 */     \
+    HH(c, d, a, b, x[11], S33, 0x6d9d6122); /* 35 */     \
+    HH(b, c, d, a, x[14], S34, 0xfde5380c); /* 36 */     \
+    HH(a, b, c, d, x[1],  S31, 0xa4beea44); /* 37 */     \
+    HH(d, a, b, c, x[4],  S32, 0x4bdecfa9); /* 38 */     \
+    HH(c, d, a, b, x[7],  S33, 0xf6bb4b60); /* 39 */     \
+    HH(b, c, d, a, x[10], S34, 0xbebfbc70); /* 40 */     \
+    HH(a, b, c, d, x[13], S31, 0x289b7ec6); /* 41 */     \
+    HH(d, a, b, c, x[0],  S32, 0xeaa127fa); /* 42 */     \
+    HH(c, d, a, b, x[3],  S33, 0xd4ef3085); /* 43 */     \
+    HH(b, c, d, a, x[6],  S34, 0x4881d05);  /* 44 */     \
+    HH(a, b, c, d, x[9],  S31, 0xd9d4d039); /* 45 */     \
+    HH(d, a, b, c, x[12], S32, 0xe6db99e5); /* 46 */     \
+    HH(c, d, a, b, x[15], S33, 0x1fa27cf8); /* 47 */     \
+    HH(b, c, d, a, x[2],  S34, 0xc4ac5665); /* 48 */     \
+    \
+    /* Round 4 */                                        \
+    II(a, b, c, d, x[0],  S41, 0xf4292244); /* 49 */     \
+    II(d, a, b, c, x[7],  S42, 0x432aff97); /* 50 */     \
+    II(c, d, a, b, x[14], S43, 0xab9423a7); /* 51 */     \
+    II(b, c, d, a, x[5],  S44, 0xfc93a039); /* 52 */     \
+    II(a, b, c, d, x[12], S41, 0x655b59c3); /* 53 */     \
+    II(d, a, b, c, x[3],  S42, 0x8f0ccc92); /* 54 */     \
+    II(c, d, a, b, x[10], S43, 0xffeff47d); /* 55 */     \
+    II(b, c, d, a, x[1],  S44, 0x85845dd1); /* 56 */     \
+    II(a, b, c, d, x[8],  S41, 0x6fa87e4f); /* 57 */     \
+    II(d, a, b, c, x[15], S42, 0xfe2ce6e0); /* 58 */     \
+    II(c, d, a, b, x[6],  S43, 0xa3014314); /* 59 */     \
+    II(b, c, d, a, x[13], S44, 0x4e0811a1); /* 60 */     \
+    II(a, b, c, d, x[4],  S41, 0xf7537e82); /* 61 */     \
+    II(d, a, b, c, x[11], S42, 0xbd3af235); /* 62 */     \
+    II(c, d, a, b, x[2],  S43, 0x2ad7d2bb); /* 63 */     \
+    II(b, c, d, a, x[9],  S44, 0xeb86d391); /* 64 */
+
 /* MD5 initialization. Begins an MD5 operation, writing a new context.
  */
 APR_DECLARE(apr_status_t) apr_md5_init(apr_md5_ctx_t *context)
@@ -334,6 +410,229 @@ APR_DECLARE(apr_status_t) apr_md5(unsigned char digest[APR_MD5_DIGESTSIZE],
     return apr_md5_final(digest, &ctx);
 }
 
+/* A message hashed by apr_md5_multi(): its whole blocks straight from
+ * the input, followed by one or two padded blocks holding the rest.
+ */
+typedef struct {
+    const unsigned char *next;
+    apr_size_t nblocks;
+    int ntail;
+    unsigned char tail[128];
+} md5_lane_t;
+
+static void md5_lane_init(md5_lane_t *lane, apr_uint32_t state[4],
+                          const unsigned char *input, apr_size_t len)
+{
+    apr_size_t rest = len % 64;
+    apr_uint32_t bits[2];
+
+    state[0] = 0x67452301;
+    state[1] = 0xefcdab89;
+    state[2] = 0x98badcfe;
+    state[3] = 0x10325476;
+
+    bits[0] = (apr_uint32_t)len << 3;
+    bits[1] = (apr_uint32_t)((apr_uint64_t)len >> 29);
+    lane->ntail = rest < 56 ? 1 : 2;
+    memset(lane->tail, 0, lane->ntail * 64);
+    memcpy(lane->tail, input + len - rest, rest);
+    lane->tail[rest] = 0x80;
+    Encode(lane->tail + lane->ntail * 64 - 8, bits, 8);
+
+    lane->next = input;
+    lane->nblocks = len / 64;
+    if (!lane->nblocks) {
+        lane->next = lane->tail;
+        lane->nblocks = lane->ntail;
+        lane->ntail = 0;
+    }
+}
+
+static const unsigned char *md5_lane_next(md5_lane_t *lane)
+{
+    const unsigned char *block = lane->next;
+
+    lane->next += 64;
+    if (!--lane->nblocks && lane->ntail) {
+        lane->next = lane->tail;
+        lane->nblocks = lane->ntail;
+        lane->ntail = 0;
+    }
+    return block;
+}
+
+static void md5_lane_finish(md5_lane_t *lane, apr_uint32_t state[4],
+                            unsigned char *digest)
+{
+    const unsigned char *block;
+
+    while (lane->nblocks || lane->ntail) {
+        block = md5_lane_next(lane);
+        MD5Transform(state, block);
+    }
+    Encode(digest, state, APR_MD5_DIGESTSIZE);
+}
+
+/* Multi-buffer hashing: MD5_LANES independent messages go through one
+ * transform in the lanes of GCC/clang generic vectors, which the compiler
+ * maps onto whatever SIMD the target offers; on x86 an AVX2 build of the
+ * same code is selected at runtime.
+ */
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+#define MD5_LANES 8
+
+/* Below this many unfinished messages, the rest is hashed one by one */
+#define MD5_LANES_MIN 3
+
+typedef apr_uint32_t md5_vec_t __attribute__((vector_size(4 * MD5_LANES)));
+
+/* state holds word i of lane l at state[i * MD5_LANES + l] */
+static __inline__ __attribute__((always_inline))
+void md5_lanes_body(apr_uint32_t *state, const unsigned char *const *blocks)
+{
+    md5_vec_t a, b, c, d, t, x[16];
+    apr_uint32_t w[MD5_LANES];
+    int i, l;
+
+    for (i = 0; i < 16; i++) {
+        for (l = 0; l < MD5_LANES; l++) {
+            const unsigned char *p = blocks[l] + 4 * i;
+
+            w[l] = (apr_uint32_t)p[0] | ((apr_uint32_t)p[1] << 8)
+                   | ((apr_uint32_t)p[2] << 16) | ((apr_uint32_t)p[3] << 24);
+        }
+        memcpy(&x[i], w, sizeof(w));
+    }
+    memcpy(&a, state, sizeof(a));
+    memcpy(&b, state + MD5_LANES, sizeof(b));
+    memcpy(&c, state + 2 * MD5_LANES, sizeof(c));
+    memcpy(&d, state + 3 * MD5_LANES, sizeof(d));
+
+    MD5_ROUNDS(a, b, c, d, x);
+
+    memcpy(&t, state, sizeof(t));
+    t += a;
+    memcpy(state, &t, sizeof(t));
+    memcpy(&t, state + MD5_LANES, sizeof(t));
+    t += b;
+    memcpy(state + MD5_LANES, &t, sizeof(t));
+    memcpy(&t, state + 2 * MD5_LANES, sizeof(t));
+    t += c;
+    memcpy(state + 2 * MD5_LANES, &t, sizeof(t));
+    memcpy(&t, state + 3 * MD5_LANES, sizeof(t));
+    t += d;
+    memcpy(state + 3 * MD5_LANES, &t, sizeof(t));
+}
+
+static void md5_lanes_generic(apr_uint32_t *state,
+                              const unsigned char *const *blocks)
+{
+    md5_lanes_body(state, blocks);
+}
+
+typedef void (*md5_lanes_fn)(apr_uint32_t *state,
+                             const unsigned char *const *blocks);
+static md5_lanes_fn md5_lanes;
+
+#if defined(__x86_64__) || defined(__i386__)
+static __attribute__((target("avx2")))
+void md5_lanes_avx2(apr_uint32_t *state, const unsigned char *const *blocks)
+{
+    md5_lanes_body(state, blocks);
+}
+#endif
+
+static void md5_multi_lanes(unsigned char *const *digests,
+                            const void *const *inputs,
+                            const apr_size_t *lens, int n)
+{
+    static const unsigned char idle_block[64];
+    md5_lane_t lane[MD5_LANES];
+    apr_uint32_t state[4 * MD5_LANES], s[4];
+    const unsigned char *blocks[MD5_LANES];
+    int done[MD5_LANES];
+    int i, l, active;
+
+    for (l = 0; l < MD5_LANES; l++) {
+        done[l] = l >= n;
+        if (!done[l]) {
+            md5_lane_init(&lane[l], s, inputs[l], lens[l]);
+            for (i = 0; i < 4; i++) {
+                state[i * MD5_LANES + l] = s[i];
+            }
+        }
+    }
+
+    for (;;) {
+        for (active = l = 0; l < MD5_LANES; l++) {
+            active += !done[l];
+        }
+        if (active < MD5_LANES_MIN) {
+            break;
+        }
+
+        for (l = 0; l < MD5_LANES; l++) {
+            blocks[l] = done[l] ? idle_block : md5_lane_next(&lane[l]);
+        }
+        md5_lanes(state, blocks);
+
+        /* idle lanes compute garbage, so take digests out as they finish */
+        for (l = 0; l < MD5_LANES; l++) {
+            if (!done[l] && !lane[l].nblocks) {
+                for (i = 0; i < 4; i++) {
+                    s[i] = state[i * MD5_LANES + l];
+                }
+                Encode(digests[l], s, APR_MD5_DIGESTSIZE);
+                done[l] = 1;
+            }
+        }
+    }
+
+    for (l = 0; l < MD5_LANES; l++) {
+        if (!done[l]) {
+            for (i = 0; i < 4; i++) {
+                s[i] = state[i * MD5_LANES + l];
+            }
+            md5_lane_finish(&lane[l], s, digests[l]);
+        }
+    }
+}
+
+#endif /* __GNUC__ */
+
+APR_DECLARE(apr_status_t) apr_md5_multi(unsigned char *const *digests,
+                                        const void *const *inputs,
+                                        const apr_size_t *lens, int n)
+{
+    int i;
+
+#ifdef MD5_LANES
+    if (!md5_lanes) {
+        md5_lanes_fn lanes = md5_lanes_generic;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            lanes = md5_lanes_avx2;
+        }
+#endif
+        md5_lanes = lanes;
+    }
+    for (i = 0; i < n; i += MD5_LANES) {
+        md5_multi_lanes(digests + i, inputs + i, lens + i,
+                        n - i < MD5_LANES ? n - i : MD5_LANES);
+    }
+#else
+    for (i = 0; i < n; i++) {
+        md5_lane_t lane;
+        apr_uint32_t state[4];
+
+        md5_lane_init(&lane, state, inputs[i], lens[i]);
+        md5_lane_finish(&lane, state, digests[i]);
+    }
+#endif
+    return APR_SUCCESS;
+}
+
 /* MD5 basic transformation. Transforms state based on block. */
 static void MD5Transform(apr_uint32_t state[4], const unsigned char block[64])
 {
@@ -342,77 +641,7 @@ static void MD5Transform(apr_uint32_t state[4], const unsigned char block[64])
 
     Decode(x, block, 64);
 
-    /* Round 1 */
-    FF(a, b, c, d, x[0],  S11, 0xd76aa478); /* 1 */
-    FF(d, a, b, c, x[1],  S12, 0xe8c7b756); /* 2 */
-    FF(c, d, a, b, x[2],  S13, 0x242070db); /* 3 */
-    FF(b, c, d, a, x[3],  S14, 0xc1bdceee); /* 4 */
-    FF(a, b, c, d, x[4],  S11, 0xf57c0faf); /* 5 */
-    FF(d, a, b, c, x[5],  S12, 0x4787c62a); /* 6 */
-    FF(c, d, a, b, x[6],  S13, 0xa8304613); /* 7 */
-    FF(b, c, d, a, x[7],  S14, 0xfd469501); /* 8 */
-    FF(a, b, c, d, x[8],  S11, 0x698098d8); /* 9 */
-    FF(d, a, b, c, x[9],  S12, 0x8b44f7af); /* 10 */
-    FF(c, d, a, b, x[10], S13, 0xffff5bb1); /* 11 */
-    FF(b, c, d, a, x[11], S14, 0x895cd7be); /* 12 */
-    FF(a, b, c, d, x[12], S11, 0x6b901122); /* 13 */
-    FF(d, a, b, c, x[13], S12, 0xfd987193); /* 14 */
-    FF(c, d, a, b, x[14], S13, 0xa679438e); /* 15 */
-    FF(b, c, d, a, x[15], S14, 0x49b40821); /* 16 */
-
-    /* Round 2 */
-    GG(a, b, c, d, x[1],  S21, 0xf61e2562); /* 17 */
-    GG(d, a, b, c, x[6],  S22, 0xc040b340); /* 18 */
-    GG(c, d, a, b, x[11], S23, 0x265e5a51); /* 19 */
-    GG(b, c, d, a, x[0],  S24, 0xe9b6c7aa); /* 20 */
-    GG(a, b, c, d, x[5],  S21, 0xd62f105d); /* 21 */
-    GG(d, a, b, c, x[10], S22, 0x2441453);  /* 22 */
-    GG(c, d, a, b, x[15], S23, 0xd8a1e681); /* 23 */
-    GG(b, c, d, a, x[4],  S24, 0xe7d3fbc8); /* 24 */
-    GG(a, b, c, d, x[9],  S21, 0x21e1cde6); /* 25 */
-    GG(d, a, b, c, x[14], S22, 0xc33707d6); /* 26 */
-    GG(c, d, a, b, x[3],  S23, 0xf4d50d87); /* 27 */
-    GG(b, c, d, a, x[8],  S24, 0x455a14ed); /* 28 */
-    GG(a, b, c, d, x[13], S21, 0xa9e3e905); /* 29 */
-    GG(d, a, b, c, x[2],  S22, 0xfcefa3f8); /* 30 */
-    GG(c, d, a, b, x[7],  S23, 0x676f02d9); /* 31 */
-    GG(b, c, d, a, x[12], S24, 0x8d2a4c8a); /* 32 */
-
-    /* Round 3 */
-    HH(a, b, c, d, x[5],  S31, 0xfffa3942); /* 33 */
-    HH(d, a, b, c, x[8],  S32, 0x8771f681); /* 34 */
-    HH(c, d, a, b, x[11], S33, 0x6d9d6122); /* 35 */
-    HH(b, c, d, a, x[14], S34, 0xfde5380c); /* 36 */
-    HH(a, b, c, d, x[1],  S31, 0xa4beea44); /* 37 */
-    HH(d, a, b, c, x[4],  S32, 0x4bdecfa9); /* 38 */
-    HH(c, d, a, b, x[7],  S33, 0xf6bb4b60); /* 39 */
-    HH(b, c, d, a, x[10], S34, 0xbebfbc70); /* 40 */
-    HH(a, b, c, d, x[13], S31, 0x289b7ec6); /* 41 */
-    HH(d, a, b, c, x[0],  S32, 0xeaa127fa); /* 42 */
-    HH(c, d, a, b, x[3],  S33, 0xd4ef3085); /* 43 */
-    HH(b, c, d, a, x[6],  S34, 0x4881d05);  /* 44 */
-    HH(a, b, c, d, x[9],  S31, 0xd9d4d039); /* 45 */
-    HH(d, a, b, c, x[12], S32, 0xe6db99e5); /* 46 */
-    HH(c, d, a, b, x[15], S33, 0x1fa27cf8); /* 47 */
-    HH(b, c, d, a, x[2],  S34, 0xc4ac5665); /* 48 */
-
-    /* Round 4 */
-    II(a, b, c, d, x[0],  S41, 0xf4292244); /* 49 */
-    II(d, a, b, c, x[7],  S42, 0x432aff97); /* 50 */
-    II(c, d, a, b, x[14], S43, 0xab9423a7); /* 51 */
-    II(b, c, d, a, x[5],  S44, 0xfc93a039); /* 52 */
-    II(a, b, c, d, x[12], S41, 0x655b59c3); /* 53 */
-    II(d, a, b, c, x[3],  S42, 0x8f0ccc92); /* 54 */
-    II(c, d, a, b, x[10], S43, 0xffeff47d); /* 55 */
-    II(b, c, d, a, x[1],  S44, 0x85845dd1); /* 56 */
-    II(a, b, c, d, x[8],  S41, 0x6fa87e4f); /* 57 */
-    II(d, a, b, c, x[15], S42, 0xfe2ce6e0); /* 58 */
-    II(c, d, a, b, x[6],  S43, 0xa3014314); /* 59 */
-    II(b, c, d, a, x[13], S44, 0x4e0811a1); /* 60 */
-    II(a, b, c, d, x[4],  S41, 0xf7537e82); /* 61 */
-    II(d, a, b, c, x[11], S42, 0xbd3af235); /* 62 */
-    II(c, d, a, b, x[2],  S43, 0x2ad7d2bb); /* 63 */
-    II(b, c, d, a, x[9],  S44, 0xeb86d391); /* 64 */
+    MD5_ROUNDS(a, b, c, d, x);
 
     state[0] += a;
     state[1] += b;
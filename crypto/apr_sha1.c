@@ -48,6 +48,7 @@
 #include "apr_base64.h"
 #include "apr_strings.h"
 #include "apr_lib.h"
+#include "apr_atomic.h"
 #if APR_CHARSET_EBCDIC
 #include "apr_xlate.h"
 #endif /*APR_CHARSET_EBCDIC*/
@@ -103,14 +104,21 @@ APR_DECLARE(apr_status_t) apr_SHA1InitEBCDIC(apr_xlate_t *x)
 }
 #endif
 
-/* do SHA transformation */
-static void sha_transform(apr_sha1_ctx_t *sha_info)
+/* load and store big-endian 32-bit words */
+#define LOAD32(p)   (((apr_uint32_t)(p)[0] << 24) | ((apr_uint32_t)(p)[1] << 16) \
+                     | ((apr_uint32_t)(p)[2] << 8) | (apr_uint32_t)(p)[3])
+#define STORE32(p, v) \
+    ((p)[0] = (apr_byte_t)((v) >> 24), (p)[1] = (apr_byte_t)((v) >> 16), \
+     (p)[2] = (apr_byte_t)((v) >> 8), (p)[3] = (apr_byte_t)(v))
+
+/* do SHA transformation of one big-endian block */
+static void sha_transform(apr_uint32_t digest[5], const apr_byte_t *block)
 {
     int i;
     apr_uint32_t temp, A, B, C, D, E, W[80];
 
     for (i = 0; i < 16; ++i) {
-        W[i] = sha_info->data[i];
+        W[i] = LOAD32(block + 4 * i);
     }
     for (i = 16; i < 80; ++i) {
         W[i] = W[i-3] ^ W[i-8] ^ W[i-14] ^ W[i-16];
@@ -118,11 +126,11 @@ static void sha_transform(apr_sha1_ctx_t *sha_info)
         W[i] = ROT32(W[i], 1);
 #endif /* USE_MODIFIED_SHA */
     }
-    A = sha_info->digest[0];
-    B = sha_info->digest[1];
-    C = sha_info->digest[2];
-    D = sha_info->digest[3];
-    E = sha_info->digest[4];
+    A = digest[0];
+    B = digest[1];
+    C = digest[2];
+    D = digest[3];
+    E = digest[4];
 #ifdef UNROLL_LOOPS
     FUNC(1, 0);  FUNC(1, 1);  FUNC(1, 2);  FUNC(1, 3);  FUNC(1, 4);
     FUNC(1, 5);  FUNC(1, 6);  FUNC(1, 7);  FUNC(1, 8);  FUNC(1, 9);
@@ -157,48 +165,380 @@ static void sha_transform(apr_sha1_ctx_t *sha_info)
         FUNC(4,i);
     }
 #endif /* !UNROLL_LOOPS */
-    sha_info->digest[0] += A;
-    sha_info->digest[1] += B;
-    sha_info->digest[2] += C;
-    sha_info->digest[3] += D;
-    sha_info->digest[4] += E;
+    digest[0] += A;
+    digest[1] += B;
+    digest[2] += C;
+    digest[3] += D;
+    digest[4] += E;
 }
 
-union endianTest {
-    long Long;
-    char Char[sizeof(long)];
-};
+static void sha1_blocks_scalar(apr_uint32_t digest[5], const apr_byte_t *data,
+                               apr_size_t nblocks)
+{
+    while (nblocks--) {
+        sha_transform(digest, data);
+        data += SHA_BLOCKSIZE;
+    }
+}
 
-static char isLittleEndian(void)
+/* Hardware SHA-1: the SHA extensions on x86 are detected at runtime, the
+ * ARMv8 crypto extensions are used when the compiler targets them.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) \
+        || (defined(__GNUC__) \
+            && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SHA1_X86_SHANI 1
+#include <immintrin.h>
+#include <cpuid.h>
+#elif defined(__aarch64__) \
+    && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#define SHA1_ARMV8_CE 1
+#include <arm_neon.h>
+#endif
+
+#if SHA1_X86_SHANI
+
+/* Four rounds per step: Ecur picks up the next four schedule words
+ * (sha1nexte adds the rotated E), Enext saves ABCD to become E of the
+ * following step.
+ */
+#define SHANI_ROUNDS(f, Ecur, Enext, M) \
+    Ecur = _mm_sha1nexte_epu32(Ecur, M); \
+    Enext = abcd; \
+    abcd = _mm_sha1rnds4_epu32(abcd, Ecur, f)
+
+/* W[t+4..t+7] = msg2(msg1(W[t..]) ^ W[t+8..], W[t+12..]), interleaved
+ * with the rounds consuming Mcur
+ */
+#define SHANI_SCHEDULE(Mcur, Mmsg2, Mxor, Mmsg1) \
+    Mmsg2 = _mm_sha1msg2_epu32(Mmsg2, Mcur); \
+    Mxor = _mm_xor_si128(Mxor, Mcur); \
+    Mmsg1 = _mm_sha1msg1_epu32(Mmsg1, Mcur)
+
+static __attribute__((target("sse4.1,sha")))
+void sha1_blocks_shani(apr_uint32_t digest[5], const apr_byte_t *data,
+                       apr_size_t nblocks)
 {
-    static union endianTest u;
-    u.Long = 1;
-    return (u.Char[0] == 1);
+    const __m128i bswap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                        7, 6, 5, 4, 3, 2, 1, 0);
+    __m128i abcd, abcd_save, e0, e0_save, e1, m0, m1, m2, m3;
+
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)digest), 0x1b);
+    e0 = _mm_set_epi32(digest[4], 0, 0, 0);
+
+    while (nblocks--) {
+        abcd_save = abcd;
+        e0_save = e0;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), bswap);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)),
+                              bswap);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)),
+                              bswap);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)),
+                              bswap);
+
+        /* rounds 0-15 also start off the message schedule */
+        e0 = _mm_add_epi32(e0, m0);
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+        SHANI_ROUNDS(0, e1, e0, m1);
+        m0 = _mm_sha1msg1_epu32(m0, m1);
+        SHANI_ROUNDS(0, e0, e1, m2);
+        m1 = _mm_sha1msg1_epu32(m1, m2);
+        m0 = _mm_xor_si128(m0, m2);
+        SHANI_ROUNDS(0, e1, e0, m3);
+        SHANI_SCHEDULE(m3, m0, m1, m2);
+
+        /* rounds 16-67 */
+        SHANI_ROUNDS(0, e0, e1, m0); SHANI_SCHEDULE(m0, m1, m2, m3);
+        SHANI_ROUNDS(1, e1, e0, m1); SHANI_SCHEDULE(m1, m2, m3, m0);
+        SHANI_ROUNDS(1, e0, e1, m2); SHANI_SCHEDULE(m2, m3, m0, m1);
+        SHANI_ROUNDS(1, e1, e0, m3); SHANI_SCHEDULE(m3, m0, m1, m2);
+        SHANI_ROUNDS(1, e0, e1, m0); SHANI_SCHEDULE(m0, m1, m2, m3);
+        SHANI_ROUNDS(1, e1, e0, m1); SHANI_SCHEDULE(m1, m2, m3, m0);
+        SHANI_ROUNDS(2, e0, e1, m2); SHANI_SCHEDULE(m2, m3, m0, m1);
+        SHANI_ROUNDS(2, e1, e0, m3); SHANI_SCHEDULE(m3, m0, m1, m2);
+        SHANI_ROUNDS(2, e0, e1, m0); SHANI_SCHEDULE(m0, m1, m2, m3);
+        SHANI_ROUNDS(2, e1, e0, m1); SHANI_SCHEDULE(m1, m2, m3, m0);
+        SHANI_ROUNDS(2, e0, e1, m2); SHANI_SCHEDULE(m2, m3, m0, m1);
+        SHANI_ROUNDS(3, e1, e0, m3); SHANI_SCHEDULE(m3, m0, m1, m2);
+        SHANI_ROUNDS(3, e0, e1, m0); SHANI_SCHEDULE(m0, m1, m2, m3);
+
+        /* rounds 68-79 finish the schedule */
+        SHANI_ROUNDS(3, e1, e0, m1);
+        m2 = _mm_sha1msg2_epu32(m2, m1);
+        m3 = _mm_xor_si128(m3, m1);
+        SHANI_ROUNDS(3, e0, e1, m2);
+        m3 = _mm_sha1msg2_epu32(m3, m2);
+        SHANI_ROUNDS(3, e1, e0, m3);
+
+        e0 = _mm_sha1nexte_epu32(e0, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+        data += SHA_BLOCKSIZE;
+    }
+
+    _mm_storeu_si128((__m128i *)digest, _mm_shuffle_epi32(abcd, 0x1b));
+    digest[4] = _mm_extract_epi32(e0, 3);
 }
 
-/* change endianness of data */
+#endif /* SHA1_X86_SHANI */
+
+#if SHA1_ARMV8_CE
+
+/* Four rounds per step, with the round constant already added to the
+ * schedule words in Wk; Enext is derived from ABCD before the rounds.
+ */
+#define CE_ROUNDS(op, Ecur, Enext, Wk) \
+    Enext = vsha1h_u32(vgetq_lane_u32(abcd, 0)); \
+    abcd = op(abcd, Ecur, Wk)
+
+/* W[t+4..t+7] from W[t..t+15], spread over two steps */
+#define CE_SCHEDULE(Mfin, Mlast, Mstart, Mnext1, Mnext2) \
+    Mfin = vsha1su1q_u32(Mfin, Mlast); \
+    Mstart = vsha1su0q_u32(Mstart, Mnext1, Mnext2)
 
-/* count is the number of bytes to do an endian flip */
-static void maybe_byte_reverse(apr_uint32_t *buffer, int count)
+static void sha1_blocks_armv8(apr_uint32_t digest[5], const apr_byte_t *data,
+                              apr_size_t nblocks)
 {
-    int i;
-    apr_byte_t ct[4], *cp;
-
-    if (isLittleEndian()) { /* do the swap only if it is little endian */
-        count /= sizeof(apr_uint32_t);
-        cp = (apr_byte_t *) buffer;
-        for (i = 0; i < count; ++i) {
-            ct[0] = cp[0];
-            ct[1] = cp[1];
-            ct[2] = cp[2];
-            ct[3] = cp[3];
-            cp[0] = ct[3];
-            cp[1] = ct[2];
-            cp[2] = ct[1];
-            cp[3] = ct[0];
-            cp += sizeof(apr_uint32_t);
+    const uint32x4_t k0 = vdupq_n_u32(CONST1), k1 = vdupq_n_u32(CONST2),
+                     k2 = vdupq_n_u32(CONST3), k3 = vdupq_n_u32(CONST4);
+    uint32x4_t abcd, abcd_save, m0, m1, m2, m3, t0, t1;
+    uint32_t e0, e0_save, e1;
+
+    abcd = vld1q_u32(digest);
+    e0 = digest[4];
+
+    while (nblocks--) {
+        abcd_save = abcd;
+        e0_save = e0;
+
+        m0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+        m1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16)));
+        m2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 32)));
+        m3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 48)));
+
+        t0 = vaddq_u32(m0, k0);
+        t1 = vaddq_u32(m1, k0);
+
+        CE_ROUNDS(vsha1cq_u32, e0, e1, t0);                 /* 0-3 */
+        t0 = vaddq_u32(m2, k0);
+        m0 = vsha1su0q_u32(m0, m1, m2);
+        CE_ROUNDS(vsha1cq_u32, e1, e0, t1);                 /* 4-7 */
+        t1 = vaddq_u32(m3, k0);
+        CE_SCHEDULE(m0, m3, m1, m2, m3);
+        CE_ROUNDS(vsha1cq_u32, e0, e1, t0);                 /* 8-11 */
+        t0 = vaddq_u32(m0, k0);
+        CE_SCHEDULE(m1, m0, m2, m3, m0);
+        CE_ROUNDS(vsha1cq_u32, e1, e0, t1);                 /* 12-15 */
+        t1 = vaddq_u32(m1, k1);
+        CE_SCHEDULE(m2, m1, m3, m0, m1);
+        CE_ROUNDS(vsha1cq_u32, e0, e1, t0);                 /* 16-19 */
+        t0 = vaddq_u32(m2, k1);
+        CE_SCHEDULE(m3, m2, m0, m1, m2);
+        CE_ROUNDS(vsha1pq_u32, e1, e0, t1);                 /* 20-23 */
+        t1 = vaddq_u32(m3, k1);
+        CE_SCHEDULE(m0, m3, m1, m2, m3);
+        CE_ROUNDS(vsha1pq_u32, e0, e1, t0);                 /* 24-27 */
+        t0 = vaddq_u32(m0, k1);
+        CE_SCHEDULE(m1, m0, m2, m3, m0);
+        CE_ROUNDS(vsha1pq_u32, e1, e0, t1);                 /* 28-31 */
+        t1 = vaddq_u32(m1, k1);
+        CE_SCHEDULE(m2, m1, m3, m0, m1);
+        CE_ROUNDS(vsha1pq_u32, e0, e1, t0);                 /* 32-35 */
+        t0 = vaddq_u32(m2, k2);
+        CE_SCHEDULE(m3, m2, m0, m1, m2);
+        CE_ROUNDS(vsha1pq_u32, e1, e0, t1);                 /* 36-39 */
+        t1 = vaddq_u32(m3, k2);
+        CE_SCHEDULE(m0, m3, m1, m2, m3);
+        CE_ROUNDS(vsha1mq_u32, e0, e1, t0);                 /* 40-43 */
+        t0 = vaddq_u32(m0, k2);
+        CE_SCHEDULE(m1, m0, m2, m3, m0);
+        CE_ROUNDS(vsha1mq_u32, e1, e0, t1);                 /* 44-47 */
+        t1 = vaddq_u32(m1, k2);
+        CE_SCHEDULE(m2, m1, m3, m0, m1);
+        CE_ROUNDS(vsha1mq_u32, e0, e1, t0);                 /* 48-51 */
+        t0 = vaddq_u32(m2, k2);
+        CE_SCHEDULE(m3, m2, m0, m1, m2);
+        CE_ROUNDS(vsha1mq_u32, e1, e0, t1);                 /* 52-55 */
+        t1 = vaddq_u32(m3, k3);
+        CE_SCHEDULE(m0, m3, m1, m2, m3);
+        CE_ROUNDS(vsha1mq_u32, e0, e1, t0);                 /* 56-59 */
+        t0 = vaddq_u32(m0, k3);
+        CE_SCHEDULE(m1, m0, m2, m3, m0);
+        CE_ROUNDS(vsha1pq_u32, e1, e0, t1);                 /* 60-63 */
+        t1 = vaddq_u32(m1, k3);
+        CE_SCHEDULE(m2, m1, m3, m0, m1);
+        CE_ROUNDS(vsha1pq_u32, e0, e1, t0);                 /* 64-67 */
+        t0 = vaddq_u32(m2, k3);
+        m3 = vsha1su1q_u32(m3, m2);
+        CE_ROUNDS(vsha1pq_u32, e1, e0, t1);                 /* 68-71 */
+        t1 = vaddq_u32(m3, k3);
+        CE_ROUNDS(vsha1pq_u32, e0, e1, t0);                 /* 72-75 */
+        CE_ROUNDS(vsha1pq_u32, e1, e0, t1);                 /* 76-79 */
+
+        e0 += e0_save;
+        abcd = vaddq_u32(abcd_save, abcd);
+        data += SHA_BLOCKSIZE;
+    }
+
+    vst1q_u32(digest, abcd);
+    digest[4] = e0;
+}
+
+#endif /* SHA1_ARMV8_CE */
+
+/* Multi-buffer hashing: SHA1_LANES independent messages go through one
+ * transform in the lanes of GCC/clang generic vectors, which the compiler
+ * maps onto whatever SIMD the target offers; on x86 an AVX2 build of the
+ * same code is selected at runtime.
+ */
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+#define SHA1_HAVE_LANES 1
+#define SHA1_LANES 8
+
+typedef apr_uint32_t sha1_vec_t __attribute__((vector_size(4 * SHA1_LANES)));
+
+/* add X to word i of the (unaligned) state of all lanes */
+#define SHA1_LANES_ADD(i, X) \
+    memcpy(&temp, state + (i) * SHA1_LANES, sizeof(temp)); \
+    temp += (X); \
+    memcpy(state + (i) * SHA1_LANES, &temp, sizeof(temp))
+
+/* state holds word i of lane l at state[i * SHA1_LANES + l] */
+static __inline__ __attribute__((always_inline))
+void sha1_lanes_body(apr_uint32_t *state, const apr_byte_t *const *blocks)
+{
+    int i, l;
+    sha1_vec_t temp, A, B, C, D, E, W[80];
+    apr_uint32_t w[SHA1_LANES];
+
+    for (i = 0; i < 16; ++i) {
+        for (l = 0; l < SHA1_LANES; l++) {
+            w[l] = LOAD32(blocks[l] + 4 * i);
+        }
+        memcpy(&W[i], w, sizeof(w));
+    }
+    for (i = 16; i < 80; ++i) {
+        W[i] = W[i-3] ^ W[i-8] ^ W[i-14] ^ W[i-16];
+        W[i] = ROT32(W[i], 1);
+    }
+    memcpy(&A, state, sizeof(A));
+    memcpy(&B, state + SHA1_LANES, sizeof(B));
+    memcpy(&C, state + 2 * SHA1_LANES, sizeof(C));
+    memcpy(&D, state + 3 * SHA1_LANES, sizeof(D));
+    memcpy(&E, state + 4 * SHA1_LANES, sizeof(E));
+    for (i = 0; i < 20; ++i) {
+        FUNC(1,i);
+    }
+    for (i = 20; i < 40; ++i) {
+        FUNC(2,i);
+    }
+    for (i = 40; i < 60; ++i) {
+        FUNC(3,i);
+    }
+    for (i = 60; i < 80; ++i) {
+        FUNC(4,i);
+    }
+    SHA1_LANES_ADD(0, A);
+    SHA1_LANES_ADD(1, B);
+    SHA1_LANES_ADD(2, C);
+    SHA1_LANES_ADD(3, D);
+    SHA1_LANES_ADD(4, E);
+}
+
+static void sha1_lanes_generic(apr_uint32_t *state,
+                               const apr_byte_t *const *blocks)
+{
+    sha1_lanes_body(state, blocks);
+}
+
+#if SHA1_X86_SHANI
+static __attribute__((target("avx2")))
+void sha1_lanes_avx2(apr_uint32_t *state, const apr_byte_t *const *blocks)
+{
+    sha1_lanes_body(state, blocks);
+}
+#endif
+
+typedef void (*sha1_lanes_fn)(apr_uint32_t *state,
+                              const apr_byte_t *const *blocks);
+
+#endif /* SHA1_HAVE_LANES */
+
+typedef void (*sha1_blocks_fn)(apr_uint32_t digest[5], const apr_byte_t *data,
+                               apr_size_t nblocks);
+
+typedef struct {
+    sha1_blocks_fn blocks;
+#if SHA1_HAVE_LANES
+    sha1_lanes_fn lanes;
+#endif
+} sha1_impl_t;
+
+/* 0 until selected, 1 while the first caller fills in sha1_impl, 2 once
+ * it is published
+ */
+static volatile apr_uint32_t sha1_impl_state;
+static sha1_impl_t sha1_impl;
+
+/* Pick the transforms for this CPU */
+static void sha1_select(sha1_impl_t *impl)
+{
+    sha1_blocks_fn blocks = sha1_blocks_scalar;
+
+#if SHA1_X86_SHANI
+    __builtin_cpu_init();
+#if SHA1_HAVE_LANES
+    impl->lanes = __builtin_cpu_supports("avx2") ? sha1_lanes_avx2
+                                                 : sha1_lanes_generic;
+#endif
+    {
+        /* the SHA extensions are CPUID.(EAX=7,ECX=0):EBX bit 29 */
+        unsigned int eax, ebx, ecx, edx;
+
+        if (__get_cpuid_max(0, NULL) >= 7) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            if ((ebx & (1u << 29)) && __builtin_cpu_supports("sse4.1")) {
+                blocks = sha1_blocks_shani;
+            }
         }
     }
+#else
+#if SHA1_HAVE_LANES
+    impl->lanes = sha1_lanes_generic;
+#endif
+#if SHA1_ARMV8_CE
+    blocks = sha1_blocks_armv8;
+#endif
+#endif
+
+    impl->blocks = blocks;
+}
+
+/* The transforms once published, or until then a selection of the
+ * caller's own in local; only the first caller publishes its selection.
+ */
+static const sha1_impl_t *sha1_get_impl(sha1_impl_t *local)
+{
+    if (apr_atomic_read32_ex(&sha1_impl_state, APR_ATOMIC_ACQUIRE) == 2) {
+        return &sha1_impl;
+    }
+    sha1_select(local);
+    if (apr_atomic_cas32(&sha1_impl_state, 1, 0) == 0) {
+        sha1_impl = *local;
+        apr_atomic_set32_ex(&sha1_impl_state, 2, APR_ATOMIC_RELEASE);
+    }
+    return local;
+}
+
+static void sha1_blocks(apr_uint32_t digest[5], const apr_byte_t *data,
+                        apr_size_t nblocks)
+{
+    sha1_impl_t local;
+
+    sha1_get_impl(&local)->blocks(digest, data, nblocks);
 }
 
 /* initialize the SHA digest */
@@ -238,19 +578,17 @@ APR_DECLARE(void) apr_sha1_update_binary(apr_sha1_ctx_t *sha_info,
         buffer += i;
         sha_info->local += i;
         if (sha_info->local == SHA_BLOCKSIZE) {
-            maybe_byte_reverse(sha_info->data, SHA_BLOCKSIZE);
-            sha_transform(sha_info);
+            sha1_blocks(sha_info->digest, (apr_byte_t *) sha_info->data, 1);
         }
         else {
             return;
         }
     }
-    while (count >= SHA_BLOCKSIZE) {
-        memcpy(sha_info->data, buffer, SHA_BLOCKSIZE);
-        buffer += SHA_BLOCKSIZE;
-        count -= SHA_BLOCKSIZE;
-        maybe_byte_reverse(sha_info->data, SHA_BLOCKSIZE);
-        sha_transform(sha_info);
+    if (count >= SHA_BLOCKSIZE) {
+        /* whole blocks are hashed straight from the caller's buffer */
+        sha1_blocks(sha_info->digest, buffer, count / SHA_BLOCKSIZE);
+        buffer += count - count % SHA_BLOCKSIZE;
+        count %= SHA_BLOCKSIZE;
     }
     memcpy(sha_info->data, buffer, count);
     sha_info->local = count;
@@ -283,8 +621,7 @@ APR_DECLARE(void) apr_sha1_update(apr_sha1_ctx_t *sha_info, const char *buf,
         buffer += i;
         sha_info->local += i;
         if (sha_info->local == SHA_BLOCKSIZE) {
-            maybe_byte_reverse(sha_info->data, SHA_BLOCKSIZE);
-            sha_transform(sha_info);
+            sha1_blocks(sha_info->digest, (apr_byte_t *) sha_info->data, 1);
         }
         else {
             return;
@@ -296,8 +633,7 @@ APR_DECLARE(void) apr_sha1_update(apr_sha1_ctx_t *sha_info, const char *buf,
                               (apr_byte_t *) sha_info->data, &outbytes_left);
         buffer += SHA_BLOCKSIZE;
         count -= SHA_BLOCKSIZE;
-        maybe_byte_reverse(sha_info->data, SHA_BLOCKSIZE);
-        sha_transform(sha_info);
+        sha1_blocks(sha_info->digest, (apr_byte_t *) sha_info->data, 1);
     }
     inbytes_left = outbytes_left = count;
     apr_xlate_conv_buffer(ebcdic2ascii_xlate, buffer, &inbytes_left,
@@ -313,8 +649,8 @@ APR_DECLARE(void) apr_sha1_update(apr_sha1_ctx_t *sha_info, const char *buf,
 APR_DECLARE(void) apr_sha1_final(unsigned char digest[APR_SHA1_DIGESTSIZE],
                              apr_sha1_ctx_t *sha_info)
 {
-    int count, i, j;
-    apr_uint32_t lo_bit_count, hi_bit_count, k;
+    int count, i;
+    apr_uint32_t lo_bit_count, hi_bit_count;
 
     lo_bit_count = sha_info->count_lo;
     hi_bit_count = sha_info->count_hi;
@@ -322,25 +658,176 @@ APR_DECLARE(void) apr_sha1_final(unsigned char digest[APR_SHA1_DIGESTSIZE],
     ((apr_byte_t *) sha_info->data)[count++] = 0x80;
     if (count > SHA_BLOCKSIZE - 8) {
         memset(((apr_byte_t *) sha_info->data) + count, 0, SHA_BLOCKSIZE - count);
-        maybe_byte_reverse(sha_info->data, SHA_BLOCKSIZE);
-        sha_transform(sha_info);
+        sha1_blocks(sha_info->digest, (apr_byte_t *) sha_info->data, 1);
         memset((apr_byte_t *) sha_info->data, 0, SHA_BLOCKSIZE - 8);
     }
     else {
         memset(((apr_byte_t *) sha_info->data) + count, 0,
                SHA_BLOCKSIZE - 8 - count);
     }
-    maybe_byte_reverse(sha_info->data, SHA_BLOCKSIZE);
-    sha_info->data[14] = hi_bit_count;
-    sha_info->data[15] = lo_bit_count;
-    sha_transform(sha_info);
-
-    for (i = 0, j = 0; j < APR_SHA1_DIGESTSIZE; i++) {
-        k = sha_info->digest[i];
-        digest[j++] = (unsigned char) ((k >> 24) & 0xff);
-        digest[j++] = (unsigned char) ((k >> 16) & 0xff);
-        digest[j++] = (unsigned char) ((k >> 8) & 0xff);
-        digest[j++] = (unsigned char) (k & 0xff);
+    STORE32(((apr_byte_t *) sha_info->data) + 56, hi_bit_count);
+    STORE32(((apr_byte_t *) sha_info->data) + 60, lo_bit_count);
+    sha1_blocks(sha_info->digest, (apr_byte_t *) sha_info->data, 1);
+
+    for (i = 0; i < 5; i++) {
+        STORE32(digest + 4 * i, sha_info->digest[i]);
+    }
+}
+
+/* A message hashed by apr_sha1_multi(): its whole blocks straight from
+ * the input, followed by one or two padded blocks holding the rest.
+ */
+typedef struct {
+    const apr_byte_t *next;
+    apr_size_t nblocks;
+    int ntail;
+    apr_byte_t tail[2 * SHA_BLOCKSIZE];
+} sha1_lane_t;
+
+static void sha1_lane_init(sha1_lane_t *lane, apr_uint32_t digest[5],
+                           const unsigned char *input, apr_size_t len)
+{
+    apr_size_t rest = len % SHA_BLOCKSIZE;
+    apr_uint64_t bits = (apr_uint64_t) len << 3;
+    apr_byte_t *end;
+
+    digest[0] = 0x67452301L;
+    digest[1] = 0xefcdab89L;
+    digest[2] = 0x98badcfeL;
+    digest[3] = 0x10325476L;
+    digest[4] = 0xc3d2e1f0L;
+
+    lane->ntail = rest < SHA_BLOCKSIZE - 8 ? 1 : 2;
+    memset(lane->tail, 0, lane->ntail * SHA_BLOCKSIZE);
+    memcpy(lane->tail, input + len - rest, rest);
+    lane->tail[rest] = 0x80;
+    end = lane->tail + lane->ntail * SHA_BLOCKSIZE - 8;
+    STORE32(end, (apr_uint32_t) (bits >> 32));
+    STORE32(end + 4, (apr_uint32_t) bits);
+
+    lane->next = input;
+    lane->nblocks = len / SHA_BLOCKSIZE;
+    if (!lane->nblocks) {
+        lane->next = lane->tail;
+        lane->nblocks = lane->ntail;
+        lane->ntail = 0;
+    }
+}
+
+static const apr_byte_t *sha1_lane_next(sha1_lane_t *lane)
+{
+    const apr_byte_t *block = lane->next;
+
+    lane->next += SHA_BLOCKSIZE;
+    if (!--lane->nblocks && lane->ntail) {
+        lane->next = lane->tail;
+        lane->nblocks = lane->ntail;
+        lane->ntail = 0;
+    }
+    return block;
+}
+
+static void sha1_lane_finish(sha1_lane_t *lane, apr_uint32_t digest[5],
+                             unsigned char *out)
+{
+    int i;
+
+    sha1_blocks(digest, lane->next, lane->nblocks);
+    if (lane->ntail) {
+        sha1_blocks(digest, lane->tail, lane->ntail);
+    }
+    for (i = 0; i < 5; i++) {
+        STORE32(out + 4 * i, digest[i]);
+    }
+}
+
+#if SHA1_HAVE_LANES
+
+/* Below this many unfinished messages, the rest is hashed one by one */
+#define SHA1_LANES_MIN 3
+
+static void sha1_multi_lanes(sha1_lanes_fn lanes,
+                             unsigned char *const *digests,
+                             const unsigned char *const *inputs,
+                             const apr_size_t *lens, int n)
+{
+    static const apr_byte_t idle_block[SHA_BLOCKSIZE];
+    sha1_lane_t lane[SHA1_LANES];
+    apr_uint32_t state[5 * SHA1_LANES], digest[5];
+    const apr_byte_t *blocks[SHA1_LANES];
+    int done[SHA1_LANES];
+    int i, l, active;
+
+    for (l = 0; l < SHA1_LANES; l++) {
+        done[l] = l >= n;
+        if (!done[l]) {
+            sha1_lane_init(&lane[l], digest, inputs[l], lens[l]);
+            for (i = 0; i < 5; i++) {
+                state[i * SHA1_LANES + l] = digest[i];
+            }
+        }
+    }
+
+    for (;;) {
+        for (active = l = 0; l < SHA1_LANES; l++) {
+            active += !done[l];
+        }
+        if (active < SHA1_LANES_MIN) {
+            break;
+        }
+
+        for (l = 0; l < SHA1_LANES; l++) {
+            blocks[l] = done[l] ? idle_block : sha1_lane_next(&lane[l]);
+        }
+        lanes(state, blocks);
+
+        /* idle lanes compute garbage, so take digests out as they finish */
+        for (l = 0; l < SHA1_LANES; l++) {
+            if (!done[l] && !lane[l].nblocks) {
+                for (i = 0; i < 5; i++) {
+                    STORE32(digests[l] + 4 * i, state[i * SHA1_LANES + l]);
+                }
+                done[l] = 1;
+            }
+        }
+    }
+
+    for (l = 0; l < SHA1_LANES; l++) {
+        if (!done[l]) {
+            for (i = 0; i < 5; i++) {
+                digest[i] = state[i * SHA1_LANES + l];
+            }
+            sha1_lane_finish(&lane[l], digest, digests[l]);
+        }
+    }
+}
+
+#endif /* SHA1_HAVE_LANES */
+
+APR_DECLARE(void) apr_sha1_multi(unsigned char *const *digests,
+                                 const unsigned char *const *inputs,
+                                 const apr_size_t *lens, int n)
+{
+    sha1_lane_t lane;
+    apr_uint32_t digest[5];
+    int i;
+#if SHA1_HAVE_LANES
+    sha1_impl_t local;
+    const sha1_impl_t *impl = sha1_get_impl(&local);
+
+    /* hardware SHA-1 on a single stream beats the lanes */
+    if (impl->blocks == sha1_blocks_scalar) {
+        for (i = 0; i < n; i += SHA1_LANES) {
+            sha1_multi_lanes(impl->lanes, digests + i, inputs + i, lens + i,
+                             n - i < SHA1_LANES ? n - i : SHA1_LANES);
+        }
+        return;
+    }
+#endif
+
+    for (i = 0; i < n; i++) {
+        sha1_lane_init(&lane, digest, inputs[i], lens[i]);
+        sha1_lane_finish(&lane, digest, digests[i]);
     }
 }
 
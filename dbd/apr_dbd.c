@@ -16,6 +16,7 @@
 
 #include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "apu.h"
 #include "apr_private.h"
@@ -210,6 +211,219 @@ APR_DECLARE(apr_status_t) apr_dbd_get_driver(apr_pool_t *pool, const char *name,
     return rv;
 }
 
+/* Prepared statement cache.  Statements are found by their SQL text in
+ * one of two hashes: 'prepared' for apr_dbd_prepare() without a label,
+ * keyed by the query before its placeholders are rewritten, and 'raw'
+ * for the SQL of apr_dbd_query() and apr_dbd_select().  One LRU list
+ * spans both.  Evicted raw statements were created by the cache and are
+ * released through the driver; prepared ones may still be held by the
+ * caller, so they are merely forgotten and live on until the connection
+ * is closed, as statements without a label always did.
+ */
+#define DBD_STMT_CACHE_DEFAULT 32
+
+typedef struct dbd_stmt_entry_t dbd_stmt_entry_t;
+
+struct dbd_stmt_entry_t {
+    dbd_stmt_entry_t *prev;
+    dbd_stmt_entry_t *next;
+    apr_hash_t *hash;
+    apr_dbd_prepared_t *statement;
+    const char *key;
+    apr_size_t klen;
+};
+
+struct apr_dbd_stmt_cache_t {
+    apr_pool_t *pool;
+    apr_hash_t *prepared;
+    apr_hash_t *raw;
+    dbd_stmt_entry_t *head;     /* most recently used */
+    dbd_stmt_entry_t *tail;     /* next to be evicted */
+    int size;
+    int entries;
+    apr_dbd_stmt_cache_stats_t stats;
+};
+
+static apr_dbd_stmt_cache_t *dbd_stmt_cache(const apr_dbd_driver_t *driver,
+                                            apr_dbd_t *handle)
+{
+    apr_dbd_stmt_cache_t *cache;
+
+    if (!driver->stmt_cache) {
+        return NULL;
+    }
+    cache = *driver->stmt_cache(handle);
+    if (cache && cache->size > 0) {
+        return cache;
+    }
+    return NULL;
+}
+
+static void dbd_stmt_unlink(apr_dbd_stmt_cache_t *cache, dbd_stmt_entry_t *e)
+{
+    if (e->prev) {
+        e->prev->next = e->next;
+    }
+    else {
+        cache->head = e->next;
+    }
+    if (e->next) {
+        e->next->prev = e->prev;
+    }
+    else {
+        cache->tail = e->prev;
+    }
+}
+
+static void dbd_stmt_push(apr_dbd_stmt_cache_t *cache, dbd_stmt_entry_t *e)
+{
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) {
+        cache->head->prev = e;
+    }
+    else {
+        cache->tail = e;
+    }
+    cache->head = e;
+}
+
+static void dbd_stmt_evict(const apr_dbd_driver_t *driver, apr_dbd_t *handle,
+                           apr_dbd_stmt_cache_t *cache, dbd_stmt_entry_t *e)
+{
+    dbd_stmt_unlink(cache, e);
+    apr_hash_set(e->hash, e->key, e->klen, NULL);
+    if (e->hash == cache->raw && handle) {
+        driver->unprepare(handle, e->statement);
+    }
+    cache->entries--;
+    free(e);
+}
+
+static apr_dbd_prepared_t *dbd_stmt_get(apr_dbd_stmt_cache_t *cache,
+                                        apr_hash_t *hash, const char *key)
+{
+    dbd_stmt_entry_t *e = apr_hash_get(hash, key, APR_HASH_KEY_STRING);
+
+    if (e == NULL) {
+        cache->stats.misses++;
+        return NULL;
+    }
+    cache->stats.hits++;
+    if (e != cache->head) {
+        dbd_stmt_unlink(cache, e);
+        dbd_stmt_push(cache, e);
+    }
+    return e->statement;
+}
+
+/* Allocate an entry for key */
+static dbd_stmt_entry_t *dbd_stmt_entry_make(apr_hash_t *hash,
+                                             const char *key)
+{
+    apr_size_t klen = strlen(key);
+    dbd_stmt_entry_t *e;
+
+    e = malloc(sizeof(*e) + klen + 1);
+    if (e == NULL) {
+        return NULL;
+    }
+    e->hash = hash;
+    e->statement = NULL;
+    e->key = memcpy((char *)(e + 1), key, klen + 1);
+    e->klen = klen;
+    return e;
+}
+
+static void dbd_stmt_put(const apr_dbd_driver_t *driver, apr_dbd_t *handle,
+                         apr_dbd_stmt_cache_t *cache, dbd_stmt_entry_t *e)
+{
+    while (cache->entries >= cache->size) {
+        cache->stats.evictions++;
+        dbd_stmt_evict(driver, handle, cache, cache->tail);
+    }
+    apr_hash_set(e->hash, e->key, e->klen, e);
+    dbd_stmt_push(cache, e);
+    cache->entries++;
+}
+
+/* The cache for ad hoc SQL.  Text holding more than one statement is
+ * left to the driver, which executes all of them.
+ */
+static apr_dbd_prepared_t *dbd_stmt_raw(const apr_dbd_driver_t *driver,
+                                        apr_dbd_t *handle,
+                                        const char *statement)
+{
+    apr_dbd_stmt_cache_t *cache = dbd_stmt_cache(driver, handle);
+    apr_dbd_prepared_t *prepared;
+    dbd_stmt_entry_t *e;
+
+    if (cache == NULL || strchr(statement, ';')) {
+        return NULL;
+    }
+    if ((prepared = dbd_stmt_get(cache, cache->raw, statement)) != NULL) {
+        return prepared;
+    }
+
+    if ((e = dbd_stmt_entry_make(cache->raw, statement)) == NULL) {
+        return NULL;
+    }
+    if (driver->prepare(cache->pool, handle, statement, NULL, 0, 0, NULL,
+                        &e->statement)) {
+        free(e);
+        return NULL;
+    }
+    dbd_stmt_put(driver, handle, cache, e);
+    return e->statement;
+}
+
+static void dbd_stmt_flush(const apr_dbd_driver_t *driver, apr_dbd_t *handle,
+                           apr_dbd_stmt_cache_t *cache, int keep)
+{
+    while (cache->entries > keep) {
+        dbd_stmt_evict(driver, handle, cache, cache->tail);
+    }
+}
+
+static apr_status_t dbd_stmt_cache_cleanup(void *data)
+{
+    /* the connection is gone; only the memory is left to release */
+    dbd_stmt_flush(NULL, NULL, data, 0);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_dbd_stmt_cache_set(const apr_dbd_driver_t *driver,
+                                                 apr_dbd_t *handle, int size)
+{
+    apr_dbd_stmt_cache_t *cache;
+
+    if (!driver->stmt_cache || !(cache = *driver->stmt_cache(handle))) {
+        return APR_ENOTIMPL;
+    }
+    if (size < 0) {
+        size = 0;
+    }
+    dbd_stmt_flush(driver, handle, cache, size);
+    cache->size = size;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_dbd_stmt_cache_stats_get(
+                                              const apr_dbd_driver_t *driver,
+                                              apr_dbd_t *handle,
+                                              apr_dbd_stmt_cache_stats_t *stats)
+{
+    apr_dbd_stmt_cache_t *cache;
+
+    if (!driver->stmt_cache || !(cache = *driver->stmt_cache(handle))) {
+        return APR_ENOTIMPL;
+    }
+    *stats = cache->stats;
+    stats->entries = cache->entries;
+    stats->size = cache->size;
+    return APR_SUCCESS;
+}
+
 APR_DECLARE(apr_status_t) apr_dbd_open_ex(const apr_dbd_driver_t *driver,
                                           apr_pool_t *pool, const char *params,
                                           apr_dbd_t **handle,
@@ -229,6 +443,17 @@ APR_DECLARE(apr_status_t) apr_dbd_open_ex(const apr_dbd_driver_t *driver,
         apr_dbd_close(driver, *handle);
         return APR_EGENERAL;
     }
+    if (driver->stmt_cache) {
+        apr_dbd_stmt_cache_t *cache = apr_pcalloc(pool, sizeof(*cache));
+
+        cache->pool = pool;
+        cache->prepared = apr_hash_make(pool);
+        cache->raw = apr_hash_make(pool);
+        cache->size = DBD_STMT_CACHE_DEFAULT;
+        apr_pool_cleanup_register(pool, cache, dbd_stmt_cache_cleanup,
+                                  apr_pool_cleanup_null);
+        *driver->stmt_cache(*handle) = cache;
+    }
     return APR_SUCCESS;
 }
 
@@ -276,6 +501,10 @@ APR_DECLARE(int) apr_dbd_transaction_mode_set(const apr_dbd_driver_t *driver,
 APR_DECLARE(apr_status_t) apr_dbd_close(const apr_dbd_driver_t *driver,
                                         apr_dbd_t *handle)
 {
+    if (driver->stmt_cache && *driver->stmt_cache(handle)) {
+        /* closing the connection releases the statements themselves */
+        dbd_stmt_flush(NULL, NULL, *driver->stmt_cache(handle), 0);
+    }
     return driver->close(handle);
 }
 
@@ -308,6 +537,12 @@ APR_DECLARE(int) apr_dbd_query(const apr_dbd_driver_t *driver,
                                apr_dbd_t *handle,
                                int *nrows, const char *statement)
 {
+    apr_dbd_prepared_t *prepared = dbd_stmt_raw(driver, handle, statement);
+
+    if (prepared) {
+        return driver->pquery((*driver->stmt_cache(handle))->pool, handle,
+                              nrows, prepared, NULL);
+    }
     return driver->query(handle,nrows,statement);
 }
 
@@ -316,6 +551,11 @@ APR_DECLARE(int) apr_dbd_select(const apr_dbd_driver_t *driver,
                                 apr_dbd_t *handle, apr_dbd_results_t **res,
                                 const char *statement, int random)
 {
+    apr_dbd_prepared_t *prepared = dbd_stmt_raw(driver, handle, statement);
+
+    if (prepared) {
+        return driver->pselect(pool, handle, res, prepared, random, NULL);
+    }
     return driver->select(pool,handle,res,statement,random);
 }
 
@@ -371,15 +611,24 @@ APR_DECLARE(int) apr_dbd_prepare(const apr_dbd_driver_t *driver,
                                  apr_dbd_prepared_t **statement)
 {
     size_t qlen;
-    int i, nargs = 0, nvals = 0;
+    int i, nargs = 0, nvals = 0, ret;
     char *p, *pq;
     const char *q;
     apr_dbd_type_e *t;
+    apr_dbd_stmt_cache_t *cache = NULL;
+    dbd_stmt_entry_t *e;
 
     if (!driver->pformat) {
         return APR_ENOTIMPL;
     }
 
+    if (!label && (cache = dbd_stmt_cache(driver, handle)) != NULL) {
+        *statement = dbd_stmt_get(cache, cache->prepared, query);
+        if (*statement) {
+            return 0;
+        }
+    }
+
     /* find the number of parameters in the query */
     for (q = query; *q; q++) {
         if (q[0] == '%') {
@@ -472,6 +721,23 @@ APR_DECLARE(int) apr_dbd_prepare(const apr_dbd_driver_t *driver,
     }
     *p = '\0';
 
+    /* a cached statement outlives both the caller's pool and its entry,
+     * which is freed on eviction, so its types go with the connection
+     */
+    if (cache && (e = dbd_stmt_entry_make(cache->prepared, query)) != NULL) {
+        t = apr_pmemdup(cache->pool, t, sizeof(*t) * nargs);
+        ret = driver->prepare(pool, handle, pq, NULL, nargs, nvals, t,
+                              &e->statement);
+        if (ret == 0) {
+            dbd_stmt_put(driver, handle, cache, e);
+            *statement = e->statement;
+        }
+        else {
+            free(e);
+        }
+        return ret;
+    }
+
     return driver->prepare(pool,handle,pq,label,nargs,nvals,t,statement);
 }
 
@@ -529,6 +795,51 @@ APR_DECLARE(int) apr_dbd_pbquery(const apr_dbd_driver_t *driver,
     return driver->pbquery(pool,handle,nrows,statement,args);
 }
 
+APR_DECLARE(int) apr_dbd_pbquery_batch(const apr_dbd_driver_t *driver,
+                                       apr_pool_t *pool, apr_dbd_t *handle,
+                                       int *nrows,
+                                       apr_dbd_prepared_t *statement,
+                                       int nsets, const void ***args,
+                                       apr_dbd_transaction_t *trans)
+{
+    apr_dbd_transaction_t *own = NULL;
+    int i, n, ret = 0;
+
+    if (driver->pbquery_batch) {
+        return driver->pbquery_batch(pool, handle, nrows, statement, nsets,
+                                     args, trans);
+    }
+
+    *nrows = 0;
+    if (!trans && driver->transaction_get) {
+        trans = driver->transaction_get(handle);
+    }
+    if (!trans) {
+        ret = driver->start_transaction(pool, handle, &own);
+        if (ret) {
+            return ret;
+        }
+    }
+    for (i = 0; i < nsets; i++) {
+        n = 0;
+        ret = driver->pbquery(pool, handle, &n, statement, args[i]);
+        if (ret) {
+            break;
+        }
+        *nrows += n;
+    }
+    if (own) {
+        if (ret) {
+            driver->transaction_mode_set(own, APR_DBD_TRANSACTION_ROLLBACK);
+            driver->end_transaction(own);
+        }
+        else {
+            ret = driver->end_transaction(own);
+        }
+    }
+    return ret;
+}
+
 APR_DECLARE(int) apr_dbd_pbselect(const apr_dbd_driver_t *driver,
                                   apr_pool_t *pool,
                                   apr_dbd_t *handle, apr_dbd_results_t **res,
@@ -571,3 +882,77 @@ APR_DECLARE(apr_status_t) apr_dbd_datum_get(const apr_dbd_driver_t *driver,
 {
     return driver->datum_get(row,col,type,data);
 }
+
+/* The text of an entry, for drivers without typed accessors.  NULL and
+ * out of bounds entries can't be told apart through get_entry(), so both
+ * are APR_ENOENT, as documented for apr_dbd_get_int64().
+ */
+static apr_status_t dbd_entry_text(const apr_dbd_driver_t *driver,
+                                   apr_dbd_row_t *row, int col,
+                                   const char **text)
+{
+    *text = driver->get_entry(row, col);
+    return *text ? APR_SUCCESS : APR_ENOENT;
+}
+
+APR_DECLARE(apr_status_t) apr_dbd_get_int64(const apr_dbd_driver_t *driver,
+                                            apr_dbd_row_t *row, int col,
+                                            apr_int64_t *value)
+{
+    const char *text;
+    char *end;
+    apr_status_t rv;
+
+    if (driver->get_int64) {
+        return driver->get_int64(row, col, value);
+    }
+    if ((rv = dbd_entry_text(driver, row, col, &text)) != APR_SUCCESS) {
+        return rv;
+    }
+    *value = apr_strtoi64(text, &end, 10);
+    return (end == text || *end) ? APR_EINVAL : APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_dbd_get_double(const apr_dbd_driver_t *driver,
+                                             apr_dbd_row_t *row, int col,
+                                             double *value)
+{
+    const char *text;
+    char *end;
+    apr_status_t rv;
+
+    if (driver->get_double) {
+        return driver->get_double(row, col, value);
+    }
+    if ((rv = dbd_entry_text(driver, row, col, &text)) != APR_SUCCESS) {
+        return rv;
+    }
+    *value = strtod(text, &end);
+    return (end == text || *end) ? APR_EINVAL : APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_dbd_get_text(const apr_dbd_driver_t *driver,
+                                           apr_dbd_row_t *row, int col,
+                                           apr_dbd_span_t *span)
+{
+    apr_status_t rv;
+
+    if (driver->get_span) {
+        return driver->get_span(row, col, 0, span);
+    }
+    if ((rv = dbd_entry_text(driver, row, col, &span->data)) != APR_SUCCESS) {
+        return rv;
+    }
+    span->len = strlen(span->data);
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_dbd_get_blob(const apr_dbd_driver_t *driver,
+                                           apr_dbd_row_t *row, int col,
+                                           apr_dbd_span_t *span)
+{
+    if (driver->get_span) {
+        return driver->get_span(row, col, 1, span);
+    }
+    return APR_ENOTIMPL;
+}
@@ -1259,6 +1259,11 @@ static void *dbd_mysql_native(apr_dbd_t *handle)
     return handle->conn;
 }
 
+static apr_dbd_transaction_t *dbd_mysql_transaction_get(apr_dbd_t *handle)
+{
+    return handle->trans;
+}
+
 static int dbd_mysql_num_cols(apr_dbd_results_t *res)
 {
     if (res->statement) {
@@ -1329,7 +1334,14 @@ APR_MODULE_DECLARE_DATA const apr_dbd_driver_t apr_dbd_mysql_driver = {
     dbd_mysql_pvbselect,
     dbd_mysql_pbquery,
     dbd_mysql_pbselect,
-    dbd_mysql_datum_get
+    dbd_mysql_datum_get,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    dbd_mysql_transaction_get
 };
 
 #endif
@@ -2166,6 +2166,11 @@ static void *dbd_oracle_native(apr_dbd_t *handle)
     return dbd_oracle_env;
 }
 
+static apr_dbd_transaction_t *dbd_oracle_transaction_get(apr_dbd_t *handle)
+{
+    return handle->trans;
+}
+
 static int dbd_oracle_num_cols(apr_dbd_results_t* res)
 {
     return res->statement->nout;
@@ -2216,6 +2221,13 @@ APR_MODULE_DECLARE_DATA const apr_dbd_driver_t apr_dbd_oracle_driver = {
     dbd_oracle_pvbselect,
     dbd_oracle_pbquery,
     dbd_oracle_pbselect,
-    dbd_oracle_datum_get
+    dbd_oracle_datum_get,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    dbd_oracle_transaction_get
 };
 #endif
@@ -1263,6 +1263,11 @@ static void *dbd_pgsql_native(apr_dbd_t *handle)
     return handle->conn;
 }
 
+static apr_dbd_transaction_t *dbd_pgsql_transaction_get(apr_dbd_t *handle)
+{
+    return handle->trans;
+}
+
 static int dbd_pgsql_num_cols(apr_dbd_results_t* res)
 {
     return res->sz;
@@ -1309,6 +1314,13 @@ APR_MODULE_DECLARE_DATA const apr_dbd_driver_t apr_dbd_pgsql_driver = {
     dbd_pgsql_pvbselect,
     dbd_pgsql_pbquery,
     dbd_pgsql_pbselect,
-    dbd_pgsql_datum_get
+    dbd_pgsql_datum_get,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    dbd_pgsql_transaction_get
 };
 #endif
@@ -521,6 +521,11 @@ static void *dbd_sqlite_native(apr_dbd_t * handle)
     return handle->conn;
 }
 
+static apr_dbd_transaction_t *dbd_sqlite_transaction_get(apr_dbd_t *handle)
+{
+    return handle->trans;
+}
+
 static int dbd_sqlite_num_cols(apr_dbd_results_t * res)
 {
     return res->sz;
@@ -562,6 +567,13 @@ APR_MODULE_DECLARE_DATA const apr_dbd_driver_t apr_dbd_sqlite2_driver = {
     dbd_sqlite_pvbselect,
     dbd_sqlite_pbquery,
     dbd_sqlite_pbselect,
-    dbd_sqlite_datum_get
+    dbd_sqlite_datum_get,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    dbd_sqlite_transaction_get
 };
 #endif
@@ -27,11 +27,13 @@
 #include "apr_strings.h"
 #include "apr_time.h"
 #include "apr_buckets.h"
+#include "apr_lib.h"
+#include "apr_thread_mutex.h"
 
 #include "apr_dbd_internal.h"
 
-#define MAX_RETRY_COUNT 15
-#define MAX_RETRY_SLEEP 100000
+/* how long a statement waits for locks held by other connections, in ms */
+#define DEFAULT_BUSY_TIMEOUT 1500
 
 struct apr_dbd_transaction_t {
     int mode;
@@ -44,6 +46,12 @@ struct apr_dbd_t {
     apr_dbd_transaction_t *trans;
     apr_pool_t *pool;
     apr_dbd_prepared_t *prep;
+    apr_dbd_prepared_t *spare;
+    apr_dbd_results_t *cursor;
+    apr_dbd_stmt_cache_t *cache;
+#if APR_HAS_THREADS
+    apr_thread_mutex_t *mutex;
+#endif
 };
 
 typedef struct {
@@ -59,6 +67,7 @@ struct apr_dbd_row_t {
     apr_dbd_row_t *next_row;
     int columnCount;
     int rownum;
+    apr_pool_t *pool;
 };
 
 struct apr_dbd_results_t {
@@ -70,6 +79,13 @@ struct apr_dbd_results_t {
     int tuples;
     char **col_names;
     apr_pool_t *pool;
+    /* sequential results step the statement from get_row */
+    apr_dbd_t *sql;
+    apr_dbd_row_t *cursor_row; /* current row, points into stmt */
+    int streaming;             /* stmt is still owned by the results */
+    int pending;               /* cursor_row was stepped but not returned */
+    int owned;                 /* stmt is finalized rather than reset */
+    int nocopy;                /* cursor_row itself is returned by get_row */
 };
 
 struct apr_dbd_prepared_t {
@@ -82,18 +98,211 @@ struct apr_dbd_prepared_t {
 
 #define dbd_sqlite3_is_success(x) (((x) == SQLITE_DONE) || ((x) == SQLITE_OK))
 
+/* Connections are independent of each other; the lock only protects a
+ * connection (and its statements and cursor) shared between threads.
+ */
+#if APR_HAS_THREADS
+#define dbd_sqlite3_lock(sql)   apr_thread_mutex_lock((sql)->mutex)
+#define dbd_sqlite3_unlock(sql) apr_thread_mutex_unlock((sql)->mutex)
+#else
+#define dbd_sqlite3_lock(sql)
+#define dbd_sqlite3_unlock(sql)
+#endif
+
+static apr_dbd_row_t *dbd_sqlite3_new_row(apr_dbd_results_t *res,
+                                         apr_pool_t *pool)
+{
+    apr_dbd_row_t *row;
+    size_t i;
+
+    row = apr_palloc(pool, sizeof(apr_dbd_row_t));
+    row->res = res;
+    row->columns = apr_palloc(pool, res->sz * sizeof(apr_dbd_column_t *));
+    for (i = 0; i < res->sz; i++) {
+        row->columns[i] = apr_palloc(pool, sizeof(apr_dbd_column_t));
+        row->columns[i]->name = res->col_names[i];
+    }
+    row->columnCount = res->sz;
+    row->next_row = 0;
+    row->rownum = 0;
+    row->pool = pool;
+
+    return row;
+}
+
+static void dbd_sqlite3_fetch(apr_dbd_column_t *column, sqlite3_stmt *stmt,
+                              int n)
+{
+    switch (column->type) {
+    case SQLITE_FLOAT:
+    case SQLITE_INTEGER:
+    case SQLITE_TEXT:
+        column->value = (char *) sqlite3_column_text(stmt, n);
+        break;
+    case SQLITE_BLOB:
+        column->value = (char *) sqlite3_column_blob(stmt, n);
+        break;
+    case SQLITE_NULL:
+    default:
+        column->value = NULL;
+        break;
+    }
+    column->size = sqlite3_column_bytes(stmt, n);
+}
+
+/* Load the current row of the statement into row.  Values are copied
+ * into pool, or with a NULL pool fetched from the statement when first
+ * asked for (a size of -1 until then); they stay valid until it is
+ * stepped, reset or finalized.
+ */
+static void dbd_sqlite3_load_row(apr_dbd_row_t *row, apr_pool_t *pool)
+{
+    sqlite3_stmt *stmt = row->res->stmt;
+    apr_dbd_column_t *column;
+    size_t i;
+
+    for (i = 0; i < row->res->sz; i++) {
+        column = row->columns[i];
+        column->type = sqlite3_column_type(stmt, i);
+        column->value = NULL;
+        column->size = -1;
+        if (pool) {
+            dbd_sqlite3_fetch(column, stmt, i);
+            if (column->value) {
+                column->value = apr_pstrmemdup(pool, column->value,
+                                               column->size);
+            }
+        }
+    }
+}
+
+/* The statement a streaming row still lives in, or NULL */
+static sqlite3_stmt *dbd_sqlite3_row_stmt(const apr_dbd_row_t *row)
+{
+    apr_dbd_results_t *res = row->res;
+
+    return (row == res->cursor_row && res->streaming) ? res->stmt : NULL;
+}
+
+static apr_dbd_column_t *dbd_sqlite3_column(const apr_dbd_row_t *row, int n)
+{
+    apr_dbd_column_t *column = row->columns[n];
+    sqlite3_stmt *stmt;
+
+    if (column->size < 0) {
+        if ((stmt = dbd_sqlite3_row_stmt(row)) != NULL) {
+            dbd_sqlite3_fetch(column, stmt, n);
+        }
+        else {
+            column->size = 0;
+        }
+    }
+    return column;
+}
+
+static apr_status_t dbd_sqlite3_cursor_cleanup(void *data);
+
+/* Hand the statement of a sequential result set back: ad-hoc statements
+ * are finalized, prepared ones reset for their next execution.
+ */
+static void dbd_sqlite3_cursor_release(apr_dbd_results_t *res)
+{
+    if (res->owned) {
+        sqlite3_finalize(res->stmt);
+    }
+    else {
+        sqlite3_reset(res->stmt);
+    }
+    if (res->streaming) {
+        apr_pool_cleanup_kill(res->pool, res, dbd_sqlite3_cursor_cleanup);
+        if (res->sql->cursor == res) {
+            res->sql->cursor = NULL;
+        }
+    }
+    res->stmt = NULL;
+    res->streaming = 0;
+    res->pending = 0;
+}
+
+static apr_status_t dbd_sqlite3_cursor_cleanup(void *data)
+{
+    apr_dbd_results_t *res = data;
+
+    if (res->streaming) {
+        dbd_sqlite3_lock(res->sql);
+        dbd_sqlite3_cursor_release(res);
+        dbd_sqlite3_unlock(res->sql);
+    }
+    return APR_SUCCESS;
+}
+
+/* Only one statement of a connection streams results at a time; before
+ * anything else runs, the rows the open cursor has not returned yet are
+ * copied into its pool and its statement is released.  A result set that
+ * is about to be reused by the caller is simply released.
+ */
+static void dbd_sqlite3_cursor_detach(apr_dbd_t *sql,
+                                      apr_dbd_results_t *reuse)
+{
+    apr_dbd_results_t *res = sql->cursor;
+    apr_dbd_row_t *row, *lastrow = NULL;
+    size_t i;
+    int ret;
+
+    if (res == NULL) {
+        return;
+    }
+    if (res == reuse) {
+        dbd_sqlite3_cursor_release(res);
+        return;
+    }
+
+    if (res->pending) {
+        ret = SQLITE_ROW;
+    }
+    else if (!res->nocopy) {
+        ret = sqlite3_step(res->stmt);
+    }
+    else {
+        /* the row last returned must outlive the statement */
+        row = res->cursor_row;
+        for (i = 0; i < res->sz; i++) {
+            dbd_sqlite3_column(row, i);
+            if (row->columns[i]->value) {
+                row->columns[i]->value =
+                    apr_pstrmemdup(res->pool, row->columns[i]->value,
+                                   row->columns[i]->size);
+            }
+        }
+        ret = sqlite3_step(res->stmt);
+    }
+
+    while (ret == SQLITE_ROW) {
+        row = dbd_sqlite3_new_row(res, res->pool);
+        dbd_sqlite3_load_row(row, res->pool);
+        if (lastrow) {
+            lastrow->next_row = row;
+        }
+        else {
+            res->next_row = row;
+        }
+        lastrow = row;
+        ret = sqlite3_step(res->stmt);
+    }
+
+    dbd_sqlite3_cursor_release(res);
+}
+
 static int dbd_sqlite3_select_internal(apr_pool_t *pool,
                                        apr_dbd_t *sql,
                                        apr_dbd_results_t **results,
-                                       sqlite3_stmt *stmt, int seek)
+                                       sqlite3_stmt *stmt, int seek,
+                                       int owned)
 {
-    int ret, retry_count = 0, column_count;
+    int ret, column_count;
     size_t i, num_tuples = 0;
-    int increment = 0;
     apr_dbd_row_t *row = NULL;
     apr_dbd_row_t *lastrow = NULL;
-    apr_dbd_column_t *column;
-    char *hold = NULL;
 
     column_count = sqlite3_column_count(stmt);
     if (!*results) {
@@ -106,59 +315,43 @@ static int dbd_sqlite3_select_internal(apr_pool_t *pool,
     (*results)->tuples = 0;
     (*results)->col_names = apr_pcalloc(pool, column_count * sizeof(char *));
     (*results)->pool = pool;
-    do {
+    (*results)->sql = sql;
+    (*results)->cursor_row = NULL;
+    (*results)->streaming = 0;
+    (*results)->pending = 0;
+    (*results)->owned = owned;
+    (*results)->nocopy = (seek == APR_DBD_SELECT_STREAM);
+    if ((*results)->nocopy) {
+        (*results)->random = seek = 0;
+    }
+    for (i = 0; i < (*results)->sz; i++) {
+        (*results)->col_names[i] =
+            apr_pstrdup(pool, sqlite3_column_name(stmt, i));
+    }
+
+    if (!seek) {
+        /* Step to the first row only, so that errors are reported here;
+         * get_row steps through the rest one row at a time.
+         */
         ret = sqlite3_step(stmt);
-        if (ret == SQLITE_BUSY) {
-            if (retry_count++ > MAX_RETRY_COUNT) {
-                ret = SQLITE_ERROR;
-            } else {
-                apr_dbd_mutex_unlock();
-                apr_sleep(MAX_RETRY_SLEEP);
-                apr_dbd_mutex_lock();
-            }
-        } else if (ret == SQLITE_ROW) {
-            int length;
-            row = apr_palloc(pool, sizeof(apr_dbd_row_t));
-            row->res = *results;
-            increment = sizeof(apr_dbd_column_t *);
-            length = increment * (*results)->sz;
-            row->columns = apr_palloc(pool, length);
-            row->columnCount = column_count;
-            for (i = 0; i < (*results)->sz; i++) {
-                column = apr_palloc(pool, sizeof(apr_dbd_column_t));
-                row->columns[i] = column;
-                /* copy column name once only */
-                if ((*results)->col_names[i] == NULL) {
-                    (*results)->col_names[i] =
-                        apr_pstrdup(pool, sqlite3_column_name(stmt, i));
-                }
-                column->name = (*results)->col_names[i];
-                column->size = sqlite3_column_bytes(stmt, i);
-                column->type = sqlite3_column_type(stmt, i);
-                column->value = NULL;
-                switch (column->type) {
-                case SQLITE_FLOAT:
-                case SQLITE_INTEGER:
-                case SQLITE_TEXT:
-                    hold = (char *) sqlite3_column_text(stmt, i);
-                    if (hold) {
-                        column->value = apr_pstrmemdup(pool, hold,
-                                                       column->size);
-                    }
-                    break;
-                case SQLITE_BLOB:
-                    hold = (char *) sqlite3_column_blob(stmt, i);
-                    if (hold) {
-                        column->value = apr_pstrmemdup(pool, hold,
-                                                       column->size);
-                    }
-                    break;
-                case SQLITE_NULL:
-                    break;
-                }
-            }
+        if (ret == SQLITE_ROW) {
+            row = dbd_sqlite3_new_row(*results, pool);
+            dbd_sqlite3_load_row(row, NULL);
+            (*results)->cursor_row = row;
+            (*results)->pending = 1;
+            (*results)->streaming = 1;
+            sql->cursor = *results;
+            apr_pool_cleanup_register(pool, *results,
+                                      dbd_sqlite3_cursor_cleanup,
+                                      apr_pool_cleanup_null);
+            return 0;
+        }
+    }
+    else {
+        while ((ret = sqlite3_step(stmt)) == SQLITE_ROW) {
+            row = dbd_sqlite3_new_row(*results, pool);
+            dbd_sqlite3_load_row(row, pool);
             row->rownum = num_tuples++;
-            row->next_row = 0;
             (*results)->tuples = num_tuples;
             if ((*results)->next_row == 0) {
                 (*results)->next_row = row;
@@ -168,7 +361,8 @@ static int dbd_sqlite3_select_internal(apr_pool_t *pool,
             }
             lastrow = row;
         }
-    } while (ret == SQLITE_ROW || ret == SQLITE_BUSY);
+    }
+    dbd_sqlite3_cursor_release(*results);
 
     if (dbd_sqlite3_is_success(ret)) {
         ret = 0;
@@ -188,15 +382,19 @@ static int dbd_sqlite3_select(apr_pool_t *pool, apr_dbd_t *sql,
         return sql->trans->errnum;
     }
 
-    apr_dbd_mutex_lock();
+    dbd_sqlite3_lock(sql);
+
+    dbd_sqlite3_cursor_detach(sql, *results);
 
     ret = sqlite3_prepare(sql->conn, query, strlen(query), &stmt, &tail);
     if (dbd_sqlite3_is_success(ret)) {
-        ret = dbd_sqlite3_select_internal(pool, sql, results, stmt, seek);
+        ret = dbd_sqlite3_select_internal(pool, sql, results, stmt, seek, 1);
+    }
+    else {
+        sqlite3_finalize(stmt);
     }
-    sqlite3_finalize(stmt);
 
-    apr_dbd_mutex_unlock();
+    dbd_sqlite3_unlock(sql);
 
     if (TXN_NOTICE_ERRORS(sql->trans)) {
         sql->trans->errnum = ret;
@@ -218,7 +416,44 @@ static int dbd_sqlite3_get_row(apr_pool_t *pool, apr_dbd_results_t *res,
 {
     int i = 0;
 
-    if (rownum == -1) {
+    if (!res->random && res->next_row == 0) {
+        int ret;
+
+        if (!res->streaming) {
+            return -1;
+        }
+        if (res->pending) {
+            res->pending = 0;
+        }
+        else {
+            dbd_sqlite3_lock(res->sql);
+            ret = sqlite3_step(res->stmt);
+            if (ret == SQLITE_ROW) {
+                dbd_sqlite3_load_row(res->cursor_row, NULL);
+            }
+            else {
+                dbd_sqlite3_cursor_release(res);
+                if (TXN_NOTICE_ERRORS(res->sql->trans)
+                    && !dbd_sqlite3_is_success(ret)) {
+                    res->sql->trans->errnum = ret;
+                }
+            }
+            dbd_sqlite3_unlock(res->sql);
+            if (ret != SQLITE_ROW) {
+                return -1;
+            }
+        }
+        if (res->nocopy) {
+            *rowp = res->cursor_row;
+        }
+        else {
+            *rowp = dbd_sqlite3_new_row(res, pool);
+            dbd_sqlite3_load_row(*rowp, pool);
+        }
+        (*rowp)->rownum = res->tuples++;
+        return 0;
+    }
+    if (rownum == -1 || !res->random) {
         *rowp = res->next_row;
         if (*rowp == 0)
             return -1;
@@ -247,7 +482,7 @@ static const char *dbd_sqlite3_get_entry(const apr_dbd_row_t *row, int n)
     if ((n < 0) || (n >= row->columnCount)) {
         return NULL;
     }
-    column = row->columns[n];
+    column = dbd_sqlite3_column(row, n);
     value = column->value;
     return value;
 }
@@ -262,6 +497,7 @@ static apr_status_t dbd_sqlite3_datum_get(const apr_dbd_row_t *row, int n,
     if (row->columns[n]->type == SQLITE_NULL) {
         return APR_ENOENT;
     }
+    dbd_sqlite3_column(row, n);
 
     switch (type) {
     case APR_DBD_TYPE_TINY:
@@ -315,9 +551,17 @@ static apr_status_t dbd_sqlite3_datum_get(const apr_dbd_row_t *row, int n,
         apr_bucket *e;
         apr_bucket_brigade *b = (apr_bucket_brigade*)data;
 
-        e = apr_bucket_pool_create(row->columns[n]->value,
-                                   row->columns[n]->size,
-                                   row->res->pool, b->bucket_alloc);
+        if (row == row->res->cursor_row && row->res->streaming) {
+            /* the value lives in the statement until the next step */
+            e = apr_bucket_heap_create(row->columns[n]->value,
+                                       row->columns[n]->size,
+                                       NULL, b->bucket_alloc);
+        }
+        else {
+            e = apr_bucket_pool_create(row->columns[n]->value,
+                                       row->columns[n]->size,
+                                       row->pool, b->bucket_alloc);
+        }
         APR_BRIGADE_INSERT_TAIL(b, e);
         }
         break;
@@ -331,6 +575,114 @@ static apr_status_t dbd_sqlite3_datum_get(const apr_dbd_row_t *row, int n,
     return APR_SUCCESS;
 }
 
+/* Numbers are read from the statement of a streaming row without going
+ * through text; materialized rows only have the text left to convert.
+ */
+static apr_status_t dbd_sqlite3_get_int64(const apr_dbd_row_t *row, int n,
+                                          apr_int64_t *value)
+{
+    apr_dbd_column_t *column;
+    sqlite3_stmt *stmt;
+    char *end;
+
+    if ((n < 0) || (n >= row->columnCount)) {
+        return APR_EGENERAL;
+    }
+    column = row->columns[n];
+    stmt = dbd_sqlite3_row_stmt(row);
+
+    switch (column->type) {
+    case SQLITE_NULL:
+        return APR_ENOENT;
+    case SQLITE_INTEGER:
+        if (stmt) {
+            *value = sqlite3_column_int64(stmt, n);
+            return APR_SUCCESS;
+        }
+        /* fall through */
+    case SQLITE_TEXT:
+        column = dbd_sqlite3_column(row, n);
+        if (column->value) {
+            *value = apr_strtoi64(column->value, &end, 10);
+            if (end != column->value && !*end) {
+                return APR_SUCCESS;
+            }
+        }
+        return APR_EINVAL;
+    case SQLITE_FLOAT:
+        if (stmt) {
+            *value = (apr_int64_t)sqlite3_column_double(stmt, n);
+        }
+        else {
+            column = dbd_sqlite3_column(row, n);
+            if (!column->value) {
+                return APR_EINVAL;
+            }
+            *value = (apr_int64_t)strtod(column->value, NULL);
+        }
+        return APR_SUCCESS;
+    default:
+        return APR_EINVAL;
+    }
+}
+
+static apr_status_t dbd_sqlite3_get_double(const apr_dbd_row_t *row, int n,
+                                           double *value)
+{
+    apr_dbd_column_t *column;
+    sqlite3_stmt *stmt;
+    char *end;
+
+    if ((n < 0) || (n >= row->columnCount)) {
+        return APR_EGENERAL;
+    }
+    column = row->columns[n];
+    stmt = dbd_sqlite3_row_stmt(row);
+
+    switch (column->type) {
+    case SQLITE_NULL:
+        return APR_ENOENT;
+    case SQLITE_INTEGER:
+    case SQLITE_FLOAT:
+        if (stmt) {
+            *value = sqlite3_column_double(stmt, n);
+            return APR_SUCCESS;
+        }
+        /* fall through */
+    case SQLITE_TEXT:
+        column = dbd_sqlite3_column(row, n);
+        if (column->value) {
+            *value = strtod(column->value, &end);
+            if (end != column->value && !*end) {
+                return APR_SUCCESS;
+            }
+        }
+        return APR_EINVAL;
+    default:
+        return APR_EINVAL;
+    }
+}
+
+static apr_status_t dbd_sqlite3_get_span(const apr_dbd_row_t *row, int n,
+                                         int binary, apr_dbd_span_t *span)
+{
+    apr_dbd_column_t *column;
+
+    if ((n < 0) || (n >= row->columnCount)) {
+        return APR_EGENERAL;
+    }
+    if (row->columns[n]->type == SQLITE_NULL) {
+        return APR_ENOENT;
+    }
+    column = dbd_sqlite3_column(row, n);
+    if (!column->value) {
+        return APR_EGENERAL;
+    }
+    span->data = column->value;
+    span->len = column->size;
+    return APR_SUCCESS;
+}
+
 static const char *dbd_sqlite3_error(apr_dbd_t *sql, int n)
 {
     return sqlite3_errmsg(sql->conn);
@@ -339,17 +691,10 @@ static const char *dbd_sqlite3_error(apr_dbd_t *sql, int n)
 static int dbd_sqlite3_query_internal(apr_dbd_t *sql, sqlite3_stmt *stmt,
                                       int *nrows)
 {
-    int ret = -1, retry_count = 0;
-
-    while(retry_count++ <= MAX_RETRY_COUNT) {
-        ret = sqlite3_step(stmt);
-        if (ret != SQLITE_BUSY)
-            break;
+    int ret;
 
-        apr_dbd_mutex_unlock();
-        apr_sleep(MAX_RETRY_SLEEP);
-        apr_dbd_mutex_lock();
-    }
+    /* waiting for other connections is left to sqlite3_busy_timeout() */
+    ret = sqlite3_step(stmt);
 
     *nrows = sqlite3_changes(sql->conn);
 
@@ -370,7 +715,9 @@ static int dbd_sqlite3_query(apr_dbd_t *sql, int *nrows, const char *query)
     }
 
     length = strlen(query);
-    apr_dbd_mutex_lock();
+    dbd_sqlite3_lock(sql);
+
+    dbd_sqlite3_cursor_detach(sql, NULL);
 
     do {
         ret = sqlite3_prepare(sql->conn, query, length, &stmt, &tail);
@@ -386,7 +733,7 @@ static int dbd_sqlite3_query(apr_dbd_t *sql, int *nrows, const char *query)
         query = tail;
     } while (length > 0);
 
-    apr_dbd_mutex_unlock();
+    dbd_sqlite3_unlock(sql);
 
     if (TXN_NOTICE_ERRORS(sql->trans)) {
         sql->trans->errnum = ret;
@@ -418,13 +765,22 @@ static int dbd_sqlite3_prepare(apr_pool_t *pool, apr_dbd_t *sql,
     const char *tail = NULL;
     int ret;
 
-    apr_dbd_mutex_lock();
+    dbd_sqlite3_lock(sql);
 
-    ret = sqlite3_prepare(sql->conn, query, strlen(query), &stmt, &tail);
+    /* v2 statements recompile themselves after schema changes, which
+     * statements kept in the cache rely on
+     */
+    ret = sqlite3_prepare_v2(sql->conn, query, strlen(query), &stmt, &tail);
     if (ret == SQLITE_OK) {
         apr_dbd_prepared_t *prep; 
 
-        prep = apr_pcalloc(sql->pool, sizeof(*prep));
+        if (sql->spare) {
+            prep = sql->spare;
+            sql->spare = prep->next;
+        }
+        else {
+            prep = apr_pcalloc(sql->pool, sizeof(*prep));
+        }
         prep->stmt = stmt;
         prep->next = sql->prep;
         prep->nargs = nargs;
@@ -439,11 +795,39 @@ static int dbd_sqlite3_prepare(apr_pool_t *pool, apr_dbd_t *sql,
         sqlite3_finalize(stmt);
     }
    
-    apr_dbd_mutex_unlock();
+    dbd_sqlite3_unlock(sql);
 
     return ret;
 }
 
+static void dbd_sqlite3_unprepare(apr_dbd_t *sql,
+                                  apr_dbd_prepared_t *statement)
+{
+    apr_dbd_prepared_t **prep;
+
+    dbd_sqlite3_lock(sql);
+
+    if (sql->cursor && sql->cursor->stmt == statement->stmt) {
+        dbd_sqlite3_cursor_detach(sql, NULL);
+    }
+    for (prep = &sql->prep; *prep; prep = &(*prep)->next) {
+        if (*prep == statement) {
+            *prep = statement->next;
+            break;
+        }
+    }
+    sqlite3_finalize(statement->stmt);
+    statement->next = sql->spare;
+    sql->spare = statement;
+
+    dbd_sqlite3_unlock(sql);
+}
+
+static apr_dbd_stmt_cache_t **dbd_sqlite3_stmt_cache(apr_dbd_t *handle)
+{
+    return &handle->cache;
+}
+
 static void dbd_sqlite3_bind(apr_dbd_prepared_t *statement, const char **values)
 {
     sqlite3_stmt *stmt = statement->stmt;
@@ -489,7 +873,9 @@ static int dbd_sqlite3_pquery(apr_pool_t *pool, apr_dbd_t *sql,
         return sql->trans->errnum;
     }
 
-    apr_dbd_mutex_lock();
+    dbd_sqlite3_lock(sql);
+
+    dbd_sqlite3_cursor_detach(sql, NULL);
 
     ret = sqlite3_reset(stmt);
     if (ret == SQLITE_OK) {
@@ -500,7 +886,7 @@ static int dbd_sqlite3_pquery(apr_pool_t *pool, apr_dbd_t *sql,
         sqlite3_reset(stmt);
     }
 
-    apr_dbd_mutex_unlock();
+    dbd_sqlite3_unlock(sql);
 
     if (TXN_NOTICE_ERRORS(sql->trans)) {
         sql->trans->errnum = ret;
@@ -539,18 +925,18 @@ static int dbd_sqlite3_pselect(apr_pool_t *pool, apr_dbd_t *sql,
         return sql->trans->errnum;
     }
 
-    apr_dbd_mutex_lock();
+    dbd_sqlite3_lock(sql);
+
+    dbd_sqlite3_cursor_detach(sql, *results);
 
     ret = sqlite3_reset(stmt);
     if (ret == SQLITE_OK) {
         dbd_sqlite3_bind(statement, values);
 
-        ret = dbd_sqlite3_select_internal(pool, sql, results, stmt, seek);
-
-        sqlite3_reset(stmt);
+        ret = dbd_sqlite3_select_internal(pool, sql, results, stmt, seek, 0);
     }
 
-    apr_dbd_mutex_unlock();
+    dbd_sqlite3_unlock(sql);
 
     if (TXN_NOTICE_ERRORS(sql->trans)) {
         sql->trans->errnum = ret;
@@ -669,7 +1055,9 @@ static int dbd_sqlite3_pbquery(apr_pool_t * pool, apr_dbd_t * sql,
         return sql->trans->errnum;
     }
 
-    apr_dbd_mutex_lock();
+    dbd_sqlite3_lock(sql);
+
+    dbd_sqlite3_cursor_detach(sql, NULL);
 
     ret = sqlite3_reset(stmt);
     if (ret == SQLITE_OK) {
@@ -680,7 +1068,63 @@ static int dbd_sqlite3_pbquery(apr_pool_t * pool, apr_dbd_t * sql,
         sqlite3_reset(stmt);
     }
 
-    apr_dbd_mutex_unlock();
+    dbd_sqlite3_unlock(sql);
+
+    if (TXN_NOTICE_ERRORS(sql->trans)) {
+        sql->trans->errnum = ret;
+    }
+    return ret;
+}
+
+static int dbd_sqlite3_pbquery_batch(apr_pool_t *pool, apr_dbd_t *sql,
+                                     int *nrows,
+                                     apr_dbd_prepared_t *statement, int nsets,
+                                     const void ***args,
+                                     apr_dbd_transaction_t *trans)
+{
+    sqlite3_stmt *stmt = statement->stmt;
+    int i, own, ret = 0;
+
+    *nrows = 0;
+    if (sql->trans && sql->trans->errnum) {
+        return sql->trans->errnum;
+    }
+
+    /* one lock, one transaction and one statement for the whole batch */
+    dbd_sqlite3_lock(sql);
+
+    dbd_sqlite3_cursor_detach(sql, NULL);
+
+    own = !trans && !sql->trans;
+    if (own) {
+        ret = sqlite3_exec(sql->conn, "BEGIN IMMEDIATE", NULL, NULL, NULL);
+    }
+    for (i = 0; ret == SQLITE_OK && i < nsets; i++) {
+        ret = sqlite3_reset(stmt);
+        if (ret == SQLITE_OK) {
+            dbd_sqlite3_bbind(statement, args[i]);
+            ret = sqlite3_step(stmt);
+            if (dbd_sqlite3_is_success(ret)) {
+                *nrows += sqlite3_changes(sql->conn);
+                ret = SQLITE_OK;
+            }
+        }
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    if (own) {
+        if (ret != SQLITE_OK) {
+            sqlite3_exec(sql->conn, "ROLLBACK", NULL, NULL, NULL);
+        }
+        else if ((ret = sqlite3_exec(sql->conn, "COMMIT", NULL, NULL,
+                                     NULL)) != SQLITE_OK) {
+            /* a failed COMMIT (SQLITE_BUSY) leaves the transaction open */
+            sqlite3_exec(sql->conn, "ROLLBACK", NULL, NULL, NULL);
+            *nrows = 0;
+        }
+    }
+
+    dbd_sqlite3_unlock(sql);
 
     if (TXN_NOTICE_ERRORS(sql->trans)) {
         sql->trans->errnum = ret;
@@ -720,18 +1164,18 @@ static int dbd_sqlite3_pbselect(apr_pool_t * pool, apr_dbd_t * sql,
         return sql->trans->errnum;
     }
 
-    apr_dbd_mutex_lock();
+    dbd_sqlite3_lock(sql);
+
+    dbd_sqlite3_cursor_detach(sql, *results);
 
     ret = sqlite3_reset(stmt);
     if (ret == SQLITE_OK) {
         dbd_sqlite3_bbind(statement, values);
 
-        ret = dbd_sqlite3_select_internal(pool, sql, results, stmt, seek);
-
-        sqlite3_reset(stmt);
+        ret = dbd_sqlite3_select_internal(pool, sql, results, stmt, seek, 0);
     }
 
-    apr_dbd_mutex_unlock();
+    dbd_sqlite3_unlock(sql);
 
     if (TXN_NOTICE_ERRORS(sql->trans)) {
         sql->trans->errnum = ret;
@@ -813,18 +1257,85 @@ static int dbd_sqlite3_transaction_mode_set(apr_dbd_transaction_t *trans,
     return trans->mode = (mode & TXN_MODE_BITS);
 }
 
+/* Run a PRAGMA whose value is a plain word, as given in the parameters */
+static int dbd_sqlite3_pragma(apr_pool_t *pool, sqlite3 *conn,
+                              const char *name, const char *value)
+{
+    const char *c;
+
+    for (c = value; *c; c++) {
+        if (!apr_isalnum(*c)) {
+            return SQLITE_MISUSE;
+        }
+    }
+    return sqlite3_exec(conn, apr_pstrcat(pool, "PRAGMA ", name, "=", value,
+                                          NULL),
+                        NULL, NULL, NULL);
+}
+
 static apr_dbd_t *dbd_sqlite3_open(apr_pool_t *pool, const char *params,
                                    const char **error)
 {
+    static const char *const delims = " \r\n\t;|,";
     apr_dbd_t *sql = NULL;
     sqlite3 *conn = NULL;
+    const char *file = params;
+    const char *journal_mode = NULL, *synchronous = NULL;
+    int busy_timeout = DEFAULT_BUSY_TIMEOUT;
     int sqlres;
+
     if (!params)
         return NULL;
-    sqlres = sqlite3_open(params, &conn);
+
+    /* Either a file name, or key=value pairs one of which is the file */
+    if (strchr(params, '=')) {
+        char *copy = apr_pstrdup(pool, params), *last, *key, *value;
+        const char *found = NULL;
+
+        for (key = apr_strtok(copy, delims, &last); key;
+             key = apr_strtok(NULL, delims, &last)) {
+            if ((value = strchr(key, '=')) == NULL) {
+                continue;
+            }
+            *value++ = '\0';
+            if (!strcasecmp(key, "file")) {
+                found = value;
+            }
+            else if (!strcasecmp(key, "busy_timeout")) {
+                busy_timeout = atoi(value);
+            }
+            else if (!strcasecmp(key, "journal_mode")) {
+                journal_mode = value;
+            }
+            else if (!strcasecmp(key, "synchronous")) {
+                synchronous = value;
+            }
+        }
+        if (found) {
+            file = found;
+        }
+        else {
+            /* just a file name containing '=' */
+            journal_mode = synchronous = NULL;
+            busy_timeout = DEFAULT_BUSY_TIMEOUT;
+        }
+    }
+
+    sqlres = sqlite3_open(file, &conn);
+    if (sqlres == SQLITE_OK) {
+        sqlres = sqlite3_busy_timeout(conn, busy_timeout);
+    }
+    if (sqlres == SQLITE_OK && journal_mode) {
+        sqlres = dbd_sqlite3_pragma(pool, conn, "journal_mode", journal_mode);
+    }
+    if (sqlres == SQLITE_OK && synchronous) {
+        sqlres = dbd_sqlite3_pragma(pool, conn, "synchronous", synchronous);
+    }
     if (sqlres != SQLITE_OK) {
         if (error) {
-            *error = apr_pstrdup(pool, sqlite3_errmsg(conn));
+            *error = apr_pstrdup(pool, sqlres == SQLITE_MISUSE
+                                       ? "invalid PRAGMA value"
+                                       : sqlite3_errmsg(conn));
         }
         sqlite3_close(conn);
         return NULL;
@@ -834,6 +1345,13 @@ static apr_dbd_t *dbd_sqlite3_open(apr_pool_t *pool, const char *params,
     sql->conn = conn;
     sql->pool = pool;
     sql->trans = NULL;
+#if APR_HAS_THREADS
+    if (apr_thread_mutex_create(&sql->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                pool) != APR_SUCCESS) {
+        sqlite3_close(conn);
+        return NULL;
+    }
+#endif
 
     return sql;
 }
@@ -842,6 +1360,10 @@ static apr_status_t dbd_sqlite3_close(apr_dbd_t *handle)
 {
     apr_dbd_prepared_t *prep = handle->prep;
 
+    if (handle->cursor) {
+        dbd_sqlite3_cursor_release(handle->cursor);
+    }
+
     /* finalize all prepared statements, or we'll get SQLITE_BUSY on close */
     while (prep) {
         sqlite3_finalize(prep->stmt);
@@ -869,6 +1391,11 @@ static void *dbd_sqlite3_native(apr_dbd_t *handle)
     return handle->conn;
 }
 
+static apr_dbd_transaction_t *dbd_sqlite3_transaction_get(apr_dbd_t *handle)
+{
+    return handle->trans;
+}
+
 static int dbd_sqlite3_num_cols(apr_dbd_results_t *res)
 {
     return res->sz;
@@ -876,6 +1403,9 @@ static int dbd_sqlite3_num_cols(apr_dbd_results_t *res)
 
 static int dbd_sqlite3_num_tuples(apr_dbd_results_t *res)
 {
+    if (!res->random) {
+        return -1;
+    }
     return res->tuples;
 }
 
@@ -910,6 +1440,13 @@ APR_MODULE_DECLARE_DATA const apr_dbd_driver_t apr_dbd_sqlite3_driver = {
     dbd_sqlite3_pvbselect,
     dbd_sqlite3_pbquery,
     dbd_sqlite3_pbselect,
-    dbd_sqlite3_datum_get
+    dbd_sqlite3_datum_get,
+    dbd_sqlite3_stmt_cache,
+    dbd_sqlite3_unprepare,
+    dbd_sqlite3_pbquery_batch,
+    dbd_sqlite3_get_int64,
+    dbd_sqlite3_get_double,
+    dbd_sqlite3_get_span,
+    dbd_sqlite3_transaction_get
 };
 #endif
@@ -83,6 +83,7 @@ static apr_status_t dbm_open_type(apr_dbm_type_t const* * vtable,
 
     *vtable = NULL;
     if (!strcasecmp(type, "default"))     *vtable = &DBM_VTABLE;
+    else if (!strcasecmp(type, "cdb"))    *vtable = &apr_dbm_type_cdb;
 #if APU_HAVE_DB
     else if (!strcasecmp(type, "db"))     *vtable = &apr_dbm_type_db;
 #endif
@@ -137,6 +138,7 @@ static apr_status_t dbm_open_type(apr_dbm_type_t const* * vtable,
 
         drivers = apr_hash_make(pool);
         apr_hash_set(drivers, "sdbm", APR_HASH_KEY_STRING, &apr_dbm_type_sdbm);
+        apr_hash_set(drivers, "cdb", APR_HASH_KEY_STRING, &apr_dbm_type_cdb);
 
         apr_pool_cleanup_register(pool, NULL, dbm_term,
                                   apr_pool_cleanup_null);
@@ -0,0 +1,602 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A constant database, in the format of D. J. Bernstein's cdb: a header
+ * of 256 (position, slots) pairs, the records as (klen, vlen, key, value),
+ * then 256 open addressed hash tables of (hash, position) slots.  All the
+ * numbers are 32 bit little endian.
+ *
+ * A database opened read-only is mapped into memory and never locked; a
+ * lookup is one probe of the header and usually one of a table.  A
+ * database opened for writing is held in memory, and written to a
+ * temporary file that is renamed over the original when it is closed,
+ * so readers see either the old contents or the new ones, never a mix.
+ */
+
+#include "apr_strings.h"
+#include "apr_hash.h"
+#include "apr_file_io.h"
+#include "apr_mmap.h"
+#define APR_WANT_MEMFUNC
+#define APR_WANT_STRFUNC
+#include "apr_want.h"
+
+#include "apu.h"
+#include "apr_private.h"
+
+#include "apr_dbm_private.h"
+
+#define CDB_HEADER      2048    /* 256 pairs of 32 bit numbers */
+#define CDB_MAXPOS      APR_UINT32_MAX
+
+typedef struct {
+    /* read-only: the whole file, mapped or read into memory */
+    const unsigned char *map;
+    apr_pool_t *mpool;          /* holds the map, released on close */
+    apr_mmap_t *mm;
+    apr_size_t size;
+    apr_uint32_t eod;           /* end of the records */
+    apr_uint32_t cursor;        /* record after the last key returned */
+
+    /* read-write: the records, written out on close */
+    apr_hash_t *recs;
+    apr_hash_index_t *hi;
+    const char *name;
+    apr_fileperms_t perm;
+    int dirty;
+} cdb_t;
+
+static apr_status_t set_error(apr_dbm_t *dbm, apr_status_t dbm_said)
+{
+    dbm->errcode = dbm_said;
+
+    if (dbm_said != APR_SUCCESS) {
+        dbm->errmsg = apr_psprintf(dbm->pool, "%pm", &dbm_said);
+    } else {
+        dbm->errmsg = NULL;
+    }
+
+    return dbm_said;
+}
+
+static apr_uint32_t cdb_hash(const char *key, apr_size_t len)
+{
+    const unsigned char *k = (const unsigned char *)key;
+    apr_uint32_t h = 5381;
+
+    while (len--)
+        h = ((h << 5) + h) ^ *k++;
+    return h;
+}
+
+static apr_uint32_t cdb_unpack(const unsigned char *b)
+{
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((apr_uint32_t)b[3] << 24);
+}
+
+static void cdb_pack(unsigned char *b, apr_uint32_t n)
+{
+    b[0] = (unsigned char)n;
+    b[1] = (unsigned char)(n >> 8);
+    b[2] = (unsigned char)(n >> 16);
+    b[3] = (unsigned char)(n >> 24);
+}
+
+/* the record at pos, or APR_EGENERAL if it runs past the records */
+static apr_status_t cdb_record(cdb_t *db, apr_uint32_t pos,
+                               apr_datum_t *key, apr_datum_t *val)
+{
+    apr_uint32_t klen, vlen;
+
+    if (pos < CDB_HEADER || pos > db->eod || db->eod - pos < 8)
+        return APR_EGENERAL;
+    klen = cdb_unpack(db->map + pos);
+    vlen = cdb_unpack(db->map + pos + 4);
+    if (klen > db->eod - pos - 8 || vlen > db->eod - pos - 8 - klen)
+        return APR_EGENERAL;
+
+    key->dptr = (char *)db->map + pos + 8;
+    key->dsize = klen;
+    if (val) {
+        val->dptr = key->dptr + klen;
+        val->dsize = vlen;
+    }
+    return APR_SUCCESS;
+}
+
+static apr_status_t cdb_find(cdb_t *db, apr_datum_t key, apr_datum_t *pvalue)
+{
+    apr_uint32_t h = cdb_hash(key.dptr, key.dsize);
+    const unsigned char *hdr = db->map + (h & 255) * 8;
+    apr_uint32_t hpos = cdb_unpack(hdr);
+    apr_uint32_t nslots = cdb_unpack(hdr + 4);
+    apr_uint32_t slot, n, pos;
+    apr_datum_t rk;
+    apr_status_t rv;
+
+    pvalue->dptr = NULL;
+    pvalue->dsize = 0;
+
+    if (nslots == 0)
+        return APR_SUCCESS;
+    if (hpos < db->eod || hpos > db->size || nslots > (db->size - hpos) / 8)
+        return APR_EGENERAL;
+
+    slot = (h >> 8) % nslots;
+    for (n = 0; n < nslots; n++) {
+        const unsigned char *s = db->map + hpos + (apr_size_t)slot * 8;
+
+        if ((pos = cdb_unpack(s + 4)) == 0)
+            break;
+        if (cdb_unpack(s) == h) {
+            if ((rv = cdb_record(db, pos, &rk, pvalue)) != APR_SUCCESS)
+                return rv;
+            if (rk.dsize == key.dsize && !memcmp(rk.dptr, key.dptr, key.dsize))
+                return APR_SUCCESS;
+        }
+        if (++slot == nslots)
+            slot = 0;
+    }
+
+    pvalue->dptr = NULL;
+    pvalue->dsize = 0;
+    return APR_SUCCESS;
+}
+
+static void cdb_unmap(cdb_t *db)
+{
+#if APR_HAS_MMAP
+    if (db->mm) {
+        apr_mmap_delete(db->mm);
+        db->mm = NULL;
+    }
+#endif
+    if (db->mpool) {
+        apr_pool_destroy(db->mpool);
+        db->mpool = NULL;
+    }
+    db->map = NULL;
+}
+
+static apr_status_t cdb_map(cdb_t *db, const char *pathname, apr_pool_t *pool)
+{
+    apr_file_t *f;
+    apr_finfo_t finfo;
+    apr_status_t rv;
+
+    if ((rv = apr_pool_create(&db->mpool, pool)) != APR_SUCCESS)
+        return rv;
+
+    rv = apr_file_open(&f, pathname, APR_FOPEN_READ | APR_FOPEN_BINARY,
+                       APR_OS_DEFAULT, db->mpool);
+    if (rv != APR_SUCCESS) {
+        cdb_unmap(db);
+        return rv;
+    }
+    if ((rv = apr_file_info_get(&finfo, APR_FINFO_SIZE, f)) != APR_SUCCESS) {
+        cdb_unmap(db);
+        return rv;
+    }
+    if (finfo.size < CDB_HEADER || finfo.size > CDB_MAXPOS) {
+        cdb_unmap(db);
+        return APR_EGENERAL;
+    }
+    db->size = (apr_size_t)finfo.size;
+
+#if APR_HAS_MMAP
+    if (apr_mmap_create(&db->mm, f, 0, db->size, APR_MMAP_READ,
+                        db->mpool) == APR_SUCCESS)
+        db->map = db->mm->mm;
+    else
+        db->mm = NULL;
+#endif
+    if (db->map == NULL) {
+        unsigned char *buf = apr_palloc(db->mpool, db->size);
+
+        if ((rv = apr_file_read_full(f, buf, db->size, NULL)) != APR_SUCCESS) {
+            cdb_unmap(db);
+            return rv;
+        }
+        db->map = buf;
+    }
+    apr_file_close(f);
+
+    /* the first hash table follows the last record */
+    db->eod = cdb_unpack(db->map);
+    if (db->eod < CDB_HEADER || db->eod > db->size) {
+        cdb_unmap(db);
+        return APR_EGENERAL;
+    }
+
+    return APR_SUCCESS;
+}
+
+static apr_status_t cdb_load(cdb_t *db, apr_pool_t *pool)
+{
+    apr_uint32_t pos = CDB_HEADER;
+    apr_datum_t key, val, *v;
+    apr_status_t rv;
+
+    while (pos < db->eod) {
+        if ((rv = cdb_record(db, pos, &key, &val)) != APR_SUCCESS)
+            return rv;
+        pos = (apr_uint32_t)(val.dptr + val.dsize - (char *)db->map);
+
+        v = apr_palloc(pool, sizeof(*v));
+        v->dptr = apr_pmemdup(pool, val.dptr, val.dsize);
+        v->dsize = val.dsize;
+        apr_hash_set(db->recs, apr_pmemdup(pool, key.dptr, key.dsize),
+                     key.dsize, v);
+    }
+
+    cdb_unmap(db);
+    return APR_SUCCESS;
+}
+
+static apr_status_t cdb_write_slots(apr_file_t *f, unsigned char *slots,
+                                    apr_uint32_t *hashes, apr_uint32_t *poss,
+                                    apr_uint32_t n)
+{
+    apr_uint32_t i, slot, nslots = n * 2;
+
+    memset(slots, 0, (apr_size_t)nslots * 8);
+    for (i = 0; i < n; i++) {
+        slot = (hashes[i] >> 8) % nslots;
+        while (cdb_unpack(slots + (apr_size_t)slot * 8 + 4) != 0)
+            if (++slot == nslots)
+                slot = 0;
+        cdb_pack(slots + (apr_size_t)slot * 8, hashes[i]);
+        cdb_pack(slots + (apr_size_t)slot * 8 + 4, poss[i]);
+    }
+    return apr_file_write_full(f, slots, (apr_size_t)nslots * 8, NULL);
+}
+
+static apr_status_t cdb_write_file(cdb_t *db, apr_file_t *f, apr_pool_t *p)
+{
+    unsigned char header[CDB_HEADER], rechdr[8], *slots;
+    apr_uint32_t count[256], start[256], fill[256];
+    apr_uint32_t *hashes, *poss, *bhashes, *bposs;
+    apr_uint32_t i, n, b, maxcount = 0;
+    apr_uint64_t pos = CDB_HEADER;
+    apr_hash_index_t *hi;
+    apr_off_t off = 0;
+    apr_status_t rv;
+
+    n = apr_hash_count(db->recs);
+    hashes = apr_palloc(p, (n + 1) * sizeof(*hashes));
+    poss = apr_palloc(p, (n + 1) * sizeof(*poss));
+    memset(count, 0, sizeof(count));
+
+    memset(header, 0, sizeof(header));
+    if ((rv = apr_file_write_full(f, header, sizeof(header), NULL))
+            != APR_SUCCESS)
+        return rv;
+
+    for (i = 0, hi = apr_hash_first(p, db->recs); hi;
+         hi = apr_hash_next(hi), i++) {
+        const void *k;
+        apr_ssize_t klen;
+        void *v;
+        apr_datum_t *val;
+
+        apr_hash_this(hi, &k, &klen, &v);
+        val = v;
+        if (pos + 8 + klen + val->dsize > CDB_MAXPOS)
+            return APR_ENOSPC;
+
+        hashes[i] = cdb_hash(k, klen);
+        poss[i] = (apr_uint32_t)pos;
+        count[hashes[i] & 255]++;
+
+        cdb_pack(rechdr, (apr_uint32_t)klen);
+        cdb_pack(rechdr + 4, (apr_uint32_t)val->dsize);
+        if ((rv = apr_file_write_full(f, rechdr, 8, NULL)) != APR_SUCCESS
+            || (rv = apr_file_write_full(f, k, klen, NULL)) != APR_SUCCESS
+            || (rv = apr_file_write_full(f, val->dptr, val->dsize, NULL))
+                   != APR_SUCCESS)
+            return rv;
+        pos += 8 + klen + val->dsize;
+    }
+
+    /* group the slots by table */
+    bhashes = apr_palloc(p, (n + 1) * sizeof(*bhashes));
+    bposs = apr_palloc(p, (n + 1) * sizeof(*bposs));
+    for (b = 0, i = 0; b < 256; b++) {
+        start[b] = fill[b] = i;
+        i += count[b];
+        if (count[b] > maxcount)
+            maxcount = count[b];
+    }
+    for (i = 0; i < n; i++) {
+        b = hashes[i] & 255;
+        bhashes[fill[b]] = hashes[i];
+        bposs[fill[b]++] = poss[i];
+    }
+
+    slots = apr_palloc(p, (apr_size_t)maxcount * 16 + 1);
+    for (b = 0; b < 256; b++) {
+        if (pos + (apr_uint64_t)count[b] * 16 > CDB_MAXPOS)
+            return APR_ENOSPC;
+        cdb_pack(header + b * 8, (apr_uint32_t)pos);
+        cdb_pack(header + b * 8 + 4, count[b] * 2);
+        if (count[b] == 0)
+            continue;
+        if ((rv = cdb_write_slots(f, slots, bhashes + start[b],
+                                  bposs + start[b], count[b])) != APR_SUCCESS)
+            return rv;
+        pos += (apr_uint64_t)count[b] * 16;
+    }
+
+    if ((rv = apr_file_seek(f, APR_SET, &off)) != APR_SUCCESS
+        || (rv = apr_file_write_full(f, header, sizeof(header), NULL))
+               != APR_SUCCESS
+        || (rv = apr_file_flush(f)) != APR_SUCCESS)
+        return rv;
+
+    rv = apr_file_sync(f);
+    return rv == APR_ENOTIMPL ? APR_SUCCESS : rv;
+}
+
+/* write the records to a temporary file, then rename it into place */
+static apr_status_t cdb_write(cdb_t *db, apr_pool_t *pool)
+{
+    apr_pool_t *p;
+    apr_file_t *f;
+    char *tmpname;
+    apr_status_t rv;
+
+    if ((rv = apr_pool_create(&p, pool)) != APR_SUCCESS)
+        return rv;
+
+    tmpname = apr_pstrcat(p, db->name, ".XXXXXX", NULL);
+    rv = apr_file_mktemp(&f, tmpname, APR_FOPEN_CREATE | APR_FOPEN_READ
+                         | APR_FOPEN_WRITE | APR_FOPEN_EXCL
+                         | APR_FOPEN_BUFFERED | APR_FOPEN_BINARY, p);
+    if (rv != APR_SUCCESS) {
+        apr_pool_destroy(p);
+        return rv;
+    }
+
+    rv = cdb_write_file(db, f, p);
+    if (rv == APR_SUCCESS)
+        rv = apr_file_close(f);
+    else
+        apr_file_close(f);
+
+    if (rv == APR_SUCCESS) {
+        apr_status_t prv = apr_file_perms_set(tmpname, db->perm);
+
+        if (prv != APR_SUCCESS && prv != APR_INCOMPLETE
+            && prv != APR_ENOTIMPL)
+            rv = prv;
+    }
+    if (rv == APR_SUCCESS)
+        rv = apr_file_rename(tmpname, db->name, p);
+    if (rv != APR_SUCCESS)
+        apr_file_remove(tmpname, p);
+
+    apr_pool_destroy(p);
+    return rv;
+}
+
+/* --------------------------------------------------------------------------
+**
+** DEFINE THE VTABLE FUNCTIONS FOR CDB
+*/
+
+static apr_status_t vt_cdb_open(apr_dbm_t **pdb, const char *pathname,
+                                apr_int32_t mode, apr_fileperms_t perm,
+                                apr_pool_t *pool)
+{
+    cdb_t *db;
+    apr_status_t rv = APR_SUCCESS;
+
+    *pdb = NULL;
+
+    db = apr_pcalloc(pool, sizeof(*db));
+
+    switch (mode) {
+    case APR_DBM_READONLY:
+        rv = cdb_map(db, pathname, pool);
+        break;
+    case APR_DBM_READWRITE:
+    case APR_DBM_RWCREATE:
+        db->recs = apr_hash_make(pool);
+        rv = cdb_map(db, pathname, pool);
+        if (rv == APR_SUCCESS) {
+            rv = cdb_load(db, pool);
+            if (rv != APR_SUCCESS)
+                cdb_unmap(db);
+        }
+        else if (APR_STATUS_IS_ENOENT(rv) && mode == APR_DBM_RWCREATE) {
+            /* written out on close even if nothing is stored */
+            db->dirty = 1;
+            rv = APR_SUCCESS;
+        }
+        break;
+    case APR_DBM_RWTRUNC:
+        db->recs = apr_hash_make(pool);
+        db->dirty = 1;
+        break;
+    default:
+        return APR_EINVAL;
+    }
+    if (rv != APR_SUCCESS)
+        return rv;
+
+    db->name = apr_pstrdup(pool, pathname);
+    db->perm = perm;
+
+    /* we have an open database... return it */
+    *pdb = apr_pcalloc(pool, sizeof(**pdb));
+    (*pdb)->pool = pool;
+    (*pdb)->type = &apr_dbm_type_cdb;
+    (*pdb)->file = db;
+
+    return APR_SUCCESS;
+}
+
+static void vt_cdb_close(apr_dbm_t *dbm)
+{
+    cdb_t *db = dbm->file;
+
+    /* ### there is no way to report a failure here; the original
+     * ### contents are left in place when one happens */
+    if (db->recs && db->dirty)
+        set_error(dbm, cdb_write(db, dbm->pool));
+    cdb_unmap(db);
+}
+
+static apr_status_t vt_cdb_fetch(apr_dbm_t *dbm, apr_datum_t key,
+                                 apr_datum_t *pvalue)
+{
+    cdb_t *db = dbm->file;
+    apr_datum_t *v;
+
+    if (db->recs) {
+        v = apr_hash_get(db->recs, key.dptr, key.dsize);
+        pvalue->dptr = v ? v->dptr : NULL;
+        pvalue->dsize = v ? v->dsize : 0;
+        return set_error(dbm, APR_SUCCESS);
+    }
+
+    return set_error(dbm, cdb_find(db, key, pvalue));
+}
+
+static apr_status_t vt_cdb_store(apr_dbm_t *dbm, apr_datum_t key,
+                                 apr_datum_t value)
+{
+    cdb_t *db = dbm->file;
+    apr_datum_t *v;
+    const void *k = key.dptr;
+
+    if (db->recs == NULL || key.dsize > CDB_MAXPOS
+        || value.dsize > CDB_MAXPOS)
+        return set_error(dbm, APR_EINVAL);
+
+    v = apr_hash_get(db->recs, key.dptr, key.dsize);
+    if (v == NULL) {
+        v = apr_palloc(dbm->pool, sizeof(*v));
+        k = apr_pmemdup(dbm->pool, key.dptr, key.dsize);
+    }
+    v->dptr = apr_pmemdup(dbm->pool, value.dptr, value.dsize);
+    v->dsize = value.dsize;
+    apr_hash_set(db->recs, k, key.dsize, v);
+    db->dirty = 1;
+
+    return set_error(dbm, APR_SUCCESS);
+}
+
+static apr_status_t vt_cdb_del(apr_dbm_t *dbm, apr_datum_t key)
+{
+    cdb_t *db = dbm->file;
+
+    if (db->recs == NULL)
+        return set_error(dbm, APR_EINVAL);
+
+    apr_hash_set(db->recs, key.dptr, key.dsize, NULL);
+    db->dirty = 1;
+
+    return set_error(dbm, APR_SUCCESS);
+}
+
+static int vt_cdb_exists(apr_dbm_t *dbm, apr_datum_t key)
+{
+    cdb_t *db = dbm->file;
+    apr_datum_t val;
+
+    if (db->recs)
+        return apr_hash_get(db->recs, key.dptr, key.dsize) != NULL;
+
+    return cdb_find(db, key, &val) == APR_SUCCESS && val.dptr != NULL;
+}
+
+static apr_status_t cdb_key(apr_dbm_t *dbm, apr_datum_t *pkey)
+{
+    cdb_t *db = dbm->file;
+    apr_datum_t val;
+    apr_status_t rv;
+
+    pkey->dptr = NULL;
+    pkey->dsize = 0;
+
+    if (db->recs) {
+        if (db->hi) {
+            const void *k;
+            apr_ssize_t klen;
+
+            apr_hash_this(db->hi, &k, &klen, NULL);
+            pkey->dptr = (char *)k;
+            pkey->dsize = klen;
+            db->hi = apr_hash_next(db->hi);
+        }
+        return set_error(dbm, APR_SUCCESS);
+    }
+
+    if (db->cursor >= db->eod)
+        return set_error(dbm, APR_SUCCESS);
+    if ((rv = cdb_record(db, db->cursor, pkey, &val)) != APR_SUCCESS) {
+        pkey->dptr = NULL;
+        pkey->dsize = 0;
+        return set_error(dbm, rv);
+    }
+    db->cursor = (apr_uint32_t)(val.dptr + val.dsize - (char *)db->map);
+
+    return set_error(dbm, APR_SUCCESS);
+}
+
+static apr_status_t vt_cdb_firstkey(apr_dbm_t *dbm, apr_datum_t *pkey)
+{
+    cdb_t *db = dbm->file;
+
+    if (db->recs)
+        db->hi = apr_hash_first(dbm->pool, db->recs);
+    else
+        db->cursor = CDB_HEADER;
+
+    return cdb_key(dbm, pkey);
+}
+
+static apr_status_t vt_cdb_nextkey(apr_dbm_t *dbm, apr_datum_t *pkey)
+{
+    return cdb_key(dbm, pkey);
+}
+
+static void vt_cdb_freedatum(apr_dbm_t *dbm, apr_datum_t data)
+{
+}
+
+static void vt_cdb_usednames(apr_pool_t *pool, const char *pathname,
+                             const char **used1, const char **used2)
+{
+    *used1 = apr_pstrdup(pool, pathname);
+    *used2 = NULL;
+}
+
+APR_MODULE_DECLARE_DATA const apr_dbm_type_t apr_dbm_type_cdb = {
+    "cdb",
+    vt_cdb_open,
+    vt_cdb_close,
+    vt_cdb_fetch,
+    vt_cdb_store,
+    vt_cdb_del,
+    vt_cdb_exists,
+    vt_cdb_firstkey,
+    vt_cdb_nextkey,
+    vt_cdb_freedatum,
+    vt_cdb_usednames
+};
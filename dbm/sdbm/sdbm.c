@@ -41,6 +41,7 @@
 static int getdbit (apr_sdbm_t *, long);
 static apr_status_t setdbit(apr_sdbm_t *, long);
 static apr_status_t getpage(apr_sdbm_t *db, long);
+static apr_status_t read_page(apr_sdbm_t *db, long);
 static apr_status_t getnext(apr_sdbm_datum_t *key, apr_sdbm_t *db);
 static apr_status_t makroom(apr_sdbm_t *, long, int);
 
@@ -66,6 +67,12 @@ static const long masks[] = {
 
 const apr_sdbm_datum_t sdbm_nullitem = { NULL, 0 };
 
+/* what pages past the end of a mapped page file read as */
+static const short empty_page[PBLKSIZ / sizeof(short)];
+
+/* directory blocks cached for every page cached by apr_sdbm_cache_set */
+#define DIR_CACHE_RATIO 8
+
 static apr_status_t database_cleanup(void *data)
 {
     apr_sdbm_t *db = data;
@@ -76,13 +83,40 @@ static apr_status_t database_cleanup(void *data)
      */
     if (db->flags & (SDBM_SHARED_LOCK | SDBM_EXCLUSIVE_LOCK))
         (void) apr_file_unlock(db->dirf);
+#if APR_HAS_MMAP
+    if (db->dirmap)
+        (void) apr_mmap_delete(db->dirmap);
+    if (db->pagmap)
+        (void) apr_mmap_delete(db->pagmap);
+#endif
     (void) apr_file_close(db->dirf);
     (void) apr_file_close(db->pagf);
+    if (db->pagcache)
+        sdbm_cache_destroy(db->pagcache);
+    if (db->dircache)
+        sdbm_cache_destroy(db->dircache);
     free(db);
 
     return APR_SUCCESS;
 }
 
+#if APR_HAS_MMAP
+/*
+ * map a whole file, leaving *mm NULL if it is empty or can't be mapped;
+ * the database then simply reads it block by block.
+ */
+static void map_file(apr_mmap_t **mm, apr_file_t *f, apr_pool_t *p)
+{
+    apr_finfo_t finfo;
+
+    *mm = NULL;
+    if (apr_file_info_get(&finfo, APR_FINFO_SIZE, f) == APR_SUCCESS
+        && finfo.size > 0 && (apr_size_t)finfo.size == finfo.size)
+        (void) apr_mmap_create(mm, f, 0, (apr_size_t)finfo.size,
+                               APR_MMAP_READ, p);
+}
+#endif
+
 static apr_status_t prep(apr_sdbm_t **pdb, const char *dirname, const char *pagname,
                          apr_int32_t flags, apr_fileperms_t perms, apr_pool_t *p)
 {
@@ -95,6 +129,7 @@ static apr_status_t prep(apr_sdbm_t **pdb, const char *dirname, const char *pagn
     memset(db, 0, sizeof(*db));
 
     db->pool = p;
+    db->pagp = db->pagbuf;
 
     /*
      * adjust user flags so that WRONLY becomes RDWR, 
@@ -118,6 +153,16 @@ static apr_status_t prep(apr_sdbm_t **pdb, const char *dirname, const char *pagn
 
     flags |= APR_FOPEN_BINARY | APR_FOPEN_READ;
 
+#if APR_HAS_MMAP
+    /*
+     * a read-only database opened without APR_SHARELOCK keeps its shared
+     * lock until closed, so nobody can change it under a mapping of it.
+     * Buffered files can't be mapped, and don't need to be.
+     */
+    if ((db->flags & (SDBM_RDONLY | SDBM_SHARED)) == SDBM_RDONLY)
+        flags &= ~APR_FOPEN_BUFFERED;
+#endif
+
     /*
      * open the files in sequence, and stat the dirfile.
      * If we fail anywhere, undo everything, return NULL.
@@ -148,6 +193,13 @@ static apr_status_t prep(apr_sdbm_t **pdb, const char *dirname, const char *pagn
         if ((status = apr_sdbm_unlock(db)) != APR_SUCCESS)
             goto error;
 
+#if APR_HAS_MMAP
+    if ((db->flags & (SDBM_RDONLY | SDBM_SHARED)) == SDBM_RDONLY) {
+        map_file(&db->dirmap, db->dirf, p);
+        map_file(&db->pagmap, db->pagf, p);
+    }
+#endif
+
     /* make sure that we close the database at some point */
     apr_pool_cleanup_register(p, db, database_cleanup, apr_pool_cleanup_null);
 
@@ -182,6 +234,36 @@ APR_DECLARE(apr_status_t) apr_sdbm_close(apr_sdbm_t *db)
     return apr_pool_cleanup_run(db->pool, db, database_cleanup);
 }
 
+APR_DECLARE(apr_status_t) apr_sdbm_cache_set(apr_sdbm_t *db, int npages)
+{
+    sdbm_cache_t *pagcache = NULL, *dircache = NULL;
+
+    if (db == NULL || npages < 0)
+        return APR_EINVAL;
+
+    if (npages) {
+        pagcache = sdbm_cache_create(npages, PBLKSIZ);
+        dircache = sdbm_cache_create((npages + DIR_CACHE_RATIO - 1)
+                                     / DIR_CACHE_RATIO, DBLKSIZ);
+        if (pagcache == NULL || dircache == NULL) {
+            if (pagcache)
+                sdbm_cache_destroy(pagcache);
+            if (dircache)
+                sdbm_cache_destroy(dircache);
+            return APR_ENOMEM;
+        }
+    }
+
+    if (db->pagcache)
+        sdbm_cache_destroy(db->pagcache);
+    if (db->dircache)
+        sdbm_cache_destroy(db->dircache);
+    db->pagcache = pagcache;
+    db->dircache = dircache;
+
+    return APR_SUCCESS;
+}
+
 APR_DECLARE(apr_status_t) apr_sdbm_fetch(apr_sdbm_t *db, apr_sdbm_datum_t *val,
                                          apr_sdbm_datum_t key)
 {
@@ -194,7 +276,7 @@ APR_DECLARE(apr_status_t) apr_sdbm_fetch(apr_sdbm_t *db, apr_sdbm_datum_t *val,
         return status;
 
     if ((status = getpage(db, exhash(key))) == APR_SUCCESS) {
-        *val = getpair(db->pagbuf, key);
+        *val = getpair(db->pagp, key);
         /* ### do we want a not-found result? */
     }
 
@@ -211,6 +293,9 @@ static apr_status_t write_page(apr_sdbm_t *db, const char *buf, long pagno)
     if ((status = apr_file_seek(db->pagf, APR_SET, &off)) == APR_SUCCESS)
         status = apr_file_write_full(db->pagf, buf, PBLKSIZ, NULL);
 
+    if (status == APR_SUCCESS && db->pagcache)
+        sdbm_cache_put(db->pagcache, pagno, buf);
+
     return status;
 }
 
@@ -410,8 +495,7 @@ APR_DECLARE(apr_status_t) apr_sdbm_firstkey(apr_sdbm_t *db,
     /*
      * start at page 0
      */
-    if ((status = read_from(db->pagf, db->pagbuf, OFF_PAG(0), PBLKSIZ))
-                == APR_SUCCESS) {
+    if ((status = read_page(db, 0)) == APR_SUCCESS) {
         db->pagbno = 0;
         db->blkptr = 0;
         db->keyptr = 0;
@@ -470,11 +554,10 @@ static apr_status_t getpage(apr_sdbm_t *db, long hash)
          * ### joe: this assumption was surely never correct? but
          * ### we make it so in read_from anyway.
          */
-        if ((status = read_from(db->pagf, db->pagbuf, OFF_PAG(pagb), PBLKSIZ)) 
-                    != APR_SUCCESS)
+        if ((status = read_page(db, pagb)) != APR_SUCCESS)
             return status;
 
-        if (!chkpage(db->pagbuf))
+        if (!chkpage(db->pagp))
             return APR_ENOSPC; /* ### better error? */
         db->pagbno = pagb;
 
@@ -483,22 +566,93 @@ static apr_status_t getpage(apr_sdbm_t *db, long hash)
     return APR_SUCCESS;
 }
 
+/*
+ * make page pagno current: db->pagp points into the mapping of a
+ * read-only database, or else at pagbuf, filled from the page cache or
+ * the page file.  The caller sets db->pagbno once it accepts the page.
+ */
+static apr_status_t read_page(apr_sdbm_t *db, long pagno)
+{
+    const char *cached;
+    apr_status_t status;
+
+    /* db->pagp no longer holds db->pagbno, whatever happens */
+    db->pagbno = -1;
+
+#if APR_HAS_MMAP
+    if (db->pagmap) {
+        apr_off_t off = OFF_PAG(pagno);
+
+        if (off + PBLKSIZ <= (apr_off_t)db->pagmap->size)
+            db->pagp = (char *)db->pagmap->mm + off;
+        else
+            db->pagp = (char *)empty_page;
+        return APR_SUCCESS;
+    }
+#endif
+
+    db->pagp = db->pagbuf;
+    if (db->pagcache
+        && (cached = sdbm_cache_get(db->pagcache, pagno)) != NULL) {
+        (void) memcpy(db->pagbuf, cached, PBLKSIZ);
+        return APR_SUCCESS;
+    }
+    if ((status = read_from(db->pagf, db->pagbuf, OFF_PAG(pagno), PBLKSIZ))
+                != APR_SUCCESS)
+        return status;
+    if (db->pagcache)
+        sdbm_cache_put(db->pagcache, pagno, db->pagbuf);
+
+    return APR_SUCCESS;
+}
+
+/*
+ * load directory block dirb into dirbuf, from the cache if possible
+ */
+static apr_status_t read_dir(apr_sdbm_t *db, long dirb)
+{
+    const char *cached;
+    apr_status_t status;
+
+    if (db->dircache
+        && (cached = sdbm_cache_get(db->dircache, dirb)) != NULL) {
+        (void) memcpy(db->dirbuf, cached, DBLKSIZ);
+    }
+    else {
+        db->dirbno = -1;
+        if ((status = read_from(db->dirf, db->dirbuf, OFF_DIR(dirb), DBLKSIZ))
+                    != APR_SUCCESS)
+            return status;
+        if (db->dircache)
+            sdbm_cache_put(db->dircache, dirb, db->dirbuf);
+
+        debug(("dir read: %d\n", dirb));
+    }
+    db->dirbno = dirb;
+
+    return APR_SUCCESS;
+}
+
 static int getdbit(apr_sdbm_t *db, long dbit)
 {
     register long c;
     register long dirb;
 
     c = dbit / BYTESIZ;
-    dirb = c / DBLKSIZ;
 
-    if (dirb != db->dirbno) {
-        if (read_from(db->dirf, db->dirbuf, OFF_DIR(dirb), DBLKSIZ)
-                    != APR_SUCCESS)
+#if APR_HAS_MMAP
+    if (db->dirmap) {
+        if ((apr_size_t)c >= db->dirmap->size)
             return 0;
+        return ((char *)db->dirmap->mm)[c] & (1 << dbit % BYTESIZ);
+    }
+#endif
 
-        db->dirbno = dirb;
+    dirb = c / DBLKSIZ;
 
-        debug(("dir read: %d\n", dirb));
+    if (dirb != db->dirbno) {
+        if (read_dir(db, dirb) != APR_SUCCESS)
+            return 0;
     }
 
     return db->dirbuf[c % DBLKSIZ] & (1 << dbit % BYTESIZ);
@@ -515,13 +669,8 @@ static apr_status_t setdbit(apr_sdbm_t *db, long dbit)
     dirb = c / DBLKSIZ;
 
     if (dirb != db->dirbno) {
-        if ((status = read_from(db->dirf, db->dirbuf, OFF_DIR(dirb), DBLKSIZ))
-                    != APR_SUCCESS)
+        if ((status = read_dir(db, dirb)) != APR_SUCCESS)
             return status;
-
-        db->dirbno = dirb;
-        
-        debug(("dir read: %d\n", dirb));
     }
 
     db->dirbuf[c % DBLKSIZ] |= (1 << dbit % BYTESIZ);
@@ -533,6 +682,9 @@ static apr_status_t setdbit(apr_sdbm_t *db, long dbit)
     if ((status = apr_file_seek(db->dirf, APR_SET, &off)) == APR_SUCCESS)
         status = apr_file_write_full(db->dirf, db->dirbuf, DBLKSIZ, NULL);
 
+    if (status == APR_SUCCESS && db->dircache)
+        sdbm_cache_put(db->dircache, dirb, db->dirbuf);
+
     return status;
 }
 
@@ -543,30 +695,43 @@ static apr_status_t setdbit(apr_sdbm_t *db, long dbit)
 static apr_status_t getnext(apr_sdbm_datum_t *key, apr_sdbm_t *db)
 {
     apr_status_t status;
+    apr_off_t off;
+
     for (;;) {
         db->keyptr++;
-        *key = getnkey(db->pagbuf, db->keyptr);
+        *key = getnkey(db->pagp, db->keyptr);
         if (key->dptr != NULL)
             return APR_SUCCESS;
         /*
          * we either run out, or there is nothing on this page..
-         * try the next one... If we lost our position on the
-         * file, we will have to seek.
+         * try the next one...  The page cache may have been used
+         * since, so don't rely on the position in the file.
          */
         db->keyptr = 0;
-        if (db->pagbno != db->blkptr++) {
-            apr_off_t off = OFF_PAG(db->blkptr);
+        off = OFF_PAG(++db->blkptr);
+
+#if APR_HAS_MMAP
+        if (db->pagmap) {
+            if (off + PBLKSIZ > (apr_off_t)db->pagmap->size)
+                return APR_EOF;
+            db->pagp = (char *)db->pagmap->mm + off;
+            db->pagbno = db->blkptr;
+        }
+        else
+#endif
+        {
+            db->pagbno = -1;
             if ((status = apr_file_seek(db->pagf, APR_SET, &off))
                         != APR_SUCCESS)
                 return status;
-        }
 
-        db->pagbno = db->blkptr;
-        /* ### EOF acceptable here too? */
-        if ((status = apr_file_read_full(db->pagf, db->pagbuf, PBLKSIZ, NULL))
-                    != APR_SUCCESS)
-            return status;
-        if (!chkpage(db->pagbuf))
+            /* ### EOF acceptable here too? */
+            if ((status = apr_file_read_full(db->pagf, db->pagbuf, PBLKSIZ,
+                                             NULL)) != APR_SUCCESS)
+                return status;
+            db->pagbno = db->blkptr;
+        }
+        if (!chkpage(db->pagp))
             return APR_EGENERAL;     /* ### need better error */
     }
 
@@ -0,0 +1,306 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * sdbm - ndbm work-alike hashed database library
+ * bulk builder: instead of splitting pages as records arrive, all the
+ * records are sorted by their hash, least significant bit first, so that
+ * every subtree of the directory is a contiguous run of them.  Each run
+ * that fits a page is written out once; every other one is split, its
+ * directory bit set, and its two halves handled the same way.
+ */
+
+#include "apr.h"
+#include "apr_file_io.h"
+#include "apr_strings.h"
+#include "apr_errno.h"
+#include "apr_sdbm.h"
+
+#include "sdbm_tune.h"
+#include "sdbm_pair.h"
+#include "sdbm_private.h"
+
+#include <string.h>     /* for memcpy() and memcmp() */
+#include <stdlib.h>     /* for malloc(), realloc(), free() and qsort() */
+
+#define exhash(item)	sdbm_hash((item).dptr, (item).dsize)
+
+/* records are copied into chunks of this size */
+#define CHUNK_SIZE (64 * 1024)
+
+/* the deepest split getpage() can follow */
+#define MAX_DEPTH 31
+
+typedef struct {
+    apr_uint32_t order;         /* hash, bit reversed */
+    apr_uint32_t seq;           /* arrival, the last duplicate wins */
+    char *data;                 /* key followed by value */
+    int ksize;
+    int vsize;
+} build_rec_t;
+
+struct apr_sdbm_builder_t {
+    apr_pool_t *pool;           /* subpool holding the record chunks */
+    apr_file_t *dirf;
+    apr_file_t *pagf;
+    build_rec_t *recs;
+    apr_size_t nrecs;
+    apr_size_t nalloc;
+    char *chunk;
+    apr_size_t chunk_left;
+    unsigned char *dir;         /* directory bitmap */
+    apr_size_t dirsize;
+    long maxdbit;               /* highest bit set in dir, or -1 */
+};
+
+static apr_uint32_t reverse_bits(apr_uint32_t v)
+{
+    v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+    v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
+    v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+    return (v >> 16) | (v << 16);
+}
+
+static int compare_recs(const void *a, const void *b)
+{
+    const build_rec_t *ra = a, *rb = b;
+    int cmp;
+
+    if (ra->order != rb->order)
+        return ra->order < rb->order ? -1 : 1;
+    if (ra->ksize != rb->ksize)
+        return ra->ksize < rb->ksize ? -1 : 1;
+    if ((cmp = memcmp(ra->data, rb->data, ra->ksize)) != 0)
+        return cmp;
+    return ra->seq < rb->seq ? -1 : 1;
+}
+
+static apr_status_t builder_cleanup(void *data)
+{
+    apr_sdbm_builder_t *b = data;
+
+    if (b->dirf) {
+        (void) apr_file_close(b->dirf);
+        b->dirf = NULL;
+    }
+    if (b->pagf) {
+        (void) apr_file_close(b->pagf);
+        b->pagf = NULL;
+    }
+    free(b->recs);
+    b->recs = NULL;
+    free(b->dir);
+    b->dir = NULL;
+
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_sdbm_build_create(apr_sdbm_builder_t **builder,
+                                                const char *name,
+                                                apr_fileperms_t perms,
+                                                apr_pool_t *p)
+{
+    apr_sdbm_builder_t *b;
+    apr_int32_t flags = APR_FOPEN_WRITE | APR_FOPEN_CREATE
+                      | APR_FOPEN_TRUNCATE | APR_FOPEN_BINARY;
+    apr_status_t status;
+
+    b = apr_pcalloc(p, sizeof(*b));
+    b->maxdbit = -1;
+    if ((status = apr_pool_create(&b->pool, p)) != APR_SUCCESS)
+        return status;
+    apr_pool_cleanup_register(p, b, builder_cleanup, apr_pool_cleanup_null);
+
+    if ((status = apr_file_open(&b->dirf,
+                                apr_pstrcat(p, name, APR_SDBM_DIRFEXT, NULL),
+                                flags, perms, p)) != APR_SUCCESS
+        || (status = apr_file_open(&b->pagf,
+                                   apr_pstrcat(p, name, APR_SDBM_PAGFEXT, NULL),
+                                   flags, perms, p)) != APR_SUCCESS) {
+        apr_pool_cleanup_run(p, b, builder_cleanup);
+        return status;
+    }
+
+    *builder = b;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_sdbm_build_add(apr_sdbm_builder_t *b,
+                                             apr_sdbm_datum_t key,
+                                             apr_sdbm_datum_t val)
+{
+    build_rec_t *rec;
+    apr_size_t need;
+
+    if (key.dptr == NULL || key.dsize <= 0 || val.dsize < 0
+        || key.dsize + val.dsize > PAIRMAX)
+        return APR_EINVAL;
+
+    if (b->nrecs == b->nalloc) {
+        apr_size_t n = b->nalloc ? b->nalloc * 2 : 1024;
+        build_rec_t *recs = realloc(b->recs, n * sizeof(*recs));
+
+        if (recs == NULL)
+            return APR_ENOMEM;
+        b->recs = recs;
+        b->nalloc = n;
+    }
+
+    need = key.dsize + val.dsize;
+    if (need > b->chunk_left) {
+        b->chunk = apr_palloc(b->pool, CHUNK_SIZE);
+        b->chunk_left = CHUNK_SIZE;
+    }
+
+    rec = &b->recs[b->nrecs];
+    rec->order = reverse_bits((apr_uint32_t)exhash(key));
+    rec->seq = (apr_uint32_t)b->nrecs++;
+    rec->data = b->chunk;
+    rec->ksize = key.dsize;
+    rec->vsize = val.dsize;
+    memcpy(b->chunk, key.dptr, key.dsize);
+    if (val.dsize)
+        memcpy(b->chunk + key.dsize, val.dptr, val.dsize);
+    b->chunk += need;
+    b->chunk_left -= need;
+
+    return APR_SUCCESS;
+}
+
+static apr_status_t set_dbit(apr_sdbm_builder_t *b, long dbit)
+{
+    apr_size_t c = dbit / BYTESIZ;
+
+    if (c >= b->dirsize) {
+        apr_size_t n = b->dirsize ? b->dirsize : DBLKSIZ;
+        unsigned char *dir;
+
+        while (n <= c)
+            n *= 2;
+        if ((dir = realloc(b->dir, n)) == NULL)
+            return APR_ENOMEM;
+        memset(dir + b->dirsize, 0, n - b->dirsize);
+        b->dir = dir;
+        b->dirsize = n;
+    }
+    b->dir[c] |= 1 << (dbit % BYTESIZ);
+    if (dbit > b->maxdbit)
+        b->maxdbit = dbit;
+
+    return APR_SUCCESS;
+}
+
+static apr_status_t write_leaf(apr_sdbm_builder_t *b, build_rec_t *recs,
+                               apr_size_t n, long pagno)
+{
+    short page[PBLKSIZ / sizeof(short)];
+    apr_sdbm_datum_t key, val;
+    apr_off_t off = (apr_off_t)pagno * PBLKSIZ;
+    apr_size_t i;
+    apr_status_t status;
+
+    if (n == 0)
+        return APR_SUCCESS;     /* holes read as empty pages */
+
+    memset(page, 0, sizeof(page));
+    for (i = 0; i < n; i++) {
+        key.dptr = recs[i].data;
+        key.dsize = recs[i].ksize;
+        val.dptr = recs[i].data + recs[i].ksize;
+        val.dsize = recs[i].vsize;
+        putpair((char *)page, key, val);
+    }
+
+    if ((status = apr_file_seek(b->pagf, APR_SET, &off)) != APR_SUCCESS)
+        return status;
+    return apr_file_write_full(b->pagf, page, PBLKSIZ, NULL);
+}
+
+/*
+ * build the subtree rooted at directory bit dbit, depth levels down,
+ * whose pages are numbered pagno with more bits to the left
+ */
+static apr_status_t build_tree(apr_sdbm_builder_t *b, build_rec_t *recs,
+                               apr_size_t n, long dbit, int depth,
+                               long pagno)
+{
+    apr_size_t i, used = sizeof(short);
+    apr_uint32_t bit;
+    apr_status_t status;
+
+    for (i = 0; i < n; i++) {
+        used += recs[i].ksize + recs[i].vsize + 2 * sizeof(short);
+        if (used > PBLKSIZ)
+            break;
+    }
+    if (i == n)
+        return write_leaf(b, recs, n, pagno);
+
+    if (depth >= MAX_DEPTH)
+        return APR_ENOSPC;      /* as when apr_sdbm_store gives up */
+    if ((status = set_dbit(b, dbit)) != APR_SUCCESS)
+        return status;
+
+    /* the records with hash bit 'depth' clear sort first */
+    bit = (apr_uint32_t)0x80000000 >> depth;
+    for (i = 0; i < n && !(recs[i].order & bit); i++)
+        ;
+
+    if ((status = build_tree(b, recs, i, 2 * dbit + 1, depth + 1,
+                             pagno)) != APR_SUCCESS)
+        return status;
+    return build_tree(b, recs + i, n - i, 2 * dbit + 2, depth + 1,
+                      pagno | (1L << depth));
+}
+
+APR_DECLARE(apr_status_t) apr_sdbm_build_finish(apr_sdbm_builder_t *b)
+{
+    apr_pool_t *p = apr_pool_parent_get(b->pool);
+    apr_size_t i, n = 0;
+    apr_status_t status;
+
+    if (b->nrecs)
+        qsort(b->recs, b->nrecs, sizeof(*b->recs), compare_recs);
+
+    /* of records with the same key, keep the one added last */
+    for (i = 0; i < b->nrecs; i++) {
+        if (i + 1 < b->nrecs
+            && b->recs[i].order == b->recs[i + 1].order
+            && b->recs[i].ksize == b->recs[i + 1].ksize
+            && !memcmp(b->recs[i].data, b->recs[i + 1].data,
+                       b->recs[i].ksize))
+            continue;
+        b->recs[n++] = b->recs[i];
+    }
+
+    status = build_tree(b, b->recs, n, 0, 0, 0);
+
+    if (status == APR_SUCCESS && b->maxdbit >= 0) {
+        /* the directory is written in whole blocks, as setdbit does */
+        apr_size_t len = b->maxdbit / BYTESIZ + 1;
+
+        len = (len + DBLKSIZ - 1) / DBLKSIZ * DBLKSIZ;
+        status = apr_file_write_full(b->dirf, b->dir, len, NULL);
+    }
+    if (status == APR_SUCCESS)
+        status = apr_file_flush(b->pagf);
+
+    apr_pool_destroy(b->pool);
+    apr_pool_cleanup_run(p, b, builder_cleanup);
+
+    return status;
+}
@@ -0,0 +1,173 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * sdbm - ndbm work-alike hashed database library
+ * block cache: the most recently used page or directory blocks, found
+ * through a hash of their block numbers and recycled in LRU order.
+ */
+
+#include "apr.h"
+#include "apr_sdbm.h"
+
+#include "sdbm_private.h"
+
+#include <string.h>     /* for memcpy() */
+#include <stdlib.h>     /* for malloc() and free() */
+
+struct sdbm_cache_t {
+    int nslots;
+    apr_size_t blksize;
+    long mask;                  /* of the bucket array */
+    int head;                   /* most recently used slot */
+    int tail;                   /* next slot to recycle */
+    long *blkno;                /* block held by each slot, or -1 */
+    int *prev;
+    int *next;
+    int *chain;                 /* next slot in the same bucket */
+    int *bucket;                /* first slot of each bucket */
+    char *data;                 /* nslots blocks of blksize bytes */
+};
+
+#define SLOT_DATA(c, i) ((c)->data + (apr_size_t)(i) * (c)->blksize)
+
+sdbm_cache_t *sdbm_cache_create(int nslots, apr_size_t blksize)
+{
+    sdbm_cache_t *c;
+    long nbuckets = 1;
+
+    while (nbuckets < nslots)
+        nbuckets <<= 1;
+
+    c = malloc(sizeof(*c));
+    if (c == NULL)
+        return NULL;
+    c->nslots = nslots;
+    c->blksize = blksize;
+    c->mask = nbuckets - 1;
+    c->blkno = malloc(nslots * sizeof(*c->blkno));
+    c->prev = malloc(nslots * sizeof(*c->prev));
+    c->next = malloc(nslots * sizeof(*c->next));
+    c->chain = malloc(nslots * sizeof(*c->chain));
+    c->bucket = malloc(nbuckets * sizeof(*c->bucket));
+    c->data = malloc(nslots * blksize);
+    if (!c->blkno || !c->prev || !c->next || !c->chain || !c->bucket
+        || !c->data) {
+        sdbm_cache_destroy(c);
+        return NULL;
+    }
+
+    sdbm_cache_clear(c);
+    return c;
+}
+
+void sdbm_cache_destroy(sdbm_cache_t *c)
+{
+    free(c->blkno);
+    free(c->prev);
+    free(c->next);
+    free(c->chain);
+    free(c->bucket);
+    free(c->data);
+    free(c);
+}
+
+void sdbm_cache_clear(sdbm_cache_t *c)
+{
+    int i;
+
+    for (i = 0; i < c->nslots; i++) {
+        c->blkno[i] = -1;
+        c->prev[i] = i - 1;
+        c->next[i] = i + 1;
+    }
+    c->next[c->nslots - 1] = -1;
+    c->head = 0;
+    c->tail = c->nslots - 1;
+    for (i = 0; i <= c->mask; i++)
+        c->bucket[i] = -1;
+}
+
+static void lru_unlink(sdbm_cache_t *c, int i)
+{
+    if (c->prev[i] >= 0)
+        c->next[c->prev[i]] = c->next[i];
+    else
+        c->head = c->next[i];
+    if (c->next[i] >= 0)
+        c->prev[c->next[i]] = c->prev[i];
+    else
+        c->tail = c->prev[i];
+}
+
+static void lru_push(sdbm_cache_t *c, int i)
+{
+    c->prev[i] = -1;
+    c->next[i] = c->head;
+    if (c->head >= 0)
+        c->prev[c->head] = i;
+    else
+        c->tail = i;
+    c->head = i;
+}
+
+static int lookup(sdbm_cache_t *c, long blkno)
+{
+    int i;
+
+    for (i = c->bucket[blkno & c->mask]; i >= 0; i = c->chain[i])
+        if (c->blkno[i] == blkno)
+            return i;
+    return -1;
+}
+
+const char *sdbm_cache_get(sdbm_cache_t *c, long blkno)
+{
+    int i = lookup(c, blkno);
+
+    if (i < 0)
+        return NULL;
+    if (i != c->head) {
+        lru_unlink(c, i);
+        lru_push(c, i);
+    }
+    return SLOT_DATA(c, i);
+}
+
+void sdbm_cache_put(sdbm_cache_t *c, long blkno, const char *buf)
+{
+    int i = lookup(c, blkno);
+    int *p;
+
+    if (i < 0) {
+        /* recycle the least recently used slot */
+        i = c->tail;
+        if (c->blkno[i] >= 0) {
+            for (p = &c->bucket[c->blkno[i] & c->mask]; *p != i;
+                 p = &c->chain[*p])
+                ;
+            *p = c->chain[i];
+        }
+        c->blkno[i] = blkno;
+        c->chain[i] = c->bucket[blkno & c->mask];
+        c->bucket[blkno & c->mask] = i;
+    }
+    memcpy(SLOT_DATA(c, i), buf, c->blksize);
+    if (i != c->head) {
+        lru_unlink(c, i);
+        lru_push(c, i);
+    }
+}
@@ -26,6 +26,7 @@
 #include "apr.h"
 #include "apr_pools.h"
 #include "apr_file_io.h"
+#include "apr_mmap.h"
 #include "apr_errno.h" /* for apr_status_t */
 
 #if 0
@@ -46,6 +47,8 @@
 #define SDBM_SHARED_LOCK	0x4    /* data base locked for shared read */
 #define SDBM_EXCLUSIVE_LOCK	0x8    /* data base locked for write */
 
+typedef struct sdbm_cache_t sdbm_cache_t;
+
 struct apr_sdbm_t {
     apr_pool_t *pool;
     apr_file_t *dirf;		       /* directory file descriptor */
@@ -59,9 +62,16 @@ struct apr_sdbm_t {
     long blkno;			       /* current page to read/write */
     long pagbno;		       /* current page in pagbuf */
     char pagbuf[PBLKSIZ];	       /* page file block buffer */
+    char *pagp;			       /* current page: pagbuf or mapped */
     long dirbno;		       /* current block in dirbuf */
     char dirbuf[DBLKSIZ];	       /* directory file block buffer */
     int  lckcnt;                       /* number of calls to sdbm_lock */
+    sdbm_cache_t *pagcache;	       /* recently used pages, or NULL */
+    sdbm_cache_t *dircache;	       /* recently used dir blocks, or NULL */
+#if APR_HAS_MMAP
+    apr_mmap_t *pagmap;		       /* page file of a read-only database */
+    apr_mmap_t *dirmap;		       /* directory file, likewise */
+#endif
 };
 
 
@@ -72,6 +82,18 @@ extern const apr_sdbm_datum_t sdbm_nullitem;
 
 long sdbm_hash(const char *str, int len);
 
+#define sdbm_cache_create apu__sdbm_cache_create
+#define sdbm_cache_destroy apu__sdbm_cache_destroy
+#define sdbm_cache_clear apu__sdbm_cache_clear
+#define sdbm_cache_get apu__sdbm_cache_get
+#define sdbm_cache_put apu__sdbm_cache_put
+
+sdbm_cache_t *sdbm_cache_create(int nslots, apr_size_t blksize);
+void sdbm_cache_destroy(sdbm_cache_t *c);
+void sdbm_cache_clear(sdbm_cache_t *c);
+const char *sdbm_cache_get(sdbm_cache_t *c, long blkno);
+void sdbm_cache_put(sdbm_cache_t *c, long blkno, const char *buf);
+
 /*
  * zero the cache
  */
@@ -79,6 +101,10 @@ long sdbm_hash(const char *str, int len);
     do { db->dirbno = (!finfo.size) ? 0 : -1; \
          db->pagbno = -1; \
          db->maxbno = (long)(finfo.size * BYTESIZ); \
+         if (db->pagcache) \
+             sdbm_cache_clear(db->pagcache); \
+         if (db->dircache) \
+             sdbm_cache_clear(db->dircache); \
     } while (0);
 
 #endif /* SDBM_PRIVATE_H */
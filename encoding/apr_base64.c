@@ -107,6 +107,457 @@ APR_DECLARE(apr_status_t) apr_base64init_ebcdic(apr_xlate_t *to_ascii,
 }
 #endif /*APR_CHARSET_EBCDIC*/
 
+static const char basis_64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char basis_64url[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+/* The SIMD kernels below produce and consume ASCII, so they are only
+ * built for ASCII platforms; the scalar kernels cover everything else.
+ * x86 kernels are compiled with per-function target attributes and
+ * selected at runtime, NEON is part of the AArch64 baseline.
+ */
+#if !APR_CHARSET_EBCDIC && (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) \
+        || (defined(__GNUC__) \
+            && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define BASE64_X86_SIMD 1
+#include <immintrin.h>
+#elif !APR_CHARSET_EBCDIC && defined(__aarch64__) && defined(__ARM_NEON)
+#define BASE64_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* The value of an encoded character, or 64 if it is not in the alphabet */
+static unsigned int decode_char(unsigned char c, int url)
+{
+    unsigned int v = pr2six[c];
+
+    if (url) {
+        if (c == '-') {
+            v = 62;
+        }
+        else if (c == '_') {
+            v = 63;
+        }
+        else if (v >= 62) {
+            /* '+' and '/' are not part of the URL safe alphabet */
+            v = 64;
+        }
+    }
+    return v;
+}
+
+/* The bulk kernels convert as many whole groups as they can: the encoders
+ * every complete 3 byte group, the decoders every 4 character group up to
+ * the first one holding anything but alphabet characters (padding
+ * included).  They return the length of the input consumed.
+ */
+typedef apr_size_t (*encode_bulk_fn)(char *dst, const unsigned char *src,
+                                     apr_size_t len, int url);
+typedef apr_size_t (*decode_bulk_fn)(unsigned char *dst, const char *src,
+                                     apr_size_t len, int url);
+
+static apr_size_t encode_bulk_scalar(char *dst, const unsigned char *src,
+                                     apr_size_t len, int url)
+{
+    const char *alphabet = url ? basis_64url : basis_64;
+    apr_size_t i;
+
+    for (i = 0; len - i >= 3; i += 3) {
+        *dst++ = alphabet[src[i] >> 2];
+        *dst++ = alphabet[((src[i] & 0x3) << 4) | (src[i + 1] >> 4)];
+        *dst++ = alphabet[((src[i + 1] & 0xF) << 2) | (src[i + 2] >> 6)];
+        *dst++ = alphabet[src[i + 2] & 0x3F];
+    }
+    return i;
+}
+
+static apr_size_t decode_bulk_scalar(unsigned char *dst, const char *src,
+                                     apr_size_t len, int url)
+{
+    const unsigned char *in = (const unsigned char *)src;
+    apr_size_t i;
+
+    for (i = 0; len - i >= 4; i += 4) {
+        unsigned int a = decode_char(in[i], url);
+        unsigned int b = decode_char(in[i + 1], url);
+        unsigned int c = decode_char(in[i + 2], url);
+        unsigned int d = decode_char(in[i + 3], url);
+
+        if ((a | b | c | d) > 63) {
+            break;
+        }
+        *dst++ = (unsigned char)(a << 2 | b >> 4);
+        *dst++ = (unsigned char)(b << 4 | c >> 2);
+        *dst++ = (unsigned char)(c << 6 | d);
+    }
+    return i;
+}
+
+#if BASE64_X86_SIMD
+
+#define SSSE3_FN __attribute__((target("ssse3")))
+#define AVX2_FN __attribute__((target("avx2")))
+
+#define BROADCAST_128(x) \
+    _mm256_inserti128_si256(_mm256_castsi128_si256(x), (x), 1)
+
+/* Per-range offsets from a sextet to its character, indexed as computed
+ * by encode_map_*(): 13 for A-Z, 0 for a-z, 1-10 for 0-9, 11 and 12 for
+ * the last two characters.
+ */
+static SSSE3_FN __m128i encode_offsets(int url)
+{
+    return _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                         '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                         '0' - 52, url ? '-' - 62 : '+' - 62,
+                         url ? '_' - 63 : '/' - 63, 'A', 0, 0);
+}
+
+/* Spread the 12 bytes at the bottom of in over 16 sextets, one per byte,
+ * using multiplies as per-lane variable shifts (after W. Mula), then
+ * map the sextets to characters.
+ */
+static SSSE3_FN __m128i encode_map_ssse3(__m128i in, __m128i offsets)
+{
+    __m128i t0, t1, idx, sel;
+
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                             7, 6, 8, 7, 10, 9, 11, 10));
+    t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+                         _mm_set1_epi32(0x04000040));
+    t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+                         _mm_set1_epi32(0x01000010));
+    idx = _mm_or_si128(t0, t1);
+
+    sel = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+    sel = _mm_or_si128(sel, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26),
+                                                         idx),
+                                          _mm_set1_epi8(13)));
+    return _mm_add_epi8(idx, _mm_shuffle_epi8(offsets, sel));
+}
+
+static SSSE3_FN apr_size_t encode_bulk_ssse3(char *dst,
+                                             const unsigned char *src,
+                                             apr_size_t len, int url)
+{
+    const __m128i offsets = encode_offsets(url);
+    apr_size_t i;
+
+    /* each 16 byte load consumes 12 bytes */
+    for (i = 0; len - i >= 16; i += 12, dst += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+
+        _mm_storeu_si128((__m128i *)dst, encode_map_ssse3(in, offsets));
+    }
+    return i + encode_bulk_scalar(dst, src + i, len - i, url);
+}
+
+static AVX2_FN apr_size_t encode_bulk_avx2(char *dst,
+                                           const unsigned char *src,
+                                           apr_size_t len, int url)
+{
+    const __m128i offsets128 = encode_offsets(url);
+    const __m256i offsets = BROADCAST_128(offsets128);
+    const __m128i shuf128 = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                          7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i shuf = BROADCAST_128(shuf128);
+    apr_size_t i;
+
+    /* 12 bytes per lane, the upper lane loaded from 12 bytes further */
+    for (i = 0; len - i >= 28; i += 24, dst += 32) {
+        __m256i in, t0, t1, idx, sel;
+
+        in = _mm256_inserti128_si256(
+                 _mm256_castsi128_si256(
+                     _mm_loadu_si128((const __m128i *)(src + i))),
+                 _mm_loadu_si128((const __m128i *)(src + i + 12)), 1);
+        in = _mm256_shuffle_epi8(in, shuf);
+        t0 = _mm256_mulhi_epu16(_mm256_and_si256(in,
+                                         _mm256_set1_epi32(0x0fc0fc00)),
+                                _mm256_set1_epi32(0x04000040));
+        t1 = _mm256_mullo_epi16(_mm256_and_si256(in,
+                                         _mm256_set1_epi32(0x003f03f0)),
+                                _mm256_set1_epi32(0x01000010));
+        idx = _mm256_or_si256(t0, t1);
+
+        sel = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        sel = _mm256_or_si256(sel,
+                  _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26),
+                                                     idx),
+                                   _mm256_set1_epi8(13)));
+        _mm256_storeu_si256((__m256i *)dst,
+                            _mm256_add_epi8(idx,
+                                            _mm256_shuffle_epi8(offsets,
+                                                                sel)));
+    }
+    return i + encode_bulk_ssse3(dst, src + i, len - i, url);
+}
+
+/* Decoding classifies each character by its two nibbles: a character is
+ * in the standard alphabet iff lut_lo[low] & lut_hi[high] is zero, and
+ * adding lut_roll[high] (lut_roll[1] for '/') yields its sextet.  The URL
+ * alphabet is first folded onto the standard one.
+ */
+#define DECODE_LUT_LO \
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, \
+    0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+#define DECODE_LUT_HI \
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, \
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+#define DECODE_LUT_ROLL \
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+
+static SSSE3_FN apr_size_t decode_bulk_ssse3(unsigned char *dst,
+                                             const char *src,
+                                             apr_size_t len, int url)
+{
+    const __m128i lut_lo = _mm_setr_epi8(DECODE_LUT_LO);
+    const __m128i lut_hi = _mm_setr_epi8(DECODE_LUT_HI);
+    const __m128i lut_roll = _mm_setr_epi8(DECODE_LUT_ROLL);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+    apr_size_t i;
+
+    /* the 16 byte store runs 4 bytes past the 12 decoded ones, which is
+     * still within the output as long as 8 more characters follow
+     */
+    for (i = 0; len - i >= 24; i += 16, dst += 12) {
+        __m128i str = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi_nibbles, lo_nibbles, roll;
+
+        if (url) {
+            if (_mm_movemask_epi8(
+                    _mm_or_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('+')),
+                                 _mm_cmpeq_epi8(str, _mm_set1_epi8('/'))))) {
+                break;
+            }
+            str = _mm_add_epi8(str,
+                      _mm_and_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('-')),
+                                    _mm_set1_epi8('+' - '-')));
+            str = _mm_add_epi8(str,
+                      _mm_and_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('_')),
+                                    _mm_set1_epi8('/' - '_')));
+        }
+        hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+        lo_nibbles = _mm_and_si128(str, mask_2f);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(
+                _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo_nibbles),
+                              _mm_shuffle_epi8(lut_hi, hi_nibbles)),
+                _mm_setzero_si128()))) {
+            break;
+        }
+        roll = _mm_shuffle_epi8(lut_roll,
+                                _mm_add_epi8(_mm_cmpeq_epi8(str, mask_2f),
+                                             hi_nibbles));
+        str = _mm_add_epi8(str, roll);
+
+        /* pack the 4 sextets of each 32-bit lane into 3 bytes */
+        str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+        str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+        str = _mm_shuffle_epi8(str, _mm_setr_epi8(2, 1, 0, 6, 5, 4,
+                                                  10, 9, 8, 14, 13, 12,
+                                                  -1, -1, -1, -1));
+        _mm_storeu_si128((__m128i *)dst, str);
+    }
+    return i + decode_bulk_scalar(dst, src + i, len - i, url);
+}
+
+static AVX2_FN apr_size_t decode_bulk_avx2(unsigned char *dst,
+                                           const char *src,
+                                           apr_size_t len, int url)
+{
+    const __m128i lut_lo128 = _mm_setr_epi8(DECODE_LUT_LO);
+    const __m128i lut_hi128 = _mm_setr_epi8(DECODE_LUT_HI);
+    const __m128i lut_roll128 = _mm_setr_epi8(DECODE_LUT_ROLL);
+    const __m128i pack128 = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                          14, 13, 12, -1, -1, -1, -1);
+    const __m256i lut_lo = BROADCAST_128(lut_lo128);
+    const __m256i lut_hi = BROADCAST_128(lut_hi128);
+    const __m256i lut_roll = BROADCAST_128(lut_roll128);
+    const __m256i pack = BROADCAST_128(pack128);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+    apr_size_t i;
+
+    /* as above, the 32 byte store needs 12 more characters to follow */
+    for (i = 0; len - i >= 44; i += 32, dst += 24) {
+        __m256i str = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i hi_nibbles, lo_nibbles, roll;
+
+        if (url) {
+            if (_mm256_movemask_epi8(_mm256_or_si256(
+                    _mm256_cmpeq_epi8(str, _mm256_set1_epi8('+')),
+                    _mm256_cmpeq_epi8(str, _mm256_set1_epi8('/'))))) {
+                break;
+            }
+            str = _mm256_add_epi8(str, _mm256_and_si256(
+                      _mm256_cmpeq_epi8(str, _mm256_set1_epi8('-')),
+                      _mm256_set1_epi8('+' - '-')));
+            str = _mm256_add_epi8(str, _mm256_and_si256(
+                      _mm256_cmpeq_epi8(str, _mm256_set1_epi8('_')),
+                      _mm256_set1_epi8('/' - '_')));
+        }
+        hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+        lo_nibbles = _mm256_and_si256(str, mask_2f);
+        if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(
+                _mm256_and_si256(_mm256_shuffle_epi8(lut_lo, lo_nibbles),
+                                 _mm256_shuffle_epi8(lut_hi, hi_nibbles)),
+                _mm256_setzero_si256()))) {
+            break;
+        }
+        roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(
+                   _mm256_cmpeq_epi8(str, mask_2f), hi_nibbles));
+        str = _mm256_add_epi8(str, roll);
+
+        str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+        str = _mm256_shuffle_epi8(str, pack);
+        /* join the 12 bytes at the bottom of each lane */
+        str = _mm256_permutevar8x32_epi32(str,
+                  _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm256_storeu_si256((__m256i *)dst, str);
+    }
+    return i + decode_bulk_ssse3(dst, src + i, len - i, url);
+}
+
+#endif /* BASE64_X86_SIMD */
+
+#if BASE64_NEON
+
+static apr_size_t encode_bulk_neon(char *dst, const unsigned char *src,
+                                   apr_size_t len, int url)
+{
+    const uint8_t *alphabet = (const uint8_t *)(url ? basis_64url
+                                                    : basis_64);
+    const uint8x16_t mask = vdupq_n_u8(0x3f);
+    uint8x16x4_t tbl;
+    apr_size_t i;
+
+    tbl.val[0] = vld1q_u8(alphabet);
+    tbl.val[1] = vld1q_u8(alphabet + 16);
+    tbl.val[2] = vld1q_u8(alphabet + 32);
+    tbl.val[3] = vld1q_u8(alphabet + 48);
+
+    /* 48 bytes, de-interleaved by the load, give 64 characters */
+    for (i = 0; len - i >= 48; i += 48, dst += 64) {
+        uint8x16x3_t in = vld3q_u8(src + i);
+        uint8x16x4_t out;
+
+        out.val[0] = vshrq_n_u8(in.val[0], 2);
+        out.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4),
+                                       vshrq_n_u8(in.val[1], 4)), mask);
+        out.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2),
+                                       vshrq_n_u8(in.val[2], 6)), mask);
+        out.val[3] = vandq_u8(in.val[2], mask);
+
+        out.val[0] = vqtbl4q_u8(tbl, out.val[0]);
+        out.val[1] = vqtbl4q_u8(tbl, out.val[1]);
+        out.val[2] = vqtbl4q_u8(tbl, out.val[2]);
+        out.val[3] = vqtbl4q_u8(tbl, out.val[3]);
+        vst4q_u8((uint8_t *)dst, out);
+    }
+    return i + encode_bulk_scalar(dst, src + i, len - i, url);
+}
+
+static apr_size_t decode_bulk_neon(unsigned char *dst, const char *src,
+                                   apr_size_t len, int url)
+{
+    const uint8x16_t sextet_max = vdupq_n_u8(63);
+    const uint8x16_t ascii_max = vdupq_n_u8(127);
+    uint8x16x4_t lo_tbl, hi_tbl;
+    apr_size_t i;
+    int k;
+
+    /* pr2six covers ASCII in two 64 entry halves, 64 marking invalid */
+    for (k = 0; k < 4; k++) {
+        lo_tbl.val[k] = vld1q_u8(pr2six + 16 * k);
+        hi_tbl.val[k] = vld1q_u8(pr2six + 64 + 16 * k);
+    }
+
+    for (i = 0; len - i >= 64; i += 64, dst += 48) {
+        uint8x16x4_t in = vld4q_u8((const uint8_t *)src + i);
+        uint8x16x3_t out;
+        uint8x16_t bad = vdupq_n_u8(0);
+
+        for (k = 0; k < 4; k++) {
+            uint8x16_t c = in.val[k], v;
+
+            if (url) {
+                bad = vorrq_u8(bad, vceqq_u8(c, vdupq_n_u8('+')));
+                bad = vorrq_u8(bad, vceqq_u8(c, vdupq_n_u8('/')));
+                c = vaddq_u8(c, vandq_u8(vceqq_u8(c, vdupq_n_u8('-')),
+                                vdupq_n_u8((uint8_t)('+' - '-'))));
+                c = vaddq_u8(c, vandq_u8(vceqq_u8(c, vdupq_n_u8('_')),
+                                vdupq_n_u8((uint8_t)('/' - '_'))));
+            }
+            v = vqtbl4q_u8(lo_tbl, c);
+            v = vqtbx4q_u8(v, hi_tbl, vsubq_u8(c, vdupq_n_u8(64)));
+            bad = vorrq_u8(bad, vcgtq_u8(v, sextet_max));
+            bad = vorrq_u8(bad, vcgtq_u8(c, ascii_max));
+            in.val[k] = v;
+        }
+        if (vmaxvq_u8(bad)) {
+            break;
+        }
+
+        out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2),
+                              vshrq_n_u8(in.val[1], 4));
+        out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4),
+                              vshrq_n_u8(in.val[2], 2));
+        out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+        vst3q_u8(dst, out);
+    }
+    return i + decode_bulk_scalar(dst, src + i, len - i, url);
+}
+
+#endif /* BASE64_NEON */
+
+static encode_bulk_fn encode_bulk_impl;
+static decode_bulk_fn decode_bulk_impl;
+
+/* Pick the kernels once; racing first callers store the same values. */
+static void base64_select_kernels(void)
+{
+    encode_bulk_fn enc = encode_bulk_scalar;
+    decode_bulk_fn dec = decode_bulk_scalar;
+
+#if BASE64_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        enc = encode_bulk_avx2;
+        dec = decode_bulk_avx2;
+    }
+    else if (__builtin_cpu_supports("ssse3")) {
+        enc = encode_bulk_ssse3;
+        dec = decode_bulk_ssse3;
+    }
+#elif BASE64_NEON
+    enc = encode_bulk_neon;
+    dec = decode_bulk_neon;
+#endif
+
+    encode_bulk_impl = enc;
+    decode_bulk_impl = dec;
+}
+
+static apr_size_t encode_bulk(char *dst, const unsigned char *src,
+                              apr_size_t len, int url)
+{
+    if (!encode_bulk_impl) {
+        base64_select_kernels();
+    }
+    return encode_bulk_impl(dst, src, len, url);
+}
+
+static apr_size_t decode_bulk(unsigned char *dst, const char *src,
+                              apr_size_t len, int url)
+{
+    if (!decode_bulk_impl) {
+        base64_select_kernels();
+    }
+    return decode_bulk_impl(dst, src, len, url);
+}
+
 APR_DECLARE(int) apr_base64_decode_len(const char *bufcoded)
 {
     int nbytesdecoded;
@@ -159,6 +610,15 @@ APR_DECLARE(int) apr_base64_decode_binary(unsigned char *bufplain,
     bufout = (unsigned char *) bufplain;
     bufin = (const unsigned char *) bufcoded;
 
+    if (nprbytes > 4) {
+        /* all nprbytes characters are valid, leave the last group */
+        apr_size_t done = decode_bulk(bufout, bufcoded, nprbytes - 1, 0);
+
+        bufout += done / 4 * 3;
+        bufin += done;
+        nprbytes -= done;
+    }
+
     while (nprbytes > 4) {
 	*(bufout++) =
 	    (unsigned char) (pr2six[*bufin] << 2 | pr2six[bufin[1]] >> 4);
@@ -188,9 +648,6 @@ APR_DECLARE(int) apr_base64_decode_binary(unsigned char *bufplain,
     return nbytesdecoded;
 }
 
-static const char basis_64[] =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
 APR_DECLARE(int) apr_base64_encode_len(int len)
 {
     return ((len + 2) / 3 * 4) + 1;
@@ -242,7 +699,12 @@ APR_DECLARE(int) apr_base64_encode_binary(char *encoded,
     char *p;
 
     p = encoded;
-    for (i = 0; i < len - 2; i += 3) {
+    i = 0;
+    if (len > 0) {
+        i = (int)encode_bulk(p, string, len, 0);
+        p += i / 3 * 4;
+    }
+    for (; i < len - 2; i += 3) {
 	*p++ = basis_64[(string[i] >> 2) & 0x3F];
 	*p++ = basis_64[((string[i] & 0x3) << 4) |
 	                ((int) (string[i + 1] & 0xF0) >> 4)];
@@ -267,3 +729,228 @@ APR_DECLARE(int) apr_base64_encode_binary(char *encoded,
     *p++ = '\0';
     return (int)(p - encoded);
 }
+
+APR_DECLARE(apr_size_t) apr_base64_encode_len_ex(apr_size_t len, int flags)
+{
+    if (flags & APR_BASE64_NOPAD) {
+        return len / 3 * 4 + (len % 3 ? len % 3 + 1 : 0);
+    }
+    return (len + 2) / 3 * 4;
+}
+
+APR_DECLARE(apr_size_t) apr_base64_encode_ex(char *coded_dst,
+                                             const unsigned char *plain_src,
+                                             apr_size_t len, int flags)
+{
+    apr_base64_ctx_t ctx;
+    apr_size_t n;
+
+    apr_base64_encode_init(&ctx, flags);
+    n = apr_base64_encode_update(&ctx, coded_dst, plain_src, len);
+    return n + apr_base64_encode_final(&ctx, coded_dst + n);
+}
+
+APR_DECLARE(apr_size_t) apr_base64_decode_len_ex(apr_size_t len)
+{
+    return (len + 3) / 4 * 3;
+}
+
+APR_DECLARE(apr_status_t) apr_base64_decode_ex(unsigned char *plain_dst,
+                                               apr_size_t *plain_len,
+                                               const char *coded_src,
+                                               apr_size_t len, int flags)
+{
+    apr_base64_ctx_t ctx;
+    apr_size_t n, tail;
+    apr_status_t rv;
+
+    apr_base64_decode_init(&ctx, flags);
+    rv = apr_base64_decode_update(&ctx, plain_dst, &n, coded_src, len);
+    if (rv == APR_SUCCESS) {
+        rv = apr_base64_decode_final(&ctx, plain_dst + n, &tail);
+        n += tail;
+    }
+    *plain_len = n;
+    return rv;
+}
+
+APR_DECLARE(void) apr_base64_encode_init(apr_base64_ctx_t *ctx, int flags)
+{
+    ctx->flags = flags;
+    ctx->pad = -1;
+    ctx->n = 0;
+}
+
+APR_DECLARE(apr_size_t) apr_base64_encode_update(apr_base64_ctx_t *ctx,
+                                                 char *coded_dst,
+                                                 const unsigned char *plain_src,
+                                                 apr_size_t len)
+{
+    int url = ctx->flags & APR_BASE64_URL;
+    char *p = coded_dst;
+    apr_size_t i = 0;
+
+    if (ctx->n) {
+        while (ctx->n < 3 && i < len) {
+            ctx->buf[ctx->n++] = plain_src[i++];
+        }
+        if (ctx->n < 3) {
+            return 0;
+        }
+        p += encode_bulk_scalar(p, ctx->buf, 3, url) / 3 * 4;
+        ctx->n = 0;
+    }
+
+    if (len - i >= 3) {
+        apr_size_t done = encode_bulk(p, plain_src + i, len - i, url);
+
+        p += done / 3 * 4;
+        i += done;
+    }
+
+    while (i < len) {
+        ctx->buf[ctx->n++] = plain_src[i++];
+    }
+    return p - coded_dst;
+}
+
+APR_DECLARE(apr_size_t) apr_base64_encode_final(apr_base64_ctx_t *ctx,
+                                                char *coded_dst)
+{
+    const char *alphabet = (ctx->flags & APR_BASE64_URL) ? basis_64url
+                                                         : basis_64;
+    const unsigned char *in = ctx->buf;
+    char *p = coded_dst;
+
+    if (!ctx->n) {
+        return 0;
+    }
+
+    *p++ = alphabet[in[0] >> 2];
+    if (ctx->n == 1) {
+        *p++ = alphabet[(in[0] & 0x3) << 4];
+    }
+    else {
+        *p++ = alphabet[((in[0] & 0x3) << 4) | (in[1] >> 4)];
+        *p++ = alphabet[(in[1] & 0xF) << 2];
+    }
+    if (!(ctx->flags & APR_BASE64_NOPAD)) {
+        while (p - coded_dst < 4) {
+            *p++ = '=';
+        }
+    }
+
+    ctx->n = 0;
+    return p - coded_dst;
+}
+
+APR_DECLARE(void) apr_base64_decode_init(apr_base64_ctx_t *ctx, int flags)
+{
+    ctx->flags = flags;
+    ctx->pad = -1;
+    ctx->n = 0;
+}
+
+/* Write out the 1 or 2 bytes of a group cut short by padding or the end
+ * of the input; ctx->buf holds sextets when decoding.
+ */
+static unsigned char *decode_partial(apr_base64_ctx_t *ctx, unsigned char *p)
+{
+    const unsigned char *v = ctx->buf;
+
+    *p++ = (unsigned char)(v[0] << 2 | v[1] >> 4);
+    if (ctx->n == 3) {
+        *p++ = (unsigned char)(v[1] << 4 | v[2] >> 2);
+    }
+    ctx->n = 0;
+    return p;
+}
+
+APR_DECLARE(apr_status_t) apr_base64_decode_update(apr_base64_ctx_t *ctx,
+                                                   unsigned char *plain_dst,
+                                                   apr_size_t *plain_len,
+                                                   const char *coded_src,
+                                                   apr_size_t len)
+{
+    const unsigned char *in = (const unsigned char *)coded_src;
+    int url = ctx->flags & APR_BASE64_URL;
+    unsigned char *p = plain_dst;
+    apr_status_t rv = APR_SUCCESS;
+    apr_size_t i = 0;
+
+    for (;;) {
+        unsigned int v;
+
+        if (ctx->n == 0 && ctx->pad < 0 && len - i >= 4) {
+            apr_size_t done = decode_bulk(p, coded_src + i, len - i, url);
+
+            p += done / 4 * 3;
+            i += done;
+        }
+        if (i == len) {
+            break;
+        }
+
+        if (in[i] == '=') {
+            if (ctx->pad < 0) {
+                /* padding may only complete a group of 2 or 3 */
+                if (ctx->n < 2) {
+                    rv = APR_EINVAL;
+                    break;
+                }
+                ctx->pad = 3 - (int)ctx->n;
+                p = decode_partial(ctx, p);
+            }
+            else if (ctx->pad > 0) {
+                ctx->pad--;
+            }
+            else {
+                rv = APR_EINVAL;
+                break;
+            }
+            i++;
+            continue;
+        }
+
+        v = decode_char(in[i], url);
+        if (v > 63 || ctx->pad >= 0) {
+            rv = APR_EINVAL;
+            break;
+        }
+        ctx->buf[ctx->n++] = (unsigned char)v;
+        i++;
+
+        if (ctx->n == 4) {
+            const unsigned char *b = ctx->buf;
+
+            *p++ = (unsigned char)(b[0] << 2 | b[1] >> 4);
+            *p++ = (unsigned char)(b[1] << 4 | b[2] >> 2);
+            *p++ = (unsigned char)(b[2] << 6 | b[3]);
+            ctx->n = 0;
+        }
+    }
+
+    *plain_len = p - plain_dst;
+    return rv;
+}
+
+APR_DECLARE(apr_status_t) apr_base64_decode_final(apr_base64_ctx_t *ctx,
+                                                  unsigned char *plain_dst,
+                                                  apr_size_t *plain_len)
+{
+    unsigned char *p = plain_dst;
+    apr_status_t rv = APR_SUCCESS;
+
+    if (ctx->n == 1) {
+        /* a single character cannot encode a whole byte */
+        rv = APR_EINVAL;
+    }
+    else if (ctx->n) {
+        p = decode_partial(ctx, p);
+    }
+
+    ctx->n = 0;
+    ctx->pad = -1;
+    *plain_len = p - plain_dst;
+    return rv;
+}
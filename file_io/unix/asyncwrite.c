@@ -0,0 +1,435 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_file_io.h"
+
+#define APR_WANT_MEMFUNC
+#include "apr_want.h"
+
+#if APR_HAS_THREADS
+
+#include "apr_atomic.h"
+#include "apr_thread_proc.h"
+#include "apr_thread_mutex.h"
+#include "apr_thread_cond.h"
+
+/* The ring is an array of fixed size cells.  A record occupies as many
+ * consecutive cells as its length requires; its bytes live in the data
+ * area behind those cells and wrap at most once, at the end of the ring.
+ *
+ * Producers reserve cells by advancing 'head' with a CAS, copy their
+ * record in, and publish it by storing (position + 1) into the sequence
+ * number of the record's first cell.  The background thread is the
+ * only consumer: it follows the published records from 'tail', writes
+ * them out and returns the cells by advancing 'done'.  Sequence numbers
+ * of released cells are reset to their own position, which can never
+ * look like a published record of a later lap.
+ */
+#define ASYNC_CELL_SIZE     64
+#define ASYNC_DEFAULT_RING  (256 * 1024)
+#define ASYNC_MIN_CELLS     16
+
+/* How long the writer thread sleeps when idle, and how long blocked
+ * producers wait before re-checking, should a wakeup go missing.
+ */
+#define ASYNC_IDLE_WAIT     apr_time_from_msec(100)
+#define ASYNC_SPACE_WAIT    apr_time_from_msec(10)
+
+typedef struct async_cell_t {
+    volatile apr_uint32_t seq;
+    apr_uint32_t len;
+} async_cell_t;
+
+struct apr_file_async_t {
+    apr_pool_t *pool;
+    apr_file_t *file;
+    apr_int32_t flags;
+    apr_uint32_t ncells;
+    apr_uint32_t mask;
+    async_cell_t *cells;
+    char *data;
+    struct iovec *vec;
+    apr_size_t nvec;
+
+    volatile apr_uint32_t head;     /* next cell to reserve */
+    volatile apr_uint32_t done;     /* cells below this one are free */
+    apr_uint32_t tail;              /* next record to write (thread only) */
+
+    volatile apr_uint32_t sleeping; /* writer thread is (about to) wait */
+    volatile apr_uint32_t closing;
+    volatile apr_uint32_t dropped;
+    volatile apr_uint32_t blocked;
+
+    apr_thread_mutex_t *mutex;
+    apr_thread_cond_t *wakeup;      /* the writer waits for records */
+    apr_thread_cond_t *progress;    /* producers wait for space/flushes */
+    apr_thread_t *thread;
+    int waiters;                    /* protected by mutex */
+    int running;                    /* protected by mutex */
+
+    /* protected by mutex */
+    apr_status_t status;
+    apr_uint64_t records;
+    apr_uint64_t bytes;
+    apr_uint64_t batches;
+    apr_uint32_t flushes;
+    apr_uint32_t errors;
+};
+
+static APR_INLINE int record_ready(apr_file_async_t *async, apr_uint32_t pos)
+{
+    async_cell_t *cell = &async->cells[pos & async->mask];
+
+    /* a CAS that never changes anything: a read with a full barrier */
+    return apr_atomic_cas32(&cell->seq, pos + 1, pos + 1) == pos + 1;
+}
+
+static void wake_writer(apr_file_async_t *async)
+{
+    if (apr_atomic_read32(&async->sleeping)) {
+        apr_thread_mutex_lock(async->mutex);
+        apr_thread_cond_signal(async->wakeup);
+        apr_thread_mutex_unlock(async->mutex);
+    }
+}
+
+/* Gather the published records starting at 'tail' into the iovec, write
+ * them out with one call and release their cells.  Returns the number
+ * of records written.
+ */
+static apr_size_t write_batch(apr_file_async_t *async)
+{
+    apr_size_t nvec = 0, nrecords = 0, nbytes = 0, written;
+    apr_size_t ringbytes = (apr_size_t)async->ncells * ASYNC_CELL_SIZE;
+    apr_uint32_t pos = async->tail;
+    apr_status_t rv = APR_SUCCESS;
+
+    while (nvec + 2 <= async->nvec && record_ready(async, pos)) {
+        async_cell_t *cell = &async->cells[pos & async->mask];
+        apr_size_t off = (apr_size_t)(pos & async->mask) * ASYNC_CELL_SIZE;
+        apr_size_t len = cell->len;
+
+        if (off + len > ringbytes) {
+            async->vec[nvec].iov_base = async->data + off;
+            async->vec[nvec].iov_len = ringbytes - off;
+            nvec++;
+            async->vec[nvec].iov_base = async->data;
+            async->vec[nvec].iov_len = off + len - ringbytes;
+            nvec++;
+        }
+        else {
+            async->vec[nvec].iov_base = async->data + off;
+            async->vec[nvec].iov_len = len;
+            nvec++;
+        }
+        nbytes += len;
+        nrecords++;
+        pos += (apr_uint32_t)((len + ASYNC_CELL_SIZE - 1) / ASYNC_CELL_SIZE);
+    }
+
+    if (nrecords == 0) {
+        return 0;
+    }
+
+    /* the file's own rotation check runs here, on this thread */
+    rv = apr_file_writev_full(async->file, async->vec, nvec, &written);
+
+    /* hand the cells back; unpublish the first cell of each record */
+    while (async->tail != pos) {
+        async_cell_t *cell = &async->cells[async->tail & async->mask];
+        apr_uint32_t len = cell->len;
+
+        cell->seq = async->tail;
+        async->tail += (len + ASYNC_CELL_SIZE - 1) / ASYNC_CELL_SIZE;
+    }
+    apr_atomic_xchg32(&async->done, pos);
+
+    apr_thread_mutex_lock(async->mutex);
+    async->batches++;
+    if (rv == APR_SUCCESS) {
+        async->records += nrecords;
+        async->bytes += nbytes;
+    }
+    else {
+        async->errors++;
+        if (async->status == APR_SUCCESS) {
+            async->status = rv;
+        }
+    }
+    if (async->waiters) {
+        apr_thread_cond_broadcast(async->progress);
+    }
+    apr_thread_mutex_unlock(async->mutex);
+
+    return nrecords;
+}
+
+static void * APR_THREAD_FUNC async_writer(apr_thread_t *thd, void *data)
+{
+    apr_file_async_t *async = data;
+
+    for (;;) {
+        if (write_batch(async)) {
+            continue;
+        }
+
+        apr_thread_mutex_lock(async->mutex);
+        if (async->closing
+            && async->tail == apr_atomic_read32(&async->head)) {
+            async->running = 0;
+            apr_thread_cond_broadcast(async->progress);
+            apr_thread_mutex_unlock(async->mutex);
+            break;
+        }
+        /* Announce the wait before the last look at the ring; a producer
+         * publishing concurrently either is seen here or sees the flag.
+         */
+        apr_atomic_xchg32(&async->sleeping, 1);
+        if (!record_ready(async, async->tail)) {
+            apr_thread_cond_timedwait(async->wakeup, async->mutex,
+                                      ASYNC_IDLE_WAIT);
+        }
+        apr_atomic_xchg32(&async->sleeping, 0);
+        apr_thread_mutex_unlock(async->mutex);
+    }
+
+    apr_thread_exit(thd, APR_SUCCESS);
+    return NULL;
+}
+
+static apr_status_t async_cleanup(void *data)
+{
+    return apr_file_async_close(data);
+}
+
+APR_DECLARE(apr_status_t) apr_file_async_create(apr_file_async_t **async,
+                                                apr_file_t *file,
+                                                apr_size_t ring_size,
+                                                apr_int32_t flags,
+                                                apr_pool_t *pool)
+{
+    apr_file_async_t *new;
+    apr_size_t ncells;
+    apr_status_t rv;
+
+    if (ring_size == 0) {
+        ring_size = ASYNC_DEFAULT_RING;
+    }
+    if (ring_size > APR_UINT32_MAX / 2) {
+        return APR_EINVAL;
+    }
+    ncells = ASYNC_MIN_CELLS;
+    while (ncells * ASYNC_CELL_SIZE < ring_size) {
+        ncells <<= 1;
+    }
+
+    new = apr_pcalloc(pool, sizeof(*new));
+    new->pool = pool;
+    new->file = file;
+    new->flags = flags;
+    new->ncells = (apr_uint32_t)ncells;
+    new->mask = new->ncells - 1;
+    new->cells = apr_palloc(pool, ncells * sizeof(async_cell_t));
+    new->data = apr_palloc(pool, ncells * ASYNC_CELL_SIZE);
+    new->nvec = APR_MAX_IOVEC_SIZE;
+    new->vec = apr_palloc(pool, new->nvec * sizeof(struct iovec));
+
+    /* no cell is published: seq != pos + 1 */
+    for (ncells = 0; ncells < new->ncells; ncells++) {
+        new->cells[ncells].seq = (apr_uint32_t)ncells;
+    }
+
+    rv = apr_thread_mutex_create(&new->mutex, APR_THREAD_MUTEX_DEFAULT, pool);
+    if (rv == APR_SUCCESS) {
+        rv = apr_thread_cond_create(&new->wakeup, pool);
+    }
+    if (rv == APR_SUCCESS) {
+        rv = apr_thread_cond_create(&new->progress, pool);
+    }
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+
+    new->running = 1;
+    rv = apr_thread_create(&new->thread, NULL, async_writer, new, pool);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+
+    /* the writer thread must be gone before subpools, and with them the
+     * thread's own pool, are destroyed
+     */
+    apr_pool_pre_cleanup_register(pool, new, async_cleanup);
+
+    *async = new;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_file_async_write(apr_file_async_t *async,
+                                               const void *buf,
+                                               apr_size_t nbytes)
+{
+    apr_size_t ringbytes = (apr_size_t)async->ncells * ASYNC_CELL_SIZE;
+    apr_uint32_t pos, need;
+    apr_size_t off;
+    int running;
+
+    if (nbytes > ringbytes || apr_atomic_read32(&async->closing)) {
+        return APR_EINVAL;
+    }
+    if (nbytes == 0) {
+        return APR_SUCCESS;
+    }
+    need = (apr_uint32_t)((nbytes + ASYNC_CELL_SIZE - 1) / ASYNC_CELL_SIZE);
+
+    for (;;) {
+        pos = apr_atomic_read32(&async->head);
+        if (pos + need - apr_atomic_read32(&async->done) <= async->ncells) {
+            if (apr_atomic_cas32(&async->head, pos + need, pos) == pos) {
+                break;
+            }
+            continue;
+        }
+
+        /* the ring is full */
+        if (async->flags & APR_FILE_ASYNC_DROP) {
+            apr_atomic_inc32(&async->dropped);
+            return APR_EAGAIN;
+        }
+        apr_atomic_inc32(&async->blocked);
+        apr_thread_mutex_lock(async->mutex);
+        async->waiters++;
+        while (async->running
+               && apr_atomic_read32(&async->head) + need
+                  - apr_atomic_read32(&async->done) > async->ncells) {
+            apr_thread_cond_signal(async->wakeup);
+            apr_thread_cond_timedwait(async->progress, async->mutex,
+                                      ASYNC_SPACE_WAIT);
+        }
+        async->waiters--;
+        running = async->running;
+        apr_thread_mutex_unlock(async->mutex);
+        if (!running) {
+            return APR_EINVAL;
+        }
+    }
+
+    off = (apr_size_t)(pos & async->mask) * ASYNC_CELL_SIZE;
+    if (off + nbytes > ringbytes) {
+        memcpy(async->data + off, buf, ringbytes - off);
+        memcpy(async->data, (const char *)buf + (ringbytes - off),
+               off + nbytes - ringbytes);
+    }
+    else {
+        memcpy(async->data + off, buf, nbytes);
+    }
+    async->cells[pos & async->mask].len = (apr_uint32_t)nbytes;
+    apr_atomic_xchg32(&async->cells[pos & async->mask].seq, pos + 1);
+
+    wake_writer(async);
+
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_file_async_flush(apr_file_async_t *async)
+{
+    apr_uint32_t target = apr_atomic_read32(&async->head);
+    apr_status_t rv;
+
+    apr_thread_mutex_lock(async->mutex);
+    async->flushes++;
+    async->waiters++;
+    while (async->running
+           && (apr_int32_t)(apr_atomic_read32(&async->done) - target) < 0) {
+        apr_thread_cond_signal(async->wakeup);
+        apr_thread_cond_timedwait(async->progress, async->mutex,
+                                  ASYNC_SPACE_WAIT);
+    }
+    async->waiters--;
+    rv = async->status;
+    apr_thread_mutex_unlock(async->mutex);
+
+    return rv;
+}
+
+APR_DECLARE(void) apr_file_async_stats_get(apr_file_async_t *async,
+                                           apr_file_async_stats_t *stats)
+{
+    apr_thread_mutex_lock(async->mutex);
+    stats->records = async->records;
+    stats->bytes = async->bytes;
+    stats->batches = async->batches;
+    stats->flushes = async->flushes;
+    stats->errors = async->errors;
+    apr_thread_mutex_unlock(async->mutex);
+    stats->dropped = apr_atomic_read32(&async->dropped);
+    stats->blocked = apr_atomic_read32(&async->blocked);
+}
+
+APR_DECLARE(apr_status_t) apr_file_async_close(apr_file_async_t *async)
+{
+    apr_status_t rv, thread_rv;
+
+    if (apr_atomic_xchg32(&async->closing, 1)) {
+        return APR_SUCCESS;
+    }
+
+    apr_thread_mutex_lock(async->mutex);
+    apr_thread_cond_signal(async->wakeup);
+    apr_thread_mutex_unlock(async->mutex);
+
+    rv = apr_thread_join(&thread_rv, async->thread);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    return async->status;
+}
+
+#else  /* !APR_HAS_THREADS */
+
+APR_DECLARE(apr_status_t) apr_file_async_create(apr_file_async_t **async,
+                                                apr_file_t *file,
+                                                apr_size_t ring_size,
+                                                apr_int32_t flags,
+                                                apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_file_async_write(apr_file_async_t *async,
+                                               const void *buf,
+                                               apr_size_t nbytes)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_file_async_flush(apr_file_async_t *async)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(void) apr_file_async_stats_get(apr_file_async_t *async,
+                                           apr_file_async_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+APR_DECLARE(apr_status_t) apr_file_async_close(apr_file_async_t *async)
+{
+    return APR_ENOTIMPL;
+}
+
+#endif /* APR_HAS_THREADS */
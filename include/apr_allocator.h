@@ -74,6 +74,34 @@ struct apr_memnode_t {
 APR_DECLARE(apr_status_t) apr_allocator_create(apr_allocator_t **allocator)
                           __attribute__((nonnull(1)));
 
+/** @see apr_allocator_create_ex */
+#define APR_ALLOCATOR_HUGE_PAGES 0x01 /**< back the regions with huge pages */
+#define APR_ALLOCATOR_NUMA_NODE  0x02 /**< place the regions on a NUMA node */
+
+/**
+ * Create a new allocator which carves its memory nodes out of large
+ * regions, rather than getting each of them from the system.
+ * @param allocator The allocator we have just created.
+ * @param flags APR_ALLOCATOR_HUGE_PAGES and/or APR_ALLOCATOR_NUMA_NODE,
+ *        or 0.
+ * @param region_size The size of the regions, 0 for the default of 4MB;
+ *        rounded up to the huge page size with APR_ALLOCATOR_HUGE_PAGES.
+ * @param numa_node The NUMA node to place the regions on, used with
+ *        APR_ALLOCATOR_NUMA_NODE.  @see apr_cpu_topology_get
+ * @remark With APR_ALLOCATOR_HUGE_PAGES, explicit huge pages (MAP_HUGETLB)
+ * are used when the system has some reserved, else transparent huge pages
+ * are requested; where neither exists the regions get ordinary pages.
+ * The NUMA node is a preference: the kernel falls back on other nodes
+ * once it is full.
+ * @remark The memory is given back to the system when the allocator is
+ * destroyed, and not before: apr_allocator_max_free_set() has no effect.
+ */
+APR_DECLARE(apr_status_t) apr_allocator_create_ex(apr_allocator_t **allocator,
+                                                  apr_uint32_t flags,
+                                                  apr_size_t region_size,
+                                                  int numa_node)
+                          __attribute__((nonnull(1)));
+
 /**
  * Destroy an allocator
  * @param allocator The allocator to be destroyed
@@ -138,6 +166,32 @@ APR_DECLARE(void) apr_allocator_max_free_set(apr_allocator_t *allocator,
                                              apr_size_t size)
                   __attribute__((nonnull(1)));
 
+/** Memory usage of an allocator, @see apr_allocator_stats_get */
+typedef struct apr_allocator_stats_t {
+    apr_size_t system_bytes;  /**< memory obtained from the system */
+    apr_size_t node_bytes;    /**< memory in memnodes, in use or free */
+    apr_size_t free_bytes;    /**< memory in free memnodes */
+    apr_size_t free_nodes;    /**< number of free memnodes */
+    apr_size_t largest_free;  /**< size of the largest free memnode */
+    apr_size_t regions;       /**< regions reserved, @see
+                                   apr_allocator_create_ex */
+    apr_size_t huge_regions;  /**< those of them on explicit huge pages */
+    apr_size_t nodes_reused;  /**< memnodes allocated from the free lists */
+    apr_size_t nodes_new;     /**< memnodes allocated from fresh memory */
+} apr_allocator_stats_t;
+
+/**
+ * Get the memory usage of an allocator.
+ * @param allocator The allocator
+ * @param stats The statistics
+ * @remark node_bytes - free_bytes is what the pools currently hold;
+ * free_bytes against node_bytes measures the fragmentation, and
+ * system_bytes - node_bytes is the part of the regions not carved yet.
+ */
+APR_DECLARE(void) apr_allocator_stats_get(apr_allocator_t *allocator,
+                                          apr_allocator_stats_t *stats)
+                  __attribute__((nonnull(1,2)));
+
 #include "apr_thread_mutex.h"
 
 #if APR_HAS_THREADS
@@ -131,6 +131,173 @@ APR_DECLARE(void*) apr_atomic_casptr(volatile void **mem, void *with, const void
  */
 APR_DECLARE(void*) apr_atomic_xchgptr(volatile void **mem, void *with);
 
+/**
+ * atomically read an apr_uint64_t from memory
+ * @param mem the pointer
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_read64(volatile apr_uint64_t *mem);
+
+/**
+ * atomically set an apr_uint64_t in memory
+ * @param mem pointer to the object
+ * @param val value that the object will assume
+ */
+APR_DECLARE(void) apr_atomic_set64(volatile apr_uint64_t *mem, apr_uint64_t val);
+
+/**
+ * atomically add 'val' to an apr_uint64_t
+ * @param mem pointer to the object
+ * @param val amount to add
+ * @return old value pointed to by mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_add64(volatile apr_uint64_t *mem, apr_uint64_t val);
+
+/**
+ * atomically subtract 'val' from an apr_uint64_t
+ * @param mem pointer to the object
+ * @param val amount to subtract
+ */
+APR_DECLARE(void) apr_atomic_sub64(volatile apr_uint64_t *mem, apr_uint64_t val);
+
+/**
+ * atomically increment an apr_uint64_t by 1
+ * @param mem pointer to the object
+ * @return old value pointed to by mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_inc64(volatile apr_uint64_t *mem);
+
+/**
+ * atomically decrement an apr_uint64_t by 1
+ * @param mem pointer to the atomic value
+ * @return zero if the value becomes zero on decrement, otherwise non-zero
+ */
+APR_DECLARE(int) apr_atomic_dec64(volatile apr_uint64_t *mem);
+
+/**
+ * compare an apr_uint64_t's value with 'cmp'.
+ * If they are the same swap the value with 'with'
+ * @param mem pointer to the value
+ * @param with what to swap it with
+ * @param cmp the value to compare it to
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                           apr_uint64_t cmp);
+
+/**
+ * exchange an apr_uint64_t's value with 'val'.
+ * @param mem pointer to the value
+ * @param val what to swap it with
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_xchg64(volatile apr_uint64_t *mem, apr_uint64_t val);
+
+/**
+ * The memory ordering an atomic operation or fence provides, with the
+ * meaning C11 gives memory_order_relaxed and its siblings.
+ * @remark The functions above without an order argument are full
+ *         barriers, except the read and set functions, which may be
+ *         no stronger than APR_ATOMIC_RELAXED.
+ */
+typedef enum {
+    APR_ATOMIC_RELAXED,     /**< atomicity only, no ordering */
+    APR_ATOMIC_ACQUIRE,     /**< later accesses stay after a read */
+    APR_ATOMIC_RELEASE,     /**< earlier accesses stay before a write */
+    APR_ATOMIC_ACQ_REL,     /**< both acquire and release */
+    APR_ATOMIC_SEQ_CST      /**< a full barrier */
+} apr_atomic_order_e;
+
+/**
+ * order the memory accesses around this call without an atomic operation
+ * @param order APR_ATOMIC_ACQUIRE keeps reads before the fence ahead of
+ *        every access after it, APR_ATOMIC_RELEASE keeps every access
+ *        before the fence ahead of writes after it, and APR_ATOMIC_SEQ_CST
+ *        is a full barrier; APR_ATOMIC_RELAXED does nothing
+ */
+APR_DECLARE(void) apr_atomic_fence(apr_atomic_order_e order);
+
+/**
+ * atomically read an apr_uint32_t with the given ordering
+ * @param mem the pointer
+ * @param order the ordering; APR_ATOMIC_RELEASE is treated as relaxed
+ * @remark Where the platform cannot provide a weaker ordering, a
+ *         stronger one is used.
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_read32_ex(volatile apr_uint32_t *mem,
+                                               apr_atomic_order_e order);
+
+/**
+ * atomically set an apr_uint32_t with the given ordering
+ * @param mem pointer to the object
+ * @param val value that the object will assume
+ * @param order the ordering; APR_ATOMIC_ACQUIRE is treated as relaxed
+ */
+APR_DECLARE(void) apr_atomic_set32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                      apr_atomic_order_e order);
+
+/**
+ * atomically add 'val' to an apr_uint32_t with the given ordering
+ * @param mem pointer to the object
+ * @param val amount to add
+ * @param order the ordering
+ * @return old value pointed to by mem
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_add32_ex(volatile apr_uint32_t *mem, apr_uint32_t val,
+                                              apr_atomic_order_e order);
+
+/**
+ * compare and swap an apr_uint32_t with the given ordering
+ * @param mem pointer to the value
+ * @param with what to swap it with
+ * @param cmp the value to compare it to
+ * @param order the ordering of a successful swap; a failed one is at
+ *        most acquire
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint32_t) apr_atomic_cas32_ex(volatile apr_uint32_t *mem, apr_uint32_t with,
+                                              apr_uint32_t cmp,
+                                              apr_atomic_order_e order);
+
+/**
+ * atomically read an apr_uint64_t with the given ordering
+ * @param mem the pointer
+ * @param order the ordering; APR_ATOMIC_RELEASE is treated as relaxed
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_read64_ex(volatile apr_uint64_t *mem,
+                                               apr_atomic_order_e order);
+
+/**
+ * atomically set an apr_uint64_t with the given ordering
+ * @param mem pointer to the object
+ * @param val value that the object will assume
+ * @param order the ordering; APR_ATOMIC_ACQUIRE is treated as relaxed
+ */
+APR_DECLARE(void) apr_atomic_set64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                      apr_atomic_order_e order);
+
+/**
+ * atomically add 'val' to an apr_uint64_t with the given ordering
+ * @param mem pointer to the object
+ * @param val amount to add
+ * @param order the ordering
+ * @return old value pointed to by mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_add64_ex(volatile apr_uint64_t *mem, apr_uint64_t val,
+                                              apr_atomic_order_e order);
+
+/**
+ * compare and swap an apr_uint64_t with the given ordering
+ * @param mem pointer to the value
+ * @param with what to swap it with
+ * @param cmp the value to compare it to
+ * @param order the ordering of a successful swap; a failed one is at
+ *        most acquire
+ * @return the old value of *mem
+ */
+APR_DECLARE(apr_uint64_t) apr_atomic_cas64_ex(volatile apr_uint64_t *mem, apr_uint64_t with,
+                                              apr_uint64_t cmp,
+                                              apr_atomic_order_e order);
+
 /** @} */
 
 #ifdef __cplusplus
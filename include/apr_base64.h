@@ -120,6 +120,162 @@ APR_DECLARE(int) apr_base64_decode_binary(unsigned char * plain_dst,
                                           const char *coded_src)
                  __attribute__((nonnull(1,2)));
 
+/**
+ * @defgroup APR_Util_Base64_Ex Length-bounded and streaming Base64
+ * @{
+ *
+ * Unlike the functions above, these take the length of the encoded input
+ * rather than relying on a terminating character, never append a \0, and
+ * report invalid input instead of silently stopping at it.  Padding is
+ * optional when decoding.
+ */
+
+/** Use the URL and filename safe alphabet of RFC 4648 ('-' and '_') */
+#define APR_BASE64_URL      0x01
+/** Do not append '=' padding when encoding */
+#define APR_BASE64_NOPAD    0x02
+
+/** @see apr_base64_ctx_t */
+typedef struct apr_base64_ctx_t apr_base64_ctx_t;
+
+/** Base64 streaming state, for encoding or decoding data that arrives
+ *  in pieces (e.g. the buckets of a brigade).  The context holds no
+ *  resources and may live on the stack.
+ */
+struct apr_base64_ctx_t {
+    /** APR_BASE64_* flags given at init time */
+    int flags;
+    /** decoding: number of '=' still acceptable, or -1 before padding */
+    int pad;
+    /** number of bytes (encoding) or characters (decoding) held in buf */
+    apr_size_t n;
+    /** input carried over to the next call */
+    unsigned char buf[4];
+};
+
+/**
+ * Get the exact length of the base64 encoding of len bytes.
+ * @param len The length of the plain data
+ * @param flags APR_BASE64_NOPAD to leave out the padding
+ * @return the length of the encoded data (there is no trailing \0)
+ */
+APR_DECLARE(apr_size_t) apr_base64_encode_len_ex(apr_size_t len, int flags)
+                 __attribute__((pure));
+
+/**
+ * Base64 encode a buffer.
+ * @param coded_dst The destination, at least apr_base64_encode_len_ex()
+ * bytes long.  No \0 is appended.
+ * @param plain_src The data to encode
+ * @param len The length of the data to encode
+ * @param flags Bitwise OR of APR_BASE64_URL and APR_BASE64_NOPAD
+ * @return the number of characters written to coded_dst
+ */
+APR_DECLARE(apr_size_t) apr_base64_encode_ex(char *coded_dst,
+                                             const unsigned char *plain_src,
+                                             apr_size_t len, int flags)
+                 __attribute__((nonnull(1,2)));
+
+/**
+ * Get the maximum length of the data decoded from len base64 characters.
+ * @param len The length of the encoded input
+ * @return the maximum number of bytes the input decodes to
+ */
+APR_DECLARE(apr_size_t) apr_base64_decode_len_ex(apr_size_t len)
+                 __attribute__((pure));
+
+/**
+ * Base64 decode exactly len characters; the input needs no terminator.
+ * @param plain_dst The destination, at least apr_base64_decode_len_ex(len)
+ * bytes long.  No \0 is appended.
+ * @param plain_len Set to the number of bytes written to plain_dst
+ * @param coded_src The encoded input
+ * @param len The length of the encoded input
+ * @param flags APR_BASE64_URL to decode the URL and filename safe alphabet
+ * @return APR_SUCCESS, or APR_EINVAL if the input contains a character
+ * outside the alphabet, misplaced padding or is truncated
+ */
+APR_DECLARE(apr_status_t) apr_base64_decode_ex(unsigned char *plain_dst,
+                                               apr_size_t *plain_len,
+                                               const char *coded_src,
+                                               apr_size_t len, int flags)
+                 __attribute__((nonnull(1,2,3)));
+
+/**
+ * Initialize a context for streaming base64 encoding.
+ * @param ctx The context to initialize
+ * @param flags Bitwise OR of APR_BASE64_URL and APR_BASE64_NOPAD
+ */
+APR_DECLARE(void) apr_base64_encode_init(apr_base64_ctx_t *ctx, int flags)
+                 __attribute__((nonnull(1)));
+
+/**
+ * Encode the next piece of the data.  Input that does not fill a whole
+ * 3-byte group is kept in the context until the next call.
+ * @param ctx The encoding context
+ * @param coded_dst The destination, at least ((len + 2) / 3) * 4 bytes long
+ * @param plain_src The next piece of data
+ * @param len The length of the piece
+ * @return the number of characters written to coded_dst
+ */
+APR_DECLARE(apr_size_t) apr_base64_encode_update(apr_base64_ctx_t *ctx,
+                                                 char *coded_dst,
+                                                 const unsigned char *plain_src,
+                                                 apr_size_t len)
+                 __attribute__((nonnull(1,2)));
+
+/**
+ * Finish streaming base64 encoding, flushing the carried-over input.
+ * @param ctx The encoding context
+ * @param coded_dst The destination, at least 4 bytes long
+ * @return the number of characters written to coded_dst
+ */
+APR_DECLARE(apr_size_t) apr_base64_encode_final(apr_base64_ctx_t *ctx,
+                                                char *coded_dst)
+                 __attribute__((nonnull(1,2)));
+
+/**
+ * Initialize a context for streaming base64 decoding.
+ * @param ctx The context to initialize
+ * @param flags APR_BASE64_URL to decode the URL and filename safe alphabet
+ */
+APR_DECLARE(void) apr_base64_decode_init(apr_base64_ctx_t *ctx, int flags)
+                 __attribute__((nonnull(1)));
+
+/**
+ * Decode the next piece of the encoded input.  Characters that do not
+ * complete a 4-character group are kept in the context until the next
+ * call.
+ * @param ctx The decoding context
+ * @param plain_dst The destination, at least apr_base64_decode_len_ex(len)
+ * bytes long
+ * @param plain_len Set to the number of bytes written to plain_dst
+ * @param coded_src The next piece of the encoded input
+ * @param len The length of the piece
+ * @return APR_SUCCESS, or APR_EINVAL on invalid input, in which case
+ * plain_len holds the bytes decoded before the offending character
+ */
+APR_DECLARE(apr_status_t) apr_base64_decode_update(apr_base64_ctx_t *ctx,
+                                                   unsigned char *plain_dst,
+                                                   apr_size_t *plain_len,
+                                                   const char *coded_src,
+                                                   apr_size_t len)
+                 __attribute__((nonnull(1,2,3)));
+
+/**
+ * Finish streaming base64 decoding.
+ * @param ctx The decoding context
+ * @param plain_dst The destination, at least 2 bytes long
+ * @param plain_len Set to the number of bytes written to plain_dst
+ * @return APR_SUCCESS, or APR_EINVAL if the input was truncated
+ */
+APR_DECLARE(apr_status_t) apr_base64_decode_final(apr_base64_ctx_t *ctx,
+                                                  unsigned char *plain_dst,
+                                                  apr_size_t *plain_len)
+                 __attribute__((nonnull(1,2,3)));
+
+/** @} */
+
 /** @} */
 #ifdef __cplusplus
 }
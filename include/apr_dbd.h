@@ -121,7 +121,13 @@ APR_DECLARE(apr_status_t) apr_dbd_get_driver(apr_pool_t *pool, const char *name,
  *  mode.
  *  @remarks SQLite3: the params is passed directly to the sqlite3_open()
  *  function as a filename to be opened (check SQLite3 documentation for more
- *  details).
+ *  details). Alternatively, the params can have "file", "busy_timeout",
+ *  "journal_mode" and "synchronous" keys, each followed by an equal sign and
+ *  a value, delimited as for Oracle. "busy_timeout" is the number of
+ *  milliseconds a statement waits for locks held by other connections
+ *  (1500 by default); "journal_mode" (e.g. WAL) and "synchronous" (e.g.
+ *  NORMAL) are applied as PRAGMAs. Each connection is locked separately, so
+ *  threads using their own connections do not serialize on each other.
  *  @remarks Oracle: the params can have "user", "pass", "dbname" and "server"
  *  keys, each followed by an equal sign and a value. Such key/value pairs can
  *  be delimited by space, CR, LF, tab, semicolon, vertical bar or comma.
@@ -274,6 +280,16 @@ APR_DECLARE(int) apr_dbd_transaction_mode_set(const apr_dbd_driver_t *driver,
 APR_DECLARE(int) apr_dbd_query(const apr_dbd_driver_t *driver, apr_dbd_t *handle,
                                int *nrows, const char *statement);
 
+/**
+ * Value of the random argument of the select functions: loop through the
+ * results in order without copying them.  Where a driver supports it, every
+ * apr_dbd_get_row() returns the same row, and the row and its entries are
+ * only valid until the next apr_dbd_get_row() on the result set or until
+ * another statement is executed on the connection.  Other drivers treat it
+ * as random access.
+ */
+#define APR_DBD_SELECT_STREAM 2
+
 /** apr_dbd_select: execute an SQL query that returns a result set
  *
  *  @param driver - the driver
@@ -283,7 +299,9 @@ APR_DECLARE(int) apr_dbd_query(const apr_dbd_driver_t *driver, apr_dbd_t *handle
  *  @param statement - the SQL statement to execute
  *  @param random - 1 to support random access to results (seek any row);
  *                  0 to support only looping through results in order
- *                    (async access - faster)
+ *                    (async access - faster);
+ *                  APR_DBD_SELECT_STREAM to loop through them in order
+ *                    without copying
  *  @return 0 for success or error code
  */
 APR_DECLARE(int) apr_dbd_select(const apr_dbd_driver_t *driver, apr_pool_t *pool,
@@ -318,6 +336,8 @@ APR_DECLARE(int) apr_dbd_num_tuples(const apr_dbd_driver_t *driver,
  *  @param rownum - row number (counting from 1), or -1 for "next row".
  *                  Ignored if random access is not supported.
  *  @return 0 for success, -1 for rownum out of range or data finished
+ *  @remark Results selected with APR_DBD_SELECT_STREAM may reuse one row
+ *  for every call, see APR_DBD_SELECT_STREAM.
  */
 APR_DECLARE(int) apr_dbd_get_row(const apr_dbd_driver_t *driver, apr_pool_t *pool,
                                  apr_dbd_results_t *res, apr_dbd_row_t **row,
@@ -481,6 +501,33 @@ APR_DECLARE(int) apr_dbd_pbquery(const apr_dbd_driver_t *driver,
                                  int *nrows, apr_dbd_prepared_t *statement,
                                  const void **args);
 
+/** apr_dbd_pbquery_batch: query using a prepared statement once for each
+ *  of several sets of binary args
+ *
+ *  @param driver - the driver
+ *  @param pool - working pool
+ *  @param handle - the connection
+ *  @param nrows - total number of rows affected.
+ *  @param statement - the prepared statement to execute
+ *  @param nsets - number of arg sets
+ *  @param args - array of nsets binary arg arrays, each as for
+ *  apr_dbd_pbquery()
+ *  @param trans - the transaction in progress on the connection, or NULL
+ *  @return 0 for success or error code
+ *  @remarks Execution stops at the first arg set that fails. If trans is
+ *  NULL and no transaction is in progress on the connection, the whole
+ *  batch runs in a transaction of its own, which is rolled back on failure;
+ *  otherwise it is left to the transaction in progress.
+ *  @remarks Drivers that can bind several arg sets at once do so; others
+ *  execute the statement once per set.
+ */
+APR_DECLARE(int) apr_dbd_pbquery_batch(const apr_dbd_driver_t *driver,
+                                       apr_pool_t *pool, apr_dbd_t *handle,
+                                       int *nrows,
+                                       apr_dbd_prepared_t *statement,
+                                       int nsets, const void ***args,
+                                       apr_dbd_transaction_t *trans);
+
 /** apr_dbd_pbselect: select using a prepared statement + binary args
  *
  *  @param driver - the driver
@@ -543,6 +590,114 @@ APR_DECLARE(apr_status_t) apr_dbd_datum_get(const apr_dbd_driver_t *driver,
                                             apr_dbd_row_t *row, int col,
                                             apr_dbd_type_e type, void *data);
 
+/** A column value in the driver's own buffers, valid as long as an entry
+ *  returned by apr_dbd_get_entry() for the same row would be
+ */
+typedef struct apr_dbd_span_t {
+    const char *data;   /**< First byte of the value, not NUL terminated */
+    apr_size_t len;     /**< Length of the value in bytes */
+} apr_dbd_span_t;
+
+/** apr_dbd_get_int64: get an entry from a row as an integer
+ *
+ *  @param driver - the driver
+ *  @param row - row pointer
+ *  @param col - entry number
+ *  @param value - where to store the value
+ *  @return APR_SUCCESS, APR_ENOENT if the entry is NULL, APR_EINVAL if it is
+ *  not a number or APR_EGENERAL if col is out of bounds
+ *  @remark Unlike apr_dbd_datum_get(), the typed accessors read the driver's
+ *  native value where it has one and never allocate.
+ *  @remark Drivers without native typed access, which is all but sqlite3,
+ *  are read through apr_dbd_get_entry().  It returns NULL both for a NULL
+ *  entry and for an out of bounds col, so with those drivers an out of
+ *  bounds col gives APR_ENOENT rather than APR_EGENERAL.
+ */
+APR_DECLARE(apr_status_t) apr_dbd_get_int64(const apr_dbd_driver_t *driver,
+                                            apr_dbd_row_t *row, int col,
+                                            apr_int64_t *value);
+
+/** apr_dbd_get_double: get an entry from a row as a floating point number
+ *
+ *  @param driver - the driver
+ *  @param row - row pointer
+ *  @param col - entry number
+ *  @param value - where to store the value
+ *  @return APR_SUCCESS, APR_ENOENT if the entry is NULL, APR_EINVAL if it is
+ *  not a number or APR_EGENERAL if col is out of bounds
+ *  @remark See apr_dbd_get_int64() for out of bounds columns.
+ */
+APR_DECLARE(apr_status_t) apr_dbd_get_double(const apr_dbd_driver_t *driver,
+                                             apr_dbd_row_t *row, int col,
+                                             double *value);
+
+/** apr_dbd_get_text: get an entry from a row as text with its length
+ *
+ *  @param driver - the driver
+ *  @param row - row pointer
+ *  @param col - entry number
+ *  @param span - where to store the location and length of the text
+ *  @return APR_SUCCESS, APR_ENOENT if the entry is NULL or APR_EGENERAL if
+ *  col is out of bounds
+ *  @remark See apr_dbd_get_int64() for out of bounds columns.
+ */
+APR_DECLARE(apr_status_t) apr_dbd_get_text(const apr_dbd_driver_t *driver,
+                                           apr_dbd_row_t *row, int col,
+                                           apr_dbd_span_t *span);
+
+/** apr_dbd_get_blob: get a binary entry from a row without copying it
+ *
+ *  @param driver - the driver
+ *  @param row - row pointer
+ *  @param col - entry number
+ *  @param span - where to store the location and length of the data
+ *  @return APR_SUCCESS, APR_ENOENT if the entry is NULL, APR_EGENERAL if
+ *  col is out of bounds or APR_ENOTIMPL if the driver only provides binary
+ *  data through apr_dbd_datum_get()
+ */
+APR_DECLARE(apr_status_t) apr_dbd_get_blob(const apr_dbd_driver_t *driver,
+                                           apr_dbd_row_t *row, int col,
+                                           apr_dbd_span_t *span);
+
+/** Counters of a connection's prepared statement cache */
+typedef struct apr_dbd_stmt_cache_stats_t {
+    apr_uint64_t hits;       /**< Statements found in the cache */
+    apr_uint64_t misses;     /**< Statements that had to be prepared */
+    apr_uint64_t evictions;  /**< Statements pushed out by newer ones */
+    int entries;             /**< Statements currently cached */
+    int size;                /**< Maximum number of cached statements */
+} apr_dbd_stmt_cache_stats_t;
+
+/** apr_dbd_stmt_cache_set: resize a connection's prepared statement cache
+ *
+ *  @param driver - the driver
+ *  @param handle - the connection
+ *  @param size - number of statements to keep, 0 to disable the cache
+ *  @return APR_SUCCESS, or APR_ENOTIMPL if the driver cannot cache
+ *  @remark Drivers supporting it give each connection a cache of the 32
+ *  most recently used statements, keyed by their SQL text.  apr_dbd_query()
+ *  and apr_dbd_select() execute cached statements instead of preparing
+ *  their SQL on every call, unless it holds more than one statement.
+ *  apr_dbd_prepare() without a label returns the statement it prepared
+ *  earlier for the same query.  Evicted statements from apr_dbd_prepare()
+ *  stay valid until the connection is closed.
+ */
+APR_DECLARE(apr_status_t) apr_dbd_stmt_cache_set(const apr_dbd_driver_t *driver,
+                                                 apr_dbd_t *handle, int size);
+
+/** apr_dbd_stmt_cache_stats_get: get the counters of a connection's
+ *  prepared statement cache
+ *
+ *  @param driver - the driver
+ *  @param handle - the connection
+ *  @param stats - the counters, filled in on return
+ *  @return APR_SUCCESS, or APR_ENOTIMPL if the driver cannot cache
+ */
+APR_DECLARE(apr_status_t) apr_dbd_stmt_cache_stats_get(
+                                              const apr_dbd_driver_t *driver,
+                                              apr_dbd_t *handle,
+                                              apr_dbd_stmt_cache_stats_t *stats);
+
 /** @} */
 
 #ifdef __cplusplus
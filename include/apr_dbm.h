@@ -67,6 +67,7 @@ typedef struct
  *  gdbm for GDBM files
  *  ndbm for NDBM files
  *  sdbm for SDBM files (always available)
+ *  cdb  for constant databases (always available)
  *  default for the default DBM type
  *  </pre>
  * @param name The dbm file name to open
@@ -81,6 +82,14 @@ typedef struct
  * @param cntxt The pool to use when creating the dbm
  * @remark The dbm name may not be a true file name, as many dbm packages
  * append suffixes for seperate data and index files.
+ * @remark A cdb database is built to be read many times by many processes:
+ * opened read-only, it is memory mapped and needs no locking.  Opened for
+ * writing, its records are held in memory and written out when it is
+ * closed, to a temporary file renamed over the old one, so readers see
+ * either the old database or the new one; concurrent writers are not
+ * serialized and the last one to close wins.  Keys and values returned
+ * from a read-only cdb database point into the mapping and must not be
+ * modified.
  * @bug In apr-util 0.9 and 1.x, the type arg was case insensitive.  This
  * was highly inefficient, and as of 2.x the dbm name must be provided in
  * the correct case (lower case for all bundled providers)
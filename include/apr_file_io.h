@@ -983,6 +983,95 @@ APR_DECLARE(apr_status_t) apr_temp_dir_get(const char **temp_dir,
 APR_DECLARE(apr_status_t) apr_file_rotating_check(apr_file_t *thefile);
 APR_DECLARE(apr_status_t) apr_file_rotating_manual_check(apr_file_t *thefile, apr_time_t time);
 
+/**
+ * @defgroup apr_file_async Asynchronous File Appender
+ * @{
+ */
+
+/** Opaque structure used for the asynchronous appender */
+typedef struct apr_file_async_t apr_file_async_t;
+
+#define APR_FILE_ASYNC_DROP  0x1  /**< Drop records rather than block the
+                                       writer when the ring is full */
+
+/** Counters maintained by the asynchronous appender */
+typedef struct apr_file_async_stats_t {
+    apr_uint64_t records;   /**< Records handed to the file */
+    apr_uint64_t bytes;     /**< Bytes handed to the file */
+    apr_uint64_t batches;   /**< Number of writev() batches issued */
+    apr_uint32_t dropped;   /**< Records discarded because the ring was full */
+    apr_uint32_t blocked;   /**< Writes that had to wait for ring space */
+    apr_uint32_t flushes;   /**< Calls to apr_file_async_flush() */
+    apr_uint32_t errors;    /**< Batches that could not be written */
+} apr_file_async_stats_t;
+
+/**
+ * Attach an asynchronous appender to an open file.
+ * @param async The newly created appender.
+ * @param file The file records are appended to, opened for writing.
+ * @param ring_size The capacity of the record ring in bytes; it is
+ *        rounded up to a power of two.  Zero selects a 256KB ring.
+ * @param flags Zero, or #APR_FILE_ASYNC_DROP.
+ * @param pool The pool to allocate the appender out of.
+ * @remark Writers copy their records into a lock-free ring and return;
+ * a background thread drains the ring, gathers the pending records into
+ * a single apr_file_writev_full() call and performs the rotation check
+ * of files opened with #APR_FOPEN_ROTATING, so neither the stat() nor
+ * the reopen happens on the caller's thread.  Once attached, the file
+ * must not be written to or closed except through the appender.  The
+ * appender is drained and its thread joined when @a pool is cleared, or
+ * when apr_file_async_close() is called.
+ * @remark Returns APR_ENOTIMPL on platforms without threads.
+ */
+APR_DECLARE(apr_status_t) apr_file_async_create(apr_file_async_t **async,
+                                                apr_file_t *file,
+                                                apr_size_t ring_size,
+                                                apr_int32_t flags,
+                                                apr_pool_t *pool);
+
+/**
+ * Queue a record for appending to the file.
+ * @param async The appender to write to.
+ * @param buf The record to write.
+ * @param nbytes The length of the record.
+ * @remark The record is written to the file as one piece and is never
+ * interleaved with records from other threads.  When the ring is full
+ * the call waits for the background thread, or with
+ * #APR_FILE_ASYNC_DROP discards the record and returns APR_EAGAIN.
+ * APR_EINVAL is returned for records larger than the ring and after the
+ * appender has been closed.
+ */
+APR_DECLARE(apr_status_t) apr_file_async_write(apr_file_async_t *async,
+                                               const void *buf,
+                                               apr_size_t nbytes);
+
+/**
+ * Wait until every record queued before the call has been handed to
+ * the file.
+ * @param async The appender to flush.
+ * @return The first error reported by the file since the appender was
+ * created, or APR_SUCCESS.
+ */
+APR_DECLARE(apr_status_t) apr_file_async_flush(apr_file_async_t *async);
+
+/**
+ * Retrieve a snapshot of the appender's counters.
+ * @param async The appender to query.
+ * @param stats Filled in with the current counters.
+ */
+APR_DECLARE(void) apr_file_async_stats_get(apr_file_async_t *async,
+                                           apr_file_async_stats_t *stats);
+
+/**
+ * Drain the ring and stop the background thread.
+ * @param async The appender to close.
+ * @remark The file itself is left open.  No thread may be writing to the
+ * appender while it is closed.
+ */
+APR_DECLARE(apr_status_t) apr_file_async_close(apr_file_async_t *async);
+
+/** @} */
+
 /** @} */
 
 
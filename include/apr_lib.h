@@ -27,6 +27,7 @@
 
 #include "apr.h"
 #include "apr_errno.h"
+#include "apr_pools.h"
 
 #if APR_HAVE_CTYPE_H
 #include <ctype.h>
@@ -175,6 +176,81 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *b),
 			        apr_vformatter_buff_t *c, const char *fmt,
 			        va_list ap);
 
+/** @see apr_vformatter_plan_create */
+typedef struct apr_vformatter_plan_t apr_vformatter_plan_t;
+
+/**
+ * An argument for apr_vformatter_plan_exec_args().  Integers of any
+ * size are passed in i (signed conversions and the '*' width or
+ * precision, where a negative width left-adjusts) or u (unsigned
+ * conversions), floating point values in d and strings and all other
+ * pointers in p.
+ */
+typedef union apr_vformatter_arg_t {
+    /** signed integer argument */
+    apr_int64_t i;
+    /** unsigned integer argument */
+    apr_uint64_t u;
+    /** floating point argument */
+    double d;
+    /** string or pointer argument */
+    const void *p;
+} apr_vformatter_arg_t;
+
+/**
+ * Compile a format string into a plan for repeated formatting with
+ * apr_vformatter_plan_exec() or apr_vformatter_plan_exec_args().
+ * The format is parsed and its conversions validated once, rather
+ * than on every call as with apr_vformatter().
+ * @param plan The compiled plan
+ * @param fmt The format string, as for apr_vformatter()
+ * @param p The pool to allocate the plan (and a copy of fmt) from
+ * @return APR_EINVAL if fmt contains an unknown conversion or ends
+ *         with an incomplete one, APR_SUCCESS otherwise
+ */
+APR_DECLARE(apr_status_t) apr_vformatter_plan_create(
+                                  apr_vformatter_plan_t **plan,
+                                  const char *fmt, apr_pool_t *p);
+
+/**
+ * Return the number of arguments a plan consumes, including the
+ * arguments for '*' widths and precisions.
+ * @param plan The compiled plan
+ */
+APR_DECLARE(int) apr_vformatter_plan_nargs(const apr_vformatter_plan_t *plan);
+
+/**
+ * Format using a compiled plan, exactly as apr_vformatter() would
+ * format with the plan's format string.
+ * @param flush_func The function to call when the buffer is full
+ * @param c The buffer to write to
+ * @param plan The compiled plan
+ * @param ap The arguments to use to fill out the format string.
+ * @return The number of bytes written, or -1 if flush_func failed
+ */
+APR_DECLARE(int) apr_vformatter_plan_exec(
+                                  int (*flush_func)(apr_vformatter_buff_t *b),
+                                  apr_vformatter_buff_t *c,
+                                  const apr_vformatter_plan_t *plan,
+                                  va_list ap);
+
+/**
+ * Format using a compiled plan, taking the arguments from an array.
+ * @param flush_func The function to call when the buffer is full
+ * @param c The buffer to write to
+ * @param plan The compiled plan
+ * @param argv The arguments, in the order the format consumes them
+ * @param argc The number of elements in argv
+ * @return The number of bytes written, or -1 if flush_func failed or
+ *         argc is less than apr_vformatter_plan_nargs()
+ */
+APR_DECLARE(int) apr_vformatter_plan_exec_args(
+                                  int (*flush_func)(apr_vformatter_buff_t *b),
+                                  apr_vformatter_buff_t *c,
+                                  const apr_vformatter_plan_t *plan,
+                                  const apr_vformatter_arg_t *argv,
+                                  int argc);
+
 /**
  * Display a prompt and read in the password from stdin.
  * @param prompt The prompt to display
@@ -129,6 +129,19 @@ APR_DECLARE(apr_status_t) apr_md5(unsigned char digest[APR_MD5_DIGESTSIZE],
                                   const void *input,
                                   apr_size_t inputLen);
 
+/**
+ * MD5 several independent messages at once.  Where the compiler supports
+ * it, up to eight messages are hashed side by side in SIMD lanes, which is
+ * considerably faster than one at a time.
+ * @param digests n output buffers of APR_MD5_DIGESTSIZE bytes each
+ * @param inputs The n messages
+ * @param lens The lengths of the n messages
+ * @param n The number of messages
+ */
+APR_DECLARE(apr_status_t) apr_md5_multi(unsigned char *const *digests,
+                                        const void *const *inputs,
+                                        const apr_size_t *lens, int n);
+
 /**
  * Encode a password using an MD5 algorithm
  * @param password The password to encode
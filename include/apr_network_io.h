@@ -105,6 +105,12 @@ extern "C" {
                                     */
 #define APR_SO_BROADCAST     65536 /**< Allow broadcast
                                     */
+#define APR_SO_REUSEPORT    131072 /**< Allow several sockets to bind
+                                    * the same address and port, the
+                                    * kernel spreading connections
+                                    * between them.
+                                    * @see apr_socket_listen_group_create
+                                    */
 
 /** @} */
 
@@ -222,6 +228,8 @@ typedef struct apr_hdtr_t       apr_hdtr_t;
 typedef struct in_addr          apr_in_addr_t;
 /** A structure to represent an IP subnet */
 typedef struct apr_ipsubnet_t apr_ipsubnet_t;
+/** A structure to represent a set of IP subnets */
+typedef struct apr_ipset_t apr_ipset_t;
 
 /** @remark use apr_uint16_t just in case some system has a short that isn't 16 bits... */
 typedef apr_uint16_t            apr_port_t;
@@ -376,6 +384,67 @@ APR_DECLARE(apr_status_t) apr_socket_accept(apr_socket_t **new_sock,
 APR_DECLARE(apr_status_t) apr_socket_connect(apr_socket_t *sock,
                                              apr_sockaddr_t *sa);
 
+/**
+ * Accept as many pending connections as are queued on a listening
+ * socket, up to a limit, so that one wakeup can serve a burst.
+ * @param new_socks An array of at least @a n sockets, filled with the
+ *                  connections accepted.
+ * @param sock The socket we are listening on.
+ * @param connection_pools An array of @a n pools; the i-th connection is
+ *                  allocated from the i-th pool.
+ * @param n The most connections to accept.
+ * @param naccepted Set to the number of connections accepted.
+ * @return The error of the first accept if no connection was accepted,
+ *         otherwise APR_SUCCESS.  An error after the first connection
+ *         just ends the batch; it will be reported by the next call.
+ * @remark Only the first accept may block.  The rest take only what is
+ *         already queued, which with a shared listening socket means
+ *         another process may win the race and shorten the batch.
+ */
+APR_DECLARE(apr_status_t) apr_socket_accept_batch(apr_socket_t **new_socks,
+                                                  apr_socket_t *sock,
+                                                  apr_pool_t **connection_pools,
+                                                  int n, int *naccepted);
+
+/**
+ * @defgroup apr_listen_group_flags Listener group flags
+ * @{
+ */
+/** Send each connection to the listener whose index is the CPU that
+ *  received it, modulo the group size (Linux only). */
+#define APR_LISTEN_GROUP_STEER_CPU 0x01
+/** @} */
+
+/**
+ * Create a group of listening sockets bound to the same address with
+ * APR_SO_REUSEPORT, so that each worker can accept from a queue of its
+ * own instead of all of them waking up for a single shared socket.
+ * @param socks An array of @a n sockets to fill in.
+ * @param n The number of listeners, typically one per worker or CPU.
+ * @param sa The address to bind to.  If its port is 0, the first socket
+ *           is given an ephemeral port and the others share it.
+ * @param type The type of the sockets (e.g., SOCK_STREAM).
+ * @param protocol The protocol of the sockets (e.g., APR_PROTO_TCP).
+ * @param backlog The listen queue size of each socket.
+ * @param flags Zero or APR_LISTEN_GROUP_STEER_CPU, to have the kernel
+ *           pick the listener by the CPU the connection arrived on; a
+ *           listener should then be served by a thread pinned to it.
+ * @param p The pool for the sockets.
+ * @return APR_ENOTIMPL if the platform does not have SO_REUSEPORT, or
+ *         cannot steer connections when asked to.  On error no socket
+ *         is left open.
+ * @remark Without steering, the kernel picks a listener by hashing the
+ *         connection's addresses and ports.
+ */
+APR_DECLARE(apr_status_t) apr_socket_listen_group_create(apr_socket_t **socks,
+                                                         int n,
+                                                         apr_sockaddr_t *sa,
+                                                         int type,
+                                                         int protocol,
+                                                         apr_int32_t backlog,
+                                                         apr_int32_t flags,
+                                                         apr_pool_t *p);
+
 /**
  * Determine whether the receive part of the socket has been closed by
  * the peer (such that a subsequent call to apr_socket_read would
@@ -422,6 +491,84 @@ APR_DECLARE(apr_status_t) apr_sockaddr_info_get(apr_sockaddr_t **sa,
                                           apr_int32_t flags,
                                           apr_pool_t *p);
 
+/**
+ * Enable, reconfigure or disable the process-wide cache consulted by
+ * apr_sockaddr_info_get() for host names.  Any existing entries are
+ * discarded.
+ * @param ttl How long a successful lookup is reused; zero or less
+ *            disables the cache.
+ * @param negative_ttl How long a lookup failure saying the name does not
+ *            exist or has no addresses is remembered, or zero to never
+ *            cache failures.  Other failures are never cached.
+ * @param max_entries The number of host names to hold; the cache is
+ *            emptied when it fills up.
+ * @remark The resolver does not report record lifetimes, so @a ttl is an
+ *         upper bound chosen by the application rather than the one
+ *         published in the DNS.
+ * @remark The cache is not safe to reconfigure while other threads are
+ *         resolving names.
+ */
+APR_DECLARE(apr_status_t) apr_sockaddr_cache_set(apr_interval_time_t ttl,
+                                                 apr_interval_time_t negative_ttl,
+                                                 unsigned int max_entries);
+
+/**
+ * Discard all entries in the resolver cache, if it is enabled.
+ */
+APR_DECLARE(void) apr_sockaddr_cache_flush(void);
+
+/**
+ * Report how many host name lookups were answered from the resolver
+ * cache, and how many had to ask the resolver, since it was enabled.
+ * @param hits The number of lookups answered from the cache.
+ * @param misses The number of lookups passed on to the resolver.
+ */
+APR_DECLARE(void) apr_sockaddr_cache_stats(apr_size_t *hits,
+                                           apr_size_t *misses);
+
+#if APR_HAS_THREADS || defined(DOXYGEN)
+
+struct apr_thread_pool;
+
+/**
+ * The completion callback of apr_sockaddr_info_get_async().
+ * @param baton The baton passed to apr_sockaddr_info_get_async().
+ * @param status The result of the lookup.
+ * @param sa The addresses found, allocated from the lookup's pool, or
+ *           NULL if @a status is not APR_SUCCESS.
+ */
+typedef void (apr_sockaddr_info_cb_t)(void *baton, apr_status_t status,
+                                      apr_sockaddr_t *sa);
+
+/**
+ * Resolve a host name on a thread of a thread pool, as
+ * apr_sockaddr_info_get() would, and pass the result to a callback.
+ * @param tp The thread pool to run the lookup on.
+ * @param hostname The hostname or numeric address string to resolve.
+ * @param family The address family to use, or APR_UNSPEC.
+ * @param port The port number.
+ * @param flags As for apr_sockaddr_info_get().
+ * @param cb The function to call, on the thread pool's thread, once the
+ *           lookup is done.
+ * @param baton Passed to @a cb; also the owner of the queued task, so
+ *           lookups not yet started can be withdrawn with
+ *           apr_thread_pool_tasks_cancel().
+ * @param p The pool for the result.
+ * @remark @a p is allocated from on the thread pool's thread until @a cb
+ *         has run, so the caller must not use or clear it meanwhile, and
+ *         it should have an allocator of its own.
+ */
+APR_DECLARE(apr_status_t) apr_sockaddr_info_get_async(struct apr_thread_pool *tp,
+                                                      const char *hostname,
+                                                      apr_int32_t family,
+                                                      apr_port_t port,
+                                                      apr_int32_t flags,
+                                                      apr_sockaddr_info_cb_t *cb,
+                                                      void *baton,
+                                                      apr_pool_t *p);
+
+#endif /* APR_HAS_THREADS */
+
 
 /**
  * Look up the host name from an apr_sockaddr_t.
@@ -570,6 +717,56 @@ APR_DECLARE(apr_status_t) apr_socket_recvfrom(apr_sockaddr_t *from,
                                               apr_socket_t *sock,
                                               apr_int32_t flags, char *buf, 
                                               apr_size_t *len);
+
+/** A datagram for apr_socket_sendmmsg() and apr_socket_recvmmsg(). */
+typedef struct apr_socket_msg_t {
+    /** Where to send the datagram, or an address (with its pool set) to
+     *  overwrite with that of its sender, as for apr_socket_recvfrom();
+     *  NULL when sending on, or receiving from, a connected socket */
+    apr_sockaddr_t *addr;
+    /** The data to send, or the buffer to receive into */
+    char *buf;
+    /** The length of the data or buffer; on return from
+     *  apr_socket_recvmmsg(), the length of the datagram received */
+    apr_size_t len;
+} apr_socket_msg_t;
+
+/**
+ * Send several datagrams, each with its own destination, with as few
+ * system calls as the platform allows.
+ * @param sock The socket to send on
+ * @param msgs The datagrams to send
+ * @param nmsgs The number of datagrams in @a msgs
+ * @param flags The flags to use, as for apr_socket_sendto()
+ * @param nsent Set to the number of datagrams sent
+ * @return The error that stopped the first datagram if none was sent,
+ *         otherwise APR_SUCCESS, even if @a *nsent is less than @a nmsgs.
+ * @remark On Linux, a run of datagrams for the same destination whose
+ *         lengths are equal (the last may be shorter) goes to the kernel
+ *         as one UDP_SEGMENT (GSO) send where supported.
+ */
+APR_DECLARE(apr_status_t) apr_socket_sendmmsg(apr_socket_t *sock,
+                                              apr_socket_msg_t *msgs,
+                                              int nmsgs, apr_int32_t flags,
+                                              int *nsent);
+
+/**
+ * Receive several datagrams with as few system calls as the platform
+ * allows.  Only the first datagram is waited for, according to the
+ * socket's timeout; after it, only what is already queued is read.
+ * @param sock The socket to receive on
+ * @param msgs The buffers to receive into; see apr_socket_msg_t
+ * @param nmsgs The number of buffers in @a msgs
+ * @param flags The flags to use, as for apr_socket_recvfrom()
+ * @param nrecv Set to the number of datagrams received
+ * @return The error that stopped the first datagram if none was
+ *         received, otherwise APR_SUCCESS.
+ * @remark A datagram longer than its buffer is truncated.
+ */
+APR_DECLARE(apr_status_t) apr_socket_recvmmsg(apr_socket_t *sock,
+                                              apr_socket_msg_t *msgs,
+                                              int nmsgs, apr_int32_t flags,
+                                              int *nrecv);
  
 #if APR_HAS_SENDFILE || defined(DOXYGEN)
 
@@ -650,6 +847,8 @@ APR_DECLARE(apr_status_t) apr_socket_wait(apr_socket_t *sock,
  *                                  supplied to bind should allow reuse
  *                                  of local addresses.
  *            APR_SO_SNDBUF     --  Set the SendBufferSize
+ *            APR_SO_REUSEPORT  --  Let several sockets bind the same
+ *                                  address and port (where supported).
  *            APR_SO_RCVBUF     --  Set the ReceiveBufferSize
  * </PRE>
  * @param on Value for the option.
@@ -684,6 +883,8 @@ APR_DECLARE(apr_status_t) apr_socket_timeout_set(apr_socket_t *sock,
  *                                  supplied to bind should allow reuse
  *                                  of local addresses.
  *            APR_SO_SNDBUF     --  Set the SendBufferSize
+ *            APR_SO_REUSEPORT  --  Let several sockets bind the same
+ *                                  address and port (where supported).
  *            APR_SO_RCVBUF     --  Set the ReceiveBufferSize
  *            APR_SO_DISCONNECTED -- Query the disconnected state of the socket.
  *                                  (Currently only used on Windows)
@@ -790,6 +991,55 @@ APR_DECLARE(apr_status_t) apr_ipsubnet_create(apr_ipsubnet_t **ipsub,
  */
 APR_DECLARE(int) apr_ipsubnet_test(apr_ipsubnet_t *ipsub, apr_sockaddr_t *sa);
 
+/**
+ * Create an empty set of ip-subnets, for testing an address against many
+ * subnets at once.
+ * @param set The new ip-subnet set
+ * @param p The pool to allocate from
+ */
+APR_DECLARE(apr_status_t) apr_ipset_create(apr_ipset_t **set, apr_pool_t *p);
+
+/**
+ * Add an ip-subnet to a set, given in the form accepted by
+ * apr_ipsubnet_create().
+ * @param set The ip-subnet set
+ * @param ipstr The input IP address string
+ * @param mask_or_numbits The input netmask or number-of-bits string, or NULL
+ * @param data The value apr_ipset_test() returns for this subnet
+ * @return APR_EBADMASK if a netmask is not a contiguous prefix, otherwise
+ *         what apr_ipsubnet_create() would return.
+ * @remark Adding the same subnet again replaces its data.
+ */
+APR_DECLARE(apr_status_t) apr_ipset_add(apr_ipset_t *set, const char *ipstr,
+                                        const char *mask_or_numbits,
+                                        void *data);
+
+/**
+ * Add a pre-built ip-subnet representation to a set.
+ * @param set The ip-subnet set
+ * @param ipsub The ip-subnet representation
+ * @param data The value apr_ipset_test() returns for this subnet
+ * @return APR_EBADMASK if the netmask is not a contiguous prefix.
+ */
+APR_DECLARE(apr_status_t) apr_ipset_add_subnet(apr_ipset_t *set,
+                                               const apr_ipsubnet_t *ipsub,
+                                               void *data);
+
+/**
+ * Test the IP address in an apr_sockaddr_t against every subnet in a set.
+ * @param set The ip-subnet set
+ * @param sa The socket address to test
+ * @param data Set to the data of the most specific subnet containing the
+ *             address, if it is not NULL and there is one.
+ * @return non-zero if the socket address is within any of the subnets,
+ *         0 otherwise
+ * @remark The subnets match the same addresses as apr_ipsubnet_test()
+ *         would; the cost depends on the prefix lengths in the set, not
+ *         on the number of subnets.
+ */
+APR_DECLARE(int) apr_ipset_test(apr_ipset_t *set, apr_sockaddr_t *sa,
+                                void **data);
+
 #if APR_HAS_SO_ACCEPTFILTER || defined(DOXYGEN)
 /**
  * Set an OS level accept filter.
@@ -424,6 +424,40 @@ APR_DECLARE(void *) apr_palloc_debug(apr_pool_t *p, apr_size_t size,
 #if APR_POOL_DEBUG
 #define apr_palloc(p, size) \
     apr_palloc_debug(p, size, APR_POOL__FILE_LINE__)
+#elif APR_HAS_INLINE && !defined(APR_POOL_NO_INLINE) && !defined(DOXYGEN)
+
+/**
+ * @internal The leading member of apr_pool_t, only exposed so that
+ * apr_palloc() can bump the active node's pointer inline.
+ */
+typedef struct apr_pool_head_t {
+    apr_memnode_t *active;
+} apr_pool_head_t;
+
+/**
+ * Inline fast path of apr_palloc(); falls back to the function when the
+ * request does not fit in the pool's active node.  Define
+ * APR_POOL_NO_INLINE before including apr_pools.h to always call it.
+ * @param p See: apr_palloc
+ * @param size See: apr_palloc
+ * @return See: apr_palloc
+ */
+static APR_INLINE void *apr_palloc_inline(apr_pool_t *p, apr_size_t size)
+{
+    apr_memnode_t *active = ((apr_pool_head_t *)p)->active;
+    apr_size_t aligned = (size + 7) & ~(apr_size_t)7; /* APR_ALIGN_DEFAULT */
+
+    if (aligned >= size
+        && aligned <= (apr_size_t)(active->endp - active->first_avail)) {
+        void *mem = active->first_avail;
+
+        active->first_avail += aligned;
+        return mem;
+    }
+    return (apr_palloc)(p, size);
+}
+
+#define apr_palloc(p, size) apr_palloc_inline(p, size)
 #endif
 
 /**
@@ -455,6 +489,45 @@ APR_DECLARE(void *) apr_pcalloc_debug(apr_pool_t *p, apr_size_t size,
     apr_pcalloc_debug(p, size, APR_POOL__FILE_LINE__)
 #endif
 
+/**
+ * The largest size served from the size-class free lists of
+ * apr_pool_alloc_small() and apr_pool_free_small()
+ */
+#define APR_POOL_SMALL_MAX 256
+
+/**
+ * Allocate a small object from a pool, reusing one of the same size
+ * class given back with apr_pool_free_small() if there is any
+ * @param p The pool to allocate from
+ * @param size The size of the object
+ * @return The allocated memory
+ * @remark Objects are grouped in classes of 8 bytes up to
+ * APR_POOL_SMALL_MAX; bigger ones come straight from apr_palloc().
+ * Meant for long-lived pools which churn fixed-size objects, where
+ * plain apr_palloc() would grow until the pool is cleared.
+ * @remark The free lists belong to the pool, so like the pool they are
+ * not thread-safe; they are emptied when the pool is cleared.
+ */
+APR_DECLARE(void *) apr_pool_alloc_small(apr_pool_t *p, apr_size_t size)
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 4))
+                    __attribute__((alloc_size(2)))
+#endif
+                    __attribute__((nonnull(1)));
+
+/**
+ * Give a small object back to its pool for reuse by apr_pool_alloc_small()
+ * @param p The pool the object was allocated from
+ * @param mem The object, from apr_pool_alloc_small() or a non-empty
+ *        apr_palloc()
+ * @param size The size it was allocated with
+ * @remark Objects bigger than APR_POOL_SMALL_MAX are not reused, nor is
+ * anything when APR_POOL_DEBUG is set; their memory is only released
+ * when the pool is cleared.
+ */
+APR_DECLARE(void) apr_pool_free_small(apr_pool_t *p, void *mem,
+                                      apr_size_t size)
+                  __attribute__((nonnull(1)));
+
 
 /*
  * Pool Properties
@@ -510,6 +583,76 @@ APR_DECLARE(void) apr_pool_tag(apr_pool_t *pool, const char *tag)
                   __attribute__((nonnull(1)));
 
 
+/*
+ * Statistics
+ */
+
+/** Memory usage of a pool, @see apr_pool_stats_get */
+typedef struct apr_pool_stats_t {
+    apr_size_t bytes_held;    /**< memory in the nodes the pool holds */
+    apr_size_t bytes_used;    /**< memory handed out from them */
+    apr_size_t bytes_high;    /**< high-water mark of bytes_held */
+    apr_size_t nodes;         /**< nodes the pool holds */
+    apr_size_t node_allocs;   /**< nodes taken from the allocator, that is
+                                   times apr_palloc() and friends ran out
+                                   of room */
+    apr_size_t clears;        /**< apr_pool_clear() calls */
+    apr_size_t cleanups_run;  /**< cleanups run by apr_pool_clear() and
+                                   apr_pool_cleanup_run() */
+    apr_size_t children;      /**< direct subpools */
+} apr_pool_stats_t;
+
+/**
+ * Get the memory usage of a pool, not including its subpools.
+ * @param pool The pool
+ * @param stats The statistics
+ * @remark The counters are only updated when a pool takes a new node,
+ * is cleared or runs cleanups, so keeping them costs apr_palloc()
+ * nothing.  Use apr_allocator_stats_get() for the allocator's view.
+ * @remark The pool must not be used by another thread meanwhile.
+ */
+APR_DECLARE(void) apr_pool_stats_get(apr_pool_t *pool,
+                                     apr_pool_stats_t *stats)
+                  __attribute__((nonnull(1,2)));
+
+/**
+ * The callback of apr_pool_walk()
+ * @param pool The pool visited
+ * @param depth Its depth below the pool the walk started from
+ * @param stats Its statistics, @see apr_pool_stats_get
+ * @param data The data passed to apr_pool_walk()
+ * @return 0 to continue the walk, anything else to stop it
+ */
+typedef int (apr_pool_walk_fn_t)(apr_pool_t *pool, int depth,
+                                 const apr_pool_stats_t *stats, void *data);
+
+/**
+ * Visit a pool and all its subpools, parents before their children.
+ * @param pool The pool to start from
+ * @param fn The function called for each pool
+ * @param data Data passed to fn
+ * @return 0, or the value fn stopped the walk with
+ * @remark No pool of the tree may be created, cleared or destroyed by
+ * another thread during the walk.
+ */
+APR_DECLARE(int) apr_pool_walk(apr_pool_t *pool, apr_pool_walk_fn_t *fn,
+                               void *data)
+                 __attribute__((nonnull(1,2)));
+
+/**
+ * Summarize the memory usage of a pool tree, one indented line per pool
+ * with its tag, statistics and the bytes held by its whole subtree.
+ * @param pool The root of the tree
+ * @param min_bytes Leave out the subtrees holding less than that
+ * @param p The pool to allocate the summary from
+ * @return The summary
+ * @remark The same restrictions as apr_pool_walk() apply.
+ */
+APR_DECLARE(char *) apr_pool_summary(apr_pool_t *pool, apr_size_t min_bytes,
+                                     apr_pool_t *p)
+                    __attribute__((nonnull(1,3)));
+
+
 /*
  * User data management
  */
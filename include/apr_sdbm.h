@@ -82,6 +82,9 @@ typedef struct {
  * @param p The pool to use when creating the sdbm
  * @remark The sdbm name is not a true file name, as sdbm appends suffixes 
  * for seperate data and index files.
+ * @remark A database opened without APR_WRITE or APR_SHARELOCK is memory
+ * mapped where the platform allows, and fetched records then point into
+ * the mapping until the database is closed.
  */
 APR_DECLARE(apr_status_t) apr_sdbm_open(apr_sdbm_t **db, const char *name, 
                                         apr_int32_t mode, 
@@ -93,6 +96,17 @@ APR_DECLARE(apr_status_t) apr_sdbm_open(apr_sdbm_t **db, const char *name,
  */
 APR_DECLARE(apr_status_t) apr_sdbm_close(apr_sdbm_t *db);
 
+/**
+ * Keep the most recently used blocks of an sdbm in memory
+ * @param db The database
+ * @param npages The number of page file blocks to keep, or 0 to stop
+ * caching; a directory block is kept for every 8 of them
+ * @remark The cache is dropped each time the database lock is acquired
+ * afresh, so it mainly benefits databases opened without APR_SHARELOCK,
+ * or runs of operations within apr_sdbm_lock and apr_sdbm_unlock.
+ */
+APR_DECLARE(apr_status_t) apr_sdbm_cache_set(apr_sdbm_t *db, int npages);
+
 /**
  * Lock an sdbm database for concurency of multiple operations
  * @param db The database to lock
@@ -167,6 +181,45 @@ APR_DECLARE(apr_status_t) apr_sdbm_firstkey(apr_sdbm_t *db, apr_sdbm_datum_t *ke
  */
 APR_DECLARE(apr_status_t) apr_sdbm_nextkey(apr_sdbm_t *db, apr_sdbm_datum_t *key);
 
+/**
+ * Structure for building an sdbm in one pass
+ */
+typedef struct apr_sdbm_builder_t apr_sdbm_builder_t;
+
+/**
+ * Start building an sdbm database from scratch
+ * @param builder The newly created builder
+ * @param name The sdbm file to create, replacing any existing one
+ * @param perms Permissions to apply to the created files
+ * @param p The pool to use for the builder and its records
+ * @remark Records are kept in memory until apr_sdbm_build_finish
+ * partitions them by hash and writes every page exactly once, rather
+ * than splitting pages as apr_sdbm_store does.  The database must not
+ * be opened before it is finished.
+ */
+APR_DECLARE(apr_status_t) apr_sdbm_build_create(apr_sdbm_builder_t **builder,
+                                                const char *name,
+                                                apr_fileperms_t perms,
+                                                apr_pool_t *p);
+
+/**
+ * Add a record to an sdbm being built
+ * @param builder The builder
+ * @param key The key datum of the record
+ * @param value The value datum of the record
+ * @remark Records may be added in any order.  If a key is added more
+ * than once, the last value added is kept, as with APR_SDBM_REPLACE.
+ */
+APR_DECLARE(apr_status_t) apr_sdbm_build_add(apr_sdbm_builder_t *builder,
+                                             apr_sdbm_datum_t key,
+                                             apr_sdbm_datum_t value);
+
+/**
+ * Write out an sdbm being built and release the builder
+ * @param builder The builder, which can't be used afterwards
+ */
+APR_DECLARE(apr_status_t) apr_sdbm_build_finish(apr_sdbm_builder_t *builder);
+
 /**
  * Returns true if the sdbm database opened for read-only access
  * @param db The database to test
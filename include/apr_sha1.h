@@ -114,6 +114,19 @@ APR_DECLARE(void) apr_sha1_update_binary(apr_sha1_ctx_t *context,
 APR_DECLARE(void) apr_sha1_final(unsigned char digest[APR_SHA1_DIGESTSIZE],
                                apr_sha1_ctx_t *context);
 
+/**
+ * Compute the SHA1 digests of several independent messages at once.
+ * Without hardware SHA1 support, up to eight messages are hashed side by
+ * side in SIMD lanes, which is considerably faster than one at a time.
+ * @param digests n output buffers of APR_SHA1_DIGESTSIZE bytes each
+ * @param inputs the n messages
+ * @param lens the lengths of the n messages
+ * @param n the number of messages
+ */
+APR_DECLARE(void) apr_sha1_multi(unsigned char *const *digests,
+                                 const unsigned char *const *inputs,
+                                 const apr_size_t *lens, int n);
+
 #ifdef __cplusplus
 }
 #endif
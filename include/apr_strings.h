@@ -48,6 +48,7 @@
 #include "apr.h"
 #include "apr_errno.h"
 #include "apr_pools.h"
+#include "apr_lib.h"
 #define APR_WANT_IOVEC
 #include "apr_want.h"
 
@@ -182,6 +183,32 @@ APR_DECLARE(char *) apr_pvsprintf(apr_pool_t *p, const char *fmt, va_list ap);
 APR_DECLARE_NONSTD(char *) apr_psprintf(apr_pool_t *p, const char *fmt, ...)
         __attribute__((format(printf,2,3)));
 
+/**
+ * printf-style style printing routine using a format compiled with
+ * apr_vformatter_plan_create().  The data is output to a string
+ * allocated from a pool
+ * @param p The pool to allocate out of
+ * @param plan The compiled format of the string
+ * @param ap The arguments to use while printing the data
+ * @return The new string
+ */
+APR_DECLARE(char *) apr_pvsprintf_plan(apr_pool_t *p,
+                                       const apr_vformatter_plan_t *plan,
+                                       va_list ap);
+
+/**
+ * printf-style style printing routine using a format compiled with
+ * apr_vformatter_plan_create().  The data is output to a string
+ * allocated from a pool
+ * @param p The pool to allocate out of
+ * @param plan The compiled format of the string
+ * @param ... The arguments to use while printing the data
+ * @return The new string
+ */
+APR_DECLARE_NONSTD(char *) apr_psprintf_plan(apr_pool_t *p,
+                                             const apr_vformatter_plan_t *plan,
+                                             ...);
+
 /**
  * Copy up to dst_size characters from src to dst; does not copy
  * past a NUL terminator in src, but always terminates dst with a NUL
@@ -280,6 +280,19 @@ APR_DECLARE(apr_size_t) apr_thread_pool_threshold_set(apr_thread_pool_t *me,
  */
 APR_DECLARE(apr_size_t) apr_thread_pool_threshold_get(apr_thread_pool_t * me);
 
+/**
+ * Pin the worker threads, each to one of the given CPUs in turn, so that
+ * their caches and the memory they allocate stay local.
+ * @param me The thread pool
+ * @param cpus The CPU ids, @see apr_cpu_topology_get, or NULL to stop
+ * pinning the workers started from now on
+ * @param ncpus The number of CPU ids in cpus
+ * @return APR_SUCCESS, or the first error pinning a running worker
+ */
+APR_DECLARE(apr_status_t) apr_thread_pool_affinity_set(apr_thread_pool_t *me,
+                                                       const int *cpus,
+                                                       int ncpus);
+
 /**
  * Get owner of the task currently been executed by the thread.
  * @param thd The thread is executing a task
@@ -207,6 +207,25 @@ typedef enum {
     APR_KILL_ONLY_ONCE          /**< send SIGTERM and then wait */
 } apr_kill_conditions_e;
 
+/** The online CPUs of the machine and their NUMA nodes */
+typedef struct apr_cpu_topology_t {
+    int ncpus;          /**< number of online CPUs */
+    int *cpus;          /**< ids of the online CPUs, in ascending order */
+    int *nodes;         /**< NUMA node of each of cpus[] */
+    int nnodes;         /**< number of NUMA nodes, 1 without NUMA */
+} apr_cpu_topology_t;
+
+/**
+ * Describe the online CPUs and the NUMA nodes they belong to.
+ * @param topology The returned topology.
+ * @param pool The pool to allocate it from.
+ * @remark CPU ids are those taken by apr_threadattr_affinity_set() and
+ * apr_thread_affinity_set().  Where NUMA placement cannot be queried,
+ * every CPU is reported on node 0.
+ */
+APR_DECLARE(apr_status_t) apr_cpu_topology_get(apr_cpu_topology_t **topology,
+                                               apr_pool_t *pool);
+
 /* Thread Function definitions */
 
 #if APR_HAS_THREADS
@@ -256,6 +275,18 @@ APR_DECLARE(apr_status_t) apr_threadattr_stacksize_set(apr_threadattr_t *attr,
 APR_DECLARE(apr_status_t) apr_threadattr_guardsize_set(apr_threadattr_t *attr,
                                                        apr_size_t guardsize);
 
+/**
+ * Restrict newly created threads to run on the given CPUs.
+ * @param attr The threadattr to affect
+ * @param cpus The CPU ids, @see apr_cpu_topology_get
+ * @param ncpus The number of CPU ids in cpus
+ * @return APR_ENOTIMPL if the platform cannot create threads with
+ * an affinity.
+ */
+APR_DECLARE(apr_status_t) apr_threadattr_affinity_set(apr_threadattr_t *attr,
+                                                      const int *cpus,
+                                                      int ncpus);
+
 /**
  * Create a new thread of execution
  * @param new_thread The newly created thread handle.
@@ -317,6 +348,49 @@ APR_DECLARE(apr_status_t) apr_thread_once(apr_thread_once_t *control,
  */
 APR_DECLARE(apr_status_t) apr_thread_detach(apr_thread_t *thd);
 
+/**
+ * Restrict a thread to run on the given CPUs.
+ * @param thread The thread, or NULL for the calling thread
+ * @param cpus The CPU ids, @see apr_cpu_topology_get
+ * @param ncpus The number of CPU ids in cpus
+ * @remark Pinning a thread keeps its caches, and the memory it touches
+ * first, local to those CPUs.
+ */
+APR_DECLARE(apr_status_t) apr_thread_affinity_set(apr_thread_t *thread,
+                                                  const int *cpus,
+                                                  int ncpus);
+
+/**
+ * Get the CPUs a thread is allowed to run on.
+ * @param cpus The returned CPU ids, in ascending order
+ * @param ncpus The returned number of CPU ids
+ * @param thread The thread, or NULL for the calling thread
+ * @param pool The pool to allocate cpus from
+ */
+APR_DECLARE(apr_status_t) apr_thread_affinity_get(int **cpus, int *ncpus,
+                                                  apr_thread_t *thread,
+                                                  apr_pool_t *pool);
+
+/**
+ * Set the name of a thread, as shown by debuggers and process listings.
+ * @param name The name; it may be truncated (to 15 characters on Linux)
+ * @param thread The thread, or NULL for the calling thread
+ * @param pool A pool for temporary allocations
+ */
+APR_DECLARE(apr_status_t) apr_thread_name_set(const char *name,
+                                              apr_thread_t *thread,
+                                              apr_pool_t *pool);
+
+/**
+ * Get the name of a thread.
+ * @param name The returned name
+ * @param thread The thread, or NULL for the calling thread
+ * @param pool The pool to allocate name from
+ */
+APR_DECLARE(apr_status_t) apr_thread_name_get(char **name,
+                                              apr_thread_t *thread,
+                                              apr_pool_t *pool);
+
 /**
  * Return the pool associated with the current thread.
  * @param data The user data associated with the thread.
@@ -559,6 +633,26 @@ APR_DECLARE(apr_status_t) apr_procattr_error_check_set(apr_procattr_t *attr,
 APR_DECLARE(apr_status_t) apr_procattr_addrspace_set(apr_procattr_t *attr,
                                                        apr_int32_t addrspace);
 
+/**
+ * Let apr_proc_create() start the child with posix_spawn() rather than
+ * fork(), where the platform has it and the other attributes allow.
+ * This avoids copying the parent's page tables, which for a large
+ * process can take milliseconds and stalls its other threads.
+ * @param attr The procattr we care about.
+ * @param spawn Nonzero to use posix_spawn() when possible.
+ * @remark Nothing runs in the child before the exec, so the child
+ *         cleanups of pools (see apr_pool_cleanup_for_exec()) are not run.
+ *         Descriptors APR opens are close-on-exec and the parent's ends of
+ *         the pipes set up by apr_procattr_io_set() are closed, but others
+ *         that are only closed by a child cleanup are inherited.
+ * @remark fork() is still used for detached children, resource limits,
+ *         a change of user or group, and a working directory the platform
+ *         cannot set with posix_spawn(); and whenever posix_spawn() fails,
+ *         so that errors are reported as they would have been otherwise.
+ */
+APR_DECLARE(apr_status_t) apr_procattr_spawn_set(apr_procattr_t *attr,
+                                                 apr_int32_t spawn);
+
 /**
  * Set the username used for running process
  * @param attr The procattr we care about. 
@@ -265,6 +265,109 @@ APR_DECLARE(char *) apr_xml_parser_geterror(apr_xml_parser *parser,
                                             char *errbuf,
                                             apr_size_t errbufsize);
 
+/* --------------------------------------------------------------------
+**
+** PULL PARSING
+**
+** Rather than building an apr_xml_doc, the reader hands back one event
+** at a time, so a document of any size is processed in bounded memory.
+** Names and values point into the parser's own buffers wherever the
+** XML backend allows it, text is copied; all stay valid until the next
+** call to apr_xml_reader_next().
+*/
+
+/** Opaque XML pull parser structure */
+typedef struct apr_xml_reader apr_xml_reader;
+
+/** The kinds of event returned by apr_xml_reader_next() */
+typedef enum {
+    APR_XML_EVENT_START,        /**< start tag; name, ns and attr are set */
+    APR_XML_EVENT_END,          /**< end tag; name and ns are set */
+    APR_XML_EVENT_TEXT          /**< character data; text and len are set */
+} apr_xml_event_e;
+
+/** @see apr_xml_event */
+typedef struct apr_xml_event apr_xml_event;
+
+/** apr_xml_event: one step through the document */
+struct apr_xml_event {
+    /** what happened */
+    apr_xml_event_e type;
+    /** element name, without its namespace prefix */
+    const char *name;
+    /** index into apr_xml_reader_namespaces() */
+    int ns;
+    /** attributes in document order, namespace declarations removed */
+    const apr_xml_attr *attr;
+    /** character data; it is not NUL-terminated */
+    const char *text;
+    /** length of the character data */
+    apr_size_t len;
+    /** nesting level: 0 for the root element and the text right inside it */
+    int depth;
+};
+
+/**
+ * Create an XML pull parser
+ * @param reader The new parser
+ * @param pool The pool to allocate the parser from.  Its size is fixed
+ *             by the depth of the document and the number of distinct
+ *             namespaces, not by the size of the document.
+ * @return APR_ENOMEM if the XML backend could not be initialised.
+ */
+APR_DECLARE(apr_status_t) apr_xml_reader_create(apr_xml_reader **reader,
+                                                apr_pool_t *pool);
+
+/**
+ * Give the pull parser its next piece of input
+ * @param reader The XML pull parser
+ * @param data The data to parse.  It must stay untouched until
+ *             apr_xml_reader_next() has returned APR_INCOMPLETE or APR_EOF.
+ * @param len The length of the data.
+ * @param is_final Nonzero if this is the end of the document.
+ * @return APR_EBUSY if the previous input has not been consumed yet.
+ */
+APR_DECLARE(apr_status_t) apr_xml_reader_feed(apr_xml_reader *reader,
+                                              const char *data,
+                                              apr_size_t len,
+                                              int is_final);
+
+/**
+ * Fetch the next event from the pull parser
+ * @param reader The XML pull parser
+ * @param event Filled in with the event.  The strings it points to are
+ *              only valid until the next call.
+ * @return APR_SUCCESS with an event, APR_INCOMPLETE when more input must
+ *         be fed, APR_EOF once the final input has been consumed, or
+ *         APR_EGENERAL if the document is malformed.
+ * @remark Character data may be split across several consecutive
+ *         APR_XML_EVENT_TEXT events.
+ * @remark Unlike apr_xml_parser, xml:lang is passed on as an ordinary
+ *         attribute; its reserved "xml" prefix is left in the name.
+ */
+APR_DECLARE(apr_status_t) apr_xml_reader_next(apr_xml_reader *reader,
+                                              apr_xml_event *event);
+
+/**
+ * Return the namespace URIs seen so far, indexed by the ns of events
+ * and attributes; use APR_XML_GET_URI_ITEM() to fetch them.  "DAV:" is
+ * always APR_XML_NS_DAV_ID.
+ * @param reader The XML pull parser
+ */
+APR_DECLARE(apr_array_header_t *) apr_xml_reader_namespaces(
+                                                      apr_xml_reader *reader);
+
+/**
+ * Fetch additional error information from the pull parser.
+ * @param reader The XML pull parser to query for errors.
+ * @param errbuf A buffer for storing error text.
+ * @param errbufsize The length of the error text buffer.
+ * @return The error buffer
+ */
+APR_DECLARE(char *) apr_xml_reader_geterror(apr_xml_reader *reader,
+                                            char *errbuf,
+                                            apr_size_t errbufsize);
+
 
 /**
  * Converts an XML element tree to flat text 
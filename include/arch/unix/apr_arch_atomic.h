@@ -42,4 +42,71 @@
 #   define USE_ATOMICS_GENERIC
 #endif
 
+#if defined(USE_ATOMICS_GENERIC)
+#   define USE_ATOMICS_GENERIC64
+#elif HAVE_ATOMIC_BUILTINS64
+#   define USE_ATOMICS_BUILTINS64
+#elif defined(USE_ATOMICS_SOLARIS)
+#   define USE_ATOMICS_SOLARIS64
+#elif defined(USE_ATOMICS_IA32) && defined(__x86_64__)
+#   define USE_ATOMICS_IA32_64
+#elif defined(USE_ATOMICS_PPC) && defined(__powerpc64__)
+#   define USE_ATOMICS_PPC64
+#elif defined(USE_ATOMICS_S390) && defined(__s390x__)
+#   define USE_ATOMICS_S390_64
+#else
+#   define USE_ATOMICS_GENERIC64
+#endif
+
+/* the compiler's __atomic builtins take a memory order; without them,
+ * the ordered variants are built from the plain operations and fences */
+#if defined(USE_ATOMICS_BUILTINS) && defined(__ATOMIC_ACQUIRE)
+#   define USE_ATOMICS_BUILTINS_ORDERED
+#endif
+#if defined(USE_ATOMICS_BUILTINS64) && defined(__ATOMIC_ACQUIRE)
+#   define USE_ATOMICS_BUILTINS64_ORDERED
+#endif
+
+#if defined(USE_ATOMICS_BUILTINS_ORDERED) \
+    || defined(USE_ATOMICS_BUILTINS64_ORDERED)
+static APR_INLINE int apr__atomic_order(apr_atomic_order_e order)
+{
+    switch (order) {
+    case APR_ATOMIC_RELAXED: return __ATOMIC_RELAXED;
+    case APR_ATOMIC_ACQUIRE: return __ATOMIC_ACQUIRE;
+    case APR_ATOMIC_RELEASE: return __ATOMIC_RELEASE;
+    case APR_ATOMIC_ACQ_REL: return __ATOMIC_ACQ_REL;
+    default:                 return __ATOMIC_SEQ_CST;
+    }
+}
+
+/* a load cannot release */
+static APR_INLINE int apr__atomic_load_order(apr_atomic_order_e order)
+{
+    switch (order) {
+    case APR_ATOMIC_RELAXED:
+    case APR_ATOMIC_RELEASE: return __ATOMIC_RELAXED;
+    case APR_ATOMIC_ACQUIRE:
+    case APR_ATOMIC_ACQ_REL: return __ATOMIC_ACQUIRE;
+    default:                 return __ATOMIC_SEQ_CST;
+    }
+}
+
+/* nor can a store acquire */
+static APR_INLINE int apr__atomic_store_order(apr_atomic_order_e order)
+{
+    switch (order) {
+    case APR_ATOMIC_RELAXED:
+    case APR_ATOMIC_ACQUIRE: return __ATOMIC_RELAXED;
+    case APR_ATOMIC_RELEASE:
+    case APR_ATOMIC_ACQ_REL: return __ATOMIC_RELEASE;
+    default:                 return __ATOMIC_SEQ_CST;
+    }
+}
+#endif
+
+#if defined(USE_ATOMICS_GENERIC64)
+apr_status_t apr__atomic_generic64_init(apr_pool_t *p);
+#endif
+
 #endif /* ATOMIC_H */
@@ -122,9 +122,12 @@ struct apr_pollset_t
     apr_uint32_t nelts;
     apr_uint32_t nalloc;
     apr_uint32_t flags;
-    /* Pipe descriptors used for wakeup */
+    /* Pipe descriptors used for wakeup; one eventfd serves as both ends
+     * where available */
     apr_file_t *wakeup_pipe[2];
     apr_pollfd_t wakeup_pfd;
+    /* nonzero while a wakeup is pending, so that others need not write */
+    volatile apr_uint32_t wakeup_set;
     apr_pollset_private_t *p;
     apr_pollset_provider_t *provider;
 };
@@ -150,9 +153,12 @@ struct apr_pollcb_t {
     apr_uint32_t nelts;
     apr_uint32_t nalloc;
     apr_uint32_t flags;
-    /* Pipe descriptors used for wakeup */
+    /* Pipe descriptors used for wakeup; one eventfd serves as both ends
+     * where available */
     apr_file_t *wakeup_pipe[2];
     apr_pollfd_t wakeup_pfd;
+    /* nonzero while a wakeup is pending, so that others need not write */
+    volatile apr_uint32_t wakeup_set;
     int fd;
     apr_pollcb_pset pollset;
     apr_pollfd_t **copyset;
@@ -184,6 +190,9 @@ struct apr_pollcb_provider_t {
 apr_status_t apr_poll_create_wakeup_pipe(apr_pool_t *pool, apr_pollfd_t *pfd, 
                                          apr_file_t **wakeup_pipe);
 apr_status_t apr_poll_close_wakeup_pipe(apr_file_t **wakeup_pipe);
-void apr_poll_drain_wakeup_pipe(apr_file_t **wakeup_pipe);
+apr_status_t apr_poll_wakeup(volatile apr_uint32_t *wakeup_set,
+                             apr_file_t **wakeup_pipe);
+void apr_poll_drain_wakeup_pipe(volatile apr_uint32_t *wakeup_set,
+                                apr_file_t **wakeup_pipe);
 
 #endif /* APR_ARCH_POLL_PRIVATE_H */
@@ -40,6 +40,9 @@ extern "C" {
 #define TXN_MODE_BITS \
   (APR_DBD_TRANSACTION_ROLLBACK|APR_DBD_TRANSACTION_IGNORE_ERRORS)
 
+/* The per-connection prepared statement cache, opaque to the drivers */
+typedef struct apr_dbd_stmt_cache_t apr_dbd_stmt_cache_t;
+
 struct apr_dbd_driver_t {
     /** name */
     const char *name;
@@ -349,6 +352,80 @@ struct apr_dbd_driver_t {
      */
     apr_status_t (*datum_get)(const apr_dbd_row_t *row, int col,
                               apr_dbd_type_e type, void *data);
+
+    /** stmt_cache: locate the connection's prepared statement cache
+     *  May be NULL if the driver doesn't support statement caching.
+     *
+     *  @param handle - the connection
+     *  @return the place in the connection where apr_dbd keeps its cache
+     */
+    apr_dbd_stmt_cache_t **(*stmt_cache)(apr_dbd_t *handle);
+
+    /** unprepare: release a statement the cache prepared and evicted
+     *  Required if stmt_cache is provided.
+     *
+     *  @param handle - the connection
+     *  @param statement - the statement to release
+     */
+    void (*unprepare)(apr_dbd_t *handle, apr_dbd_prepared_t *statement);
+
+    /** pbquery_batch: execute a prepared statement once per binary arg set
+     *  May be NULL, in which case apr_dbd runs pbquery in a loop.
+     *
+     *  @param pool - working pool
+     *  @param handle - the connection
+     *  @param nrows - total number of rows affected
+     *  @param statement - the prepared statement to execute
+     *  @param nsets - number of arg sets
+     *  @param args - array of nsets binary arg arrays
+     *  @param trans - the caller's transaction, or NULL for one of its own
+     *  @return 0 for success or error code
+     */
+    int (*pbquery_batch)(apr_pool_t *pool, apr_dbd_t *handle, int *nrows,
+                         apr_dbd_prepared_t *statement, int nsets,
+                         const void ***args, apr_dbd_transaction_t *trans);
+
+    /** get_int64: get an entry from a row as an integer
+     *  May be NULL, in which case apr_dbd converts the text of the entry.
+     *
+     *  @param row - row pointer
+     *  @param col - entry number
+     *  @param value - where to store the value
+     *  @return APR_SUCCESS, APR_ENOENT for NULL, APR_EINVAL or APR_EGENERAL
+     */
+    apr_status_t (*get_int64)(const apr_dbd_row_t *row, int col,
+                              apr_int64_t *value);
+
+    /** get_double: get an entry from a row as a floating point number
+     *  May be NULL, in which case apr_dbd converts the text of the entry.
+     *
+     *  @param row - row pointer
+     *  @param col - entry number
+     *  @param value - where to store the value
+     *  @return APR_SUCCESS, APR_ENOENT for NULL, APR_EINVAL or APR_EGENERAL
+     */
+    apr_status_t (*get_double)(const apr_dbd_row_t *row, int col,
+                               double *value);
+
+    /** get_span: get an entry from a row in place, with its length
+     *  May be NULL, in which case apr_dbd uses the text of the entry.
+     *
+     *  @param row - row pointer
+     *  @param col - entry number
+     *  @param binary - whether the entry is wanted as binary data
+     *  @param span - where to store the location and length of the entry
+     *  @return APR_SUCCESS, APR_ENOENT for NULL or APR_EGENERAL
+     */
+    apr_status_t (*get_span)(const apr_dbd_row_t *row, int col, int binary,
+                             apr_dbd_span_t *span);
+
+    /** transaction_get: get the transaction in progress on a connection
+     *  May be NULL, in which case apr_dbd assumes there is none.
+     *
+     *  @param handle - the connection
+     *  @return the transaction, or NULL
+     */
+    apr_dbd_transaction_t *(*transaction_get)(apr_dbd_t *handle);
 };
 
 /* Export mutex lock/unlock for drivers that need it 
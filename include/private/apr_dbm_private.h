@@ -110,6 +110,7 @@ struct apr_dbm_t
 
 /* Declare all of the DBM provider tables */
 APR_MODULE_DECLARE_DATA extern const apr_dbm_type_t apr_dbm_type_sdbm;
+APR_MODULE_DECLARE_DATA extern const apr_dbm_type_t apr_dbm_type_cdb;
 APR_MODULE_DECLARE_DATA extern const apr_dbm_type_t apr_dbm_type_gdbm;
 APR_MODULE_DECLARE_DATA extern const apr_dbm_type_t apr_dbm_type_ndbm;
 APR_MODULE_DECLARE_DATA extern const apr_dbm_type_t apr_dbm_type_db;
@@ -322,6 +322,10 @@ SOURCE=.\dbm\apr_dbm_berkeleydb.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\dbm\apr_dbm_cdb.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\dbm\apr_dbm_gdbm.c
 # End Source File
 # Begin Source File
@@ -350,6 +354,10 @@ SOURCE=.\encoding\apr_base64.c
 # PROP Default_Filter ""
 # Begin Source File
 
+SOURCE=.\file_io\unix\asyncwrite.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\file_io\win32\buffer.c
 # End Source File
 # Begin Source File
@@ -619,6 +627,14 @@ SOURCE=.\dbm\sdbm\sdbm.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\dbm\sdbm\sdbm_build.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\dbm\sdbm\sdbm_cache.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\dbm\sdbm\sdbm_hash.c
 # End Source File
 # Begin Source File
@@ -797,6 +813,10 @@ SOURCE=.\xml\apr_xml.c
 
 SOURCE=.\xml\apr_xml_expat.c
 # End Source File
+# Begin Source File
+
+SOURCE=.\xml\apr_xml_reader.c
+# End Source File
 # End Group
 # End Group
 # Begin Group "Private Header Files"
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+/* apr_palloc() is defined here, not inlined */
+#define APR_POOL_NO_INLINE
+
 #include "apr.h"
 #include "apr_private.h"
 
@@ -26,6 +29,7 @@
 #include "apr_lib.h"
 #include "apr_thread_mutex.h"
 #include "apr_hash.h"
+#include "apr_tables.h"
 #include "apr_time.h"
 #define APR_WANT_MEMFUNC
 #include "apr_want.h"
@@ -43,6 +47,15 @@
 #include <sys/mman.h>
 #endif
 
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP) && defined(HAVE_MUNMAP) \
+    && defined(HAVE_MAP_ANON)
+#define ALLOCATOR_REGIONS_MMAP 1
+#include <sys/mman.h>
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#endif
+
 /*
  * Magic numbers
  */
@@ -75,6 +88,26 @@ static unsigned int boundary_size;
 #define TIMEOUT_USECS    3000000
 #define TIMEOUT_INTERVAL   46875
 
+/*
+ * Regions of apr_allocator_create_ex() allocators: by default 4MB, in
+ * multiples of 2MB (the usual huge page size) when backed by huge pages.
+ */
+#define REGION_SIZE_DEFAULT (4 * 1024 * 1024)
+#define HUGE_PAGE_SIZE      (2 * 1024 * 1024)
+
+typedef struct allocator_region_t allocator_region_t;
+
+struct allocator_region_t {
+    allocator_region_t *next;
+    char               *base;
+    apr_size_t          size;
+    enum {
+        REGION_MALLOC,
+        REGION_MMAP,
+        REGION_HUGETLB
+    }                   how;
+};
+
 /*
  * Allocator
  *
@@ -111,6 +144,25 @@ struct apr_allocator_t {
      * slot 19: size 81920
      */
     apr_memnode_t      *free[MAX_INDEX];
+    /** Size of the regions the nodes are carved out of, or 0 when each
+     * node is obtained from the system on its own.
+     * @see apr_allocator_create_ex()
+     */
+    apr_size_t          region_size;
+    apr_uint32_t        flags;
+    int                 numa_node;
+    /** All the regions reserved so far */
+    allocator_region_t *regions;
+    /** The part of the current region not carved yet */
+    char               *region_avail;
+    char               *region_endp;
+    /** @see apr_allocator_stats_get() */
+    apr_size_t          system_bytes;
+    apr_size_t          node_bytes;
+    apr_size_t          nregions;
+    apr_size_t          nhuge_regions;
+    apr_size_t          nodes_reused;
+    apr_size_t          nodes_new;
 };
 
 #define SIZEOF_ALLOCATOR_T  APR_ALIGN_DEFAULT(sizeof(apr_allocator_t))
@@ -137,10 +189,48 @@ APR_DECLARE(apr_status_t) apr_allocator_create(apr_allocator_t **allocator)
     return APR_SUCCESS;
 }
 
+APR_DECLARE(apr_status_t) apr_allocator_create_ex(apr_allocator_t **allocator,
+                                                  apr_uint32_t flags,
+                                                  apr_size_t region_size,
+                                                  int numa_node)
+{
+    apr_status_t rv;
+
+    if ((rv = apr_allocator_create(allocator)) != APR_SUCCESS)
+        return rv;
+
+    if (!region_size)
+        region_size = REGION_SIZE_DEFAULT;
+    (*allocator)->region_size = APR_ALIGN(region_size,
+                                          (flags & APR_ALLOCATOR_HUGE_PAGES)
+                                          ? HUGE_PAGE_SIZE : BOUNDARY_SIZE);
+    (*allocator)->flags = flags;
+    (*allocator)->numa_node = numa_node;
+
+    return APR_SUCCESS;
+}
+
 APR_DECLARE(void) apr_allocator_destroy(apr_allocator_t *allocator)
 {
     apr_uint32_t index;
     apr_memnode_t *node, **ref;
+    allocator_region_t *region;
+
+    /* The nodes live in the regions, if any */
+    while ((region = allocator->regions) != NULL) {
+        allocator->regions = region->next;
+#ifdef ALLOCATOR_REGIONS_MMAP
+        if (region->how != REGION_MALLOC)
+            munmap(region->base, region->size);
+        else
+#endif
+        free(region->base);
+        free(region);
+    }
+    if (allocator->region_size) {
+        free(allocator);
+        return;
+    }
 
     for (index = 0; index < MAX_INDEX; index++) {
         ref = &allocator->free[index];
@@ -196,6 +286,10 @@ APR_DECLARE(void) apr_allocator_max_free_set(apr_allocator_t *allocator,
         apr_thread_mutex_lock(mutex);
 #endif /* APR_HAS_THREADS */
 
+    /* Nodes carved out of regions can't be given back one by one */
+    if (allocator->region_size)
+        size = APR_ALLOCATOR_MAX_FREE_UNLIMITED;
+
     max_free_index = APR_ALIGN(size, BOUNDARY_SIZE) >> BOUNDARY_INDEX;
     allocator->current_free_index += max_free_index;
     allocator->current_free_index -= allocator->max_free_index;
@@ -209,6 +303,169 @@ APR_DECLARE(void) apr_allocator_max_free_set(apr_allocator_t *allocator,
 #endif
 }
 
+#if defined(ALLOCATOR_REGIONS_MMAP) && defined(SYS_mbind)
+/* Prefer the given NUMA node for the pages of a region not touched yet;
+ * the kernel falls back on other nodes once it is full.
+ */
+static void region_bind(char *base, apr_size_t size, int node)
+{
+    unsigned long nodemask[1024 / (8 * sizeof(unsigned long))];
+    const int bits = 8 * sizeof(unsigned long);
+
+    if (node < 0 || node >= (int)(8 * sizeof(nodemask)) - 1)
+        return;
+    memset(nodemask, 0, sizeof(nodemask));
+    nodemask[node / bits] |= 1UL << (node % bits);
+    syscall(SYS_mbind, base, size, 1 /* MPOL_PREFERRED */,
+            nodemask, 8 * sizeof(nodemask), 0);
+}
+#endif
+
+/* Reserve a region of the given size, which is a multiple of the huge
+ * page size when the allocator uses huge pages.
+ */
+static allocator_region_t *region_reserve(apr_allocator_t *allocator,
+                                          apr_size_t size)
+{
+    allocator_region_t *region;
+
+    if ((region = malloc(sizeof(*region))) == NULL)
+        return NULL;
+    region->base = NULL;
+    region->size = size;
+
+#ifdef ALLOCATOR_REGIONS_MMAP
+#ifdef MAP_HUGETLB
+    /* Explicit huge pages first, if the system has some reserved */
+    if (allocator->flags & APR_ALLOCATOR_HUGE_PAGES) {
+        region->base = mmap(NULL, size, PROT_READ|PROT_WRITE,
+                            MAP_PRIVATE|MAP_ANON|MAP_HUGETLB, -1, 0);
+        if (region->base == MAP_FAILED)
+            region->base = NULL;
+        else
+            region->how = REGION_HUGETLB;
+    }
+#endif
+    if (region->base == NULL) {
+        apr_size_t align = 0;
+        char *base;
+
+        /* Transparent huge pages need a huge page aligned mapping */
+        if (allocator->flags & APR_ALLOCATOR_HUGE_PAGES)
+            align = HUGE_PAGE_SIZE;
+
+        base = mmap(NULL, size + align, PROT_READ|PROT_WRITE,
+                    MAP_PRIVATE|MAP_ANON, -1, 0);
+        if (base != MAP_FAILED) {
+            region->base = base;
+            region->how = REGION_MMAP;
+            if (align) {
+                region->base = (char *)APR_ALIGN((apr_uintptr_t)base, align);
+                if (region->base > base)
+                    munmap(base, region->base - base);
+                munmap(region->base + size, base + align - region->base);
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+                madvise(region->base, size, MADV_HUGEPAGE);
+#endif
+            }
+        }
+    }
+#ifdef SYS_mbind
+    if (region->base && (allocator->flags & APR_ALLOCATOR_NUMA_NODE))
+        region_bind(region->base, size, allocator->numa_node);
+#endif
+#endif /* ALLOCATOR_REGIONS_MMAP */
+
+    if (region->base == NULL) {
+        if ((region->base = malloc(size)) == NULL) {
+            free(region);
+            return NULL;
+        }
+        region->how = REGION_MALLOC;
+    }
+
+    region->next = allocator->regions;
+    allocator->regions = region;
+    allocator->system_bytes += size;
+    allocator->nregions++;
+    if (region->how == REGION_HUGETLB)
+        allocator->nhuge_regions++;
+
+    return region;
+}
+
+/* Carve a node out of the current region, reserving a new one as needed.
+ * The unused end of the previous region becomes a free node.
+ */
+static apr_memnode_t *region_alloc(apr_allocator_t *allocator,
+                                   apr_size_t size)
+{
+    allocator_region_t *region;
+    apr_memnode_t *node = NULL;
+    apr_size_t avail;
+
+#if APR_HAS_THREADS
+    if (allocator->mutex)
+        apr_thread_mutex_lock(allocator->mutex);
+#endif /* APR_HAS_THREADS */
+
+    avail = allocator->region_endp - allocator->region_avail;
+    if (size > allocator->region_size) {
+        /* Too large for a region, give it one of its own */
+        size = APR_ALIGN(size, (allocator->flags & APR_ALLOCATOR_HUGE_PAGES)
+                               ? HUGE_PAGE_SIZE : BOUNDARY_SIZE);
+        if ((region = region_reserve(allocator, size)) != NULL)
+            node = (apr_memnode_t *)region->base;
+    }
+    else {
+        if (avail < size
+            && (region = region_reserve(allocator,
+                                        allocator->region_size)) != NULL) {
+            if (avail >= MIN_ALLOC) {
+                apr_memnode_t *tail = (apr_memnode_t *)allocator->region_avail;
+                apr_uint32_t index = (apr_uint32_t)(avail >> BOUNDARY_INDEX) - 1;
+
+                tail->index = index;
+                tail->first_avail = (char *)tail + APR_MEMNODE_T_SIZE;
+                tail->endp = allocator->region_endp;
+                if (index >= MAX_INDEX)
+                    index = 0;
+                else if (index > allocator->max_index)
+                    allocator->max_index = index;
+                tail->next = allocator->free[index];
+                allocator->free[index] = tail;
+                allocator->node_bytes += avail;
+            }
+            allocator->region_avail = region->base;
+            allocator->region_endp = region->base + region->size;
+            avail = region->size;
+        }
+        if (avail >= size) {
+            node = (apr_memnode_t *)allocator->region_avail;
+            allocator->region_avail += size;
+        }
+    }
+    if (node) {
+        allocator->node_bytes += size;
+        allocator->nodes_new++;
+    }
+
+#if APR_HAS_THREADS
+    if (allocator->mutex)
+        apr_thread_mutex_unlock(allocator->mutex);
+#endif /* APR_HAS_THREADS */
+
+    if (node == NULL)
+        return NULL;
+
+    node->next = NULL;
+    node->index = (apr_uint32_t)(size >> BOUNDARY_INDEX) - 1;
+    node->first_avail = (char *)node + APR_MEMNODE_T_SIZE;
+    node->endp = (char *)node + size;
+
+    return node;
+}
+
 static APR_INLINE
 apr_memnode_t *allocator_alloc(apr_allocator_t *allocator, apr_size_t in_size)
 {
@@ -281,6 +538,7 @@ apr_memnode_t *allocator_alloc(apr_allocator_t *allocator, apr_size_t in_size)
             allocator->current_free_index += node->index + 1;
             if (allocator->current_free_index > allocator->max_free_index)
                 allocator->current_free_index = allocator->max_free_index;
+            allocator->nodes_reused++;
 
 #if APR_HAS_THREADS
             if (allocator->mutex)
@@ -321,6 +579,7 @@ apr_memnode_t *allocator_alloc(apr_allocator_t *allocator, apr_size_t in_size)
             allocator->current_free_index += node->index + 1;
             if (allocator->current_free_index > allocator->max_free_index)
                 allocator->current_free_index = allocator->max_free_index;
+            allocator->nodes_reused++;
 
 #if APR_HAS_THREADS
             if (allocator->mutex)
@@ -339,6 +598,10 @@ apr_memnode_t *allocator_alloc(apr_allocator_t *allocator, apr_size_t in_size)
 #endif /* APR_HAS_THREADS */
     }
 
+    if (allocator->region_size) {
+        return region_alloc(allocator, size);
+    }
+
     /* If we haven't got a suitable node, malloc a new one
      * and initialize it.
      */
@@ -350,6 +613,18 @@ apr_memnode_t *allocator_alloc(apr_allocator_t *allocator, apr_size_t in_size)
 #endif
         return NULL;
 
+#if APR_HAS_THREADS
+    if (allocator->mutex)
+        apr_thread_mutex_lock(allocator->mutex);
+#endif /* APR_HAS_THREADS */
+    allocator->system_bytes += size;
+    allocator->node_bytes += size;
+    allocator->nodes_new++;
+#if APR_HAS_THREADS
+    if (allocator->mutex)
+        apr_thread_mutex_unlock(allocator->mutex);
+#endif /* APR_HAS_THREADS */
+
     node->next = NULL;
     node->index = index;
     node->first_avail = (char *)node + APR_MEMNODE_T_SIZE;
@@ -385,6 +660,8 @@ void allocator_free(apr_allocator_t *allocator, apr_memnode_t *node)
             && index + 1 > current_free_index) {
             node->next = freelist;
             freelist = node;
+            allocator->system_bytes -= (apr_size_t)(index + 1) << BOUNDARY_INDEX;
+            allocator->node_bytes -= (apr_size_t)(index + 1) << BOUNDARY_INDEX;
         }
         else if (index < MAX_INDEX) {
             /* Add the node to the appropiate 'size' bucket.  Adjust
@@ -444,6 +721,42 @@ APR_DECLARE(void) apr_allocator_free(apr_allocator_t *allocator,
     allocator_free(allocator, node);
 }
 
+APR_DECLARE(void) apr_allocator_stats_get(apr_allocator_t *allocator,
+                                          apr_allocator_stats_t *stats)
+{
+    apr_uint32_t index;
+    apr_memnode_t *node;
+    apr_size_t size;
+
+    memset(stats, 0, sizeof(*stats));
+
+#if APR_HAS_THREADS
+    if (allocator->mutex)
+        apr_thread_mutex_lock(allocator->mutex);
+#endif /* APR_HAS_THREADS */
+
+    stats->system_bytes = allocator->system_bytes;
+    stats->node_bytes = allocator->node_bytes;
+    stats->regions = allocator->nregions;
+    stats->huge_regions = allocator->nhuge_regions;
+    stats->nodes_reused = allocator->nodes_reused;
+    stats->nodes_new = allocator->nodes_new;
+    for (index = 0; index < MAX_INDEX; index++) {
+        for (node = allocator->free[index]; node; node = node->next) {
+            size = (apr_size_t)(node->index + 1) << BOUNDARY_INDEX;
+            stats->free_bytes += size;
+            stats->free_nodes++;
+            if (size > stats->largest_free)
+                stats->largest_free = size;
+        }
+    }
+
+#if APR_HAS_THREADS
+    if (allocator->mutex)
+        apr_thread_mutex_unlock(allocator->mutex);
+#endif /* APR_HAS_THREADS */
+}
+
 
 
 /*
@@ -498,6 +811,9 @@ struct debug_node_t {
  * to see how it is used.
  */
 struct apr_pool_t {
+#if !APR_POOL_DEBUG
+    apr_memnode_t        *active; /* must come first, see apr_pool_head_t */
+#endif
     apr_pool_t           *parent;
     apr_pool_t           *child;
     apr_pool_t           *sibling;
@@ -511,9 +827,15 @@ struct apr_pool_t {
     const char           *tag;
 
 #if !APR_POOL_DEBUG
-    apr_memnode_t        *active;
     apr_memnode_t        *self; /* The node containing the pool itself */
     char                 *self_first_avail;
+    /* @see apr_pool_stats_get(), only updated off the fast path */
+    apr_size_t            stat_node_allocs;
+    apr_size_t            stat_bytes;
+    apr_size_t            stat_bytes_high;
+    apr_size_t            stat_clears;
+    /* @see apr_pool_alloc_small(), allocated on first use */
+    void                **small_free;
 
 #else /* APR_POOL_DEBUG */
     apr_pool_t           *joined; /* the caller has guaranteed that this pool
@@ -533,6 +855,7 @@ struct apr_pool_t {
     apr_os_proc_t         owner_proc;
 #endif /* defined(NETWARE) */
     cleanup_t            *pre_cleanups;
+    apr_size_t            stat_cleanups;
 };
 
 #define SIZEOF_POOL_T       APR_ALIGN_DEFAULT(sizeof(apr_pool_t))
@@ -557,7 +880,7 @@ static apr_file_t *file_stderr = NULL;
  * Local functions
  */
 
-static void run_cleanups(cleanup_t **c);
+static apr_size_t run_cleanups(cleanup_t **c);
 static void free_proc_chain(struct process_chain *procs);
 
 #if APR_POOL_DEBUG
@@ -661,6 +984,14 @@ APR_DECLARE(void) apr_pool_terminate(void)
 /* Returns the amount of free space in the given node. */
 #define node_free_space(node_) ((apr_size_t)(node_->endp - node_->first_avail))
 
+/* Account for a node joining the pool, on the slow paths only */
+#define pool_stat_node(pool, node) do {                         \
+    (pool)->stat_node_allocs++;                                 \
+    (pool)->stat_bytes += (node)->endp - (char *)(node);        \
+    if ((pool)->stat_bytes > (pool)->stat_bytes_high)           \
+        (pool)->stat_bytes_high = (pool)->stat_bytes;           \
+} while (0)
+
 /*
  * Memory allocation
  */
@@ -699,6 +1030,7 @@ APR_DECLARE(void *) apr_palloc(apr_pool_t *pool, apr_size_t in_size)
 
             return NULL;
         }
+        pool_stat_node(pool, node);
     }
 
     node->free_index = 0;
@@ -750,6 +1082,52 @@ APR_DECLARE(void *) apr_pcalloc(apr_pool_t *pool, apr_size_t size)
 }
 
 
+/*
+ * Size-class free lists
+ */
+
+#define SMALL_CLASSES (APR_POOL_SMALL_MAX >> 3)
+#define SMALL_CLASS(size) ((size) ? (APR_ALIGN_DEFAULT(size) >> 3) - 1 : 0)
+
+APR_DECLARE(void *) apr_pool_alloc_small(apr_pool_t *pool, apr_size_t size)
+{
+    apr_size_t index;
+    void *mem;
+
+    if (size > APR_POOL_SMALL_MAX)
+        return apr_palloc(pool, size);
+
+    index = SMALL_CLASS(size);
+    if (pool->small_free && (mem = pool->small_free[index]) != NULL) {
+        pool->small_free[index] = *(void **)mem;
+        return mem;
+    }
+
+    /* Allocate the whole class, its objects are interchangeable */
+    return apr_palloc(pool, (index + 1) << 3);
+}
+
+APR_DECLARE(void) apr_pool_free_small(apr_pool_t *pool, void *mem,
+                                      apr_size_t size)
+{
+    apr_size_t index;
+
+    if (mem == NULL || size > APR_POOL_SMALL_MAX)
+        return;
+
+    if (pool->small_free == NULL) {
+        pool->small_free = apr_palloc(pool, SMALL_CLASSES * sizeof(void *));
+        if (pool->small_free == NULL)
+            return;
+        memset(pool->small_free, 0, SMALL_CLASSES * sizeof(void *));
+    }
+
+    index = SMALL_CLASS(size);
+    *(void **)mem = pool->small_free[index];
+    pool->small_free[index] = mem;
+}
+
+
 /*
  * Pool creation/destruction
  */
@@ -759,7 +1137,7 @@ APR_DECLARE(void) apr_pool_clear(apr_pool_t *pool)
     apr_memnode_t *active;
 
     /* Run pre destroy cleanups */
-    run_cleanups(&pool->pre_cleanups);
+    pool->stat_cleanups += run_cleanups(&pool->pre_cleanups);
     pool->pre_cleanups = NULL;
 
     /* Destroy the subpools.  The subpools will detach themselves from
@@ -769,7 +1147,7 @@ APR_DECLARE(void) apr_pool_clear(apr_pool_t *pool)
         apr_pool_destroy(pool->child);
 
     /* Run cleanups */
-    run_cleanups(&pool->cleanups);
+    pool->stat_cleanups += run_cleanups(&pool->cleanups);
     pool->cleanups = NULL;
     pool->free_cleanups = NULL;
 
@@ -780,6 +1158,12 @@ APR_DECLARE(void) apr_pool_clear(apr_pool_t *pool)
     /* Clear the user data. */
     pool->user_data = NULL;
 
+    /* The free lists live in the nodes being reset */
+    pool->small_free = NULL;
+
+    pool->stat_clears++;
+    pool->stat_bytes = pool->self->endp - (char *)pool->self;
+
     /* Find the node attached to the pool structure, reset it, make
      * it the active node and free the rest of the nodes.
      */
@@ -801,7 +1185,7 @@ APR_DECLARE(void) apr_pool_destroy(apr_pool_t *pool)
     apr_allocator_t *allocator;
 
     /* Run pre destroy cleanups */
-    run_cleanups(&pool->pre_cleanups);
+    pool->stat_cleanups += run_cleanups(&pool->pre_cleanups);
     pool->pre_cleanups = NULL;
 
     /* Destroy the subpools.  The subpools will detach themselve from
@@ -811,7 +1195,7 @@ APR_DECLARE(void) apr_pool_destroy(apr_pool_t *pool)
         apr_pool_destroy(pool->child);
 
     /* Run cleanups */
-    run_cleanups(&pool->cleanups);
+    pool->stat_cleanups += run_cleanups(&pool->cleanups);
 
     /* Free subprocesses */
     free_proc_chain(pool->subprocesses);
@@ -912,6 +1296,11 @@ APR_DECLARE(apr_status_t) apr_pool_create_ex(apr_pool_t **newpool,
     pool->subprocesses = NULL;
     pool->user_data = NULL;
     pool->tag = NULL;
+    pool->stat_node_allocs = 1;
+    pool->stat_bytes = pool->stat_bytes_high = node->endp - (char *)node;
+    pool->stat_clears = 0;
+    pool->stat_cleanups = 0;
+    pool->small_free = NULL;
 
 #ifdef NETWARE
     pool->owner_proc = (apr_os_proc_t)getnlmhandle();
@@ -1016,6 +1405,11 @@ APR_DECLARE(apr_status_t) apr_pool_create_unmanaged_ex(apr_pool_t **newpool,
     pool->parent = NULL;
     pool->sibling = NULL;
     pool->ref = NULL;
+    pool->stat_node_allocs = 1;
+    pool->stat_bytes = pool->stat_bytes_high = node->endp - (char *)node;
+    pool->stat_clears = 0;
+    pool->stat_cleanups = 0;
+    pool->small_free = NULL;
 
 #ifdef NETWARE
     pool->owner_proc = (apr_os_proc_t)getnlmhandle();
@@ -1126,7 +1520,9 @@ static int psprintf_flush(apr_vformatter_buff_t *vbuff)
     return 0;
 }
 
-APR_DECLARE(char *) apr_pvsprintf(apr_pool_t *pool, const char *fmt, va_list ap)
+/* Format either fmt, or the compiled plan if one is given */
+static char *pvsprintf(apr_pool_t *pool, const char *fmt,
+                       const apr_vformatter_plan_t *plan, va_list ap)
 {
     struct psprintf_data ps;
     char *strp;
@@ -1156,7 +1552,8 @@ APR_DECLARE(char *) apr_pvsprintf(apr_pool_t *pool, const char *fmt, va_list ap)
         }
     }
 
-    if (apr_vformatter(psprintf_flush, &ps.vbuff, fmt, ap) == -1) {
+    if ((plan ? apr_vformatter_plan_exec(psprintf_flush, &ps.vbuff, plan, ap)
+              : apr_vformatter(psprintf_flush, &ps.vbuff, fmt, ap)) == -1) {
         if (pool->abort_fn)
             pool->abort_fn(APR_ENOMEM);
 
@@ -1184,6 +1581,7 @@ APR_DECLARE(char *) apr_pvsprintf(apr_pool_t *pool, const char *fmt, va_list ap)
     node = ps.node;
 
     node->free_index = 0;
+    pool_stat_node(pool, node);
 
     list_insert(node, active);
 
@@ -1539,6 +1937,17 @@ APR_DECLARE(void *) apr_pcalloc_debug(apr_pool_t *pool, apr_size_t size,
     return mem;
 }
 
+APR_DECLARE(void *) apr_pool_alloc_small(apr_pool_t *pool, apr_size_t size)
+{
+    return apr_palloc(pool, size);
+}
+
+APR_DECLARE(void) apr_pool_free_small(apr_pool_t *pool, void *mem,
+                                      apr_size_t size)
+{
+    /* Keep every allocation apart until the pool is cleared */
+}
+
 
 /*
  * Pool creation/destruction (debug)
@@ -1552,7 +1961,7 @@ static void pool_clear_debug(apr_pool_t *pool, const char *file_line)
     apr_uint32_t index;
 
     /* Run pre destroy cleanups */
-    run_cleanups(&pool->pre_cleanups);
+    pool->stat_cleanups += run_cleanups(&pool->pre_cleanups);
     pool->pre_cleanups = NULL;
 
     /* Destroy the subpools.  The subpools will detach themselves from
@@ -1562,7 +1971,7 @@ static void pool_clear_debug(apr_pool_t *pool, const char *file_line)
         pool_destroy_debug(pool->child, file_line);
 
     /* Run cleanups */
-    run_cleanups(&pool->cleanups);
+    pool->stat_cleanups += run_cleanups(&pool->cleanups);
     pool->free_cleanups = NULL;
     pool->cleanups = NULL;
 
@@ -1890,7 +2299,9 @@ static int psprintf_flush(apr_vformatter_buff_t *vbuff)
     return 0;
 }
 
-APR_DECLARE(char *) apr_pvsprintf(apr_pool_t *pool, const char *fmt, va_list ap)
+/* Format either fmt, or the compiled plan if one is given */
+static char *pvsprintf(apr_pool_t *pool, const char *fmt,
+                       const apr_vformatter_plan_t *plan, va_list ap)
 {
     struct psprintf_data ps;
     debug_node_t *node;
@@ -1904,7 +2315,8 @@ APR_DECLARE(char *) apr_pvsprintf(apr_pool_t *pool, const char *fmt, va_list ap)
     /* Save a byte for the NUL terminator */
     ps.vbuff.endpos = ps.mem + ps.size - 1;
 
-    if (apr_vformatter(psprintf_flush, &ps.vbuff, fmt, ap) == -1) {
+    if ((plan ? apr_vformatter_plan_exec(psprintf_flush, &ps.vbuff, plan, ap)
+              : apr_vformatter(psprintf_flush, &ps.vbuff, fmt, ap)) == -1) {
         if (pool->abort_fn)
             pool->abort_fn(APR_ENOMEM);
 
@@ -2049,6 +2461,11 @@ void netware_pool_proc_cleanup ()
  * "Print" functions (common)
  */
 
+APR_DECLARE(char *) apr_pvsprintf(apr_pool_t *p, const char *fmt, va_list ap)
+{
+    return pvsprintf(p, fmt, NULL, ap);
+}
+
 APR_DECLARE_NONSTD(char *) apr_psprintf(apr_pool_t *p, const char *fmt, ...)
 {
     va_list ap;
@@ -2060,6 +2477,26 @@ APR_DECLARE_NONSTD(char *) apr_psprintf(apr_pool_t *p, const char *fmt, ...)
     return res;
 }
 
+APR_DECLARE(char *) apr_pvsprintf_plan(apr_pool_t *p,
+                                       const apr_vformatter_plan_t *plan,
+                                       va_list ap)
+{
+    return pvsprintf(p, NULL, plan, ap);
+}
+
+APR_DECLARE_NONSTD(char *) apr_psprintf_plan(apr_pool_t *p,
+                                             const apr_vformatter_plan_t *plan,
+                                             ...)
+{
+    va_list ap;
+    char *res;
+
+    va_start(ap, plan);
+    res = apr_pvsprintf_plan(p, plan, ap);
+    va_end(ap);
+    return res;
+}
+
 /*
  * Pool Properties
  */
@@ -2124,6 +2561,127 @@ APR_DECLARE(void) apr_pool_tag(apr_pool_t *pool, const char *tag)
 }
 
 
+/*
+ * Statistics
+ */
+
+APR_DECLARE(void) apr_pool_stats_get(apr_pool_t *pool,
+                                     apr_pool_stats_t *stats)
+{
+#if !APR_POOL_DEBUG
+    apr_memnode_t *node;
+#endif
+    apr_pool_t *child;
+
+    memset(stats, 0, sizeof(*stats));
+
+#if !APR_POOL_DEBUG
+    node = pool->active;
+    do {
+        stats->bytes_held += node->endp - (char *)node;
+        stats->bytes_used += node->first_avail
+                             - ((char *)node + APR_MEMNODE_T_SIZE);
+        stats->nodes++;
+        node = node->next;
+    } while (node != pool->active);
+
+    stats->bytes_high = pool->stat_bytes_high;
+    stats->node_allocs = pool->stat_node_allocs;
+    stats->clears = pool->stat_clears;
+#else
+    stats->bytes_held = stats->bytes_used = apr_pool_num_bytes(pool, 0);
+    stats->bytes_high = stats->bytes_held;
+    stats->node_allocs = pool->stat_total_alloc;
+    stats->clears = pool->stat_clear;
+    {
+        debug_node_t *node;
+
+        for (node = pool->nodes; node; node = node->next)
+            stats->nodes += node->index;
+    }
+#endif
+    if (stats->bytes_high < stats->bytes_held)
+        stats->bytes_high = stats->bytes_held;
+    stats->cleanups_run = pool->stat_cleanups;
+
+    for (child = pool->child; child; child = child->sibling)
+        stats->children++;
+}
+
+static int pool_walk(apr_pool_t *pool, int depth,
+                     apr_pool_walk_fn_t *fn, void *data)
+{
+    apr_pool_stats_t stats;
+    apr_pool_t *child;
+    int rv;
+
+    apr_pool_stats_get(pool, &stats);
+    if ((rv = fn(pool, depth, &stats, data)) != 0)
+        return rv;
+
+    for (child = pool->child; child; child = child->sibling) {
+        if ((rv = pool_walk(child, depth + 1, fn, data)) != 0)
+            return rv;
+    }
+    return 0;
+}
+
+APR_DECLARE(int) apr_pool_walk(apr_pool_t *pool, apr_pool_walk_fn_t *fn,
+                               void *data)
+{
+    return pool_walk(pool, 0, fn, data);
+}
+
+/* Add the summary lines of pool and its subpools to lines, returning the
+ * bytes held by the whole subtree.
+ */
+static apr_size_t pool_summary(apr_pool_t *pool, int depth,
+                               apr_size_t min_bytes,
+                               apr_array_header_t *lines)
+{
+    apr_pool_stats_t stats;
+    apr_pool_t *child;
+    apr_size_t subtree;
+    int line;
+
+    apr_pool_stats_get(pool, &stats);
+
+    /* the children come first, so that the line can show their total */
+    line = lines->nelts;
+    APR_ARRAY_PUSH(lines, char *) = NULL;
+    subtree = stats.bytes_held;
+    for (child = pool->child; child; child = child->sibling)
+        subtree += pool_summary(child, depth + 1, min_bytes, lines);
+
+    if (subtree < min_bytes) {
+        lines->nelts = line;
+        return subtree;
+    }
+    APR_ARRAY_IDX(lines, line, char *) =
+        apr_psprintf(lines->pool, "%*s%s [%pp]: %" APR_SIZE_T_FMT
+                     " bytes in subtree, %" APR_SIZE_T_FMT " held, %"
+                     APR_SIZE_T_FMT " used, %" APR_SIZE_T_FMT " high, %"
+                     APR_SIZE_T_FMT " nodes, %" APR_SIZE_T_FMT
+                     " node allocs, %" APR_SIZE_T_FMT " clears, %"
+                     APR_SIZE_T_FMT " cleanups\n",
+                     2 * depth, "", pool->tag ? pool->tag : "(untagged)",
+                     pool, subtree, stats.bytes_held, stats.bytes_used,
+                     stats.bytes_high, stats.nodes, stats.node_allocs,
+                     stats.clears, stats.cleanups_run);
+    return subtree;
+}
+
+APR_DECLARE(char *) apr_pool_summary(apr_pool_t *pool, apr_size_t min_bytes,
+                                     apr_pool_t *p)
+{
+    apr_array_header_t *lines = apr_array_make(p, 16, sizeof(char *));
+
+    pool_summary(pool, 0, min_bytes, lines);
+
+    return apr_array_pstrcat(p, lines, 0);
+}
+
+
 /*
  * User data management
  */
@@ -2347,18 +2905,22 @@ APR_DECLARE(apr_status_t) apr_pool_cleanup_run(apr_pool_t *p, void *data,
                               apr_status_t (*cleanup_fn)(void *))
 {
     apr_pool_cleanup_kill(p, data, cleanup_fn);
+    p->stat_cleanups++;
     return (*cleanup_fn)(data);
 }
 
-static void run_cleanups(cleanup_t **cref)
+static apr_size_t run_cleanups(cleanup_t **cref)
 {
     cleanup_t *c = *cref;
+    apr_size_t n = 0;
 
     while (c) {
         *cref = c->next;
         (*c->plain_cleanup_fn)((void *)c->data);
         c = *cref;
+        n++;
     }
+    return n;
 }
 
 #if !defined(WIN32) && !defined(OS2)
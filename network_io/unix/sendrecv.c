@@ -22,6 +22,10 @@
 #include "apr_arch_file_io.h"
 #endif /* APR_HAS_SENDFILE */
 
+#if defined(HAVE_NETINET_UDP_H)
+#include <netinet/udp.h>
+#endif
+
 /* osreldate.h is only needed on FreeBSD for sendfile detection */
 #if defined(__FreeBSD__)
 #include <osreldate.h>
@@ -184,6 +188,225 @@ apr_status_t apr_socket_recvfrom(apr_sockaddr_t *from, apr_socket_t *sock,
     return APR_SUCCESS;
 }
 
+#if defined(HAVE_SENDMMSG) || defined(HAVE_RECVMMSG)
+/* the most datagrams passed to the kernel at once */
+#define MMSG_BATCH 64
+#endif
+
+#ifdef HAVE_SENDMMSG
+
+#if defined(UDP_SEGMENT)
+/* what the kernel will take in one UDP_SEGMENT send */
+#ifndef UDP_MAX_SEGMENTS
+#define UDP_MAX_SEGMENTS 64
+#endif
+#define UDP_GSO_MAX_BYTES 65000
+
+static int same_dest(const apr_sockaddr_t *a, const apr_sockaddr_t *b)
+{
+    return a == b || (a && b && a->salen == b->salen
+                      && memcmp(&a->sa, &b->sa, a->salen) == 0);
+}
+
+/* how many of msgs[0..n) can go as one segmented datagram */
+static int gso_run(const apr_socket_msg_t *msgs, int n)
+{
+    apr_size_t size = msgs[0].len, total = size;
+    int i;
+
+    if (n > UDP_MAX_SEGMENTS) {
+        n = UDP_MAX_SEGMENTS;
+    }
+    for (i = 1; i < n; i++) {
+        if (!same_dest(msgs[0].addr, msgs[i].addr)
+            || msgs[i].len > size || msgs[i].len == 0
+            || total + msgs[i].len > UDP_GSO_MAX_BYTES) {
+            break;
+        }
+        total += msgs[i].len;
+        if (msgs[i].len < size) {
+            /* only the last segment may be short */
+            return i + 1;
+        }
+    }
+    return i;
+}
+#endif /* UDP_SEGMENT */
+
+apr_status_t apr_socket_sendmmsg(apr_socket_t *sock, apr_socket_msg_t *msgs,
+                                 int nmsgs, apr_int32_t flags, int *nsent)
+{
+    struct mmsghdr hdr[MMSG_BATCH];
+    struct iovec iov[MMSG_BATCH];
+    int count[MMSG_BATCH];
+#if defined(UDP_SEGMENT)
+    char control[MMSG_BATCH][CMSG_SPACE(sizeof(apr_uint16_t))];
+    int gso = sock->type == SOCK_DGRAM
+              && (sock->protocol == 0 || sock->protocol == IPPROTO_UDP)
+              && sock->local_addr->family != APR_UNIX;
+#endif
+    int done = 0;
+
+    while (done < nmsgs) {
+        int nhdr = 0, niov = 0, next = done, segmented = 0;
+        int rv, i;
+
+        while (next < nmsgs && nhdr < MMSG_BATCH && niov < MMSG_BATCH) {
+            struct msghdr *m = &hdr[nhdr].msg_hdr;
+            apr_socket_msg_t *msg = &msgs[next];
+            int run = 1;
+
+#if defined(UDP_SEGMENT)
+            if (gso && msg->len > 0) {
+                run = gso_run(msg, MMSG_BATCH - niov < nmsgs - next
+                                   ? MMSG_BATCH - niov : nmsgs - next);
+            }
+#endif
+            memset(m, 0, sizeof(*m));
+            if (msg->addr) {
+                m->msg_name = &msg->addr->sa;
+                m->msg_namelen = msg->addr->salen;
+            }
+            m->msg_iov = &iov[niov];
+            m->msg_iovlen = run;
+            for (i = 0; i < run; i++, niov++) {
+                iov[niov].iov_base = msg[i].buf;
+                iov[niov].iov_len = msg[i].len;
+            }
+#if defined(UDP_SEGMENT)
+            if (run > 1) {
+                struct cmsghdr *cm;
+                apr_uint16_t size = (apr_uint16_t)msg->len;
+
+                m->msg_control = control[nhdr];
+                m->msg_controllen = sizeof(control[nhdr]);
+                cm = CMSG_FIRSTHDR(m);
+                cm->cmsg_level = SOL_UDP;
+                cm->cmsg_type = UDP_SEGMENT;
+                cm->cmsg_len = CMSG_LEN(sizeof(size));
+                memcpy(CMSG_DATA(cm), &size, sizeof(size));
+                segmented = 1;
+            }
+#endif
+            count[nhdr++] = run;
+            next += run;
+        }
+
+        do {
+            rv = sendmmsg(sock->socketdes, hdr, nhdr, flags);
+        } while (rv == -1 && errno == EINTR);
+
+        while (rv == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)
+               && sock->timeout > 0) {
+            apr_status_t arv = apr_wait_for_io_or_timeout(NULL, sock, 0);
+            if (arv != APR_SUCCESS) {
+                *nsent = done;
+                return done ? APR_SUCCESS : arv;
+            }
+            do {
+                rv = sendmmsg(sock->socketdes, hdr, nhdr, flags);
+            } while (rv == -1 && errno == EINTR);
+        }
+
+#if defined(UDP_SEGMENT)
+        if (rv == -1 && segmented) {
+            /* no GSO here, or not on this route; send them one by one */
+            gso = 0;
+            continue;
+        }
+#endif
+        if (rv == -1) {
+            *nsent = done;
+            return done ? APR_SUCCESS : errno;
+        }
+
+        for (i = 0; i < rv; i++) {
+            done += count[i];
+        }
+        if (rv < nhdr) {
+            break;
+        }
+    }
+
+    *nsent = done;
+    return APR_SUCCESS;
+}
+
+#endif /* HAVE_SENDMMSG */
+
+#ifdef HAVE_RECVMMSG
+
+apr_status_t apr_socket_recvmmsg(apr_socket_t *sock, apr_socket_msg_t *msgs,
+                                 int nmsgs, apr_int32_t flags, int *nrecv)
+{
+    struct mmsghdr hdr[MMSG_BATCH];
+    struct iovec iov[MMSG_BATCH];
+    int done = 0;
+
+    while (done < nmsgs) {
+        int n = nmsgs - done < MMSG_BATCH ? nmsgs - done : MMSG_BATCH;
+        /* wait for the first datagram only */
+        int mflags = flags | (done ? MSG_DONTWAIT : MSG_WAITFORONE);
+        int rv, i;
+
+        for (i = 0; i < n; i++) {
+            apr_socket_msg_t *msg = &msgs[done + i];
+            struct msghdr *m = &hdr[i].msg_hdr;
+
+            memset(m, 0, sizeof(*m));
+            if (msg->addr) {
+                m->msg_name = &msg->addr->sa;
+                m->msg_namelen = sizeof(msg->addr->sa);
+            }
+            iov[i].iov_base = msg->buf;
+            iov[i].iov_len = msg->len;
+            m->msg_iov = &iov[i];
+            m->msg_iovlen = 1;
+        }
+
+        do {
+            rv = recvmmsg(sock->socketdes, hdr, n, mflags, NULL);
+        } while (rv == -1 && errno == EINTR);
+
+        while (rv == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)
+               && sock->timeout > 0 && !done) {
+            apr_status_t arv = apr_wait_for_io_or_timeout(NULL, sock, 1);
+            if (arv != APR_SUCCESS) {
+                *nrecv = 0;
+                return arv;
+            }
+            do {
+                rv = recvmmsg(sock->socketdes, hdr, n, mflags, NULL);
+            } while (rv == -1 && errno == EINTR);
+        }
+
+        if (rv == -1) {
+            *nrecv = done;
+            return done ? APR_SUCCESS : errno;
+        }
+
+        for (i = 0; i < rv; i++) {
+            apr_socket_msg_t *msg = &msgs[done + i];
+
+            msg->len = hdr[i].msg_len;
+            if (msg->addr) {
+                msg->addr->salen = hdr[i].msg_hdr.msg_namelen;
+                apr_sockaddr_vars_set(msg->addr, msg->addr->sa.sin.sin_family,
+                                      ntohs(msg->addr->sa.sin.sin_port));
+            }
+        }
+        done += rv;
+        if (rv < n) {
+            break;
+        }
+    }
+
+    *nrecv = done;
+    return APR_SUCCESS;
+}
+
+#endif /* HAVE_RECVMMSG */
+
 apr_status_t apr_socket_sendv(apr_socket_t * sock, const struct iovec *vec,
                               apr_int32_t nvec, apr_size_t *len)
 {
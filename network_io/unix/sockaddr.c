@@ -20,6 +20,10 @@
 #include "apr_lib.h"
 #include "apr_strings.h"
 #include "apr_private.h"
+#include "apr_hash.h"
+#include "apr_time.h"
+#include "apr_thread_mutex.h"
+#include "apr_thread_pool.h"
 
 #if APR_HAVE_STDLIB_H
 #include <stdlib.h>
@@ -586,6 +590,243 @@ static apr_status_t find_addresses(apr_sockaddr_t **sa,
 
 #endif /* end of !HAVE_GETADDRINFO code */
 
+/*
+ * The process-wide lookup cache.  getaddrinfo() does not report record
+ * TTLs, so an entry simply lives for the configured time.  Entries are
+ * malloc()ed, so that replacing one gives its memory back, and the table
+ * is emptied whenever it fills up.
+ */
+typedef struct {
+    apr_time_t expires;
+    apr_status_t status;
+    const char *key;
+    int naddrs;
+    apr_sockaddr_t addrs[1];    /* only family and sa are used */
+} sockaddr_cache_entry_t;
+
+static apr_pool_t *sockaddr_cache_pool;
+static apr_hash_t *sockaddr_cache;
+static apr_interval_time_t sockaddr_cache_ttl;
+static apr_interval_time_t sockaddr_cache_negative_ttl;
+static unsigned int sockaddr_cache_max;
+static apr_size_t sockaddr_cache_hits, sockaddr_cache_misses;
+
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *sockaddr_cache_lock;
+#define SOCKADDR_CACHE_LOCK()   apr_thread_mutex_lock(sockaddr_cache_lock)
+#define SOCKADDR_CACHE_UNLOCK() apr_thread_mutex_unlock(sockaddr_cache_lock)
+#else
+#define SOCKADDR_CACHE_LOCK()
+#define SOCKADDR_CACHE_UNLOCK()
+#endif
+
+static void sockaddr_cache_empty(void)
+{
+    apr_hash_index_t *hi;
+
+    for (hi = apr_hash_first(NULL, sockaddr_cache); hi; hi = apr_hash_next(hi)) {
+        free(apr_hash_this_val(hi));
+    }
+    apr_hash_clear(sockaddr_cache);
+}
+
+static apr_status_t sockaddr_cache_cleanup(void *data)
+{
+    sockaddr_cache_empty();
+    sockaddr_cache = NULL;
+    sockaddr_cache_pool = NULL;
+    return APR_SUCCESS;
+}
+
+#if defined(HAVE_GETADDRINFO) && !defined(WIN32)
+#if defined(NEGATIVE_EAI)
+#define EAI_STATUS(eai) (APR_OS_START_EAIERR - (eai))
+#else
+#define EAI_STATUS(eai) (APR_OS_START_EAIERR + (eai))
+#endif
+#endif
+
+/* a failure that will not go away by asking again soon: the name does
+ * not exist, or has no addresses (of the family asked for); local trouble
+ * such as EAI_MEMORY or EAI_SYSTEM, and server failures, are worth retrying
+ */
+static int sockaddr_cache_failure_ok(apr_status_t error)
+{
+#if defined(HAVE_GETADDRINFO) && !defined(WIN32)
+#ifdef EAI_NONAME
+    if (error == EAI_STATUS(EAI_NONAME)) {
+        return 1;
+    }
+#endif
+#if defined(EAI_NODATA) && (!defined(EAI_NONAME) || EAI_NODATA != EAI_NONAME)
+    if (error == EAI_STATUS(EAI_NODATA)) {
+        return 1;
+    }
+#endif
+#ifdef EAI_ADDRFAMILY
+    if (error == EAI_STATUS(EAI_ADDRFAMILY)) {
+        return 1;
+    }
+#endif
+#endif
+    return 0;
+}
+
+static apr_status_t cached_find_addresses(apr_sockaddr_t **sa,
+                                          const char *hostname,
+                                          apr_int32_t family,
+                                          apr_port_t port, apr_int32_t flags,
+                                          apr_pool_t *p)
+{
+    sockaddr_cache_entry_t *entry, *old;
+    apr_sockaddr_t *cur, *prev_sa;
+    apr_time_t now = apr_time_now();
+    apr_size_t klen, size;
+    apr_status_t rv;
+    char *key;
+    int i, n;
+
+    key = apr_psprintf(p, "%d/%d/%s", (int)family,
+                       (int)(flags & (APR_IPV4_ADDR_OK | APR_IPV6_ADDR_OK)),
+                       hostname);
+    klen = strlen(key);
+
+    SOCKADDR_CACHE_LOCK();
+    entry = apr_hash_get(sockaddr_cache, key, klen);
+    if (entry && entry->expires > now) {
+        sockaddr_cache_hits++;
+
+        prev_sa = NULL;
+        for (i = 0; i < entry->naddrs; i++) {
+            apr_sockaddr_t *new_sa = apr_pcalloc(p, sizeof(apr_sockaddr_t));
+
+            new_sa->pool = p;
+            memcpy(&new_sa->sa, &entry->addrs[i].sa, sizeof(new_sa->sa));
+            apr_sockaddr_vars_set(new_sa, entry->addrs[i].family, port);
+
+            if (!prev_sa) { /* first element in new list */
+                new_sa->hostname = apr_pstrdup(p, hostname);
+                *sa = new_sa;
+            }
+            else {
+                new_sa->hostname = prev_sa->hostname;
+                prev_sa->next = new_sa;
+            }
+            prev_sa = new_sa;
+        }
+        rv = entry->status;
+        SOCKADDR_CACHE_UNLOCK();
+        return rv;
+    }
+    sockaddr_cache_misses++;
+    SOCKADDR_CACHE_UNLOCK();
+
+    rv = find_addresses(sa, hostname, family, port, flags, p);
+    if (rv != APR_SUCCESS && (sockaddr_cache_negative_ttl <= 0
+                              || !sockaddr_cache_failure_ok(rv))) {
+        return rv;
+    }
+
+    n = 0;
+    if (rv == APR_SUCCESS) {
+        for (cur = *sa; cur; cur = cur->next) {
+            n++;
+        }
+    }
+    size = APR_OFFSETOF(sockaddr_cache_entry_t, addrs)
+         + n * sizeof(apr_sockaddr_t);
+    entry = malloc(size + klen + 1);
+    if (entry == NULL) {
+        return rv;
+    }
+    entry->expires = now + (rv == APR_SUCCESS ? sockaddr_cache_ttl
+                                              : sockaddr_cache_negative_ttl);
+    entry->status = rv;
+    entry->naddrs = n;
+    for (i = 0, cur = *sa; i < n; i++, cur = cur->next) {
+        entry->addrs[i] = *cur;
+        /* the port is the caller's, so keep it out of the cache */
+#if APR_HAVE_IPV6
+        if (cur->family == AF_INET6) {
+            entry->addrs[i].sa.sin6.sin6_port = 0;
+        }
+        else
+#endif
+        entry->addrs[i].sa.sin.sin_port = 0;
+    }
+    entry->key = memcpy((char *)entry + size, key, klen + 1);
+
+    SOCKADDR_CACHE_LOCK();
+    old = apr_hash_get(sockaddr_cache, key, klen);
+    if (old) {
+        /* the table still points at the old entry's key */
+        apr_hash_set(sockaddr_cache, old->key, klen, NULL);
+        free(old);
+    }
+    else if (apr_hash_count(sockaddr_cache) >= sockaddr_cache_max) {
+        sockaddr_cache_empty();
+    }
+    apr_hash_set(sockaddr_cache, entry->key, klen, entry);
+    SOCKADDR_CACHE_UNLOCK();
+
+    return rv;
+}
+
+APR_DECLARE(apr_status_t) apr_sockaddr_cache_set(apr_interval_time_t ttl,
+                                                 apr_interval_time_t negative_ttl,
+                                                 unsigned int max_entries)
+{
+    apr_pool_t *pool;
+    apr_status_t rv;
+
+    if (sockaddr_cache_pool) {
+        apr_pool_destroy(sockaddr_cache_pool);
+    }
+    if (ttl <= 0 || max_entries == 0) {
+        return APR_SUCCESS;
+    }
+
+    rv = apr_pool_create(&pool, NULL);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+#if APR_HAS_THREADS
+    rv = apr_thread_mutex_create(&sockaddr_cache_lock,
+                                 APR_THREAD_MUTEX_DEFAULT, pool);
+    if (rv != APR_SUCCESS) {
+        apr_pool_destroy(pool);
+        return rv;
+    }
+#endif
+    apr_pool_cleanup_register(pool, NULL, sockaddr_cache_cleanup,
+                              apr_pool_cleanup_null);
+
+    sockaddr_cache_ttl = ttl;
+    sockaddr_cache_negative_ttl = negative_ttl;
+    sockaddr_cache_max = max_entries;
+    sockaddr_cache_hits = sockaddr_cache_misses = 0;
+    sockaddr_cache_pool = pool;
+    sockaddr_cache = apr_hash_make(pool);
+
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(void) apr_sockaddr_cache_flush(void)
+{
+    if (sockaddr_cache) {
+        SOCKADDR_CACHE_LOCK();
+        sockaddr_cache_empty();
+        SOCKADDR_CACHE_UNLOCK();
+    }
+}
+
+APR_DECLARE(void) apr_sockaddr_cache_stats(apr_size_t *hits,
+                                           apr_size_t *misses)
+{
+    *hits = sockaddr_cache_hits;
+    *misses = sockaddr_cache_misses;
+}
+
 APR_DECLARE(apr_status_t) apr_sockaddr_info_get(apr_sockaddr_t **sa,
                                                 const char *hostname, 
                                                 apr_int32_t family, apr_port_t port,
@@ -643,9 +884,61 @@ APR_DECLARE(apr_status_t) apr_sockaddr_info_get(apr_sockaddr_t **sa,
     }
 #endif
 
+    if (hostname && sockaddr_cache) {
+        return cached_find_addresses(sa, hostname, family, port, flags, p);
+    }
     return find_addresses(sa, hostname, family, port, flags, p);
 }
 
+#if APR_HAS_THREADS
+
+typedef struct {
+    const char *hostname;
+    apr_int32_t family;
+    apr_port_t port;
+    apr_int32_t flags;
+    apr_sockaddr_info_cb_t *cb;
+    void *baton;
+    apr_pool_t *pool;
+} sockaddr_lookup_t;
+
+static void * APR_THREAD_FUNC sockaddr_lookup(apr_thread_t *thd, void *data)
+{
+    sockaddr_lookup_t *lookup = data;
+    apr_sockaddr_t *sa;
+    apr_status_t rv;
+
+    rv = apr_sockaddr_info_get(&sa, lookup->hostname, lookup->family,
+                               lookup->port, lookup->flags, lookup->pool);
+    lookup->cb(lookup->baton, rv, rv == APR_SUCCESS ? sa : NULL);
+    return NULL;
+}
+
+APR_DECLARE(apr_status_t) apr_sockaddr_info_get_async(struct apr_thread_pool *tp,
+                                                      const char *hostname,
+                                                      apr_int32_t family,
+                                                      apr_port_t port,
+                                                      apr_int32_t flags,
+                                                      apr_sockaddr_info_cb_t *cb,
+                                                      void *baton,
+                                                      apr_pool_t *p)
+{
+    sockaddr_lookup_t *lookup = apr_palloc(p, sizeof(*lookup));
+
+    lookup->hostname = hostname ? apr_pstrdup(p, hostname) : NULL;
+    lookup->family = family;
+    lookup->port = port;
+    lookup->flags = flags;
+    lookup->cb = cb;
+    lookup->baton = baton;
+    lookup->pool = p;
+
+    return apr_thread_pool_push(tp, sockaddr_lookup, lookup,
+                                APR_THREAD_TASK_PRIORITY_NORMAL, baton);
+}
+
+#endif /* APR_HAS_THREADS */
+
 APR_DECLARE(apr_status_t) apr_getnameinfo(char **hostname,
                                           apr_sockaddr_t *sockaddr,
                                           apr_int32_t flags)
@@ -995,36 +1288,25 @@ static void fix_subnet(apr_ipsubnet_t *ipsub)
     }
 }
 
-/* be sure not to store any IPv4 address as a v4-mapped IPv6 address */
-APR_DECLARE(apr_status_t) apr_ipsubnet_create(apr_ipsubnet_t **ipsub, const char *ipstr, 
-                                              const char *mask_or_numbits, apr_pool_t *p)
+/* fill in an ip-subnet; the caller has already checked looks_like_ip() */
+static apr_status_t ipsubnet_init(apr_ipsubnet_t *ipsub, const char *ipstr,
+                                  const char *mask_or_numbits)
 {
     apr_status_t rv;
     char *endptr;
     long bits, maxbits = 32;
 
-    /* filter out stuff which doesn't look remotely like an IP address; this helps 
-     * callers like mod_access which have a syntax allowing hostname or IP address;
-     * APR_EINVAL tells the caller that it was probably not intended to be an IP
-     * address
-     */
-    if (!looks_like_ip(ipstr)) {
-        return APR_EINVAL;
-    }
-
-    *ipsub = apr_pcalloc(p, sizeof(apr_ipsubnet_t));
-
     /* assume ipstr is an individual IP address, not a subnet */
-    memset((*ipsub)->mask, 0xFF, sizeof (*ipsub)->mask);
+    memset(ipsub->mask, 0xFF, sizeof ipsub->mask);
 
-    rv = parse_ip(*ipsub, ipstr, mask_or_numbits == NULL);
+    rv = parse_ip(ipsub, ipstr, mask_or_numbits == NULL);
     if (rv != APR_SUCCESS) {
         return rv;
     }
 
     if (mask_or_numbits) {
 #if APR_HAVE_IPV6
-        if ((*ipsub)->family == AF_INET6) {
+        if (ipsub->family == AF_INET6) {
             maxbits = 128;
         }
 #endif
@@ -1034,22 +1316,22 @@ APR_DECLARE(apr_status_t) apr_ipsubnet_create(apr_ipsubnet_t **ipsub, const char
             int cur_entry = 0;
             apr_int32_t cur_bit_value;
 
-            memset((*ipsub)->mask, 0, sizeof (*ipsub)->mask);
+            memset(ipsub->mask, 0, sizeof ipsub->mask);
             while (bits > 32) {
-                (*ipsub)->mask[cur_entry] = 0xFFFFFFFF; /* all 32 bits */
+                ipsub->mask[cur_entry] = 0xFFFFFFFF; /* all 32 bits */
                 bits -= 32;
                 ++cur_entry;
             }
             cur_bit_value = 0x80000000;
             while (bits) {
-                (*ipsub)->mask[cur_entry] |= cur_bit_value;
+                ipsub->mask[cur_entry] |= cur_bit_value;
                 --bits;
                 cur_bit_value /= 2;
             }
-            (*ipsub)->mask[cur_entry] = htonl((*ipsub)->mask[cur_entry]);
+            ipsub->mask[cur_entry] = htonl(ipsub->mask[cur_entry]);
         }
-        else if (apr_inet_pton(AF_INET, mask_or_numbits, (*ipsub)->mask) == 1 &&
-            (*ipsub)->family == AF_INET) {
+        else if (apr_inet_pton(AF_INET, mask_or_numbits, ipsub->mask) == 1 &&
+            ipsub->family == AF_INET) {
             /* valid IPv4 netmask */
         }
         else {
@@ -1057,11 +1339,29 @@ APR_DECLARE(apr_status_t) apr_ipsubnet_create(apr_ipsubnet_t **ipsub, const char
         }
     }
 
-    fix_subnet(*ipsub);
+    fix_subnet(ipsub);
 
     return APR_SUCCESS;
 }
 
+/* be sure not to store any IPv4 address as a v4-mapped IPv6 address */
+APR_DECLARE(apr_status_t) apr_ipsubnet_create(apr_ipsubnet_t **ipsub, const char *ipstr, 
+                                              const char *mask_or_numbits, apr_pool_t *p)
+{
+    /* filter out stuff which doesn't look remotely like an IP address; this helps 
+     * callers like mod_access which have a syntax allowing hostname or IP address;
+     * APR_EINVAL tells the caller that it was probably not intended to be an IP
+     * address
+     */
+    if (!looks_like_ip(ipstr)) {
+        return APR_EINVAL;
+    }
+
+    *ipsub = apr_pcalloc(p, sizeof(apr_ipsubnet_t));
+
+    return ipsubnet_init(*ipsub, ipstr, mask_or_numbits);
+}
+
 APR_DECLARE(int) apr_ipsubnet_test(apr_ipsubnet_t *ipsub, apr_sockaddr_t *sa)
 {
 #if APR_HAVE_IPV6
@@ -1097,3 +1397,256 @@ APR_DECLARE(int) apr_ipsubnet_test(apr_ipsubnet_t *ipsub, apr_sockaddr_t *sa)
 #endif /* APR_HAVE_IPV6 */
     return 0; /* no match */
 }
+
+/*
+ * apr_ipset_t: a path-compressed binary trie per address family, whose
+ * nodes live in one array and refer to each other by index.  Every node
+ * carries its full prefix, so a lookup only ever follows one path and
+ * stops at the first node that does not match, remembering the last
+ * node on the way that ends an entry.
+ */
+
+#if APR_HAVE_IPV6
+#define IPSET_WORDS 4
+#else
+#define IPSET_WORDS 1
+#endif
+
+typedef struct {
+    apr_uint32_t key[IPSET_WORDS];  /* host order, bits past plen clear */
+    int plen;
+    int child[2];                   /* node index, or -1 */
+    int used;                       /* an entry ends at this node */
+    void *data;
+} ipset_node_t;
+
+struct apr_ipset_t {
+    apr_array_header_t *nodes;
+    int root[2];                    /* IPv4, IPv6 */
+};
+
+#define IPSET_NODE(set, i) (&APR_ARRAY_IDX((set)->nodes, (i), ipset_node_t))
+#define IPSET_BIT(key, i) (((key)[(i) >> 5] >> (31 - ((i) & 31))) & 1)
+
+static int ipset_prefix_match(const apr_uint32_t *a, const apr_uint32_t *b,
+                              int plen)
+{
+    int i = 0;
+
+    for (; plen >= 32; plen -= 32, i++) {
+        if (a[i] != b[i]) {
+            return 0;
+        }
+    }
+    return plen == 0 || ((a[i] ^ b[i]) >> (32 - plen)) == 0;
+}
+
+static int ipset_common_bits(const apr_uint32_t *a, const apr_uint32_t *b,
+                             int max)
+{
+    int i, n;
+
+    for (i = 0, n = 0; n < max; i++, n += 32) {
+        apr_uint32_t x = a[i] ^ b[i];
+
+        if (x) {
+            while (!(x & 0x80000000)) {
+                x <<= 1;
+                n++;
+            }
+            return n < max ? n : max;
+        }
+    }
+    return max;
+}
+
+static int ipset_new_node(apr_ipset_t *set, const apr_uint32_t *key, int plen)
+{
+    ipset_node_t *node = apr_array_push(set->nodes);
+    int i, bits;
+
+    for (i = 0, bits = plen; i < IPSET_WORDS; i++, bits -= 32) {
+        if (bits >= 32) {
+            node->key[i] = key[i];
+        }
+        else if (bits > 0) {
+            node->key[i] = key[i] & (0xFFFFFFFF << (32 - bits));
+        }
+        else {
+            node->key[i] = 0;
+        }
+    }
+    node->plen = plen;
+    node->child[0] = node->child[1] = -1;
+    node->used = 0;
+    node->data = NULL;
+
+    return set->nodes->nelts - 1;
+}
+
+APR_DECLARE(apr_status_t) apr_ipset_create(apr_ipset_t **set, apr_pool_t *p)
+{
+    *set = apr_palloc(p, sizeof(apr_ipset_t));
+    (*set)->nodes = apr_array_make(p, 64, sizeof(ipset_node_t));
+    (*set)->root[0] = (*set)->root[1] = -1;
+
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_ipset_add_subnet(apr_ipset_t *set,
+                                               const apr_ipsubnet_t *ipsub,
+                                               void *data)
+{
+    apr_uint32_t key[IPSET_WORDS] = { 0 };
+    int i, plen, words = 1, family = 0;
+    int cur, parent = -1, which = 0, leaf, common = 0;
+    ipset_node_t *node;
+
+#if APR_HAVE_IPV6
+    if (ipsub->family == AF_INET6) {
+        words = 4;
+        family = 1;
+    }
+#endif
+
+    /* only a contiguous mask has a prefix length */
+    for (i = 0, plen = 0; i < words; i++) {
+        apr_uint32_t m = ntohl(ipsub->mask[i]);
+
+        key[i] = ntohl(ipsub->sub[i]);
+        if (plen == 32 * i) {
+            while (m & 0x80000000) {
+                m <<= 1;
+                plen++;
+            }
+        }
+        if (m) {
+            return APR_EBADMASK;
+        }
+    }
+
+    /* nodes may move as the array grows, so links are kept as indexes */
+    cur = set->root[family];
+    while (cur >= 0) {
+        node = IPSET_NODE(set, cur);
+        common = ipset_common_bits(node->key, key,
+                                   node->plen < plen ? node->plen : plen);
+        if (common < node->plen) {
+            break;
+        }
+        if (node->plen == plen) {
+            /* the same subnet again; the last one added wins */
+            node->used = 1;
+            node->data = data;
+            return APR_SUCCESS;
+        }
+        parent = cur;
+        which = IPSET_BIT(key, node->plen);
+        cur = node->child[which];
+    }
+
+    leaf = ipset_new_node(set, key, plen);
+    IPSET_NODE(set, leaf)->used = 1;
+    IPSET_NODE(set, leaf)->data = data;
+
+    if (cur >= 0) {
+        /* cur diverges from the new prefix, or extends past it */
+        const apr_uint32_t *cur_key = IPSET_NODE(set, cur)->key;
+
+        if (common == plen) {
+            IPSET_NODE(set, leaf)->child[IPSET_BIT(cur_key, plen)] = cur;
+        }
+        else {
+            int glue = ipset_new_node(set, key, common);
+
+            cur_key = IPSET_NODE(set, cur)->key;
+            IPSET_NODE(set, glue)->child[IPSET_BIT(key, common)] = leaf;
+            IPSET_NODE(set, glue)->child[IPSET_BIT(cur_key, common)] = cur;
+            leaf = glue;
+        }
+    }
+
+    if (parent < 0) {
+        set->root[family] = leaf;
+    }
+    else {
+        IPSET_NODE(set, parent)->child[which] = leaf;
+    }
+
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_ipset_add(apr_ipset_t *set, const char *ipstr,
+                                        const char *mask_or_numbits,
+                                        void *data)
+{
+    apr_ipsubnet_t ipsub;
+    apr_status_t rv;
+
+    if (!looks_like_ip(ipstr)) {
+        return APR_EINVAL;
+    }
+    memset(&ipsub, 0, sizeof ipsub);
+    rv = ipsubnet_init(&ipsub, ipstr, mask_or_numbits);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+
+    return apr_ipset_add_subnet(set, &ipsub, data);
+}
+
+APR_DECLARE(int) apr_ipset_test(apr_ipset_t *set, apr_sockaddr_t *sa,
+                                void **data)
+{
+    apr_uint32_t key[IPSET_WORDS];
+    const ipset_node_t *node, *best = NULL;
+    int cur, maxbits = 32;
+
+    /* the same families match as in apr_ipsubnet_test() */
+    if (sa->family == AF_INET) {
+        key[0] = ntohl(sa->sa.sin.sin_addr.s_addr);
+        cur = set->root[0];
+    }
+#if APR_HAVE_IPV6
+    else if (sa->family == AF_INET6
+             && IN6_IS_ADDR_V4MAPPED((struct in6_addr *)sa->ipaddr_ptr)) {
+        key[0] = ntohl(((apr_uint32_t *)sa->ipaddr_ptr)[3]);
+        cur = set->root[0];
+    }
+    else if (sa->family == AF_INET6) {
+        const apr_uint32_t *addr = (const apr_uint32_t *)sa->ipaddr_ptr;
+
+        key[0] = ntohl(addr[0]);
+        key[1] = ntohl(addr[1]);
+        key[2] = ntohl(addr[2]);
+        key[3] = ntohl(addr[3]);
+        cur = set->root[1];
+        maxbits = 128;
+    }
+#endif
+    else {
+        return 0;
+    }
+
+    while (cur >= 0) {
+        node = IPSET_NODE(set, cur);
+        if (!ipset_prefix_match(node->key, key, node->plen)) {
+            break;
+        }
+        if (node->used) {
+            best = node;
+        }
+        if (node->plen == maxbits) {
+            break;
+        }
+        cur = node->child[IPSET_BIT(key, node->plen)];
+    }
+
+    if (best == NULL) {
+        return 0;
+    }
+    if (data) {
+        *data = best->data;
+    }
+    return 1;
+}
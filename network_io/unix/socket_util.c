@@ -14,8 +14,15 @@
  * limitations under the License.
  */
 
+#include "apr_private.h"
 #include "apr_network_io.h"
 #include "apr_poll.h"
+#include "apr_portable.h"
+
+#if defined(__linux__) && APR_HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#include <linux/filter.h>
+#endif
 
 APR_DECLARE(apr_status_t) apr_socket_atreadeof(apr_socket_t *sock, int *atreadeof)
 {
@@ -72,3 +79,202 @@ APR_DECLARE(apr_status_t) apr_socket_atreadeof(apr_socket_t *sock, int *atreadeo
     return APR_EGENERAL;
 }
 
+
+/* true if a read on sock would not block */
+static int socket_readable(apr_socket_t *sock)
+{
+    apr_pollfd_t pfd;
+    apr_int32_t nfds;
+
+    pfd.p = NULL;
+    pfd.desc_type = APR_POLL_SOCKET;
+    pfd.reqevents = APR_POLLIN;
+    pfd.desc.s = sock;
+    return apr_poll(&pfd, 1, &nfds, 0) == APR_SUCCESS;
+}
+
+/* hand each connection to the listener for the CPU taking the packet */
+static apr_status_t steer_by_cpu(apr_socket_t *sock, int n)
+{
+#if defined(SO_ATTACH_REUSEPORT_CBPF) && defined(SKF_AD_CPU)
+    struct sock_filter code[] = {
+        { BPF_LD  | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, 0 },
+        { BPF_RET | BPF_A, 0, 0, 0 }
+    };
+    struct sock_fprog prog;
+    apr_os_sock_t fd;
+
+    code[1].k = n;
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+
+    apr_os_sock_get(&fd, sock);
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                   &prog, sizeof(prog)) == -1) {
+        return errno;
+    }
+    return APR_SUCCESS;
+#else
+    return APR_ENOTIMPL;
+#endif
+}
+
+APR_DECLARE(apr_status_t) apr_socket_listen_group_create(apr_socket_t **socks,
+                                                         int n,
+                                                         apr_sockaddr_t *sa,
+                                                         int type,
+                                                         int protocol,
+                                                         apr_int32_t backlog,
+                                                         apr_int32_t flags,
+                                                         apr_pool_t *p)
+{
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    if (n < 1) {
+        return APR_EINVAL;
+    }
+
+    for (i = 0; i < n; i++) {
+        rv = apr_socket_create(&socks[i], sa->family, type, protocol, p);
+        if (rv != APR_SUCCESS) {
+            break;
+        }
+        if ((rv = apr_socket_opt_set(socks[i], APR_SO_REUSEADDR, 1))
+                != APR_SUCCESS
+            || (rv = apr_socket_opt_set(socks[i], APR_SO_REUSEPORT, 1))
+                != APR_SUCCESS
+            || (rv = apr_socket_bind(socks[i], sa)) != APR_SUCCESS
+            || (rv = apr_socket_listen(socks[i], backlog)) != APR_SUCCESS) {
+            apr_socket_close(socks[i]);
+            break;
+        }
+        if (i == 0) {
+            /* the others must share the port the first one was given */
+            rv = apr_socket_addr_get(&sa, APR_LOCAL, socks[0]);
+            if (rv != APR_SUCCESS) {
+                apr_socket_close(socks[i]);
+                break;
+            }
+        }
+    }
+
+    /* the program is shared by the group; attach it once all are in */
+    if (rv == APR_SUCCESS && (flags & APR_LISTEN_GROUP_STEER_CPU)) {
+        rv = steer_by_cpu(socks[0], n);
+    }
+
+    if (rv != APR_SUCCESS) {
+        while (i-- > 0) {
+            apr_socket_close(socks[i]);
+        }
+    }
+    return rv;
+}
+
+APR_DECLARE(apr_status_t) apr_socket_accept_batch(apr_socket_t **new_socks,
+                                                  apr_socket_t *sock,
+                                                  apr_pool_t **connection_pools,
+                                                  int n, int *naccepted)
+{
+    apr_interval_time_t timeout;
+    apr_status_t rv;
+    int i;
+
+    *naccepted = 0;
+    if (n < 1) {
+        return APR_EINVAL;
+    }
+
+    /* the first accept behaves exactly as apr_socket_accept() */
+    rv = apr_socket_accept(&new_socks[0], sock, connection_pools[0]);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+
+    /* the rest only take what is already queued: a blocking listener is
+     * made non-blocking meanwhile, as another process may take the
+     * connection that a poll saw before this one gets to accept it
+     */
+    apr_socket_timeout_get(sock, &timeout);
+    if (timeout != 0) {
+        apr_socket_timeout_set(sock, 0);
+    }
+    for (i = 1; i < n; i++) {
+        /* APR_EAGAIN, or anything else that will show up again next time */
+        if (apr_socket_accept(&new_socks[i], sock, connection_pools[i])
+                != APR_SUCCESS) {
+            break;
+        }
+#if APR_O_NONBLOCK_INHERITED
+        if (timeout != 0) {
+            apr_socket_opt_set(new_socks[i], APR_SO_NONBLOCK, 0);
+        }
+#endif
+    }
+    if (timeout != 0) {
+        apr_socket_timeout_set(sock, timeout);
+    }
+
+    *naccepted = i;
+    return APR_SUCCESS;
+}
+
+#ifndef HAVE_SENDMMSG
+APR_DECLARE(apr_status_t) apr_socket_sendmmsg(apr_socket_t *sock,
+                                              apr_socket_msg_t *msgs,
+                                              int nmsgs, apr_int32_t flags,
+                                              int *nsent)
+{
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    for (i = 0; i < nmsgs; i++) {
+        apr_size_t len = msgs[i].len;
+
+        if (msgs[i].addr) {
+            rv = apr_socket_sendto(sock, msgs[i].addr, flags, msgs[i].buf,
+                                   &len);
+        }
+        else {
+            rv = apr_socket_send(sock, msgs[i].buf, &len);
+        }
+        if (rv != APR_SUCCESS) {
+            break;
+        }
+    }
+
+    *nsent = i;
+    return i ? APR_SUCCESS : rv;
+}
+#endif /* HAVE_SENDMMSG */
+
+#ifndef HAVE_RECVMMSG
+APR_DECLARE(apr_status_t) apr_socket_recvmmsg(apr_socket_t *sock,
+                                              apr_socket_msg_t *msgs,
+                                              int nmsgs, apr_int32_t flags,
+                                              int *nrecv)
+{
+    apr_interval_time_t timeout;
+    apr_sockaddr_t from;
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    apr_socket_timeout_get(sock, &timeout);
+    for (i = 0; i < nmsgs; i++) {
+        /* only the first datagram is waited for */
+        if (i && timeout != 0 && !socket_readable(sock)) {
+            break;
+        }
+        rv = apr_socket_recvfrom(msgs[i].addr ? msgs[i].addr : &from, sock,
+                                 flags, msgs[i].buf, &msgs[i].len);
+        if (rv != APR_SUCCESS) {
+            break;
+        }
+    }
+
+    *nrecv = i;
+    return i ? APR_SUCCESS : rv;
+}
+#endif /* HAVE_RECVMMSG */
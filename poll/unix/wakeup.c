@@ -22,6 +22,12 @@
 #include "apr_arch_networkio.h"
 #include "apr_arch_poll_private.h"
 #include "apr_arch_inherit.h"
+#include "apr_atomic.h"
+
+#if APR_FILES_AS_SOCKETS && defined(HAVE_EVENTFD) && defined(HAVE_SYS_EVENTFD_H)
+#include <sys/eventfd.h>
+#define WAKEUP_EVENTFD 1
+#endif
 
 #if !APR_FILES_AS_SOCKETS
 
@@ -80,6 +86,28 @@ apr_status_t apr_poll_create_wakeup_pipe(apr_pool_t *pool, apr_pollfd_t *pfd,
 {
     apr_status_t rv;
 
+#ifdef WAKEUP_EVENTFD
+    {
+        apr_os_file_t fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+        /* without it (an old kernel), fall back on a pipe */
+        if (fd != -1) {
+            if ((rv = apr_os_pipe_put_ex(&wakeup_pipe[0], &fd, 1, pool))
+                    != APR_SUCCESS) {
+                close(fd);
+                return rv;
+            }
+            wakeup_pipe[1] = wakeup_pipe[0];
+
+            pfd->p = pool;
+            pfd->reqevents = APR_POLLIN;
+            pfd->desc_type = APR_POLL_FILE;
+            pfd->desc.f = wakeup_pipe[0];
+            return APR_SUCCESS;
+        }
+    }
+#endif
+
     if ((rv = apr_file_pipe_create(&wakeup_pipe[0], &wakeup_pipe[1],
                                    pool)) != APR_SUCCESS)
         return rv;
@@ -119,6 +147,10 @@ apr_status_t apr_poll_close_wakeup_pipe(apr_file_t **wakeup_pipe)
     apr_status_t rv1 = APR_SUCCESS;
 
     /* Close both sides of the wakeup pipe */
+    if (wakeup_pipe[0] == wakeup_pipe[1]) {
+        /* an eventfd */
+        wakeup_pipe[1] = NULL;
+    }
     if (wakeup_pipe[0]) {
         rv0 = apr_file_close(wakeup_pipe[0]);
         wakeup_pipe[0] = NULL;
@@ -132,13 +164,58 @@ apr_status_t apr_poll_close_wakeup_pipe(apr_file_t **wakeup_pipe)
 
 #endif /* APR_FILES_AS_SOCKETS */
 
+/* Wake up the poller, unless a wakeup is already pending: concurrent
+ * callers then cost a single write, and the pipe never fills up.
+ */
+apr_status_t apr_poll_wakeup(volatile apr_uint32_t *wakeup_set,
+                             apr_file_t **wakeup_pipe)
+{
+    apr_status_t rv;
+
+    if (apr_atomic_cas32(wakeup_set, 1, 0) != 0) {
+        return APR_SUCCESS;
+    }
+
+#ifdef WAKEUP_EVENTFD
+    if (wakeup_pipe[0] == wakeup_pipe[1]) {
+        apr_uint64_t one = 1;
+
+        if (write(wakeup_pipe[1]->filedes, &one, sizeof(one)) == -1) {
+            rv = errno;
+            apr_atomic_set32(wakeup_set, 0);
+            return rv;
+        }
+        return APR_SUCCESS;
+    }
+#endif
+
+    if ((rv = apr_file_putc(1, wakeup_pipe[1])) != APR_SUCCESS) {
+        apr_atomic_set32(wakeup_set, 0);
+    }
+    return rv;
+}
+
 /* Read and discard whatever is in the wakeup pipe.
  */
-void apr_poll_drain_wakeup_pipe(apr_file_t **wakeup_pipe)
+void apr_poll_drain_wakeup_pipe(volatile apr_uint32_t *wakeup_set,
+                                apr_file_t **wakeup_pipe)
 {
     char rb[512];
     apr_size_t nr = sizeof(rb);
 
+#ifdef WAKEUP_EVENTFD
+    if (wakeup_pipe[0] == wakeup_pipe[1]) {
+        apr_uint64_t count;
+
+        /* one read resets the counter */
+        if (read(wakeup_pipe[0]->filedes, &count, sizeof(count)) == -1) {
+            /* EAGAIN: already drained */
+        }
+        apr_atomic_set32(wakeup_set, 0);
+        return;
+    }
+#endif
+
     while (apr_file_read(wakeup_pipe[0], rb, &nr) == APR_SUCCESS) {
         /* Although we write just one byte to the other end of the pipe
          * during wakeup, multiple threads could call the wakeup.
@@ -148,4 +225,8 @@ void apr_poll_drain_wakeup_pipe(apr_file_t **wakeup_pipe)
         if (nr != sizeof(rb))
             break;
     }
+
+    /* Only rearm once empty: wakeups skipped until now are answered by
+     * the poll that is about to return APR_EINTR. */
+    apr_atomic_set32(wakeup_set, 0);
 }
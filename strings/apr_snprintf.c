@@ -311,6 +311,33 @@ while (width > len)
     has_prefix=YES;
 
 
+/*
+ * The decimal representations of 0 to 99, for converting two digits
+ * at a time.
+ */
+static const char two_digits[100][2] = {
+    {'0','0'},{'0','1'},{'0','2'},{'0','3'},{'0','4'},
+    {'0','5'},{'0','6'},{'0','7'},{'0','8'},{'0','9'},
+    {'1','0'},{'1','1'},{'1','2'},{'1','3'},{'1','4'},
+    {'1','5'},{'1','6'},{'1','7'},{'1','8'},{'1','9'},
+    {'2','0'},{'2','1'},{'2','2'},{'2','3'},{'2','4'},
+    {'2','5'},{'2','6'},{'2','7'},{'2','8'},{'2','9'},
+    {'3','0'},{'3','1'},{'3','2'},{'3','3'},{'3','4'},
+    {'3','5'},{'3','6'},{'3','7'},{'3','8'},{'3','9'},
+    {'4','0'},{'4','1'},{'4','2'},{'4','3'},{'4','4'},
+    {'4','5'},{'4','6'},{'4','7'},{'4','8'},{'4','9'},
+    {'5','0'},{'5','1'},{'5','2'},{'5','3'},{'5','4'},
+    {'5','5'},{'5','6'},{'5','7'},{'5','8'},{'5','9'},
+    {'6','0'},{'6','1'},{'6','2'},{'6','3'},{'6','4'},
+    {'6','5'},{'6','6'},{'6','7'},{'6','8'},{'6','9'},
+    {'7','0'},{'7','1'},{'7','2'},{'7','3'},{'7','4'},
+    {'7','5'},{'7','6'},{'7','7'},{'7','8'},{'7','9'},
+    {'8','0'},{'8','1'},{'8','2'},{'8','3'},{'8','4'},
+    {'8','5'},{'8','6'},{'8','7'},{'8','8'},{'8','9'},
+    {'9','0'},{'9','1'},{'9','2'},{'9','3'},{'9','4'},
+    {'9','5'},{'9','6'},{'9','7'},{'9','8'},{'9','9'}
+};
+
 /*
  * Convert num to its decimal format.
  * Return value:
@@ -356,15 +383,23 @@ static char *conv_10(register apr_int32_t num, register int is_unsigned,
     }
 
     /*
-     * We use a do-while loop so that we write at least 1 digit 
+     * Emit two digits per division, then the last one or two digits
+     * so that we write at least 1 digit
      */
-    do {
-        register apr_uint32_t new_magnitude = magnitude / 10;
+    while (magnitude >= 100) {
+        register const char *d = two_digits[magnitude % 100];
 
-        *--p = (char) (magnitude - new_magnitude * 10 + '0');
-        magnitude = new_magnitude;
+        magnitude /= 100;
+        *--p = d[1];
+        *--p = d[0];
+    }
+    if (magnitude >= 10) {
+        *--p = two_digits[magnitude][1];
+        *--p = two_digits[magnitude][0];
+    }
+    else {
+        *--p = (char) (magnitude + '0');
     }
-    while (magnitude);
 
     *len = buf_end - p;
     return (p);
@@ -376,6 +411,7 @@ static char *conv_10_quad(apr_int64_t num, register int is_unsigned,
 {
     register char *p = buf_end;
     apr_uint64_t magnitude = num;
+    int is_negative_low;
 
     /*
      * We see if we can use the faster non-quad version by checking the
@@ -408,15 +444,17 @@ static char *conv_10_quad(apr_int64_t num, register int is_unsigned,
     }
 
     /*
-     * We use a do-while loop so that we write at least 1 digit 
+     * Emit two digits per 64-bit division until the rest fits the
+     * cheaper 32-bit arithmetic of conv_10
      */
-    do {
-        apr_uint64_t new_magnitude = magnitude / 10;
+    while (magnitude > APR_UINT32_MAX) {
+        const char *d = two_digits[magnitude % 100];
 
-        *--p = (char) (magnitude - new_magnitude * 10 + '0');
-        magnitude = new_magnitude;
+        magnitude /= 100;
+        *--p = d[1];
+        *--p = d[0];
     }
-    while (magnitude);
+    p = conv_10((apr_int32_t)magnitude, TRUE, &is_negative_low, p, len);
 
     *len = buf_end - p;
     return (p);
@@ -678,10 +716,193 @@ static char *conv_os_thread_t_hex(apr_os_thread_t *tid, char *buf_end, apr_size_
 #endif
 
 /*
- * Do format conversion placing the output in buffer
+ * A parsed conversion specification, the part of the format string
+ * starting at a '%' up to and including the conversion character.
  */
-APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
-    apr_vformatter_buff_t *vbuff, const char *fmt, va_list ap)
+typedef enum {
+    IS_QUAD, IS_LONG, IS_SHORT, IS_INT
+} var_type_e;
+
+typedef struct {
+    /* literal text preceding the conversion (only used by plans) */
+    const char *literal;
+    apr_size_t literal_len;
+
+    char conv;              /* conversion character, NUL for none */
+    char ext;               /* second character of the %p extensions */
+    char pad_char;
+    char adjust_left;
+    boolean_e alternate_form;
+    boolean_e print_sign;
+    boolean_e print_blank;
+    boolean_e adjust_width;
+    boolean_e adjust_precision;
+    boolean_e width_arg;    /* width given as '*' */
+    boolean_e precision_arg;/* precision given as '*' */
+    var_type_e var_type;
+    apr_size_t min_width;
+    apr_size_t precision;
+} fmt_spec_t;
+
+struct apr_vformatter_plan_t {
+    /** The conversions, each with the literal text preceding it */
+    fmt_spec_t *specs;
+    /** The number of conversions, including a trailing literal */
+    int nspecs;
+    /** The number of arguments the conversions consume */
+    int nargs;
+};
+
+/*
+ * Parse the conversion specification following a '%'.  Returns a
+ * pointer to the last character of the specification, which is the
+ * conversion character (or the second character of a %p extension),
+ * or the terminating NUL of a truncated specification.
+ */
+static const char *parse_spec(const char *fmt, fmt_spec_t *spec)
+{
+    spec->adjust_left = NO;
+    spec->alternate_form = spec->print_sign = spec->print_blank = NO;
+    spec->width_arg = spec->precision_arg = NO;
+    spec->pad_char = ' ';
+    spec->ext = NUL;
+
+    /*
+     * Try to avoid checking for flags, width or precision
+     */
+    if (!apr_islower(*fmt)) {
+        /*
+         * Recognize flags: -, #, BLANK, +
+         */
+        for (;; fmt++) {
+            if (*fmt == '-')
+                spec->adjust_left = YES;
+            else if (*fmt == '+')
+                spec->print_sign = YES;
+            else if (*fmt == '#')
+                spec->alternate_form = YES;
+            else if (*fmt == ' ')
+                spec->print_blank = YES;
+            else if (*fmt == '0')
+                spec->pad_char = '0';
+            else
+                break;
+        }
+
+        /*
+         * Check if a width was specified
+         */
+        if (apr_isdigit(*fmt)) {
+            STR_TO_DEC(fmt, spec->min_width);
+            spec->adjust_width = YES;
+        }
+        else if (*fmt == '*') {
+            fmt++;
+            spec->adjust_width = YES;
+            spec->width_arg = YES;
+        }
+        else
+            spec->adjust_width = NO;
+
+        /*
+         * Check if a precision was specified
+         */
+        if (*fmt == '.') {
+            spec->adjust_precision = YES;
+            fmt++;
+            if (apr_isdigit(*fmt)) {
+                STR_TO_DEC(fmt, spec->precision);
+            }
+            else if (*fmt == '*') {
+                fmt++;
+                spec->precision_arg = YES;
+            }
+            else
+                spec->precision = 0;
+        }
+        else
+            spec->adjust_precision = NO;
+    }
+    else
+        spec->adjust_precision = spec->adjust_width = NO;
+
+    /*
+     * Modifier check.  In same cases, APR_OFF_T_FMT can be
+     * "lld" and APR_INT64_T_FMT can be "ld" (that is, off_t is
+     * "larger" than int64). Check that case 1st.
+     * Note that if APR_OFF_T_FMT is "d",
+     * the first if condition is never true. If APR_INT64_T_FMT
+     * is "d' then the second if condition is never true.
+     */
+    if ((sizeof(APR_OFF_T_FMT) > sizeof(APR_INT64_T_FMT)) &&
+        ((sizeof(APR_OFF_T_FMT) == 4 &&
+         fmt[0] == APR_OFF_T_FMT[0] &&
+         fmt[1] == APR_OFF_T_FMT[1]) ||
+        (sizeof(APR_OFF_T_FMT) == 3 &&
+         fmt[0] == APR_OFF_T_FMT[0]) ||
+        (sizeof(APR_OFF_T_FMT) > 4 &&
+         strncmp(fmt, APR_OFF_T_FMT,
+                 sizeof(APR_OFF_T_FMT) - 2) == 0))) {
+        /* Need to account for trailing 'd' and null in sizeof() */
+        spec->var_type = IS_QUAD;
+        fmt += (sizeof(APR_OFF_T_FMT) - 2);
+    }
+    else if ((sizeof(APR_INT64_T_FMT) == 4 &&
+         fmt[0] == APR_INT64_T_FMT[0] &&
+         fmt[1] == APR_INT64_T_FMT[1]) ||
+        (sizeof(APR_INT64_T_FMT) == 3 &&
+         fmt[0] == APR_INT64_T_FMT[0]) ||
+        (sizeof(APR_INT64_T_FMT) > 4 &&
+         strncmp(fmt, APR_INT64_T_FMT,
+                 sizeof(APR_INT64_T_FMT) - 2) == 0)) {
+        /* Need to account for trailing 'd' and null in sizeof() */
+        spec->var_type = IS_QUAD;
+        fmt += (sizeof(APR_INT64_T_FMT) - 2);
+    }
+    else if (*fmt == 'q') {
+        spec->var_type = IS_QUAD;
+        fmt++;
+    }
+    else if (*fmt == 'l') {
+        spec->var_type = IS_LONG;
+        fmt++;
+    }
+    else if (*fmt == 'h') {
+        spec->var_type = IS_SHORT;
+        fmt++;
+    }
+    else {
+        spec->var_type = IS_INT;
+    }
+
+    spec->conv = *fmt;
+    if (*fmt == 'p') {
+        spec->ext = *++fmt;
+    }
+    return fmt;
+}
+
+/*
+ * Argument extraction, either from the va_list or, when executing a
+ * plan with an argument array, from the next element of the array.
+ */
+#define INT_ARG(type)                               \
+    (argv ? (type) argv[argi++].i : va_arg(ap, type))
+#define UINT_ARG(type)                              \
+    (argv ? (type) argv[argi++].u : va_arg(ap, type))
+#define DOUBLE_ARG()                                \
+    (argv ? argv[argi++].d : va_arg(ap, double))
+#define PTR_ARG(type)                               \
+    (argv ? (type) argv[argi++].p : va_arg(ap, type))
+
+/*
+ * Do format conversion placing the output in buffer.  The conversions
+ * are either parsed from fmt as we go, or taken from a compiled plan.
+ */
+static int vformatter(int (*flush_func)(apr_vformatter_buff_t *),
+                      apr_vformatter_buff_t *vbuff, const char *fmt,
+                      const apr_vformatter_plan_t *plan,
+                      const apr_vformatter_arg_t *argv, va_list ap)
 {
     register char *sp;
     register char *bep;
@@ -709,10 +930,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
     char num_buf[NUM_BUF_SIZE];
     char char_buf[2];                /* for printing %% and %<unknown> */
 
-    enum var_type_enum {
-            IS_QUAD, IS_LONG, IS_SHORT, IS_INT
-    };
-    enum var_type_enum var_type = IS_INT;
+    var_type_e var_type = IS_INT;
 
     /*
      * Flag variables
@@ -724,139 +942,86 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
     boolean_e adjust_width;
     int is_negative;
 
+    fmt_spec_t parsed;
+    const fmt_spec_t *cur, *spec = NULL, *end = NULL;
+    int argi = 0;
+
+    if (plan) {
+        spec = plan->specs;
+        end = spec + plan->nspecs;
+    }
+
     sp = vbuff->curpos;
     bep = vbuff->endpos;
 
-    while (*fmt) {
-        if (*fmt != '%') {
-            INS_CHAR(*fmt, sp, bep, cc);
+    for (;;) {
+        if (plan) {
+            if (spec == end)
+                break;
+            s = (char *)spec->literal;
+            i = spec->literal_len;
+            if (sp && (apr_size_t)(bep - sp) >= i) {
+                memcpy(sp, s, i);
+                sp += i;
+                cc += (int)i;
+            }
+            else {
+                for (; i != 0; i--) {
+                    INS_CHAR(*s, sp, bep, cc);
+                    s++;
+                }
+            }
+            if (spec->conv == NUL) {
+                /* trailing literal text */
+                break;
+            }
+            cur = spec++;
         }
         else {
+            if (*fmt == NUL)
+                break;
+            if (*fmt != '%') {
+                INS_CHAR(*fmt, sp, bep, cc);
+                fmt++;
+                continue;
+            }
+            fmt = parse_spec(fmt + 1, &parsed);
+            cur = &parsed;
+        }
+
+        {
             /*
              * Default variable settings
              */
             boolean_e print_something = YES;
-            adjust = RIGHT;
-            alternate_form = print_sign = print_blank = NO;
-            pad_char = ' ';
+            adjust = cur->adjust_left ? LEFT : RIGHT;
+            alternate_form = cur->alternate_form;
+            print_sign = cur->print_sign;
+            print_blank = cur->print_blank;
+            pad_char = cur->pad_char;
             prefix_char = NUL;
-
-            fmt++;
-
-            /*
-             * Try to avoid checking for flags, width or precision
-             */
-            if (!apr_islower(*fmt)) {
-                /*
-                 * Recognize flags: -, #, BLANK, +
-                 */
-                for (;; fmt++) {
-                    if (*fmt == '-')
-                        adjust = LEFT;
-                    else if (*fmt == '+')
-                        print_sign = YES;
-                    else if (*fmt == '#')
-                        alternate_form = YES;
-                    else if (*fmt == ' ')
-                        print_blank = YES;
-                    else if (*fmt == '0')
-                        pad_char = '0';
-                    else
-                        break;
-                }
-
-                /*
-                 * Check if a width was specified
-                 */
-                if (apr_isdigit(*fmt)) {
-                    STR_TO_DEC(fmt, min_width);
-                    adjust_width = YES;
-                }
-                else if (*fmt == '*') {
-                    int v = va_arg(ap, int);
-                    fmt++;
-                    adjust_width = YES;
-                    if (v < 0) {
-                        adjust = LEFT;
-                        min_width = (apr_size_t)(-v);
-                    }
-                    else
-                        min_width = (apr_size_t)v;
+            adjust_width = cur->adjust_width;
+            adjust_precision = cur->adjust_precision;
+            var_type = cur->var_type;
+
+            if (cur->width_arg) {
+                int v = INT_ARG(int);
+                if (v < 0) {
+                    adjust = LEFT;
+                    min_width = (apr_size_t)(-v);
                 }
                 else
-                    adjust_width = NO;
-
-                /*
-                 * Check if a precision was specified
-                 */
-                if (*fmt == '.') {
-                    adjust_precision = YES;
-                    fmt++;
-                    if (apr_isdigit(*fmt)) {
-                        STR_TO_DEC(fmt, precision);
-                    }
-                    else if (*fmt == '*') {
-                        int v = va_arg(ap, int);
-                        fmt++;
-                        precision = (v < 0) ? 0 : (apr_size_t)v;
-                    }
-                    else
-                        precision = 0;
-                }
-                else
-                    adjust_precision = NO;
+                    min_width = (apr_size_t)v;
             }
-            else
-                adjust_precision = adjust_width = NO;
+            else if (adjust_width)
+                min_width = cur->min_width;
 
-            /*
-             * Modifier check.  In same cases, APR_OFF_T_FMT can be
-             * "lld" and APR_INT64_T_FMT can be "ld" (that is, off_t is
-             * "larger" than int64). Check that case 1st.
-             * Note that if APR_OFF_T_FMT is "d",
-             * the first if condition is never true. If APR_INT64_T_FMT
-             * is "d' then the second if condition is never true.
-             */
-            if ((sizeof(APR_OFF_T_FMT) > sizeof(APR_INT64_T_FMT)) &&
-                ((sizeof(APR_OFF_T_FMT) == 4 &&
-                 fmt[0] == APR_OFF_T_FMT[0] &&
-                 fmt[1] == APR_OFF_T_FMT[1]) ||
-                (sizeof(APR_OFF_T_FMT) == 3 &&
-                 fmt[0] == APR_OFF_T_FMT[0]) ||
-                (sizeof(APR_OFF_T_FMT) > 4 &&
-                 strncmp(fmt, APR_OFF_T_FMT, 
-                         sizeof(APR_OFF_T_FMT) - 2) == 0))) {
-                /* Need to account for trailing 'd' and null in sizeof() */
-                var_type = IS_QUAD;
-                fmt += (sizeof(APR_OFF_T_FMT) - 2);
-            }
-            else if ((sizeof(APR_INT64_T_FMT) == 4 &&
-                 fmt[0] == APR_INT64_T_FMT[0] &&
-                 fmt[1] == APR_INT64_T_FMT[1]) ||
-                (sizeof(APR_INT64_T_FMT) == 3 &&
-                 fmt[0] == APR_INT64_T_FMT[0]) ||
-                (sizeof(APR_INT64_T_FMT) > 4 &&
-                 strncmp(fmt, APR_INT64_T_FMT, 
-                         sizeof(APR_INT64_T_FMT) - 2) == 0)) {
-                /* Need to account for trailing 'd' and null in sizeof() */
-                var_type = IS_QUAD;
-                fmt += (sizeof(APR_INT64_T_FMT) - 2);
-            }
-            else if (*fmt == 'q') {
-                var_type = IS_QUAD;
-                fmt++;
-            }
-            else if (*fmt == 'l') {
-                var_type = IS_LONG;
-                fmt++;
-            }
-            else if (*fmt == 'h') {
-                var_type = IS_SHORT;
-                fmt++;
-            }
-            else {
-                var_type = IS_INT;
+            if (cur->precision_arg) {
+                int v = INT_ARG(int);
+                precision = (v < 0) ? 0 : (apr_size_t)v;
             }
+            else if (adjust_precision)
+                precision = cur->precision;
 
             /*
              * Argument extraction and printing.
@@ -869,20 +1034,20 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
              * NOTE: pad_char may be set to '0' because of the 0 flag.
              *   It is reset to ' ' by non-numeric formats
              */
-            switch (*fmt) {
+            switch (cur->conv) {
             case 'u':
                 if (var_type == IS_QUAD) {
-                    i_quad = va_arg(ap, apr_uint64_t);
+                    i_quad = UINT_ARG(apr_uint64_t);
                     s = conv_10_quad(i_quad, 1, &is_negative,
                             &num_buf[NUM_BUF_SIZE], &s_len);
                 }
                 else {
                     if (var_type == IS_LONG)
-                        i_num = (apr_int32_t) va_arg(ap, apr_uint32_t);
+                        i_num = (apr_int32_t) UINT_ARG(apr_uint32_t);
                     else if (var_type == IS_SHORT)
-                        i_num = (apr_int32_t) (unsigned short) va_arg(ap, unsigned int);
+                        i_num = (apr_int32_t) (unsigned short) UINT_ARG(unsigned int);
                     else
-                        i_num = (apr_int32_t) va_arg(ap, unsigned int);
+                        i_num = (apr_int32_t) UINT_ARG(unsigned int);
                     s = conv_10(i_num, 1, &is_negative,
                             &num_buf[NUM_BUF_SIZE], &s_len);
                 }
@@ -892,17 +1057,17 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
             case 'd':
             case 'i':
                 if (var_type == IS_QUAD) {
-                    i_quad = va_arg(ap, apr_int64_t);
+                    i_quad = INT_ARG(apr_int64_t);
                     s = conv_10_quad(i_quad, 0, &is_negative,
                             &num_buf[NUM_BUF_SIZE], &s_len);
                 }
                 else {
                     if (var_type == IS_LONG)
-                        i_num = va_arg(ap, apr_int32_t);
+                        i_num = INT_ARG(apr_int32_t);
                     else if (var_type == IS_SHORT)
-                        i_num = (short) va_arg(ap, int);
+                        i_num = (short) INT_ARG(int);
                     else
-                        i_num = va_arg(ap, int);
+                        i_num = INT_ARG(int);
                     s = conv_10(i_num, 0, &is_negative,
                             &num_buf[NUM_BUF_SIZE], &s_len);
                 }
@@ -919,18 +1084,18 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
 
             case 'o':
                 if (var_type == IS_QUAD) {
-                    ui_quad = va_arg(ap, apr_uint64_t);
-                    s = conv_p2_quad(ui_quad, 3, *fmt,
+                    ui_quad = UINT_ARG(apr_uint64_t);
+                    s = conv_p2_quad(ui_quad, 3, cur->conv,
                             &num_buf[NUM_BUF_SIZE], &s_len);
                 }
                 else {
                     if (var_type == IS_LONG)
-                        ui_num = va_arg(ap, apr_uint32_t);
+                        ui_num = UINT_ARG(apr_uint32_t);
                     else if (var_type == IS_SHORT)
-                        ui_num = (unsigned short) va_arg(ap, unsigned int);
+                        ui_num = (unsigned short) UINT_ARG(unsigned int);
                     else
-                        ui_num = va_arg(ap, unsigned int);
-                    s = conv_p2(ui_num, 3, *fmt,
+                        ui_num = UINT_ARG(unsigned int);
+                    s = conv_p2(ui_num, 3, cur->conv,
                             &num_buf[NUM_BUF_SIZE], &s_len);
                 }
                 FIX_PRECISION(adjust_precision, precision, s, s_len);
@@ -944,23 +1109,23 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
             case 'x':
             case 'X':
                 if (var_type == IS_QUAD) {
-                    ui_quad = va_arg(ap, apr_uint64_t);
-                    s = conv_p2_quad(ui_quad, 4, *fmt,
+                    ui_quad = UINT_ARG(apr_uint64_t);
+                    s = conv_p2_quad(ui_quad, 4, cur->conv,
                             &num_buf[NUM_BUF_SIZE], &s_len);
                 }
                 else {
                     if (var_type == IS_LONG)
-                        ui_num = va_arg(ap, apr_uint32_t);
+                        ui_num = UINT_ARG(apr_uint32_t);
                     else if (var_type == IS_SHORT)
-                        ui_num = (unsigned short) va_arg(ap, unsigned int);
+                        ui_num = (unsigned short) UINT_ARG(unsigned int);
                     else
-                        ui_num = va_arg(ap, unsigned int);
-                    s = conv_p2(ui_num, 4, *fmt,
+                        ui_num = UINT_ARG(unsigned int);
+                    s = conv_p2(ui_num, 4, cur->conv,
                             &num_buf[NUM_BUF_SIZE], &s_len);
                 }
                 FIX_PRECISION(adjust_precision, precision, s, s_len);
                 if (alternate_form && ui_num != 0) {
-                    *--s = *fmt;        /* 'x' or 'X' */
+                    *--s = cur->conv;        /* 'x' or 'X' */
                     *--s = '0';
                     s_len += 2;
                 }
@@ -968,7 +1133,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
 
 
             case 's':
-                s = va_arg(ap, char *);
+                s = PTR_ARG(char *);
                 if (s != NULL) {
                     if (!adjust_precision) {
                         s_len = strlen(s);
@@ -1014,7 +1179,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
             case 'f':
             case 'e':
             case 'E':
-                fp_num = va_arg(ap, double);
+                fp_num = DOUBLE_ARG();
                 /*
                  * We use &num_buf[ 1 ], so that we have room for the sign
                  */
@@ -1032,7 +1197,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                 }
 #endif
                 if (!s) {
-                    s = conv_fp(*fmt, fp_num, alternate_form,
+                    s = conv_fp(cur->conv, fp_num, alternate_form,
                                 (int)((adjust_precision == NO) ? FLOAT_DIGITS : precision),
                                 &is_negative, &num_buf[1], &s_len);
                     if (is_negative)
@@ -1054,7 +1219,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                 /*
                  * * We use &num_buf[ 1 ], so that we have room for the sign
                  */
-                s = apr_gcvt(va_arg(ap, double), (int) precision, &num_buf[1],
+                s = apr_gcvt(DOUBLE_ARG(), (int) precision, &num_buf[1],
                             alternate_form);
                 if (*s == '-')
                     prefix_char = *s++;
@@ -1069,13 +1234,13 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                     s[s_len++] = '.';
                     s[s_len] = '\0'; /* delimit for following strchr() */
                 }
-                if (*fmt == 'G' && (q = strchr(s, 'e')) != NULL)
+                if (cur->conv == 'G' && (q = strchr(s, 'e')) != NULL)
                     *q = 'E';
                 break;
 
 
             case 'c':
-                char_buf[0] = (char) (va_arg(ap, int));
+                char_buf[0] = (char) (INT_ARG(int));
                 s = &char_buf[0];
                 s_len = 1;
                 pad_char = ' ';
@@ -1092,13 +1257,13 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
 
             case 'n':
                 if (var_type == IS_QUAD)
-                    *(va_arg(ap, apr_int64_t *)) = cc;
+                    *(PTR_ARG(apr_int64_t *)) = cc;
                 else if (var_type == IS_LONG)
-                    *(va_arg(ap, long *)) = cc;
+                    *(PTR_ARG(long *)) = cc;
                 else if (var_type == IS_SHORT)
-                    *(va_arg(ap, short *)) = cc;
+                    *(PTR_ARG(short *)) = cc;
                 else
-                    *(va_arg(ap, int *)) = cc;
+                    *(PTR_ARG(int *)) = cc;
                 print_something = NO;
                 break;
 
@@ -1107,7 +1272,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                  * type specifier
                  */
             case 'p':
-                switch(*++fmt) {
+                switch(cur->ext) {
                 /*
                  * If the pointer size is equal to or smaller than the size
                  * of the largest unsigned int, we convert the pointer to a
@@ -1117,13 +1282,13 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                 case 'p':
 #if APR_SIZEOF_VOIDP == 8
                     if (sizeof(void *) <= sizeof(apr_uint64_t)) {
-                        ui_quad = (apr_uint64_t) va_arg(ap, void *);
+                        ui_quad = (apr_uint64_t) PTR_ARG(void *);
                         s = conv_p2_quad(ui_quad, 4, 'x',
                                 &num_buf[NUM_BUF_SIZE], &s_len);
                     }
 #else
                     if (sizeof(void *) <= sizeof(apr_uint32_t)) {
-                        ui_num = (apr_uint32_t) va_arg(ap, void *);
+                        ui_num = (apr_uint32_t) PTR_ARG(void *);
                         s = conv_p2(ui_num, 4, 'x',
                                 &num_buf[NUM_BUF_SIZE], &s_len);
                     }
@@ -1141,7 +1306,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                 {
                     apr_sockaddr_t *sa;
 
-                    sa = va_arg(ap, apr_sockaddr_t *);
+                    sa = PTR_ARG(apr_sockaddr_t *);
                     if (sa != NULL) {
                         s = conv_apr_sockaddr(sa, &num_buf[NUM_BUF_SIZE], &s_len);
                         if (adjust_precision && precision < s_len)
@@ -1160,7 +1325,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                 {
                     struct in_addr *ia;
 
-                    ia = va_arg(ap, struct in_addr *);
+                    ia = PTR_ARG(struct in_addr *);
                     if (ia != NULL) {
                         s = conv_in_addr(ia, &num_buf[NUM_BUF_SIZE], &s_len);
                         if (adjust_precision && precision < s_len)
@@ -1179,7 +1344,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                 {
                     apr_status_t *mrv;
 
-                    mrv = va_arg(ap, apr_status_t *);
+                    mrv = PTR_ARG(apr_status_t *);
                     if (mrv != NULL) {
                         s = apr_strerror(*mrv, num_buf, NUM_BUF_SIZE-1);
                         s_len = strlen(s);
@@ -1197,7 +1362,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                 {
                     apr_os_thread_t *tid;
 
-                    tid = va_arg(ap, apr_os_thread_t *);
+                    tid = PTR_ARG(apr_os_thread_t *);
                     if (tid != NULL) {
                         s = conv_os_thread_t(tid, &num_buf[NUM_BUF_SIZE], &s_len);
                         if (adjust_precision && precision < s_len)
@@ -1222,7 +1387,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                 {
                     apr_os_thread_t *tid;
 
-                    tid = va_arg(ap, apr_os_thread_t *);
+                    tid = PTR_ARG(apr_os_thread_t *);
                     if (tid != NULL) {
                         s = conv_os_thread_t_hex(tid, &num_buf[NUM_BUF_SIZE], &s_len);
                         if (adjust_precision && precision < s_len)
@@ -1249,16 +1414,16 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                     char buf[5];
                     apr_off_t size = 0;
 
-                    if (*fmt == 'B') {
-                        apr_uint32_t *arg = va_arg(ap, apr_uint32_t *);
+                    if (cur->ext == 'B') {
+                        apr_uint32_t *arg = PTR_ARG(apr_uint32_t *);
                         size = (arg) ? *arg : 0;
                     }
-                    else if (*fmt == 'F') {
-                        apr_off_t *arg = va_arg(ap, apr_off_t *);
+                    else if (cur->ext == 'F') {
+                        apr_off_t *arg = PTR_ARG(apr_off_t *);
                         size = (arg) ? *arg : 0;
                     }
                     else {
-                        apr_size_t *arg = va_arg(ap, apr_size_t *);
+                        apr_size_t *arg = PTR_ARG(apr_size_t *);
                         size = (arg) ? *arg : 0;
                     }
 
@@ -1276,7 +1441,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                     s = "bogus %p";
                     s_len = 8;
                     prefix_char = NUL;
-                    (void)va_arg(ap, void *); /* skip the bogus argument on the stack */
+                    (void)PTR_ARG(void *); /* skip the bogus argument on the stack */
                     break;
                 }
                 break;
@@ -1301,7 +1466,7 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
                  */
             default:
                 char_buf[0] = '%';
-                char_buf[1] = *fmt;
+                char_buf[1] = cur->conv;
                 s = char_buf;
                 s_len = 2;
                 pad_char = ' ';
@@ -1324,25 +1489,152 @@ APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
             }
 
             /*
-             * Print the string s. 
+             * Print the string s.
              */
             if (print_something == YES) {
-                for (i = s_len; i != 0; i--) {
-                      INS_CHAR(*s, sp, bep, cc);
-                    s++;
+                if (sp && (apr_size_t)(bep - sp) >= s_len) {
+                    memcpy(sp, s, s_len);
+                    sp += s_len;
+                    cc += (int)s_len;
+                }
+                else {
+                    for (i = s_len; i != 0; i--) {
+                        INS_CHAR(*s, sp, bep, cc);
+                        s++;
+                    }
                 }
             }
 
             if (adjust_width && adjust == LEFT && min_width > s_len)
                 PAD(min_width, s_len, pad_char);
         }
-        fmt++;
+        if (!plan)
+            fmt++;
     }
     vbuff->curpos = sp;
 
     return cc;
 }
 
+APR_DECLARE(int) apr_vformatter(int (*flush_func)(apr_vformatter_buff_t *),
+    apr_vformatter_buff_t *vbuff, const char *fmt, va_list ap)
+{
+    return vformatter(flush_func, vbuff, fmt, NULL, NULL, ap);
+}
+
+APR_DECLARE(apr_status_t) apr_vformatter_plan_create(
+    apr_vformatter_plan_t **newplan, const char *fmt, apr_pool_t *p)
+{
+    apr_vformatter_plan_t *plan;
+    const char *f;
+    fmt_spec_t *spec;
+    int nspecs = 1;
+
+    /* Size the plan by the number of '%' characters, which is at
+     * least the number of conversions (a "%%" is counted twice).
+     */
+    for (f = fmt; *f; f++) {
+        if (*f == '%')
+            nspecs++;
+    }
+
+    /* the literals point into our own copy of the format string */
+    fmt = apr_pstrdup(p, fmt);
+
+    plan = apr_palloc(p, sizeof(*plan));
+    plan->specs = apr_palloc(p, nspecs * sizeof(fmt_spec_t));
+    plan->nspecs = 0;
+    plan->nargs = 0;
+
+    f = fmt;
+    for (;;) {
+        spec = &plan->specs[plan->nspecs++];
+        spec->literal = f;
+        while (*f && *f != '%')
+            f++;
+        spec->literal_len = f - spec->literal;
+        if (*f == NUL) {
+            spec->conv = NUL;
+            break;
+        }
+
+        spec->min_width = 0;
+        spec->precision = 0;
+        f = parse_spec(f + 1, spec);
+
+        switch (spec->conv) {
+        case 'u': case 'd': case 'i': case 'o': case 'x': case 'X':
+        case 's': case 'f': case 'e': case 'E': case 'g': case 'G':
+        case 'c': case 'n':
+            break;
+        case '%':
+            break;
+        case 'p':
+            switch (spec->ext) {
+            case 'p': case 'I': case 'A': case 'm': case 'T': case 't':
+            case 'B': case 'F': case 'S':
+                break;
+            default:
+                return APR_EINVAL;
+            }
+            break;
+        default:
+            /* unknown conversion, or a '%' ending the format */
+            return APR_EINVAL;
+        }
+
+        if (spec->width_arg)
+            plan->nargs++;
+        if (spec->precision_arg)
+            plan->nargs++;
+        if (spec->conv != '%')
+            plan->nargs++;
+        f++;
+    }
+
+    *newplan = plan;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(int) apr_vformatter_plan_nargs(const apr_vformatter_plan_t *plan)
+{
+    return plan->nargs;
+}
+
+APR_DECLARE(int) apr_vformatter_plan_exec(
+    int (*flush_func)(apr_vformatter_buff_t *), apr_vformatter_buff_t *vbuff,
+    const apr_vformatter_plan_t *plan, va_list ap)
+{
+    return vformatter(flush_func, vbuff, NULL, plan, NULL, ap);
+}
+
+/* Supplies the va_list vformatter() wants; it is never read when
+ * formatting from an argument array.
+ */
+static int vformatter_argv(int (*flush_func)(apr_vformatter_buff_t *),
+                           apr_vformatter_buff_t *vbuff,
+                           const apr_vformatter_plan_t *plan,
+                           const apr_vformatter_arg_t *argv, ...)
+{
+    va_list ap;
+    int cc;
+
+    va_start(ap, argv);
+    cc = vformatter(flush_func, vbuff, NULL, plan, argv, ap);
+    va_end(ap);
+    return cc;
+}
+
+APR_DECLARE(int) apr_vformatter_plan_exec_args(
+    int (*flush_func)(apr_vformatter_buff_t *), apr_vformatter_buff_t *vbuff,
+    const apr_vformatter_plan_t *plan, const apr_vformatter_arg_t *argv,
+    int argc)
+{
+    if (argc < plan->nargs)
+        return -1;
+    return vformatter_argv(flush_func, vbuff, plan, argv);
+}
+
 
 static int snprintf_flush(apr_vformatter_buff_t *vbuff)
 {
@@ -0,0 +1,156 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * sdbmbuild: build an sdbm database from "key<TAB>value" lines
+ *
+ *   sdbmbuild [-s separator] [-q] database [input]
+ *
+ * The lines are read from input, or from stdin when it is omitted or
+ * "-".  A key given more than once keeps its last value.
+ */
+
+#include "apr.h"
+#include "apr_general.h"
+#include "apr_getopt.h"
+#include "apr_file_io.h"
+#include "apr_strings.h"
+#include "apr_sdbm.h"
+#include "apr_time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-s separator] [-q] database [input]\n",
+            prog);
+    exit(1);
+}
+
+static void fail(const char *what, const char *arg, apr_status_t rv)
+{
+    char msg[256];
+
+    fprintf(stderr, "sdbmbuild: %s %s: %s\n", what, arg,
+            apr_strerror(rv, msg, sizeof(msg)));
+    exit(1);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+    apr_getopt_t *opt;
+    apr_file_t *in;
+    apr_sdbm_builder_t *builder;
+    apr_sdbm_datum_t key, val;
+    apr_time_t start;
+    apr_status_t rv;
+    const char *arg, *input = "-";
+    char sep = '\t';
+    int quiet = 0;
+    char line[8192], *s;
+    apr_size_t len;
+    unsigned long lineno = 0, records = 0, skipped = 0;
+    char c;
+
+    apr_initialize();
+    atexit(apr_terminate);
+    apr_pool_create(&pool, NULL);
+
+    apr_getopt_init(&opt, pool, argc, argv);
+    while ((rv = apr_getopt(opt, "s:q", &c, &arg)) == APR_SUCCESS) {
+        switch (c) {
+        case 's':
+            if (strlen(arg) != 1)
+                usage(argv[0]);
+            sep = arg[0];
+            break;
+        case 'q':
+            quiet = 1;
+            break;
+        }
+    }
+    if (rv != APR_EOF || opt->ind >= argc || argc - opt->ind > 2)
+        usage(argv[0]);
+    if (argc - opt->ind == 2)
+        input = argv[opt->ind + 1];
+
+    if (strcmp(input, "-") == 0)
+        rv = apr_file_open_stdin(&in, pool);
+    else
+        rv = apr_file_open(&in, input, APR_FOPEN_READ | APR_FOPEN_BUFFERED,
+                           APR_OS_DEFAULT, pool);
+    if (rv != APR_SUCCESS)
+        fail("cannot open", input, rv);
+
+    start = apr_time_now();
+    rv = apr_sdbm_build_create(&builder, argv[opt->ind], APR_OS_DEFAULT,
+                               pool);
+    if (rv != APR_SUCCESS)
+        fail("cannot create", argv[opt->ind], rv);
+
+    while (apr_file_gets(line, sizeof(line), in) == APR_SUCCESS) {
+        lineno++;
+        len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n') {
+            /* far beyond what a page holds; skip to the end of the line */
+            while (apr_file_getc(&c, in) == APR_SUCCESS && c != '\n')
+                ;
+            if (!quiet)
+                fprintf(stderr, "sdbmbuild: %s:%lu: record too large\n",
+                        input, lineno);
+            skipped++;
+            continue;
+        }
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            line[--len] = '\0';
+        if (len == 0)
+            continue;
+
+        if ((s = strchr(line, sep)) == NULL || s == line) {
+            if (!quiet)
+                fprintf(stderr, "sdbmbuild: %s:%lu: no key\n", input,
+                        lineno);
+            skipped++;
+            continue;
+        }
+        key.dptr = line;
+        key.dsize = (int)(s - line);
+        val.dptr = s + 1;
+        val.dsize = (int)(len - key.dsize - 1);
+
+        if ((rv = apr_sdbm_build_add(builder, key, val)) != APR_SUCCESS) {
+            if (!quiet)
+                fprintf(stderr, "sdbmbuild: %s:%lu: record too large\n",
+                        input, lineno);
+            skipped++;
+            continue;
+        }
+        records++;
+    }
+
+    if ((rv = apr_sdbm_build_finish(builder)) != APR_SUCCESS)
+        fail("cannot write", argv[opt->ind], rv);
+
+    if (!quiet)
+        printf("%lu records loaded into %s in %.2f seconds, %lu skipped\n",
+               records, argv[opt->ind],
+               (double)(apr_time_now() - start) / APR_USEC_PER_SEC, skipped);
+
+    apr_pool_destroy(pool);
+    return skipped ? 2 : 0;
+}
@@ -76,6 +76,7 @@ const struct testlist {
     {testbase64},
     {testmd4},
     {testmd5},
+    {testsha1},
     {testcrypto},
     {testdbd},
     {testdate},
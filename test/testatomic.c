@@ -218,6 +218,133 @@ static void test_inc_neg1(abts_case *tc, void *data)
     ABTS_ASSERT(tc, str, y32 == 0);
 }
 
+#define BIG64 APR_UINT64_C(0x100000002)
+
+static void test_set64(abts_case *tc, void *data)
+{
+    apr_uint64_t y64;
+    apr_atomic_set64(&y64, BIG64);
+    ABTS_TRUE(tc, y64 == BIG64);
+}
+
+static void test_read64(abts_case *tc, void *data)
+{
+    apr_uint64_t y64;
+    apr_atomic_set64(&y64, BIG64);
+    ABTS_TRUE(tc, apr_atomic_read64(&y64) == BIG64);
+}
+
+static void test_dec64(abts_case *tc, void *data)
+{
+    apr_uint64_t y64;
+    int rv;
+
+    apr_atomic_set64(&y64, 2);
+
+    rv = apr_atomic_dec64(&y64);
+    ABTS_TRUE(tc, y64 == 1);
+    ABTS_ASSERT(tc, "atomic_dec returned zero when it shouldn't", rv != 0);
+
+    rv = apr_atomic_dec64(&y64);
+    ABTS_TRUE(tc, y64 == 0);
+    ABTS_ASSERT(tc, "atomic_dec didn't returned zero when it should", rv == 0);
+
+    /* the low 32 bits reaching zero is not the value reaching zero */
+    apr_atomic_set64(&y64, APR_UINT64_C(0x100000001));
+    rv = apr_atomic_dec64(&y64);
+    ABTS_TRUE(tc, y64 == APR_UINT64_C(0x100000000));
+    ABTS_ASSERT(tc, "atomic_dec returned zero when it shouldn't", rv != 0);
+}
+
+static void test_xchg64(abts_case *tc, void *data)
+{
+    apr_uint64_t oldval;
+    apr_uint64_t y64;
+
+    apr_atomic_set64(&y64, 100);
+    oldval = apr_atomic_xchg64(&y64, BIG64);
+
+    ABTS_TRUE(tc, oldval == 100);
+    ABTS_TRUE(tc, y64 == BIG64);
+}
+
+static void test_cas64_equal(abts_case *tc, void *data)
+{
+    apr_uint64_t casval = BIG64;
+    apr_uint64_t oldval;
+
+    oldval = apr_atomic_cas64(&casval, 12, BIG64);
+    ABTS_TRUE(tc, oldval == BIG64);
+    ABTS_TRUE(tc, casval == 12);
+}
+
+static void test_cas64_notequal(abts_case *tc, void *data)
+{
+    apr_uint64_t casval = BIG64;
+    apr_uint64_t oldval;
+
+    /* equal in the low 32 bits only */
+    oldval = apr_atomic_cas64(&casval, 23, 2);
+    ABTS_TRUE(tc, oldval == BIG64);
+    ABTS_TRUE(tc, casval == BIG64);
+}
+
+static void test_add_inc_sub64(abts_case *tc, void *data)
+{
+    apr_uint64_t y64;
+    apr_uint64_t oldval;
+
+    /* carries into the high word and borrows back out of it */
+    apr_atomic_set64(&y64, APR_UINT64_C(0xfffffffe));
+    oldval = apr_atomic_add64(&y64, 1);
+    ABTS_TRUE(tc, oldval == APR_UINT64_C(0xfffffffe));
+    oldval = apr_atomic_inc64(&y64);
+    ABTS_TRUE(tc, oldval == APR_UINT64_C(0xffffffff));
+    ABTS_TRUE(tc, y64 == APR_UINT64_C(0x100000000));
+    apr_atomic_sub64(&y64, 2);
+    ABTS_TRUE(tc, y64 == APR_UINT64_C(0xfffffffe));
+}
+
+static void test_wrap_zero64(abts_case *tc, void *data)
+{
+    apr_uint64_t y64;
+    int rv;
+
+    apr_atomic_set64(&y64, 0);
+    rv = apr_atomic_dec64(&y64);
+
+    ABTS_ASSERT(tc, "apr_atomic_dec64 on zero returned zero.", rv != 0);
+    ABTS_ASSERT(tc, "zero wrap failed", y64 == ~APR_UINT64_C(0));
+
+    apr_atomic_inc64(&y64);
+    ABTS_ASSERT(tc, "-1 wrap failed", y64 == 0);
+}
+
+static void test_ordered(abts_case *tc, void *data)
+{
+    apr_atomic_order_e order;
+    apr_uint32_t y32;
+    apr_uint64_t y64;
+
+    for (order = APR_ATOMIC_RELAXED; order <= APR_ATOMIC_SEQ_CST; order++) {
+        apr_atomic_set32_ex(&y32, 10, order);
+        ABTS_INT_EQUAL(tc, 10, apr_atomic_read32_ex(&y32, order));
+        ABTS_INT_EQUAL(tc, 10, apr_atomic_add32_ex(&y32, 5, order));
+        ABTS_INT_EQUAL(tc, 15, apr_atomic_cas32_ex(&y32, 20, 15, order));
+        ABTS_INT_EQUAL(tc, 20, apr_atomic_cas32_ex(&y32, 30, 15, order));
+        ABTS_INT_EQUAL(tc, 20, y32);
+
+        apr_atomic_set64_ex(&y64, BIG64, order);
+        ABTS_TRUE(tc, apr_atomic_read64_ex(&y64, order) == BIG64);
+        ABTS_TRUE(tc, apr_atomic_add64_ex(&y64, 5, order) == BIG64);
+        ABTS_TRUE(tc, apr_atomic_cas64_ex(&y64, 1, BIG64 + 5, order)
+                      == BIG64 + 5);
+        ABTS_TRUE(tc, apr_atomic_cas64_ex(&y64, 2, BIG64, order) == 1);
+        ABTS_TRUE(tc, y64 == 1);
+
+        apr_atomic_fence(order);
+    }
+}
 
 #if APR_HAS_THREADS
 
@@ -297,6 +424,96 @@ static void test_atomics_threaded(abts_case *tc, void *data)
     ABTS_ASSERT(tc, "Failed creating threads", rv == APR_SUCCESS);
 }
 
+static volatile apr_uint64_t atomic_ops64;
+
+static void *APR_THREAD_FUNC thread_func_atomic64(apr_thread_t *thd,
+                                                  void *data)
+{
+    int i;
+
+    for (i = 0; i < NUM_ITERATIONS ; i++) {
+        apr_atomic_inc64(&atomic_ops64);
+        apr_atomic_add64(&atomic_ops64, 2);
+        apr_atomic_dec64(&atomic_ops64);
+        apr_atomic_dec64(&atomic_ops64);
+    }
+    apr_thread_exit(thd, exit_ret_val);
+    return NULL;
+}
+
+static void test_atomics_threaded64(abts_case *tc, void *data)
+{
+    apr_thread_t *t[NUM_THREADS];
+    apr_uint64_t base = APR_UINT64_C(0xffffff00);
+    apr_status_t rv;
+    int i;
+
+    /* the count crosses into the high 32 bits as the threads run */
+    apr_atomic_set64(&atomic_ops64, base);
+
+    for (i = 0; i < NUM_THREADS; i++) {
+        rv = apr_thread_create(&t[i], NULL, thread_func_atomic64, NULL, p);
+        ABTS_ASSERT(tc, "Failed creating threads", rv == APR_SUCCESS);
+    }
+    for (i = 0; i < NUM_THREADS; i++) {
+        apr_status_t s;
+
+        apr_thread_join(&s, t[i]);
+        ABTS_ASSERT(tc, "Invalid return value from thread_join",
+                    s == exit_ret_val);
+    }
+
+    ABTS_TRUE(tc, apr_atomic_read64(&atomic_ops64)
+                  == base + NUM_THREADS * NUM_ITERATIONS);
+}
+
+#define NUM_MESSAGES 10000
+
+static apr_uint32_t message_data[2];
+static volatile apr_uint32_t message_seq;
+
+/* data written before a release is seen after the matching acquire:
+ * odd sequence numbers hand a message over, even ones hand it back */
+static void *APR_THREAD_FUNC thread_func_producer(apr_thread_t *thd,
+                                                  void *data)
+{
+    apr_uint32_t i;
+
+    for (i = 1; i <= NUM_MESSAGES; i++) {
+        while (apr_atomic_read32_ex(&message_seq, APR_ATOMIC_ACQUIRE)
+               != 2 * i - 2)
+            apr_thread_yield();
+        message_data[0] = i;
+        message_data[1] = ~i;
+        apr_atomic_set32_ex(&message_seq, 2 * i - 1, APR_ATOMIC_RELEASE);
+    }
+    apr_thread_exit(thd, exit_ret_val);
+    return NULL;
+}
+
+static void test_acquire_release(abts_case *tc, void *data)
+{
+    apr_thread_t *t;
+    apr_status_t rv;
+    apr_uint32_t i, bad = 0;
+
+    apr_atomic_set32_ex(&message_seq, 0, APR_ATOMIC_SEQ_CST);
+    rv = apr_thread_create(&t, NULL, thread_func_producer, NULL, p);
+    APR_ASSERT_SUCCESS(tc, "Failed creating thread", rv);
+
+    for (i = 1; i <= NUM_MESSAGES; i++) {
+        while (apr_atomic_read32_ex(&message_seq, APR_ATOMIC_ACQUIRE)
+               != 2 * i - 1)
+            apr_thread_yield();
+        if (message_data[0] != i || message_data[1] != ~i)
+            bad++;
+        apr_atomic_set32_ex(&message_seq, 2 * i, APR_ATOMIC_RELEASE);
+    }
+    apr_thread_join(&rv, t);
+    ABTS_INT_EQUAL(tc, exit_ret_val, rv);
+    ABTS_INT_EQUAL(tc, 0, bad);
+}
+
 #undef NUM_THREADS
 #define NUM_THREADS 7
 
@@ -512,9 +729,20 @@ abts_suite *testatomic(abts_suite *suite)
     abts_run_test(suite, test_set_add_inc_sub, NULL);
     abts_run_test(suite, test_wrap_zero, NULL);
     abts_run_test(suite, test_inc_neg1, NULL);
+    abts_run_test(suite, test_set64, NULL);
+    abts_run_test(suite, test_read64, NULL);
+    abts_run_test(suite, test_dec64, NULL);
+    abts_run_test(suite, test_xchg64, NULL);
+    abts_run_test(suite, test_cas64_equal, NULL);
+    abts_run_test(suite, test_cas64_notequal, NULL);
+    abts_run_test(suite, test_add_inc_sub64, NULL);
+    abts_run_test(suite, test_wrap_zero64, NULL);
+    abts_run_test(suite, test_ordered, NULL);
 
 #if APR_HAS_THREADS
     abts_run_test(suite, test_atomics_threaded, NULL);
+    abts_run_test(suite, test_atomics_threaded64, NULL);
+    abts_run_test(suite, test_acquire_release, NULL);
     abts_run_test(suite, test_atomics_busyloop_threaded, NULL);
 #endif
 
@@ -69,11 +69,244 @@ static void test_base64(abts_case *tc, void *data)
     }
 }
 
+static void test_base64_decode(abts_case *tc, void *data)
+{
+    int i;
+
+    for (i = 0; i < num_base64; i++) {
+        unsigned char dec[32];
+        apr_size_t len, orig_len = strlen(base64_tbl[i].orig);
+        apr_status_t rv;
+
+        len = apr_base64_decode_binary(dec, base64_tbl[i].enc);
+        ABTS_SIZE_EQUAL(tc, orig_len, len);
+        ABTS_ASSERT(tc, "decode_binary output",
+                    memcmp(dec, base64_tbl[i].orig, len) == 0);
+
+        rv = apr_base64_decode_ex(dec, &len, base64_tbl[i].enc,
+                                  strlen(base64_tbl[i].enc), 0);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        ABTS_SIZE_EQUAL(tc, orig_len, len);
+        ABTS_ASSERT(tc, "decode_ex output",
+                    memcmp(dec, base64_tbl[i].orig, len) == 0);
+    }
+}
+
+static void test_base64url(abts_case *tc, void *data)
+{
+    const unsigned char raw[] = "\xfb\xff\xbf";
+    unsigned char dec[8];
+    char enc[8];
+    apr_size_t len;
+
+    len = apr_base64_encode_ex(enc, raw, 2, 0);
+    ABTS_SIZE_EQUAL(tc, 4, len);
+    ABTS_ASSERT(tc, "standard alphabet", memcmp(enc, "+/8=", 4) == 0);
+
+    len = apr_base64_encode_ex(enc, raw, 2, APR_BASE64_URL);
+    ABTS_SIZE_EQUAL(tc, 4, len);
+    ABTS_ASSERT(tc, "url alphabet", memcmp(enc, "-_8=", 4) == 0);
+
+    len = apr_base64_encode_ex(enc, raw, 2, APR_BASE64_URL|APR_BASE64_NOPAD);
+    ABTS_SIZE_EQUAL(tc, apr_base64_encode_len_ex(2, APR_BASE64_NOPAD), len);
+    ABTS_ASSERT(tc, "url alphabet unpadded", memcmp(enc, "-_8", 3) == 0);
+
+    ABTS_INT_EQUAL(tc, APR_SUCCESS,
+                   apr_base64_decode_ex(dec, &len, "-_-_", 4,
+                                        APR_BASE64_URL));
+    ABTS_SIZE_EQUAL(tc, 3, len);
+    ABTS_ASSERT(tc, "url decode", memcmp(dec, raw, 3) == 0);
+
+    ABTS_INT_EQUAL(tc, APR_SUCCESS,
+                   apr_base64_decode_ex(dec, &len, "-_8", 3,
+                                        APR_BASE64_URL));
+    ABTS_SIZE_EQUAL(tc, 2, len);
+
+    ABTS_INT_EQUAL(tc, APR_EINVAL,
+                   apr_base64_decode_ex(dec, &len, "+/8=", 4,
+                                        APR_BASE64_URL));
+    ABTS_INT_EQUAL(tc, APR_EINVAL,
+                   apr_base64_decode_ex(dec, &len, "-_8=", 4, 0));
+}
+
+static void test_base64_malformed(abts_case *tc, void *data)
+{
+    static const char *const bad[] = {
+        "S", "SGVsb", "S===", "=SGU", "SGU==", "SA==SA==", "SGVsbA==x",
+        "SGV sbG8", "SGVs\nbG8="
+    };
+    static const char *const good[] = {
+        "SA", "SA=", "SA==", "SGU", "SGU=", "SGVsbG8"
+    };
+    unsigned char dec[16];
+    apr_size_t len;
+    int i;
+
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        ABTS_INT_EQUAL(tc, APR_EINVAL,
+                       apr_base64_decode_ex(dec, &len, bad[i],
+                                            strlen(bad[i]), 0));
+    }
+    for (i = 0; i < sizeof(good) / sizeof(good[0]); i++) {
+        ABTS_INT_EQUAL(tc, APR_SUCCESS,
+                       apr_base64_decode_ex(dec, &len, good[i],
+                                            strlen(good[i]), 0));
+    }
+}
+
+/* Straightforward reference encoder, to check the vectorized kernels */
+static apr_size_t ref_encode(char *dst, const unsigned char *src,
+                             apr_size_t len, const char *alphabet)
+{
+    apr_size_t i, n = 0;
+
+    for (i = 0; i < len; i += 3) {
+        unsigned long v = (unsigned long)src[i] << 16;
+
+        if (i + 1 < len) {
+            v |= src[i + 1] << 8;
+        }
+        if (i + 2 < len) {
+            v |= src[i + 2];
+        }
+        dst[n++] = alphabet[(v >> 18) & 0x3f];
+        dst[n++] = alphabet[(v >> 12) & 0x3f];
+        dst[n++] = i + 1 < len ? alphabet[(v >> 6) & 0x3f] : '=';
+        dst[n++] = i + 2 < len ? alphabet[v & 0x3f] : '=';
+    }
+    return n;
+}
+
+#define MAX_RAW 300
+
+static void test_base64_kernels(abts_case *tc, void *data)
+{
+    static const char *const alphabets[] = {
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+    };
+    unsigned char raw[MAX_RAW], dec[MAX_RAW + 3];
+    char enc[MAX_RAW * 2], ref[MAX_RAW * 2];
+    apr_size_t len, i, n, m;
+    int url;
+
+    srand(4242);
+    for (i = 0; i < MAX_RAW; i++) {
+        raw[i] = rand() & 0xff;
+    }
+
+    for (url = 0; url < 2; url++) {
+        int flags = url ? APR_BASE64_URL : 0;
+
+        for (len = 0; len <= MAX_RAW; len++) {
+            n = apr_base64_encode_ex(enc, raw, len, flags);
+            m = ref_encode(ref, raw, len, alphabets[url]);
+            ABTS_SIZE_EQUAL(tc, m, n);
+            ABTS_SIZE_EQUAL(tc, apr_base64_encode_len_ex(len, flags), n);
+            ABTS_ASSERT(tc, "encode_ex matches reference",
+                        memcmp(enc, ref, n) == 0);
+
+            ABTS_INT_EQUAL(tc, APR_SUCCESS,
+                           apr_base64_decode_ex(dec, &m, enc, n, flags));
+            ABTS_SIZE_EQUAL(tc, len, m);
+            ABTS_ASSERT(tc, "decode_ex round trip",
+                        memcmp(dec, raw, len) == 0);
+
+            if (!url) {
+                enc[n] = '\0';
+                ABTS_INT_EQUAL(tc, (int)n + 1,
+                               apr_base64_encode_binary(ref, raw, (int)len));
+                ABTS_ASSERT(tc, "encode_binary matches encode_ex",
+                            memcmp(enc, ref, n + 1) == 0);
+                ABTS_INT_EQUAL(tc, (int)len,
+                               apr_base64_decode_binary(dec, enc));
+                ABTS_ASSERT(tc, "decode_binary round trip",
+                            memcmp(dec, raw, len) == 0);
+            }
+        }
+
+        /* every byte value at every position of a long group run must be
+         * accepted exactly when it belongs to the alphabet
+         */
+        n = ref_encode(ref, raw, 96, alphabets[url]);
+        for (i = 0; i < n; i++) {
+            int c;
+
+            for (c = 0; c < 256; c++) {
+                int valid;
+                apr_status_t rv;
+
+                if (c == '=') {
+                    /* valid as padding at the end, tested above */
+                    continue;
+                }
+                valid = c && strchr(alphabets[url], c) != NULL;
+
+                memcpy(enc, ref, n);
+                enc[i] = (char)c;
+                rv = apr_base64_decode_ex(dec, &m, enc, n, flags);
+                if (valid != (rv == APR_SUCCESS)) {
+                    char msg[64];
+                    sprintf(msg, "char %d at %d misclassified", c, (int)i);
+                    ABTS_FAIL(tc, msg);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static void test_base64_stream(abts_case *tc, void *data)
+{
+    unsigned char raw[MAX_RAW], dec[MAX_RAW + 3];
+    char enc[MAX_RAW * 2], once[MAX_RAW * 2];
+    apr_base64_ctx_t ctx;
+    apr_size_t i, n, m, step, total;
+
+    srand(1717);
+    for (i = 0; i < MAX_RAW; i++) {
+        raw[i] = rand() & 0xff;
+    }
+    m = apr_base64_encode_ex(once, raw, MAX_RAW, 0);
+
+    for (step = 1; step <= 50; step++) {
+        apr_base64_encode_init(&ctx, 0);
+        for (n = i = 0; i < MAX_RAW; i += step) {
+            apr_size_t chunk = MAX_RAW - i < step ? MAX_RAW - i : step;
+
+            n += apr_base64_encode_update(&ctx, enc + n, raw + i, chunk);
+        }
+        n += apr_base64_encode_final(&ctx, enc + n);
+        ABTS_SIZE_EQUAL(tc, m, n);
+        ABTS_ASSERT(tc, "streamed encoding", memcmp(enc, once, n) == 0);
+
+        apr_base64_decode_init(&ctx, 0);
+        for (total = i = 0; i < m; i += step) {
+            apr_size_t chunk = m - i < step ? m - i : step;
+
+            ABTS_INT_EQUAL(tc, APR_SUCCESS,
+                           apr_base64_decode_update(&ctx, dec + total, &n,
+                                                    once + i, chunk));
+            total += n;
+        }
+        ABTS_INT_EQUAL(tc, APR_SUCCESS,
+                       apr_base64_decode_final(&ctx, dec + total, &n));
+        total += n;
+        ABTS_SIZE_EQUAL(tc, MAX_RAW, total);
+        ABTS_ASSERT(tc, "streamed decoding", memcmp(dec, raw, total) == 0);
+    }
+}
+
 abts_suite *testbase64(abts_suite *suite)
 {
     suite = ADD_SUITE(suite);
 
     abts_run_test(suite, test_base64, NULL);
+    abts_run_test(suite, test_base64_decode, NULL);
+    abts_run_test(suite, test_base64url, NULL);
+    abts_run_test(suite, test_base64_malformed, NULL);
+    abts_run_test(suite, test_base64_kernels, NULL);
+    abts_run_test(suite, test_base64_stream, NULL);
 
     return suite;
 }
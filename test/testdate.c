@@ -191,12 +191,72 @@ static void test_date_rfc(abts_case *tc, void *data)
     }
 }
 
+static void test_date_parse_imf_fixdate(abts_case *tc, void *data)
+{
+    static const char *const valid[] = {
+        "Sun, 06 Nov 1994 08:49:37 GMT",
+        "Sat, 08 Jan 2000 18:31:41 GMT",
+        "Tue, 29 Feb 2000 00:00:00 GMT",
+        "Thu, 01 Jan 1970 00:00:01 GMT",
+        "Sat, 08 Jan 2000 18:31:41 GMT; length=1024",
+        NULL
+    };
+    static const char *const invalid[] = {
+        "Mon, 31 Apr 2000 08:49:37 GMT",
+        "Tue, 29 Feb 1900 08:49:37 GMT",
+        "Sun, 06 Xyz 1994 08:49:37 GMT",
+        "Sun, 06 Nov 1994 24:49:37 GMT",
+        "Sun, 06 Nov 1994 08:4",
+        "Sun,",
+        NULL
+    };
+    int i, j;
+
+    /* parse each twice, the second parse is served from the cache */
+    for (i = 0; valid[i]; i++) {
+        char str[APR_RFC822_DATE_LEN];
+        apr_time_t t = apr_date_parse_http(valid[i]);
+
+        ABTS_TRUE(tc, t != APR_DATE_BAD);
+        for (j = 0; j < 2; j++) {
+            ABTS_TRUE(tc, apr_date_parse_http(valid[i]) == t);
+            ABTS_TRUE(tc, apr_date_parse_rfc(valid[i]) == t);
+            apr_rfc822_date(str, t);
+            ABTS_STR_NEQUAL(tc, valid[i], str, APR_RFC822_DATE_LEN - 1);
+        }
+    }
+    for (i = 0; invalid[i]; i++) {
+        for (j = 0; j < 2; j++) {
+            ABTS_TRUE(tc, apr_date_parse_http(invalid[i]) == APR_DATE_BAD);
+        }
+    }
+}
+
+static void test_rfc822_date_cache(abts_case *tc, void *data)
+{
+    char str[APR_RFC822_DATE_LEN];
+    apr_time_t t = apr_time_from_sec(APR_INT64_C(947356301));
+
+    apr_rfc822_date(str, t);
+    ABTS_STR_EQUAL(tc, "Sat, 08 Jan 2000 18:31:41 GMT", str);
+    apr_rfc822_date(str, t + APR_USEC_PER_SEC / 2);
+    ABTS_STR_EQUAL(tc, "Sat, 08 Jan 2000 18:31:41 GMT", str);
+    apr_rfc822_date(str, t + APR_USEC_PER_SEC);
+    ABTS_STR_EQUAL(tc, "Sat, 08 Jan 2000 18:31:42 GMT", str);
+    apr_rfc822_date(str, t);
+    ABTS_STR_EQUAL(tc, "Sat, 08 Jan 2000 18:31:41 GMT", str);
+    apr_rfc822_date(str, -APR_USEC_PER_SEC);
+    ABTS_STR_EQUAL(tc, "Wed, 31 Dec 1969 23:59:59 GMT", str);
+}
+
 abts_suite *testdate(abts_suite *suite)
 {
     suite = ADD_SUITE(suite);
 
     abts_run_test(suite, test_date_parse_http, NULL);
     abts_run_test(suite, test_date_rfc, NULL);
+    abts_run_test(suite, test_date_parse_imf_fixdate, NULL);
+    abts_run_test(suite, test_rfc822_date_cache, NULL);
 
     return suite;
 }
@@ -0,0 +1,120 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_date.h"
+#include "apr_time.h"
+#include "apr_general.h"
+#include "apr_errno.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ITERATIONS 1000000
+
+/* If-Modified-Since values as seen in the access logs of a busy server;
+ * the IMF-fixdate dominates, the rest is legacy clients and proxies.
+ */
+static const char *const ims_headers[] = {
+    "Sat, 08 Jan 2000 18:31:41 GMT",
+    "Sat, 08 Jan 2000 18:31:41 GMT",
+    "Sat, 08 Jan 2000 18:31:41 GMT",
+    "Tue, 15 Nov 1994 12:45:26 GMT",
+    "Sat, 08 Jan 2000 18:31:41 GMT",
+    "Sat, 08 Jan 2000 18:31:41 GMT; length=3495",
+    "Wed, 21 Oct 2015 07:28:00 GMT",
+    "Saturday, 08-Jan-00 18:31:41 GMT",
+    "Sat, 08 Jan 2000 18:31:41 GMT",
+    "Sat Jan  8 18:31:41 2000",
+};
+
+#define NUM_HEADERS (sizeof(ims_headers) / sizeof(ims_headers[0]))
+
+static void report(const char *what, apr_time_t start, int n)
+{
+    apr_time_t elapsed = apr_time_now() - start;
+
+    printf("%-50s %8" APR_TIME_T_FMT " usec, %6.1f ns/call\n", what,
+           elapsed, (double)elapsed * 1000.0 / n);
+}
+
+static void bench_parse(void)
+{
+    apr_time_t start, sum = 0;
+    char dates[NUM_HEADERS][APR_RFC822_DATE_LEN];
+    int i;
+
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++) {
+        sum += apr_date_parse_http(ims_headers[i % NUM_HEADERS]);
+    }
+    report("apr_date_parse_http (If-Modified-Since mix)", start, ITERATIONS);
+
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++) {
+        sum += apr_date_parse_rfc(ims_headers[i % NUM_HEADERS]);
+    }
+    report("apr_date_parse_rfc (mask matching)", start, ITERATIONS);
+
+    /* distinct IMF-fixdates defeat the last-value cache */
+    for (i = 0; i < NUM_HEADERS; i++) {
+        apr_rfc822_date(dates[i], apr_time_from_sec(947356301 + i * 86413));
+    }
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++) {
+        sum += apr_date_parse_http(dates[i % NUM_HEADERS]);
+    }
+    report("apr_date_parse_http (distinct IMF-fixdates)", start,
+           ITERATIONS);
+
+    if (sum == 0) {
+        printf("unexpected parse failure\n");
+        exit(-1);
+    }
+}
+
+static void bench_format(void)
+{
+    char str[APR_RFC822_DATE_LEN];
+    apr_time_t start, now;
+    int i;
+
+    /* start on a second boundary, so the first loop never leaves it */
+    now = apr_time_from_sec(apr_time_sec(apr_time_now()));
+
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++) {
+        apr_rfc822_date(str, now + i % APR_USEC_PER_SEC);
+    }
+    report("apr_rfc822_date (same second)", start, ITERATIONS);
+
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++) {
+        apr_rfc822_date(str, now + apr_time_from_sec(i));
+    }
+    report("apr_rfc822_date (distinct seconds)", start, ITERATIONS);
+}
+
+int main(int argc, const char * const *argv)
+{
+    printf("APR Date Performance Test\n==============\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+
+    bench_parse();
+    bench_format();
+
+    return 0;
+}
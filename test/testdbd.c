@@ -21,6 +21,9 @@
 #include "apr_dbd.h"
 #include "apr_strings.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 static void test_dbd_init(abts_case *tc, void *data)
 {
     apr_pool_t *pool = p;
@@ -200,6 +203,394 @@ static void test_dbd_sqlite2(abts_case *tc, void *data)
 #endif
 
 #if APU_HAVE_SQLITE3
+static void test_sqlite3_cursor(abts_case *tc, apr_dbd_t *handle,
+                                const apr_dbd_driver_t *driver)
+{
+    apr_pool_t *pool;
+    apr_dbd_results_t *res = NULL;
+    apr_dbd_row_t *row = NULL;
+    const char *entries[3];
+    int i, nrows;
+
+    apr_pool_create(&pool, p);
+
+    test_statement(tc, handle, driver,
+                   "CREATE TABLE apr_dbd_cursor (id integer, name text)");
+    test_statement(tc, handle, driver, "BEGIN");
+    for (i = 0; i < 100; i++) {
+        test_statement(tc, handle, driver,
+                       apr_psprintf(pool, "INSERT INTO apr_dbd_cursor "
+                                    "VALUES(%d, 'row %d')", i, i));
+    }
+    test_statement(tc, handle, driver, "COMMIT");
+
+    /* rows are fetched one at a time, each copied into its own row */
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_select(driver, pool, handle, &res,
+                                         "SELECT id, name FROM apr_dbd_cursor "
+                                         "ORDER BY id", 0));
+    ABTS_INT_EQUAL(tc, -1, apr_dbd_num_tuples(driver, res));
+    for (i = 0; i < 3; i++) {
+        ABTS_INT_EQUAL(tc, 0, apr_dbd_get_row(driver, pool, res, &row, -1));
+        entries[i] = apr_dbd_get_entry(driver, row, 1);
+    }
+    while (apr_dbd_get_row(driver, pool, res, &row, -1) == 0)
+        ;
+    for (i = 0; i < 3; i++) {
+        ABTS_STR_EQUAL(tc, apr_psprintf(pool, "row %d", i), entries[i]);
+    }
+
+    /* or without copying into the same row */
+    res = NULL;
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_select(driver, pool, handle, &res,
+                                         "SELECT id, name FROM apr_dbd_cursor "
+                                         "ORDER BY id",
+                                         APR_DBD_SELECT_STREAM));
+    ABTS_INT_EQUAL(tc, -1, apr_dbd_num_tuples(driver, res));
+    ABTS_INT_EQUAL(tc, 2, apr_dbd_num_cols(driver, res));
+    ABTS_STR_EQUAL(tc, "name", apr_dbd_get_name(driver, res, 1));
+    for (i = 0; i < 10; i++) {
+        ABTS_INT_EQUAL(tc, 0, apr_dbd_get_row(driver, pool, res, &row, -1));
+        ABTS_STR_EQUAL(tc, apr_itoa(pool, i),
+                       apr_dbd_get_entry(driver, row, 0));
+    }
+
+    /* another statement on the connection detaches the open cursor */
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_query(driver, handle, &nrows,
+                                        "DELETE FROM apr_dbd_cursor "
+                                        "WHERE id >= 50"));
+    ABTS_INT_EQUAL(tc, 50, nrows);
+    ABTS_STR_EQUAL(tc, "row 9", apr_dbd_get_entry(driver, row, 1));
+
+    for (; apr_dbd_get_row(driver, pool, res, &row, -1) == 0; i++) {
+        ABTS_STR_EQUAL(tc, apr_psprintf(pool, "row %d", i),
+                       apr_dbd_get_entry(driver, row, 1));
+    }
+    ABTS_INT_EQUAL(tc, 100, i);
+
+    /* a cursor left open must not keep the table locked */
+    res = NULL;
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_select(driver, pool, handle, &res,
+                                         "SELECT id FROM apr_dbd_cursor", 0));
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_get_row(driver, pool, res, &row, -1));
+    test_statement(tc, handle, driver, "DROP TABLE apr_dbd_cursor");
+
+    apr_pool_destroy(pool);
+}
+
+static void test_sqlite3_stmt_cache(abts_case *tc, apr_dbd_t *handle,
+                                    const apr_dbd_driver_t *driver)
+{
+    apr_dbd_stmt_cache_stats_t before, after;
+    apr_dbd_prepared_t *first, *again;
+    apr_dbd_results_t *res = NULL;
+    apr_dbd_row_t *row = NULL;
+    void *junk[16];
+    int i, nrows;
+
+    APR_ASSERT_SUCCESS(tc, "resize statement cache",
+                       apr_dbd_stmt_cache_set(driver, handle, 2));
+    APR_ASSERT_SUCCESS(tc, "get cache counters",
+                       apr_dbd_stmt_cache_stats_get(driver, handle, &before));
+    ABTS_INT_EQUAL(tc, 2, before.size);
+
+    /* ad hoc SQL is prepared once */
+    test_statement(tc, handle, driver, "CREATE TEMP TABLE apr_dbd_cache (i integer)");
+    test_statement(tc, handle, driver, "INSERT INTO apr_dbd_cache VALUES(1)");
+    test_statement(tc, handle, driver, "INSERT INTO apr_dbd_cache VALUES(1)");
+    apr_dbd_stmt_cache_stats_get(driver, handle, &after);
+    ABTS_INT_EQUAL(tc, 1, (int)(after.hits - before.hits));
+    ABTS_INT_EQUAL(tc, 2, (int)(after.misses - before.misses));
+
+    /* text with several statements goes to the driver */
+    test_statement(tc, handle, driver,
+                   "INSERT INTO apr_dbd_cache VALUES(2); "
+                   "INSERT INTO apr_dbd_cache VALUES(3)");
+    apr_dbd_stmt_cache_stats_get(driver, handle, &before);
+    ABTS_INT_EQUAL(tc, (int)after.misses, (int)before.misses);
+
+    /* unlabelled statements are shared */
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_prepare(driver, p, handle,
+                                          "SELECT i FROM apr_dbd_cache "
+                                          "WHERE i = %d", NULL, &first));
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_prepare(driver, p, handle,
+                                          "SELECT i FROM apr_dbd_cache "
+                                          "WHERE i = %d", NULL, &again));
+    ABTS_PTR_EQUAL(tc, first, again);
+
+    /* evicted, but still usable by whoever holds it */
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_select(driver, p, handle, &res,
+                                         "SELECT count(*) FROM apr_dbd_cache",
+                                         1));
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_select(driver, p, handle, &res,
+                                         "SELECT max(i) FROM apr_dbd_cache",
+                                         1));
+    apr_dbd_stmt_cache_stats_get(driver, handle, &after);
+    ABTS_INT_EQUAL(tc, 2, after.entries);
+    ABTS_ASSERT(tc, "statements evicted", after.evictions > before.evictions);
+    /* whatever reuses the memory of the evicted entries must not change
+     * how the statement binds its arguments
+     */
+    for (i = 0; i < 16; i++) {
+        apr_dbd_type_e *types = junk[i] = malloc(64 + 8 * i);
+        int j;
+
+        for (j = 0; j < (64 + 8 * i) / (int)sizeof(*types); j++) {
+            types[j] = APR_DBD_TYPE_BLOB;
+        }
+    }
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_pvselect(driver, p, handle, &res, first,
+                                           0, "1"));
+    nrows = 0;
+    while (apr_dbd_get_row(driver, p, res, &row, -1) == 0) {
+        nrows++;
+    }
+    ABTS_INT_EQUAL(tc, 2, nrows);
+    for (i = 0; i < 16; i++) {
+        free(junk[i]);
+    }
+
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_prepare(driver, p, handle,
+                                          "SELECT i FROM apr_dbd_cache "
+                                          "WHERE i = %d", NULL, &again));
+    ABTS_ASSERT(tc, "evicted statement prepared again", first != again);
+
+    APR_ASSERT_SUCCESS(tc, "disable statement cache",
+                       apr_dbd_stmt_cache_set(driver, handle, 0));
+    apr_dbd_stmt_cache_stats_get(driver, handle, &after);
+    ABTS_INT_EQUAL(tc, 0, after.entries);
+    test_statement(tc, handle, driver, "DROP TABLE apr_dbd_cache");
+    apr_dbd_stmt_cache_stats_get(driver, handle, &before);
+    ABTS_INT_EQUAL(tc, (int)after.misses, (int)before.misses);
+    apr_dbd_stmt_cache_set(driver, handle, 32);
+}
+
+static int count_rows(apr_dbd_t *handle, const apr_dbd_driver_t *driver,
+                      const char *query)
+{
+    apr_dbd_results_t *res = NULL;
+    apr_dbd_row_t *row = NULL;
+    int n = -1;
+
+    if (apr_dbd_select(driver, p, handle, &res, query, 0) == 0
+        && apr_dbd_get_row(driver, p, res, &row, -1) == 0) {
+        n = atoi(apr_dbd_get_entry(driver, row, 0));
+        while (apr_dbd_get_row(driver, p, res, &row, -1) == 0)
+            ;
+    }
+    return n;
+}
+
+static void test_sqlite3_batch(abts_case *tc, apr_dbd_t *handle,
+                               const apr_dbd_driver_t *driver)
+{
+    apr_dbd_prepared_t *stmt = NULL;
+    apr_dbd_transaction_t *trans = NULL;
+    const void **args[100];
+    int keys[100];
+    const char *name = "batch";
+    int i, nrows, rv;
+
+    test_statement(tc, handle, driver, "CREATE TEMP TABLE apr_dbd_batch "
+                   "(k integer primary key, name varchar(10))");
+    rv = apr_dbd_prepare(driver, p, handle,
+                         "INSERT INTO apr_dbd_batch VALUES (%d, %s)",
+                         NULL, &stmt);
+    ABTS_INT_EQUAL(tc, 0, rv);
+    if (rv) {
+        return;
+    }
+    for (i = 0; i < 100; i++) {
+        keys[i] = i;
+        args[i] = apr_palloc(p, 2 * sizeof(*args[i]));
+        args[i][0] = &keys[i];
+        args[i][1] = name;
+    }
+
+    rv = apr_dbd_pbquery_batch(driver, p, handle, &nrows, stmt, 100, args,
+                               NULL);
+    ABTS_INT_EQUAL(tc, 0, rv);
+    ABTS_INT_EQUAL(tc, 100, nrows);
+    ABTS_INT_EQUAL(tc, 100, count_rows(handle, driver,
+                                       "SELECT count(*) FROM apr_dbd_batch "
+                                       "WHERE name = 'batch'"));
+
+    /* a duplicate key fails the batch and rolls it back as a whole */
+    for (i = 0; i < 100; i++) {
+        keys[i] = 150 - i;
+    }
+    rv = apr_dbd_pbquery_batch(driver, p, handle, &nrows, stmt, 100, args,
+                               NULL);
+    ABTS_ASSERT(tc, "batch with a duplicate key succeeded", rv != 0);
+    ABTS_INT_EQUAL(tc, 51, nrows);
+    ABTS_INT_EQUAL(tc, 100, count_rows(handle, driver,
+                                       "SELECT count(*) FROM apr_dbd_batch"));
+
+    /* within the caller's transaction */
+    for (i = 0; i < 10; i++) {
+        keys[i] = 200 + i;
+    }
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_transaction_start(driver, p, handle,
+                                                    &trans));
+    rv = apr_dbd_pbquery_batch(driver, p, handle, &nrows, stmt, 10, args,
+                               trans);
+    ABTS_INT_EQUAL(tc, 0, rv);
+    ABTS_INT_EQUAL(tc, 10, nrows);
+    apr_dbd_transaction_mode_set(driver, trans,
+                                 APR_DBD_TRANSACTION_ROLLBACK);
+    apr_dbd_transaction_end(driver, p, trans);
+    ABTS_INT_EQUAL(tc, 100, count_rows(handle, driver,
+                                       "SELECT count(*) FROM apr_dbd_batch"));
+
+    test_statement(tc, handle, driver, "DROP TABLE apr_dbd_batch");
+}
+
+static void test_sqlite3_batch_busy(abts_case *tc,
+                                    const apr_dbd_driver_t *driver)
+{
+    apr_dbd_t *writer = NULL, *reader = NULL;
+    apr_dbd_prepared_t *stmt = NULL;
+    apr_dbd_results_t *res = NULL;
+    apr_dbd_row_t *row = NULL;
+    const void **args[10];
+    int keys[10];
+    int i, nrows, rv;
+
+    rv = apr_dbd_open(driver, p, "file=data/sqlite3.db;busy_timeout=10",
+                      &writer);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv) {
+        return;
+    }
+    rv = apr_dbd_open(driver, p, "data/sqlite3.db", &reader);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv) {
+        apr_dbd_close(driver, writer);
+        return;
+    }
+
+    test_statement(tc, writer, driver,
+                   "CREATE TABLE apr_dbd_busy (k integer)");
+    test_statement(tc, writer, driver,
+                   "INSERT INTO apr_dbd_busy VALUES (-1)");
+    rv = apr_dbd_prepare(driver, p, writer,
+                         "INSERT INTO apr_dbd_busy VALUES (%d)", NULL, &stmt);
+    ABTS_INT_EQUAL(tc, 0, rv);
+    for (i = 0; i < 10; i++) {
+        keys[i] = i;
+        args[i] = apr_palloc(p, sizeof(*args[i]));
+        args[i][0] = &keys[i];
+    }
+
+    /* the open cursor of the reader keeps the COMMIT from its lock */
+    ABTS_INT_EQUAL(tc, 0, apr_dbd_select(driver, p, reader, &res,
+                                         "SELECT k FROM apr_dbd_busy", 0));
+    if (rv == 0) {
+        rv = apr_dbd_pbquery_batch(driver, p, writer, &nrows, stmt, 10, args,
+                                   NULL);
+        ABTS_ASSERT(tc, "batch committed under a reader", rv != 0);
+        ABTS_INT_EQUAL(tc, 0, nrows);
+    }
+    while (apr_dbd_get_row(driver, p, res, &row, -1) == 0)
+        ;
+
+    /* and the batch was rolled back */
+    ABTS_INT_EQUAL(tc, 1, count_rows(writer, driver,
+                                     "SELECT count(*) FROM apr_dbd_busy"));
+    test_statement(tc, writer, driver, "DROP TABLE apr_dbd_busy");
+
+    apr_dbd_close(driver, reader);
+    apr_dbd_close(driver, writer);
+}
+
+static void check_typed_row(abts_case *tc, const apr_dbd_driver_t *driver,
+                            apr_dbd_row_t *row)
+{
+    apr_int64_t i = 0;
+    double d = 0;
+    apr_dbd_span_t span;
+
+    APR_ASSERT_SUCCESS(tc, "integer column",
+                       apr_dbd_get_int64(driver, row, 0, &i));
+    ABTS_INT_EQUAL(tc, 42, (int)i);
+    APR_ASSERT_SUCCESS(tc, "real column",
+                       apr_dbd_get_double(driver, row, 1, &d));
+    ABTS_ASSERT(tc, "real value", d == 2.5);
+    APR_ASSERT_SUCCESS(tc, "integer as double",
+                       apr_dbd_get_double(driver, row, 0, &d));
+    ABTS_ASSERT(tc, "converted value", d == 42.0);
+
+    APR_ASSERT_SUCCESS(tc, "text column",
+                       apr_dbd_get_text(driver, row, 2, &span));
+    ABTS_INT_EQUAL(tc, 5, (int)span.len);
+    ABTS_ASSERT(tc, "text value", memcmp(span.data, "hello", 5) == 0);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, apr_dbd_get_int64(driver, row, 2, &i));
+
+    APR_ASSERT_SUCCESS(tc, "blob column",
+                       apr_dbd_get_blob(driver, row, 3, &span));
+    ABTS_INT_EQUAL(tc, 3, (int)span.len);
+    ABTS_ASSERT(tc, "blob value", memcmp(span.data, "\0\377\1", 3) == 0);
+
+    ABTS_INT_EQUAL(tc, APR_ENOENT, apr_dbd_get_int64(driver, row, 4, &i));
+    ABTS_INT_EQUAL(tc, APR_ENOENT, apr_dbd_get_text(driver, row, 4, &span));
+    ABTS_INT_EQUAL(tc, APR_EGENERAL, apr_dbd_get_int64(driver, row, 5, &i));
+}
+
+static void test_sqlite3_typed(abts_case *tc, apr_dbd_t *handle,
+                               const apr_dbd_driver_t *driver)
+{
+    apr_dbd_results_t *res;
+    apr_dbd_row_t *row;
+    static const int modes[] = { APR_DBD_SELECT_STREAM, 0, 1 };
+    int i;
+
+    test_statement(tc, handle, driver, "CREATE TEMP TABLE apr_dbd_typed "
+                   "(i integer, d real, t text, b blob, n integer)");
+    test_statement(tc, handle, driver, "INSERT INTO apr_dbd_typed VALUES "
+                   "(42, 2.5, 'hello', x'00ff01', NULL)");
+
+    /* streaming rows, then rows copied out of the statement */
+    for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        res = NULL;
+        row = NULL;
+        ABTS_INT_EQUAL(tc, 0, apr_dbd_select(driver, p, handle, &res,
+                                             "SELECT * FROM apr_dbd_typed",
+                                             modes[i]));
+        ABTS_INT_EQUAL(tc, 0, apr_dbd_get_row(driver, p, res, &row, -1));
+        if (row) {
+            check_typed_row(tc, driver, row);
+        }
+        while (apr_dbd_get_row(driver, p, res, &row, -1) == 0)
+            ;
+    }
+
+    test_statement(tc, handle, driver, "DROP TABLE apr_dbd_typed");
+}
+
+static void test_sqlite3_open_params(abts_case *tc,
+                                     const apr_dbd_driver_t *driver)
+{
+    apr_status_t rv;
+    apr_dbd_t *handle = NULL;
+    const char *error = NULL;
+
+    rv = apr_dbd_open_ex(driver, p, "file=data/sqlite3.db;busy_timeout=500;"
+                         "journal_mode=TRUNCATE;synchronous=NORMAL",
+                         &handle, &error);
+    ABTS_ASSERT(tc, "failed to open with parameters", rv == APR_SUCCESS);
+    if (rv == APR_SUCCESS) {
+        test_statement(tc, handle, driver,
+                       "CREATE TEMP TABLE apr_dbd_open (i integer)");
+        apr_dbd_close(driver, handle);
+    }
+
+    handle = NULL;
+    rv = apr_dbd_open_ex(driver, p, "file=data/sqlite3.db journal_mode=W-AL",
+                         &handle, &error);
+    ABTS_ASSERT(tc, "opened with an invalid PRAGMA", rv != APR_SUCCESS);
+    ABTS_PTR_EQUAL(tc, NULL, handle);
+    ABTS_STR_EQUAL(tc, "invalid PRAGMA value", error);
+}
+
 static void test_dbd_sqlite3(abts_case *tc, void *data)
 {
     apr_pool_t *pool = p;
@@ -223,6 +614,12 @@ static void test_dbd_sqlite3(abts_case *tc, void *data)
     	return;
     }
 
+    test_sqlite3_open_params(tc, driver);
+    test_sqlite3_cursor(tc, handle, driver);
+    test_sqlite3_stmt_cache(tc, handle, driver);
+    test_sqlite3_batch(tc, handle, driver);
+    test_sqlite3_batch_busy(tc, driver);
+    test_sqlite3_typed(tc, handle, driver);
     test_dbd_generic(tc, handle, driver);
 }
 #endif
@@ -0,0 +1,235 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apu.h"
+#include "apr_atomic.h"
+#include "apr_dbd.h"
+#include "apr_file_io.h"
+#include "apr_strings.h"
+#include "apr_thread_proc.h"
+#include "apr_time.h"
+#include "apr_general.h"
+#include "apr_errno.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !APU_HAVE_SQLITE3 || !APR_HAS_THREADS
+
+int main(void)
+{
+    printf("This program won't work on this platform because there is no "
+           "support for sqlite3 or threads.\n");
+    return 0;
+}
+
+#else /* APU_HAVE_SQLITE3 && APR_HAS_THREADS */
+
+#define DBFILE     "data/dbdperf.db"
+#define ROWS       10000
+#define LOOKUPS    50000
+#define MAX_THREADS 8
+
+/* WAL lets readers on separate connections proceed without blocking */
+#define PARAMS     "file=" DBFILE ";journal_mode=WAL;synchronous=NORMAL"
+
+static const apr_dbd_driver_t *driver;
+static volatile apr_uint32_t failures;
+
+static apr_dbd_t *open_db(apr_pool_t *pool)
+{
+    apr_dbd_t *handle = NULL;
+    const char *error = NULL;
+
+    if (apr_dbd_open_ex(driver, pool, PARAMS, &handle, &error)
+            != APR_SUCCESS) {
+        fprintf(stderr, "failed to open %s: %s\n", DBFILE,
+                error ? error : "unknown error");
+        exit(-1);
+    }
+    return handle;
+}
+
+static void report(const char *what, apr_time_t start, int n)
+{
+    apr_time_t elapsed = apr_time_now() - start;
+
+    printf("%-40s %10.0f rows/sec\n", what,
+           (double)n * APR_USEC_PER_SEC / elapsed);
+}
+
+static void populate(apr_pool_t *pool)
+{
+    apr_dbd_t *handle = open_db(pool);
+    apr_dbd_prepared_t *stmt = NULL;
+    const void ***args;
+    int *keys;
+    apr_time_t start;
+    int i, nrows;
+
+    apr_dbd_query(driver, handle, &nrows,
+                  "CREATE TABLE perf (k integer primary key, v varchar(40))");
+    if (apr_dbd_prepare(driver, pool, handle,
+                        "INSERT INTO perf VALUES (%d, %s)", NULL, &stmt)) {
+        fprintf(stderr, "prepare failed: %s\n",
+                apr_dbd_error(driver, handle, 0));
+        exit(-1);
+    }
+
+    args = apr_palloc(pool, ROWS * sizeof(*args));
+    keys = apr_palloc(pool, ROWS * sizeof(*keys));
+    for (i = 0; i < ROWS; i++) {
+        keys[i] = i;
+        args[i] = apr_palloc(pool, 2 * sizeof(*args[i]));
+        args[i][0] = &keys[i];
+        args[i][1] = apr_psprintf(pool, "value number %d", i);
+    }
+
+    /* one implicit transaction per row */
+    start = apr_time_now();
+    for (i = 0; i < ROWS / 10; i++) {
+        keys[i] = ROWS + i;
+        apr_dbd_pbquery(driver, pool, handle, &nrows, stmt, args[i]);
+    }
+    report("apr_dbd_pbquery (autocommit)", start, ROWS / 10);
+    apr_dbd_query(driver, handle, &nrows, "DELETE FROM perf");
+
+    for (i = 0; i < ROWS; i++) {
+        keys[i] = i;
+    }
+    start = apr_time_now();
+    if (apr_dbd_pbquery_batch(driver, pool, handle, &nrows, stmt, ROWS, args,
+                              NULL) || nrows != ROWS) {
+        fprintf(stderr, "batch insert failed: %s\n",
+                apr_dbd_error(driver, handle, 0));
+        exit(-1);
+    }
+    report("apr_dbd_pbquery_batch", start, ROWS);
+    printf("\n");
+
+    apr_dbd_close(driver, handle);
+}
+
+static void * APR_THREAD_FUNC reader(apr_thread_t *thd, void *data)
+{
+    apr_pool_t *pool, *iterpool;
+    apr_dbd_t *handle;
+    apr_dbd_prepared_t *stmt = NULL;
+    apr_dbd_results_t *res;
+    apr_dbd_row_t *row;
+    apr_dbd_span_t span;
+    int lookups = *(int *)data;
+    unsigned int key = (unsigned int)(apr_uintptr_t)thd;
+    int i;
+
+    apr_pool_create(&pool, NULL);
+    apr_pool_create(&iterpool, pool);
+    handle = open_db(pool);
+    if (apr_dbd_prepare(driver, pool, handle,
+                        "SELECT v FROM perf WHERE k = %d", NULL, &stmt)) {
+        fprintf(stderr, "prepare failed: %s\n",
+                apr_dbd_error(driver, handle, 0));
+        exit(-1);
+    }
+
+    for (i = 0; i < lookups; i++) {
+        key = key * 1103515245 + 12345;
+        res = NULL;
+        row = NULL;
+        if (apr_dbd_pvselect(driver, iterpool, handle, &res, stmt, 0,
+                             apr_itoa(iterpool, (key >> 8) % ROWS), NULL)
+            || apr_dbd_get_row(driver, iterpool, res, &row, -1)
+            || apr_dbd_get_text(driver, row, 0, &span) != APR_SUCCESS) {
+            apr_atomic_inc32(&failures);
+        }
+        while (res && apr_dbd_get_row(driver, iterpool, res, &row, -1) == 0)
+            ;
+        apr_pool_clear(iterpool);
+    }
+
+    apr_dbd_close(driver, handle);
+    apr_pool_destroy(pool);
+    apr_thread_exit(thd, APR_SUCCESS);
+    return NULL;
+}
+
+static double run_readers(apr_pool_t *pool, int nthreads)
+{
+    apr_thread_t *threads[MAX_THREADS];
+    apr_status_t rv;
+    apr_time_t start, elapsed;
+    int lookups = LOOKUPS / nthreads;
+    int i;
+
+    start = apr_time_now();
+    for (i = 0; i < nthreads; i++) {
+        apr_thread_create(&threads[i], NULL, reader, &lookups, pool);
+    }
+    for (i = 0; i < nthreads; i++) {
+        apr_thread_join(&rv, threads[i]);
+    }
+    elapsed = apr_time_now() - start;
+
+    return (double)(lookups * nthreads) * APR_USEC_PER_SEC / elapsed;
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+    double base = 0, rate;
+    int nthreads;
+
+    printf("APR DBD SQLite3 Performance Test\n"
+           "================================\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+    apr_pool_create(&pool, NULL);
+
+    apr_dbd_init(pool);
+    if (apr_dbd_get_driver(pool, "sqlite3", &driver) != APR_SUCCESS) {
+        fprintf(stderr, "sqlite3 driver not available\n");
+        exit(-1);
+    }
+
+    apr_file_remove(DBFILE, pool);
+    apr_file_remove(DBFILE "-wal", pool);
+    apr_file_remove(DBFILE "-shm", pool);
+    populate(pool);
+
+    printf("%d point lookups, one connection per thread\n\n", LOOKUPS);
+    for (nthreads = 1; nthreads <= MAX_THREADS; nthreads *= 2) {
+        rate = run_readers(pool, nthreads);
+        if (nthreads == 1) {
+            base = rate;
+        }
+        printf("%d thread(s): %10.0f lookups/sec (%.2fx)\n", nthreads, rate,
+               rate / base);
+    }
+
+    if (failures) {
+        printf("\n%u lookups failed\n", failures);
+    }
+
+    apr_file_remove(DBFILE, pool);
+    apr_file_remove(DBFILE "-wal", pool);
+    apr_file_remove(DBFILE "-shm", pool);
+    apr_pool_destroy(pool);
+
+    return failures ? -1 : 0;
+}
+
+#endif /* APU_HAVE_SQLITE3 && APR_HAS_THREADS */
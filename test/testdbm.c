@@ -19,6 +19,8 @@
 #include "apr_pools.h"
 #include "apr_errno.h"
 #include "apr_dbm.h"
+#include "apr_file_io.h"
+#include "apr_sdbm.h"
 #include "apr_uuid.h"
 #include "apr_strings.h"
 #include "abts.h"
@@ -200,6 +202,313 @@ static void test_dbm(abts_case *tc, void *data)
     apr_dbm_close(db);
 }
 
+#if APU_HAVE_SDBM
+static void sdbm_check(abts_case *tc, apr_sdbm_t *db, int nrecs, int step)
+{
+    apr_sdbm_datum_t key, val;
+    char kbuf[32], vbuf[32];
+    apr_status_t rv;
+    int i, found = 0;
+
+    for (i = 0; i < nrecs; i++) {
+        key.dptr = kbuf;
+        key.dsize = apr_snprintf(kbuf, sizeof(kbuf), "key%d", i);
+        val.dptr = NULL;
+        val.dsize = 0;
+        rv = apr_sdbm_fetch(db, &val, key);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        if (i % step == 0) {
+            ABTS_INT_EQUAL(tc, apr_snprintf(vbuf, sizeof(vbuf), "value%d", i),
+                           val.dsize);
+            ABTS_INT_EQUAL(tc, 0, memcmp(val.dptr, vbuf, val.dsize));
+        }
+        else {
+            ABTS_PTR_EQUAL(tc, NULL, val.dptr);
+        }
+    }
+
+    rv = apr_sdbm_firstkey(db, &key);
+    while (rv == APR_SUCCESS && key.dptr != NULL) {
+        found++;
+        rv = apr_sdbm_nextkey(db, &key);
+    }
+    ABTS_INT_EQUAL(tc, (nrecs + step - 1) / step, found);
+}
+
+static void test_sdbm_cache(abts_case *tc, void *data)
+{
+    const char *file = "data/test-sdbmcache";
+    apr_sdbm_datum_t key, val;
+    char kbuf[32], vbuf[32];
+    apr_sdbm_t *db;
+    apr_status_t rv;
+    int i;
+
+    rv = apr_sdbm_open(&db, file, APR_FOPEN_WRITE | APR_FOPEN_CREATE
+                       | APR_FOPEN_TRUNCATE, APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+
+    /* a small cache, so that pages split and get evicted */
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_sdbm_cache_set(db, 8));
+    for (i = 0; i < 2000; i++) {
+        key.dptr = kbuf;
+        key.dsize = apr_snprintf(kbuf, sizeof(kbuf), "key%d", i);
+        val.dptr = vbuf;
+        val.dsize = apr_snprintf(vbuf, sizeof(vbuf), "value%d", i);
+        rv = apr_sdbm_store(db, key, val, APR_SDBM_INSERT);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+    for (i = 0; i < 2000; i++) {
+        if (i % 3) {
+            key.dptr = kbuf;
+            key.dsize = apr_snprintf(kbuf, sizeof(kbuf), "key%d", i);
+            ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_sdbm_delete(db, key));
+        }
+    }
+    sdbm_check(tc, db, 2000, 3);
+
+    /* what was cached is what was written */
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_sdbm_cache_set(db, 0));
+    sdbm_check(tc, db, 2000, 3);
+    apr_sdbm_close(db);
+
+    /* read-only, served from a mapping of the files */
+    rv = apr_sdbm_open(&db, file, APR_FOPEN_READ, APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    sdbm_check(tc, db, 2000, 3);
+    apr_sdbm_close(db);
+
+    /* read-only and shared, through the cache */
+    rv = apr_sdbm_open(&db, file, APR_FOPEN_READ | APR_FOPEN_SHARELOCK,
+                       APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    apr_sdbm_cache_set(db, 64);
+    apr_sdbm_lock(db, APR_FLOCK_SHARED);
+    sdbm_check(tc, db, 2000, 3);
+    sdbm_check(tc, db, 2000, 3);
+    apr_sdbm_unlock(db);
+    apr_sdbm_close(db);
+}
+
+static void test_sdbm_build(abts_case *tc, void *data)
+{
+    const char *file = "data/test-sdbmbuild";
+    apr_sdbm_builder_t *builder;
+    apr_sdbm_datum_t key, val;
+    char kbuf[32], vbuf[32], big[9000];
+    apr_sdbm_t *db;
+    apr_status_t rv;
+    int i, n;
+
+    rv = apr_sdbm_build_create(&builder, file, APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+
+    /* stale values first, then every record in a scattered order */
+    for (i = 0; i < 2000; i += 3) {
+        key.dptr = kbuf;
+        key.dsize = apr_snprintf(kbuf, sizeof(kbuf), "key%d", i);
+        val.dptr = "stale";
+        val.dsize = 5;
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_sdbm_build_add(builder, key, val));
+    }
+    for (i = 0; i < 2000; i++) {
+        n = i * 7 % 2000;
+        if (n % 3)
+            continue;
+        key.dptr = kbuf;
+        key.dsize = apr_snprintf(kbuf, sizeof(kbuf), "key%d", n);
+        val.dptr = vbuf;
+        val.dsize = apr_snprintf(vbuf, sizeof(vbuf), "value%d", n);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_sdbm_build_add(builder, key, val));
+    }
+
+    /* a record that could never fit a page is refused */
+    memset(big, 'x', sizeof(big));
+    val.dptr = big;
+    val.dsize = sizeof(big);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, apr_sdbm_build_add(builder, key, val));
+
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_sdbm_build_finish(builder));
+
+    rv = apr_sdbm_open(&db, file, APR_FOPEN_READ, APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    sdbm_check(tc, db, 2000, 3);
+    apr_sdbm_close(db);
+
+    /* the built database keeps growing through the usual page splits */
+    rv = apr_sdbm_open(&db, file, APR_FOPEN_WRITE, APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    for (i = 2001; i < 6000; i += 3) {
+        key.dptr = kbuf;
+        key.dsize = apr_snprintf(kbuf, sizeof(kbuf), "key%d", i);
+        val.dptr = vbuf;
+        val.dsize = apr_snprintf(vbuf, sizeof(vbuf), "value%d", i);
+        rv = apr_sdbm_store(db, key, val, APR_SDBM_INSERT);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+    sdbm_check(tc, db, 6000, 3);
+    apr_sdbm_close(db);
+
+    apr_sdbm_build_create(&builder, file, APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_sdbm_build_finish(builder));
+    rv = apr_sdbm_open(&db, file, APR_FOPEN_READ, APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    sdbm_check(tc, db, 0, 3);
+    apr_sdbm_close(db);
+}
+#endif
+
+static void cdb_store(abts_case *tc, apr_dbm_t *db, const char *k,
+                      const char *v)
+{
+    apr_datum_t key, val;
+
+    key.dptr = (char *)k;
+    key.dsize = strlen(k);
+    val.dptr = (char *)v;
+    val.dsize = strlen(v);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_dbm_store(db, key, val));
+}
+
+static void cdb_check(abts_case *tc, apr_dbm_t *db, const char *k,
+                      const char *v)
+{
+    apr_datum_t key, val;
+
+    key.dptr = (char *)k;
+    key.dsize = strlen(k);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_dbm_fetch(db, key, &val));
+    if (v == NULL) {
+        ABTS_PTR_EQUAL(tc, NULL, val.dptr);
+    }
+    else {
+        ABTS_INT_EQUAL(tc, strlen(v), val.dsize);
+        ABTS_INT_EQUAL(tc, 0, memcmp(v, val.dptr, val.dsize));
+    }
+}
+
+static void test_cdb_replace(abts_case *tc, void *data)
+{
+    const char *file = "data/test-cdbreplace";
+    unsigned char empty[2048];
+    apr_dbm_t *db, *old;
+    apr_datum_t key;
+    apr_file_t *f;
+    apr_finfo_t before, after;
+    apr_status_t rv;
+    int i;
+
+    /* an empty database as written by any cdb tool */
+    for (i = 0; i < 256; i++) {
+        empty[i * 8] = 0;
+        empty[i * 8 + 1] = 8;
+        memset(empty + i * 8 + 2, 0, 6);
+    }
+    rv = apr_file_open(&f, file, APR_FOPEN_WRITE | APR_FOPEN_CREATE
+                       | APR_FOPEN_TRUNCATE | APR_FOPEN_BINARY,
+                       APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    apr_file_write_full(f, empty, sizeof(empty), NULL);
+    apr_file_close(f);
+
+    rv = apr_dbm_open_ex(&db, "cdb", file, APR_DBM_READONLY,
+                         APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_dbm_firstkey(db, &key));
+    ABTS_PTR_EQUAL(tc, NULL, key.dptr);
+    cdb_check(tc, db, "alpha", NULL);
+    apr_dbm_close(db);
+
+    rv = apr_dbm_open_ex(&db, "cdb", file, APR_DBM_READWRITE,
+                         APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    cdb_store(tc, db, "alpha", "1");
+    cdb_store(tc, db, "beta", "2");
+    apr_dbm_close(db);
+
+    /* a reader keeps the database it opened while it is replaced */
+    rv = apr_dbm_open_ex(&old, "cdb", file, APR_DBM_READONLY,
+                         APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    ABTS_INT_EQUAL(tc, APR_EINVAL, apr_dbm_delete(old, key));
+
+    rv = apr_dbm_open_ex(&db, "cdb", file, APR_DBM_READWRITE,
+                         APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    cdb_check(tc, db, "alpha", "1");
+    cdb_store(tc, db, "alpha", "one");
+    cdb_store(tc, db, "gamma", "3");
+    key.dptr = "beta";
+    key.dsize = 4;
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, apr_dbm_delete(db, key));
+    apr_dbm_close(db);
+
+    cdb_check(tc, old, "alpha", "1");
+    cdb_check(tc, old, "beta", "2");
+    cdb_check(tc, old, "gamma", NULL);
+    apr_dbm_close(old);
+
+    rv = apr_dbm_open_ex(&db, "cdb", file, APR_DBM_READONLY,
+                         APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    cdb_check(tc, db, "alpha", "one");
+    cdb_check(tc, db, "beta", NULL);
+    cdb_check(tc, db, "gamma", "3");
+    apr_dbm_close(db);
+
+    /* a database that is not modified is not written out again */
+    ABTS_INT_EQUAL(tc, APR_SUCCESS,
+                   apr_stat(&before, file, APR_FINFO_INODE, p));
+    rv = apr_dbm_open_ex(&db, "cdb", file, APR_DBM_RWCREATE,
+                         APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+    cdb_check(tc, db, "gamma", "3");
+    apr_dbm_close(db);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS,
+                   apr_stat(&after, file, APR_FINFO_INODE, p));
+    ABTS_ASSERT(tc, "unmodified database was rewritten",
+                before.inode == after.inode);
+
+    /* a file too short for the header is refused */
+    apr_file_open(&f, file, APR_FOPEN_WRITE | APR_FOPEN_TRUNCATE,
+                  APR_OS_DEFAULT, p);
+    apr_file_write_full(f, empty, 100, NULL);
+    apr_file_close(f);
+    rv = apr_dbm_open_ex(&db, "cdb", file, APR_DBM_READONLY,
+                         APR_OS_DEFAULT, p);
+    ABTS_INT_EQUAL(tc, APR_EGENERAL, rv);
+
+    apr_file_remove(file, p);
+}
+
 abts_suite *testdbm(abts_suite *suite)
 {
     suite = ADD_SUITE(suite);
@@ -212,7 +521,11 @@ abts_suite *testdbm(abts_suite *suite)
 #endif
 #if APU_HAVE_SDBM
     abts_run_test(suite, test_dbm, "sdbm");
+    abts_run_test(suite, test_sdbm_cache, NULL);
+    abts_run_test(suite, test_sdbm_build, NULL);
 #endif
+    abts_run_test(suite, test_dbm, "cdb");
+    abts_run_test(suite, test_cdb_replace, NULL);
 #if APU_HAVE_DB
     abts_run_test(suite, test_dbm, "db");
 #endif
@@ -0,0 +1,231 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_dbm.h"
+#include "apr_sdbm.h"
+#include "apr_file_io.h"
+#include "apr_strings.h"
+#include "apr_time.h"
+#include "apr_general.h"
+#include "apr_errno.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DBFILE   "data/dbmperf"
+#define RECORDS  200000
+#define LOOKUPS  1000000
+
+static void fail(const char *what, apr_status_t rv)
+{
+    char msg[256];
+
+    fprintf(stderr, "%s: %s\n", what, apr_strerror(rv, msg, sizeof(msg)));
+    exit(-1);
+}
+
+static apr_sdbm_datum_t make_key(char *buf, apr_size_t len, unsigned int i)
+{
+    apr_sdbm_datum_t key;
+
+    key.dptr = buf;
+    key.dsize = apr_snprintf(buf, len, "user%08u", i);
+    return key;
+}
+
+static apr_sdbm_datum_t make_val(char *buf, apr_size_t len, unsigned int i)
+{
+    apr_sdbm_datum_t val;
+
+    val.dptr = buf;
+    val.dsize = apr_snprintf(buf, len, "$apr1$%08x$0123456789abcdefghijkl", i);
+    return val;
+}
+
+static void report(const char *what, apr_time_t start)
+{
+    apr_time_t elapsed = apr_time_now() - start;
+
+    printf("%-40s %10.0f records/sec\n", what,
+           (double)RECORDS * APR_USEC_PER_SEC / elapsed);
+}
+
+static void populate(apr_pool_t *pool)
+{
+    apr_sdbm_t *db;
+    apr_sdbm_datum_t key, val;
+    char kbuf[32], vbuf[64];
+    apr_time_t start;
+    apr_status_t rv;
+    unsigned int i;
+
+    start = apr_time_now();
+    rv = apr_sdbm_open(&db, DBFILE, APR_FOPEN_WRITE | APR_FOPEN_CREATE
+                       | APR_FOPEN_TRUNCATE, APR_OS_DEFAULT, pool);
+    if (rv != APR_SUCCESS)
+        fail("apr_sdbm_open", rv);
+    apr_sdbm_cache_set(db, 1024);
+
+    for (i = 0; i < RECORDS; i++) {
+        key = make_key(kbuf, sizeof(kbuf), i);
+        val = make_val(vbuf, sizeof(vbuf), i);
+        if ((rv = apr_sdbm_store(db, key, val, APR_SDBM_REPLACE))
+                != APR_SUCCESS)
+            fail("apr_sdbm_store", rv);
+    }
+    apr_sdbm_close(db);
+    report("apr_sdbm_store, 1024 page cache", start);
+}
+
+static void build(apr_pool_t *pool)
+{
+    apr_sdbm_builder_t *builder;
+    apr_sdbm_datum_t key, val;
+    char kbuf[32], vbuf[64];
+    apr_time_t start;
+    apr_status_t rv;
+    unsigned int i;
+
+    start = apr_time_now();
+    if ((rv = apr_sdbm_build_create(&builder, DBFILE, APR_OS_DEFAULT, pool))
+            != APR_SUCCESS)
+        fail("apr_sdbm_build_create", rv);
+
+    /* insert in a scattered order, as an unsorted input would */
+    for (i = 0; i < RECORDS; i++) {
+        unsigned int n = (unsigned int)(i * 7919u % RECORDS);
+
+        key = make_key(kbuf, sizeof(kbuf), n);
+        val = make_val(vbuf, sizeof(vbuf), n);
+        if ((rv = apr_sdbm_build_add(builder, key, val)) != APR_SUCCESS)
+            fail("apr_sdbm_build_add", rv);
+    }
+    if ((rv = apr_sdbm_build_finish(builder)) != APR_SUCCESS)
+        fail("apr_sdbm_build_finish", rv);
+    report("apr_sdbm_build", start);
+    printf("\n");
+}
+
+static void bench(apr_pool_t *pool, const char *what, apr_int32_t flags,
+                  int npages)
+{
+    apr_sdbm_t *db;
+    apr_sdbm_datum_t key, val;
+    char kbuf[32];
+    apr_time_t start, elapsed;
+    apr_status_t rv;
+    unsigned int i, seed = 1, hits = 0;
+
+    if ((rv = apr_sdbm_open(&db, DBFILE, flags, APR_OS_DEFAULT, pool))
+            != APR_SUCCESS)
+        fail("apr_sdbm_open", rv);
+    if (npages)
+        apr_sdbm_cache_set(db, npages);
+
+    start = apr_time_now();
+    for (i = 0; i < LOOKUPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        /* one in ten lookups misses */
+        key = make_key(kbuf, sizeof(kbuf),
+                       (seed >> 8) % (RECORDS + RECORDS / 10));
+        if (apr_sdbm_fetch(db, &val, key) == APR_SUCCESS && val.dptr)
+            hits++;
+    }
+    elapsed = apr_time_now() - start;
+    apr_sdbm_close(db);
+
+    printf("%-40s %10.0f lookups/sec (%u hits)\n", what,
+           (double)LOOKUPS * APR_USEC_PER_SEC / elapsed, hits);
+}
+
+static void bench_cdb(apr_pool_t *pool)
+{
+    apr_dbm_t *db;
+    apr_datum_t key, val;
+    apr_sdbm_datum_t k, v;
+    char kbuf[32], vbuf[64];
+    apr_time_t start, elapsed;
+    apr_status_t rv;
+    unsigned int i, seed = 1, hits = 0;
+
+    start = apr_time_now();
+    if ((rv = apr_dbm_open_ex(&db, "cdb", DBFILE ".cdb", APR_DBM_RWTRUNC,
+                              APR_OS_DEFAULT, pool)) != APR_SUCCESS)
+        fail("apr_dbm_open_ex", rv);
+    for (i = 0; i < RECORDS; i++) {
+        k = make_key(kbuf, sizeof(kbuf), i);
+        v = make_val(vbuf, sizeof(vbuf), i);
+        key.dptr = k.dptr;
+        key.dsize = k.dsize;
+        val.dptr = v.dptr;
+        val.dsize = v.dsize;
+        if ((rv = apr_dbm_store(db, key, val)) != APR_SUCCESS)
+            fail("apr_dbm_store", rv);
+    }
+    apr_dbm_close(db);
+    report("cdb, apr_dbm_store", start);
+
+    if ((rv = apr_dbm_open_ex(&db, "cdb", DBFILE ".cdb", APR_DBM_READONLY,
+                              APR_OS_DEFAULT, pool)) != APR_SUCCESS)
+        fail("apr_dbm_open_ex", rv);
+
+    start = apr_time_now();
+    for (i = 0; i < LOOKUPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        k = make_key(kbuf, sizeof(kbuf),
+                     (seed >> 8) % (RECORDS + RECORDS / 10));
+        key.dptr = k.dptr;
+        key.dsize = k.dsize;
+        if (apr_dbm_fetch(db, key, &val) == APR_SUCCESS && val.dptr)
+            hits++;
+    }
+    elapsed = apr_time_now() - start;
+    apr_dbm_close(db);
+
+    printf("%-40s %10.0f lookups/sec (%u hits)\n", "cdb, read-only",
+           (double)LOOKUPS * APR_USEC_PER_SEC / elapsed, hits);
+    apr_file_remove(DBFILE ".cdb", pool);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+
+    printf("APR SDBM Performance Test\n"
+           "=========================\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+    apr_pool_create(&pool, NULL);
+
+    populate(pool);
+    build(pool);
+
+    bench(pool, "read-write, uncached", APR_FOPEN_WRITE, 0);
+    bench(pool, "read-write, 256 page cache", APR_FOPEN_WRITE, 256);
+    bench(pool, "read-write, 4096 page cache", APR_FOPEN_WRITE, 4096);
+    bench(pool, "read-only, buffered, shared",
+          APR_FOPEN_READ | APR_FOPEN_BUFFERED | APR_FOPEN_SHARELOCK, 0);
+    bench(pool, "read-only, memory mapped", APR_FOPEN_READ, 0);
+    printf("\n");
+    bench_cdb(pool);
+
+    apr_file_remove(DBFILE APR_SDBM_DIRFEXT, pool);
+    apr_file_remove(DBFILE APR_SDBM_PAGFEXT, pool);
+    apr_pool_destroy(pool);
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_md5.h"
+#include "apr_sha1.h"
+#include "apr_time.h"
+#include "apr_general.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Single-threaded, so the figures are per core */
+
+#define NUM_MSGS 8
+#define TOTAL_BYTES (256 * 1024 * 1024)
+
+static unsigned char buf[NUM_MSGS * 16384];
+
+static void report(const char *what, apr_size_t size, apr_time_t start,
+                   apr_size_t bytes)
+{
+    apr_time_t elapsed = apr_time_now() - start;
+
+    printf("%-28s %6" APR_SIZE_T_FMT " bytes: %8.1f MB/s\n", what, size,
+           (double)bytes / (elapsed ? elapsed : 1));
+}
+
+static void bench(apr_size_t size)
+{
+    unsigned char digests[NUM_MSGS][APR_SHA1_DIGESTSIZE];
+    unsigned char *outs[NUM_MSGS];
+    const unsigned char *ins[NUM_MSGS];
+    apr_size_t lens[NUM_MSGS];
+    apr_size_t i, rounds = TOTAL_BYTES / (size * NUM_MSGS);
+    apr_sha1_ctx_t context;
+    apr_time_t start;
+    int l;
+
+    for (l = 0; l < NUM_MSGS; l++) {
+        ins[l] = buf + l * size;
+        lens[l] = size;
+        outs[l] = digests[l];
+    }
+
+    start = apr_time_now();
+    for (i = 0; i < rounds; i++) {
+        for (l = 0; l < NUM_MSGS; l++) {
+            apr_md5(digests[l], ins[l], size);
+        }
+    }
+    report("apr_md5", size, start, rounds * size * NUM_MSGS);
+
+    start = apr_time_now();
+    for (i = 0; i < rounds; i++) {
+        apr_md5_multi(outs, (const void *const *)ins, lens, NUM_MSGS);
+    }
+    report("apr_md5_multi (8 messages)", size, start,
+           rounds * size * NUM_MSGS);
+
+    start = apr_time_now();
+    for (i = 0; i < rounds; i++) {
+        for (l = 0; l < NUM_MSGS; l++) {
+            apr_sha1_init(&context);
+            apr_sha1_update_binary(&context, ins[l], (unsigned int)size);
+            apr_sha1_final(digests[l], &context);
+        }
+    }
+    report("apr_sha1", size, start, rounds * size * NUM_MSGS);
+
+    start = apr_time_now();
+    for (i = 0; i < rounds; i++) {
+        apr_sha1_multi(outs, ins, lens, NUM_MSGS);
+    }
+    report("apr_sha1_multi (8 messages)", size, start,
+           rounds * size * NUM_MSGS);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_size_t i;
+
+    printf("APR Digest Performance Test\n==============\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+
+    for (i = 0; i < sizeof(buf); i++) {
+        buf[i] = (unsigned char)rand();
+    }
+
+    bench(64);
+    bench(1024);
+    bench(16384);
+
+    return 0;
+}
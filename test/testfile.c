@@ -21,6 +21,8 @@
 #include "apr_general.h"
 #include "apr_poll.h"
 #include "apr_lib.h"
+#include "apr_strings.h"
+#include "apr_thread_proc.h"
 #include "testutil.h"
 
 #define DIRNAME "data"
@@ -1028,6 +1030,140 @@ static void test_xthread(abts_case *tc, void *data)
     apr_file_close(f);
 }
 
+#if APR_HAS_THREADS
+
+#define ASYNC_THREADS 4
+#define ASYNC_RECORDS 2000
+
+typedef struct async_producer_t {
+    apr_file_async_t *async;
+    int id;
+} async_producer_t;
+
+static void * APR_THREAD_FUNC async_producer(apr_thread_t *thd, void *data)
+{
+    async_producer_t *prod = data;
+    char buf[256];
+    apr_status_t rv = APR_SUCCESS;
+    int i;
+
+    for (i = 0; i < ASYNC_RECORDS && rv == APR_SUCCESS; i++) {
+        /* vary the length so records span cells and wrap the ring */
+        int len = apr_snprintf(buf, sizeof(buf), "%d %d %.*s\n",
+                               prod->id, i, i % 150,
+                               "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+                               "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+                               "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+        rv = apr_file_async_write(prod->async, buf, len);
+    }
+
+    apr_thread_exit(thd, rv);
+    return NULL;
+}
+
+static void test_async_write(abts_case *tc, void *data)
+{
+    const char *fname = "data/testasync.dat";
+    apr_file_t *f;
+    apr_file_async_t *async;
+    apr_file_async_stats_t stats;
+    apr_thread_t *threads[ASYNC_THREADS];
+    async_producer_t prods[ASYNC_THREADS];
+    int next[ASYNC_THREADS] = { 0 };
+    apr_finfo_t finfo;
+    char line[256];
+    int i, lines = 0;
+
+    APR_ASSERT_SUCCESS(tc, "open file for writing",
+                       apr_file_open(&f, fname,
+                                     APR_FOPEN_WRITE|APR_FOPEN_CREATE|
+                                     APR_FOPEN_TRUNCATE|APR_FOPEN_APPEND,
+                                     APR_OS_DEFAULT, p));
+
+    /* a small ring makes the producers wait for the writer thread */
+    APR_ASSERT_SUCCESS(tc, "create appender",
+                       apr_file_async_create(&async, f, 4096, 0, p));
+
+    for (i = 0; i < ASYNC_THREADS; i++) {
+        prods[i].async = async;
+        prods[i].id = i;
+        APR_ASSERT_SUCCESS(tc, "create producer",
+                           apr_thread_create(&threads[i], NULL,
+                                             async_producer, &prods[i], p));
+    }
+    for (i = 0; i < ASYNC_THREADS; i++) {
+        apr_status_t rv;
+
+        apr_thread_join(&rv, threads[i]);
+        APR_ASSERT_SUCCESS(tc, "producer writes", rv);
+    }
+
+    APR_ASSERT_SUCCESS(tc, "flush appender", apr_file_async_flush(async));
+    apr_file_async_stats_get(async, &stats);
+    ABTS_ASSERT(tc, "all records written",
+                stats.records == ASYNC_THREADS * ASYNC_RECORDS);
+    ABTS_INT_EQUAL(tc, 0, stats.dropped);
+    ABTS_INT_EQUAL(tc, 0, stats.errors);
+    ABTS_INT_EQUAL(tc, 1, stats.flushes);
+
+    APR_ASSERT_SUCCESS(tc, "stat file",
+                       apr_stat(&finfo, fname, APR_FINFO_SIZE, p));
+    ABTS_ASSERT(tc, "file holds every byte",
+                (apr_uint64_t)finfo.size == stats.bytes);
+
+    APR_ASSERT_SUCCESS(tc, "close appender", apr_file_async_close(async));
+    ABTS_INT_EQUAL(tc, APR_EINVAL, apr_file_async_write(async, "x", 1));
+    apr_file_close(f);
+
+    /* every thread's records are whole and in the order written */
+    APR_ASSERT_SUCCESS(tc, "open file for reading",
+                       apr_file_open(&f, fname, APR_FOPEN_READ,
+                                     APR_OS_DEFAULT, p));
+    while (apr_file_gets(line, sizeof(line), f) == APR_SUCCESS) {
+        int id, seq;
+
+        ABTS_INT_EQUAL(tc, 2, sscanf(line, "%d %d", &id, &seq));
+        ABTS_ASSERT(tc, "valid producer", id >= 0 && id < ASYNC_THREADS);
+        ABTS_INT_EQUAL(tc, next[id], seq);
+        ABTS_INT_EQUAL(tc, (int)strlen(line),
+                       (int)strlen(apr_psprintf(p, "%d %d ", id, seq))
+                       + seq % 150 + 1);
+        next[id] = seq + 1;
+        lines++;
+    }
+    apr_file_close(f);
+    ABTS_INT_EQUAL(tc, ASYNC_THREADS * ASYNC_RECORDS, lines);
+}
+
+static void test_async_oversize(abts_case *tc, void *data)
+{
+    const char *fname = "data/testasync.dat";
+    apr_file_t *f;
+    apr_file_async_t *async;
+    char big[2048];
+
+    APR_ASSERT_SUCCESS(tc, "open file for writing",
+                       apr_file_open(&f, fname,
+                                     APR_FOPEN_WRITE|APR_FOPEN_CREATE|
+                                     APR_FOPEN_TRUNCATE,
+                                     APR_OS_DEFAULT, p));
+    APR_ASSERT_SUCCESS(tc, "create appender",
+                       apr_file_async_create(&async, f, 1024,
+                                             APR_FILE_ASYNC_DROP, p));
+
+    memset(big, 'x', sizeof(big));
+    ABTS_INT_EQUAL(tc, APR_EINVAL,
+                   apr_file_async_write(async, big, sizeof(big)));
+    APR_ASSERT_SUCCESS(tc, "ring sized write",
+                       apr_file_async_write(async, big, 1024));
+
+    APR_ASSERT_SUCCESS(tc, "close appender", apr_file_async_close(async));
+    file_contents_equal(tc, fname, big, 1024);
+    apr_file_close(f);
+}
+
+#endif /* APR_HAS_THREADS */
+
 abts_suite *testfile(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -1068,6 +1204,10 @@ abts_suite *testfile(abts_suite *suite)
     abts_run_test(suite, test_fail_read_flush, NULL);
     abts_run_test(suite, test_buffer_set_get, NULL);
     abts_run_test(suite, test_xthread, NULL);
+#if APR_HAS_THREADS
+    abts_run_test(suite, test_async_write, NULL);
+    abts_run_test(suite, test_async_oversize, NULL);
+#endif
 
     return suite;
 }
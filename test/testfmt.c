@@ -18,6 +18,7 @@
 #include "apr.h"
 #include "apr_portable.h"
 #include "apr_strings.h"
+#include "apr_lib.h"
 
 static void ssize_t_fmt(abts_case *tc, void *data)
 {
@@ -146,6 +147,142 @@ static void error_fmt(abts_case *tc, void *data)
     ABTS_STR_EQUAL(tc, sbuf, s);
 }
 
+static void decimal_fmts(abts_case *tc, void *data)
+{
+    char buf[100];
+
+    apr_snprintf(buf, sizeof buf, "%d %d %d %d %d", 0, 7, 10, 99, 100);
+    ABTS_STR_EQUAL(tc, "0 7 10 99 100", buf);
+
+    apr_snprintf(buf, sizeof buf, "%d %d", -1234567, (int)APR_INT32_MIN);
+    ABTS_STR_EQUAL(tc, "-1234567 -2147483648", buf);
+
+    apr_snprintf(buf, sizeof buf, "%u %u", 1000000000u, 4294967295u);
+    ABTS_STR_EQUAL(tc, "1000000000 4294967295", buf);
+
+    apr_snprintf(buf, sizeof buf, "%" APR_UINT64_T_FMT " %" APR_UINT64_T_FMT,
+                 APR_UINT64_C(4294967296), APR_UINT64_C(18446744073709551615));
+    ABTS_STR_EQUAL(tc, "4294967296 18446744073709551615", buf);
+
+    apr_snprintf(buf, sizeof buf, "%" APR_INT64_T_FMT, APR_INT64_MIN);
+    ABTS_STR_EQUAL(tc, "-9223372036854775808", buf);
+
+    apr_snprintf(buf, sizeof buf, "%" APR_INT64_T_FMT, APR_INT64_C(100000000000));
+    ABTS_STR_EQUAL(tc, "100000000000", buf);
+}
+
+static int plan_flush(apr_vformatter_buff_t *vbuff)
+{
+    return -1;
+}
+
+static void plan_fmt(abts_case *tc, void *data)
+{
+    static const char *const fmts[] = {
+        "",
+        "no conversions",
+        "%s",
+        "%d%%%s",
+        "[%5d|%-5d|%05d|%+d|% d]",
+        "%*d|%-*s|%.*s|",
+        "%x %X %#x %o %#o %c",
+        "%" APR_INT64_T_FMT " %" APR_UINT64_T_FMT " trailing",
+        NULL
+    };
+    apr_vformatter_plan_t *plan;
+    apr_vformatter_arg_t argv[3];
+    apr_vformatter_buff_t vbuff;
+    char buf[100];
+    int i, cc;
+
+    for (i = 0; fmts[i]; i++) {
+        apr_status_t rv = apr_vformatter_plan_create(&plan, fmts[i], p);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+
+    apr_vformatter_plan_create(&plan, "", p);
+    ABTS_STR_EQUAL(tc, "", apr_psprintf_plan(p, plan));
+    ABTS_INT_EQUAL(tc, 0, apr_vformatter_plan_nargs(plan));
+
+    apr_vformatter_plan_create(&plan, "no conversions", p);
+    ABTS_STR_EQUAL(tc, "no conversions", apr_psprintf_plan(p, plan));
+
+    apr_vformatter_plan_create(&plan, "%d%%%s", p);
+    ABTS_INT_EQUAL(tc, 2, apr_vformatter_plan_nargs(plan));
+    ABTS_STR_EQUAL(tc, "42%foo", apr_psprintf_plan(p, plan, 42, "foo"));
+
+    apr_vformatter_plan_create(&plan, "[%5d|%-5d|%05d|%+d|% d]", p);
+    ABTS_STR_EQUAL(tc, apr_psprintf(p, "[%5d|%-5d|%05d|%+d|% d]",
+                                    -3, 3, -3, 3, 3),
+                   apr_psprintf_plan(p, plan, -3, 3, -3, 3, 3));
+
+    apr_vformatter_plan_create(&plan, "%*d|%-*s|%.*s|", p);
+    ABTS_INT_EQUAL(tc, 6, apr_vformatter_plan_nargs(plan));
+    ABTS_STR_EQUAL(tc, "   12|ab   |abc|",
+                   apr_psprintf_plan(p, plan, 5, 12, 5, "ab", 3, "abcdef"));
+
+    apr_vformatter_plan_create(&plan, "%x %X %#x %o %#o %c", p);
+    ABTS_STR_EQUAL(tc, "ff FF 0xff 17 017 z",
+                   apr_psprintf_plan(p, plan, 255, 255, 255, 15, 15, 'z'));
+
+    apr_vformatter_plan_create(&plan, "%" APR_INT64_T_FMT
+                               " %" APR_UINT64_T_FMT " trailing", p);
+    ABTS_STR_EQUAL(tc, "-314159265358979323 10267677267010969076 trailing",
+                   apr_psprintf_plan(p, plan,
+                                     APR_INT64_C(-314159265358979323),
+                                     APR_UINT64_C(10267677267010969076)));
+
+    /* the same plan fed from an argument array */
+    argv[0].i = APR_INT64_C(-42);
+    argv[1].u = 42;
+    vbuff.curpos = buf;
+    vbuff.endpos = buf + sizeof(buf) - 1;
+    cc = apr_vformatter_plan_exec_args(plan_flush, &vbuff, plan, argv, 2);
+    *vbuff.curpos = '\0';
+    ABTS_INT_EQUAL(tc, 15, cc);
+    ABTS_STR_EQUAL(tc, "-42 42 trailing", buf);
+
+    apr_vformatter_plan_create(&plan, "%s=%5.1f", p);
+    argv[0].p = "pi";
+    argv[1].d = 3.14159;
+    vbuff.curpos = buf;
+    cc = apr_vformatter_plan_exec_args(plan_flush, &vbuff, plan, argv, 2);
+    *vbuff.curpos = '\0';
+    ABTS_STR_EQUAL(tc, "pi=  3.1", buf);
+
+    /* too few arguments */
+    vbuff.curpos = buf;
+    cc = apr_vformatter_plan_exec_args(plan_flush, &vbuff, plan, argv, 1);
+    ABTS_INT_EQUAL(tc, -1, cc);
+
+    /* output exceeding the buffer fails through the flush function */
+    vbuff.curpos = buf;
+    vbuff.endpos = buf + 4;
+    cc = apr_vformatter_plan_exec_args(plan_flush, &vbuff, plan, argv, 2);
+    ABTS_INT_EQUAL(tc, -1, cc);
+
+    /* '*' widths are signed, a negative one left-adjusts */
+    apr_vformatter_plan_create(&plan, "[%*d]", p);
+    argv[0].i = -4;
+    argv[1].i = 7;
+    vbuff.curpos = buf;
+    vbuff.endpos = buf + sizeof(buf) - 1;
+    cc = apr_vformatter_plan_exec_args(plan_flush, &vbuff, plan, argv, 2);
+    *vbuff.curpos = '\0';
+    ABTS_INT_EQUAL(tc, 6, cc);
+    ABTS_STR_EQUAL(tc, "[7   ]", buf);
+
+    /* conversions are validated when the plan is compiled */
+    ABTS_INT_EQUAL(tc, APR_EINVAL,
+                   apr_vformatter_plan_create(&plan, "%y", p));
+    ABTS_INT_EQUAL(tc, APR_EINVAL,
+                   apr_vformatter_plan_create(&plan, "%pZ", p));
+    ABTS_INT_EQUAL(tc, APR_EINVAL,
+                   apr_vformatter_plan_create(&plan, "trailing %", p));
+    ABTS_INT_EQUAL(tc, APR_EINVAL,
+                   apr_vformatter_plan_create(&plan, "trailing %p", p));
+}
+
 abts_suite *testfmt(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -160,6 +297,8 @@ abts_suite *testfmt(abts_suite *suite)
     abts_run_test(suite, uint64_t_hex_fmt, NULL);
     abts_run_test(suite, more_int64_fmts, NULL);
     abts_run_test(suite, error_fmt, NULL);
+    abts_run_test(suite, decimal_fmts, NULL);
+    abts_run_test(suite, plan_fmt, NULL);
 
     return suite;
 }
@@ -0,0 +1,129 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_network_io.h"
+#include "apr_strings.h"
+#include "apr_time.h"
+#include "apr_general.h"
+#include "apr_errno.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SUBNETS        50000
+#define SCAN_LOOKUPS   2000
+#define SET_LOOKUPS    1000000
+
+static apr_uint32_t seed = 1;
+
+static apr_uint32_t next_random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8 | seed << 24;
+}
+
+static void fail(const char *what, apr_status_t rv)
+{
+    char msg[256];
+
+    fprintf(stderr, "%s: %s\n", what, apr_strerror(rv, msg, sizeof(msg)));
+    exit(-1);
+}
+
+static void report(const char *what, apr_time_t start, int n, int hits)
+{
+    apr_time_t elapsed = apr_time_now() - start;
+
+    printf("%-40s %10.1f ns/lookup (%d%% hits)\n", what,
+           (double)elapsed * 1000.0 / n, hits * 100 / n);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+    apr_ipsubnet_t **subnets;
+    apr_ipset_t *set;
+    apr_sockaddr_t *sa;
+    apr_time_t start;
+    apr_status_t rv;
+    char ipstr[16], numbits[3];
+    int i, j, hits;
+
+    printf("APR IP Subnet Set Performance Test\n"
+           "==================================\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+    apr_pool_create(&pool, NULL);
+
+    /* an allow/deny list: mostly /16 to /32, a few wide blocks */
+    subnets = apr_palloc(pool, SUBNETS * sizeof(*subnets));
+    start = apr_time_now();
+    for (i = 0; i < SUBNETS; i++) {
+        apr_uint32_t addr = next_random();
+
+        apr_snprintf(ipstr, sizeof ipstr, "%u.%u.%u.%u", addr >> 24,
+                     (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF);
+        apr_snprintf(numbits, sizeof numbits, "%u",
+                     i % 100 ? 16 + next_random() % 17 : 12);
+        if ((rv = apr_ipsubnet_create(&subnets[i], ipstr, numbits, pool))
+                != APR_SUCCESS)
+            fail("apr_ipsubnet_create", rv);
+    }
+    printf("%d subnets parsed in %" APR_TIME_T_FMT " usec\n", SUBNETS,
+           apr_time_now() - start);
+
+    start = apr_time_now();
+    apr_ipset_create(&set, pool);
+    for (i = 0; i < SUBNETS; i++) {
+        if ((rv = apr_ipset_add_subnet(set, subnets[i], subnets[i]))
+                != APR_SUCCESS)
+            fail("apr_ipset_add_subnet", rv);
+    }
+    printf("%d subnets added to a set in %" APR_TIME_T_FMT " usec\n\n",
+           SUBNETS, apr_time_now() - start);
+
+    if ((rv = apr_sockaddr_info_get(&sa, "0.0.0.0", APR_INET, 0, 0, pool))
+            != APR_SUCCESS)
+        fail("apr_sockaddr_info_get", rv);
+
+    seed = 42;
+    hits = 0;
+    start = apr_time_now();
+    for (i = 0; i < SCAN_LOOKUPS; i++) {
+        sa->sa.sin.sin_addr.s_addr = htonl(next_random());
+        for (j = 0; j < SUBNETS; j++) {
+            if (apr_ipsubnet_test(subnets[j], sa)) {
+                hits++;
+                break;
+            }
+        }
+    }
+    report("apr_ipsubnet_test, linear scan", start, SCAN_LOOKUPS, hits);
+
+    seed = 42;
+    hits = 0;
+    start = apr_time_now();
+    for (i = 0; i < SET_LOOKUPS; i++) {
+        sa->sa.sin.sin_addr.s_addr = htonl(next_random());
+        if (apr_ipset_test(set, sa, NULL))
+            hits++;
+    }
+    report("apr_ipset_test", start, SET_LOOKUPS, hits);
+
+    apr_pool_destroy(pool);
+    return 0;
+}
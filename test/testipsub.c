@@ -17,6 +17,7 @@
 #include "testutil.h"
 #include "apr_general.h"
 #include "apr_network_io.h"
+#include "apr_strings.h"
 #include "apr_errno.h"
 
 static void test_bad_input(abts_case *tc, void *data)
@@ -164,6 +165,151 @@ static void test_badip_str(abts_case *tc, void *data)
                       "The specified IP address is invalid.");
 }
 
+static void test_ipset(abts_case *tc, void *data)
+{
+    struct {
+        const char *ipstr, *mask;
+    } subnets[] =
+    {
+         {"10.0.0.0",         "8"}
+        ,{"10.1.0.0",         "255.255.0.0"}
+        ,{"10.1.2.3",         NULL}
+        ,{"192.168",          NULL}
+#if APR_HAVE_IPV6
+        ,{"fe80::",           "10"}
+        ,{"fe80::1",          "128"}
+        ,{"2001:db8::",       "32"}
+#endif
+    };
+    struct {
+        const char *addr;
+        int family;
+        int subnet;                     /* index above, or -1 */
+    } lookups[] =
+    {
+         {"10.1.2.3",         APR_INET,  2}
+        ,{"10.1.2.4",         APR_INET,  1}
+        ,{"10.2.0.1",         APR_INET,  0}
+        ,{"192.168.7.7",      APR_INET,  3}
+        ,{"11.0.0.1",         APR_INET,  -1}
+#if APR_HAVE_IPV6
+        ,{"::ffff:10.1.9.9",  APR_INET6, 1}
+        ,{"::ffff:11.0.0.1",  APR_INET6, -1}
+        ,{"fe80::1",          APR_INET6, 5}
+        ,{"fe80::2",          APR_INET6, 4}
+        ,{"2001:db8:1::1",    APR_INET6, 6}
+        ,{"2001:db9::1",      APR_INET6, -1}
+        ,{"::a01:203",        APR_INET6, -1} /* not v4-mapped */
+#endif
+    };
+    apr_ipset_t *set;
+    apr_sockaddr_t *sa;
+    apr_status_t rv;
+    void *found;
+    int i, rc;
+
+    rv = apr_ipset_create(&set, p);
+    APR_ASSERT_SUCCESS(tc, "create ipset", rv);
+
+    for (i = 0; i < sizeof subnets / sizeof subnets[0]; i++) {
+        rv = apr_ipset_add(set, subnets[i].ipstr, subnets[i].mask,
+                           &subnets[i]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+    ABTS_INT_EQUAL(tc, APR_EINVAL, apr_ipset_add(set, "my.host.name", NULL,
+                                                 NULL));
+    ABTS_INT_EQUAL(tc, APR_EBADMASK, apr_ipset_add(set, "10.0.0.0",
+                                                   "255.0.255.0", NULL));
+
+    for (i = 0; i < sizeof lookups / sizeof lookups[0]; i++) {
+        rv = apr_sockaddr_info_get(&sa, lookups[i].addr, lookups[i].family,
+                                   0, 0, p);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        if (rv != APR_SUCCESS)
+            continue;
+        found = NULL;
+        rc = apr_ipset_test(set, sa, &found);
+        if (lookups[i].subnet < 0) {
+            ABTS_INT_EQUAL(tc, 0, rc);
+        }
+        else {
+            ABTS_TRUE(tc, rc != 0);
+            ABTS_PTR_EQUAL(tc, &subnets[lookups[i].subnet], found);
+        }
+    }
+
+    /* adding a subnet again replaces its data */
+    rv = apr_ipset_add(set, "10.0.0.0", "255.0.0.0", &subnets[3]);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_sockaddr_info_get(&sa, "10.2.0.1", APR_INET, 0, 0, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_TRUE(tc, apr_ipset_test(set, sa, &found) != 0);
+    ABTS_PTR_EQUAL(tc, &subnets[3], found);
+}
+
+#define RANDOM_SUBNETS 500
+
+/* the most specific of a pile of nested random subnets, found both ways */
+static void test_ipset_random(abts_case *tc, void *data)
+{
+    apr_ipsubnet_t *ipsub[RANDOM_SUBNETS];
+    int bits[RANDOM_SUBNETS];
+    apr_ipset_t *set;
+    apr_sockaddr_t *sa;
+    apr_uint32_t seed = 1, addr;
+    char ipstr[16], numbits[3];
+    apr_status_t rv;
+    void *found;
+    int i, j, best;
+
+    rv = apr_ipset_create(&set, p);
+    APR_ASSERT_SUCCESS(tc, "create ipset", rv);
+
+    for (i = 0; i < RANDOM_SUBNETS; i++) {
+        seed = seed * 1103515245 + 12345;
+        /* keep them within 10/8 so that they overlap */
+        addr = 0x0A000000 | (seed >> 8);
+        bits[i] = 8 + (seed >> 27) % 25;
+        apr_snprintf(ipstr, sizeof ipstr, "%u.%u.%u.%u", addr >> 24,
+                     (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF);
+        apr_snprintf(numbits, sizeof numbits, "%d", bits[i]);
+
+        rv = apr_ipsubnet_create(&ipsub[i], ipstr, numbits, p);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        rv = apr_ipset_add_subnet(set, ipsub[i], &bits[i]);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+
+    rv = apr_sockaddr_info_get(&sa, "10.0.0.0", APR_INET, 0, 0, p);
+    APR_ASSERT_SUCCESS(tc, "sockaddr", rv);
+
+    for (i = 0; i < 5000; i++) {
+        seed = seed * 1103515245 + 12345;
+        /* mostly near one of the subnets */
+        addr = 0x0A000000 | (seed >> 8);
+        if (i & 1)
+            addr ^= (seed >> 4) & 0xFF;
+        sa->sa.sin.sin_addr.s_addr = htonl(addr);
+
+        for (j = 0, best = -1; j < RANDOM_SUBNETS; j++) {
+            if (apr_ipsubnet_test(ipsub[j], sa)
+                && (best < 0 || bits[j] >= bits[best]))
+                best = j;
+        }
+
+        found = NULL;
+        if (best < 0) {
+            ABTS_INT_EQUAL(tc, 0, apr_ipset_test(set, sa, &found));
+        }
+        else {
+            ABTS_TRUE(tc, apr_ipset_test(set, sa, &found) != 0);
+            ABTS_PTR_NOTNULL(tc, found);
+            if (found)
+                ABTS_INT_EQUAL(tc, bits[best], *(int *)found);
+        }
+    }
+}
+
 abts_suite *testipsub(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -173,6 +319,8 @@ abts_suite *testipsub(abts_suite *suite)
     abts_run_test(suite, test_interesting_subnets, NULL);
     abts_run_test(suite, test_badmask_str, NULL);
     abts_run_test(suite, test_badip_str, NULL);
+    abts_run_test(suite, test_ipset, NULL);
+    abts_run_test(suite, test_ipset_random, NULL);
     return suite;
 }
 
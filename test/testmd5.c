@@ -66,6 +66,44 @@ static void test_md5sum(abts_case *tc, void *data)
                     (memcmp(digest, sum, APR_MD5_DIGESTSIZE) == 0));
 }
 
+#define NUM_MSGS 19
+
+static void test_md5_multi(abts_case *tc, void *data)
+{
+        static unsigned char buf[NUM_MSGS * 1024];
+        unsigned char digests[NUM_MSGS][APR_MD5_DIGESTSIZE];
+        unsigned char digest[APR_MD5_DIGESTSIZE];
+        unsigned char *outs[NUM_MSGS];
+        const void *ins[NUM_MSGS];
+        apr_size_t lens[NUM_MSGS];
+        int i, n;
+
+        srand(5);
+        for (i = 0; i < sizeof(buf); i++) {
+            buf[i] = rand() & 0xff;
+        }
+
+        for (n = 1; n <= NUM_MSGS; n++) {
+            for (i = 0; i < n; i++) {
+                ins[i] = buf + i * 1024;
+                lens[i] = (i * 37 + n * 11) % 130;
+                if (i % 5 == 4) {
+                    lens[i] += 700;
+                }
+                outs[i] = digests[i];
+            }
+            ABTS_ASSERT(tc, "apr_md5_multi",
+                        apr_md5_multi(outs, ins, lens, n) == APR_SUCCESS);
+
+            for (i = 0; i < n; i++) {
+                apr_md5(digest, ins[i], lens[i]);
+                ABTS_ASSERT(tc, "apr_md5_multi matches apr_md5",
+                            memcmp(digest, digests[i],
+                                   APR_MD5_DIGESTSIZE) == 0);
+            }
+        }
+}
+
 abts_suite *testmd5(abts_suite *suite)
 {
         suite = ADD_SUITE(suite);
@@ -73,6 +111,7 @@ abts_suite *testmd5(abts_suite *suite)
         for (count=0; count < num_sums; count++) {
             abts_run_test(suite, test_md5sum, NULL);
         }
+        abts_run_test(suite, test_md5_multi, NULL);
 
         return suite;
 }
@@ -0,0 +1,162 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_network_io.h"
+#include "apr_time.h"
+#include "apr_general.h"
+#include "apr_errno.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DATAGRAMS  200000
+#define BATCH      32
+#define SIZE       200
+
+static apr_socket_t *sender, *receiver;
+static apr_sockaddr_t *to;
+
+static void fail(const char *what, apr_status_t rv)
+{
+    char msg[256];
+
+    fprintf(stderr, "%s: %s\n", what, apr_strerror(rv, msg, sizeof(msg)));
+    exit(-1);
+}
+
+static void setup(apr_pool_t *pool)
+{
+    apr_sockaddr_t *sa;
+    apr_status_t rv;
+
+    if ((rv = apr_sockaddr_info_get(&sa, "127.0.0.1", APR_INET, 0, 0, pool))
+            != APR_SUCCESS)
+        fail("apr_sockaddr_info_get", rv);
+    if ((rv = apr_socket_create(&receiver, APR_INET, SOCK_DGRAM, 0, pool))
+            != APR_SUCCESS
+        || (rv = apr_socket_create(&sender, APR_INET, SOCK_DGRAM, 0, pool))
+            != APR_SUCCESS)
+        fail("apr_socket_create", rv);
+    if ((rv = apr_socket_bind(receiver, sa)) != APR_SUCCESS)
+        fail("apr_socket_bind", rv);
+    if ((rv = apr_socket_addr_get(&to, APR_LOCAL, receiver)) != APR_SUCCESS)
+        fail("apr_socket_addr_get", rv);
+
+    /* room for a whole batch in flight */
+    apr_socket_opt_set(receiver, APR_SO_RCVBUF, 1024 * 1024);
+}
+
+static void report(const char *what, apr_time_t start)
+{
+    apr_time_t elapsed = apr_time_now() - start;
+
+    printf("%-40s %10.0f datagrams/sec\n", what,
+           (double)DATAGRAMS * APR_USEC_PER_SEC / elapsed);
+}
+
+/* send a batch, then read it back, one datagram per call */
+static void bench_single(apr_pool_t *pool)
+{
+    char buf[SIZE], rbuf[SIZE * 2];
+    apr_sockaddr_t *from;
+    apr_time_t start;
+    apr_status_t rv;
+    apr_size_t len;
+    int i, j;
+
+    from = apr_pcalloc(pool, sizeof(*from));
+    memset(buf, 'x', sizeof(buf));
+
+    start = apr_time_now();
+    for (i = 0; i < DATAGRAMS; i += BATCH) {
+        for (j = 0; j < BATCH; j++) {
+            len = SIZE;
+            if ((rv = apr_socket_sendto(sender, to, 0, buf, &len))
+                    != APR_SUCCESS)
+                fail("apr_socket_sendto", rv);
+        }
+        for (j = 0; j < BATCH; j++) {
+            len = sizeof(rbuf);
+            if ((rv = apr_socket_recvfrom(from, receiver, 0, rbuf, &len))
+                    != APR_SUCCESS)
+                fail("apr_socket_recvfrom", rv);
+        }
+    }
+    report("apr_socket_sendto/recvfrom", start);
+}
+
+/* the same traffic, a batch per call */
+static void bench_batch(apr_pool_t *pool, const char *what, int same_size)
+{
+    char buf[SIZE], rbuf[BATCH][SIZE * 2];
+    apr_sockaddr_t from[BATCH];
+    apr_socket_msg_t out[BATCH], in[BATCH];
+    apr_time_t start;
+    apr_status_t rv;
+    int i, j, n, got;
+
+    memset(buf, 'x', sizeof(buf));
+    for (j = 0; j < BATCH; j++) {
+        out[j].addr = to;
+        out[j].buf = buf;
+        /* a varying size keeps the batch from being one GSO send */
+        out[j].len = same_size ? SIZE : SIZE - (j % 2);
+    }
+
+    start = apr_time_now();
+    for (i = 0; i < DATAGRAMS; i += BATCH) {
+        for (n = 0; n < BATCH; n += got) {
+            if ((rv = apr_socket_sendmmsg(sender, out + n, BATCH - n, 0,
+                                          &got)) != APR_SUCCESS)
+                fail("apr_socket_sendmmsg", rv);
+        }
+        for (n = 0; n < BATCH; n += got) {
+            for (j = n; j < BATCH; j++) {
+                in[j].addr = &from[j];
+                in[j].buf = rbuf[j];
+                in[j].len = sizeof(rbuf[j]);
+            }
+            if ((rv = apr_socket_recvmmsg(receiver, in + n, BATCH - n, 0,
+                                          &got)) != APR_SUCCESS)
+                fail("apr_socket_recvmmsg", rv);
+        }
+    }
+    report(what, start);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+
+    printf("APR Batched Datagram Performance Test\n"
+           "=====================================\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+    apr_pool_create(&pool, NULL);
+
+    setup(pool);
+    printf("%d datagrams of %d bytes over loopback, %d per batch\n\n",
+           DATAGRAMS, SIZE, BATCH);
+
+    bench_single(pool);
+    bench_batch(pool, "apr_socket_sendmmsg/recvmmsg", 0);
+    bench_batch(pool, "apr_socket_sendmmsg/recvmmsg, equal sizes", 1);
+
+    apr_pool_destroy(pool);
+    return 0;
+}
@@ -21,6 +21,8 @@
 #include "apr_lib.h"
 #include "apr_network_io.h"
 #include "apr_poll.h"
+#include "apr_thread_proc.h"
+#include "apr_atomic.h"
 
 #define SMALL_NUM_SOCKETS 3
 /* We can't use 64 here, because some platforms *ahem* Solaris *ahem* have
@@ -819,6 +821,111 @@ static void pollcb_wakeup(abts_case *tc, void *data)
     ABTS_INT_EQUAL(tc, APR_EINTR, rv);
 }
 
+static void pollset_wakeup_coalesce(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_pollset_t *pollset;
+    apr_int32_t num;
+    const apr_pollfd_t *descriptors;
+    int i;
+
+    rv = apr_pollset_create(&pollset, 1, p, APR_POLLSET_WAKEABLE);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "apr_pollset_wakeup() not supported");
+        return;
+    }
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    /* pending wakeups fold into a single one */
+    for (i = 0; i < 10000; i++) {
+        rv = apr_pollset_wakeup(pollset);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    }
+    rv = apr_pollset_poll(pollset, -1, &num, &descriptors);
+    ABTS_INT_EQUAL(tc, APR_EINTR, rv);
+    rv = apr_pollset_poll(pollset, 0, &num, &descriptors);
+    ABTS_INT_EQUAL(tc, 1, APR_STATUS_IS_TIMEUP(rv));
+
+    /* and the next wakeup is not lost */
+    rv = apr_pollset_wakeup(pollset);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_pollset_poll(pollset, -1, &num, &descriptors);
+    ABTS_INT_EQUAL(tc, APR_EINTR, rv);
+
+    apr_pollset_destroy(pollset);
+}
+
+#if APR_HAS_THREADS
+
+#define WAKEUP_ROUNDS 2000
+
+static volatile apr_uint32_t wakeups_seen;
+
+static void * APR_THREAD_FUNC wakeup_poller(apr_thread_t *thd, void *data)
+{
+    apr_pollset_t *pollset = data;
+    apr_int32_t num;
+    const apr_pollfd_t *descriptors;
+    apr_status_t rv = APR_SUCCESS;
+
+    while (apr_atomic_read32(&wakeups_seen) < WAKEUP_ROUNDS) {
+        rv = apr_pollset_poll(pollset, apr_time_from_sec(5), &num,
+                              &descriptors);
+        if (rv != APR_EINTR)
+            break;
+        apr_atomic_inc32(&wakeups_seen);
+        rv = APR_SUCCESS;
+    }
+    apr_thread_exit(thd, rv);
+    return NULL;
+}
+
+static void pollset_wakeup_roundtrip(abts_case *tc, void *data)
+{
+    apr_status_t rv, retval;
+    apr_pollset_t *pollset;
+    apr_thread_t *thread;
+    apr_time_t start;
+    apr_uint32_t seen;
+    apr_uint32_t calls = 0;
+
+    rv = apr_pollset_create(&pollset, 1, p, APR_POLLSET_WAKEABLE);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "apr_pollset_wakeup() not supported");
+        return;
+    }
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    apr_atomic_set32(&wakeups_seen, 0);
+    rv = apr_thread_create(&thread, NULL, wakeup_poller, pollset, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    /* wake the poller up and wait for each round trip */
+    start = apr_time_now();
+    for (seen = 0; seen < WAKEUP_ROUNDS; ) {
+        rv = apr_pollset_wakeup(pollset);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        calls++;
+        while (apr_atomic_read32(&wakeups_seen) == seen) {
+            apr_thread_yield();
+            if (apr_time_now() - start > apr_time_from_sec(30))
+                break;
+        }
+        if (apr_atomic_read32(&wakeups_seen) == seen)
+            break;
+        seen = apr_atomic_read32(&wakeups_seen);
+    }
+
+    apr_thread_join(&retval, thread);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, retval);
+    ABTS_INT_EQUAL(tc, WAKEUP_ROUNDS, wakeups_seen);
+    ABTS_ASSERT(tc, "more wakeups seen than made", calls >= wakeups_seen);
+
+    apr_pollset_destroy(pollset);
+}
+
+#endif /* APR_HAS_THREADS */
+
 static void justsleep(abts_case *tc, void *data)
 {
     apr_int32_t nsds;
@@ -925,6 +1032,10 @@ abts_suite *testpoll(abts_suite *suite)
 
     abts_run_test(suite, pollset_wakeup, NULL);
     abts_run_test(suite, pollcb_wakeup, NULL);
+    abts_run_test(suite, pollset_wakeup_coalesce, NULL);
+#if APR_HAS_THREADS
+    abts_run_test(suite, pollset_wakeup_roundtrip, NULL);
+#endif
     return suite;
 }
 
@@ -0,0 +1,104 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr_pools.h"
+#include "apr_time.h"
+#include "apr_general.h"
+#include "apr_errno.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ITERATIONS 1000000
+#define OBJECTS    64
+
+static void report(const char *what, apr_time_t start, int n)
+{
+    apr_time_t elapsed = apr_time_now() - start;
+
+    printf("%-50s %8" APR_TIME_T_FMT " usec, %6.1f ns/call\n", what,
+           elapsed, (double)elapsed * 1000.0 / n);
+}
+
+static void bench_palloc(apr_pool_t *pool)
+{
+    apr_time_t start;
+    int i;
+
+    /* leave the nodes cached in the allocator, so no run pays for them */
+    for (i = 0; i < ITERATIONS; i++)
+        (apr_palloc)(pool, 32);
+    apr_pool_clear(pool);
+
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++)
+        apr_palloc(pool, 32);
+    report("apr_palloc, 32 bytes (inline)", start, ITERATIONS);
+    apr_pool_clear(pool);
+
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++)
+        (apr_palloc)(pool, 32);
+    report("apr_palloc, 32 bytes (function)", start, ITERATIONS);
+    apr_pool_clear(pool);
+}
+
+static void bench_small(apr_pool_t *pool)
+{
+    apr_pool_stats_t stats;
+    apr_time_t start;
+    void *live[OBJECTS] = { NULL };
+    int i;
+
+    /* a long-lived pool replacing objects of a fixed working set */
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++)
+        live[i % OBJECTS] = apr_palloc(pool, 48);
+    report("apr_palloc, 48 byte working set", start, ITERATIONS);
+    apr_pool_stats_get(pool, &stats);
+    printf("%-50s %8" APR_SIZE_T_FMT " bytes\n", "  pool size",
+           stats.bytes_used);
+    apr_pool_clear(pool);
+
+    for (i = 0; i < OBJECTS; i++)
+        live[i] = NULL;
+    start = apr_time_now();
+    for (i = 0; i < ITERATIONS; i++) {
+        apr_pool_free_small(pool, live[i % OBJECTS], 48);
+        live[i % OBJECTS] = apr_pool_alloc_small(pool, 48);
+    }
+    report("apr_pool_alloc_small, 48 byte working set", start, ITERATIONS);
+    apr_pool_stats_get(pool, &stats);
+    printf("%-50s %8" APR_SIZE_T_FMT " bytes\n", "  pool size",
+           stats.bytes_used);
+    apr_pool_clear(pool);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+
+    printf("APR Pool Performance Test\n==============\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+    apr_pool_create(&pool, NULL);
+
+    bench_palloc(pool);
+    bench_small(pool);
+
+    apr_pool_destroy(pool);
+    return 0;
+}
@@ -17,6 +17,7 @@
 
 #include "apr_general.h"
 #include "apr_pools.h"
+#include "apr_allocator.h"
 #include "apr_errno.h"
 #include "apr_file_io.h"
 #include <string.h>
@@ -139,6 +140,273 @@ static void test_cleanups(abts_case *tc, void *data)
     }
 }
 
+static void allocator_stats(abts_case *tc, void *data)
+{
+    apr_allocator_t *alloc;
+    apr_allocator_stats_t stats;
+    apr_memnode_t *node;
+    apr_status_t rv;
+
+    rv = apr_allocator_create(&alloc);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    node = apr_allocator_alloc(alloc, ALLOC_BYTES);
+    ABTS_PTR_NOTNULL(tc, node);
+    apr_allocator_stats_get(alloc, &stats);
+    ABTS_ASSERT(tc, "no memory obtained", stats.system_bytes > ALLOC_BYTES);
+    ABTS_ASSERT(tc, "node not accounted for",
+                stats.node_bytes == stats.system_bytes);
+    ABTS_INT_EQUAL(tc, 0, stats.free_nodes);
+    ABTS_INT_EQUAL(tc, 0, stats.regions);
+
+    apr_allocator_free(alloc, node);
+    apr_allocator_stats_get(alloc, &stats);
+    ABTS_INT_EQUAL(tc, 1, stats.free_nodes);
+    ABTS_ASSERT(tc, "free node not accounted for",
+                stats.free_bytes == stats.node_bytes
+                && stats.largest_free == stats.free_bytes);
+
+    apr_allocator_destroy(alloc);
+}
+
+static void allocator_regions(abts_case *tc, void *data)
+{
+    apr_allocator_t *alloc;
+    apr_allocator_stats_t stats;
+    apr_memnode_t *nodes[100], *big;
+    apr_pool_t *pool;
+    apr_status_t rv;
+    char *mem;
+    int i;
+
+    rv = apr_allocator_create_ex(&alloc, APR_ALLOCATOR_HUGE_PAGES
+                                         | APR_ALLOCATOR_NUMA_NODE,
+                                 0, 0);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    /* 100 nodes of 12KB and up fit in the first 4MB region */
+    for (i = 0; i < 100; i++) {
+        nodes[i] = apr_allocator_alloc(alloc, 8192 + i);
+        ABTS_PTR_NOTNULL(tc, nodes[i]);
+        memset(nodes[i]->first_avail, i, nodes[i]->endp - nodes[i]->first_avail);
+        if (i) {
+            ABTS_ASSERT(tc, "nodes not carved in turn",
+                        (char *)nodes[i] == nodes[i - 1]->endp);
+        }
+    }
+    apr_allocator_stats_get(alloc, &stats);
+    ABTS_INT_EQUAL(tc, 1, stats.regions);
+    ABTS_ASSERT(tc, "region not 4MB", stats.system_bytes == 4 * 1024 * 1024);
+    ABTS_ASSERT(tc, "nodes not accounted for",
+                stats.node_bytes == 100 * 12288);
+    ABTS_INT_EQUAL(tc, 0, stats.free_nodes);
+
+    /* a node larger than a region gets one of its own */
+    big = apr_allocator_alloc(alloc, 5 * 1024 * 1024);
+    ABTS_PTR_NOTNULL(tc, big);
+    memset(big->first_avail, 0, big->endp - big->first_avail);
+    apr_allocator_stats_get(alloc, &stats);
+    ABTS_INT_EQUAL(tc, 2, stats.regions);
+
+    /* freed nodes are reused, never given back one by one */
+    apr_allocator_max_free_set(alloc, 8192);
+    for (i = 0; i < 100; i += 2) {
+        nodes[i]->next = NULL;
+        apr_allocator_free(alloc, nodes[i]);
+    }
+    apr_allocator_stats_get(alloc, &stats);
+    ABTS_INT_EQUAL(tc, 50, stats.free_nodes);
+    ABTS_ASSERT(tc, "fragmentation not seen",
+                stats.free_bytes == 50 * 12288);
+    ABTS_PTR_EQUAL(tc, nodes[98], apr_allocator_alloc(alloc, 8192));
+
+    /* pools work on top of it */
+    rv = apr_pool_create_ex(&pool, NULL, NULL, alloc);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    apr_allocator_owner_set(alloc, pool);
+    for (i = 0; i < 1000; i++) {
+        mem = apr_palloc(pool, ALLOC_BYTES);
+        ABTS_PTR_NOTNULL(tc, mem);
+        memset(mem, 0, ALLOC_BYTES);
+    }
+    apr_allocator_stats_get(alloc, &stats);
+    ABTS_ASSERT(tc, "pool memory not carved out of regions",
+                stats.system_bytes >= stats.node_bytes
+                && stats.node_bytes - stats.free_bytes > 1000 * ALLOC_BYTES);
+    apr_pool_destroy(pool);
+}
+
+static int walk_count(apr_pool_t *pool, int depth,
+                      const apr_pool_stats_t *stats, void *data)
+{
+    int *depths = data;
+
+    depths[depth]++;
+    return 0;
+}
+
+static void pool_stats(abts_case *tc, void *data)
+{
+    apr_allocator_t *alloc;
+    apr_allocator_stats_t astats;
+    apr_pool_t *pool, *child;
+    apr_pool_stats_t stats;
+    int i, depths[3] = { 0, 0, 0 };
+    char *summary;
+
+    apr_allocator_create(&alloc);
+    apr_pool_create_ex(&pool, NULL, NULL, alloc);
+    apr_allocator_owner_set(alloc, pool);
+    apr_pool_tag(pool, "stats");
+
+    apr_pool_stats_get(pool, &stats);
+    ABTS_INT_EQUAL(tc, 1, stats.nodes);
+    ABTS_INT_EQUAL(tc, 1, stats.node_allocs);
+    ABTS_INT_EQUAL(tc, 0, stats.children);
+
+    for (i = 0; i < 100; i++) {
+        apr_palloc(pool, 1000);
+        apr_pool_cleanup_register(pool, NULL, apr_pool_cleanup_null,
+                                  apr_pool_cleanup_null);
+    }
+    apr_pool_stats_get(pool, &stats);
+    ABTS_ASSERT(tc, "no node taken", stats.node_allocs > 1);
+    ABTS_INT_EQUAL(tc, stats.node_allocs, stats.nodes);
+    ABTS_ASSERT(tc, "allocations not seen", stats.bytes_used >= 100 * 1000);
+    ABTS_ASSERT(tc, "held less than used",
+                stats.bytes_held > stats.bytes_used);
+    ABTS_ASSERT(tc, "high-water mark off",
+                stats.bytes_high == stats.bytes_held);
+
+    apr_pool_clear(pool);
+    apr_pool_stats_get(pool, &stats);
+    ABTS_INT_EQUAL(tc, 1, stats.clears);
+    ABTS_INT_EQUAL(tc, 100, stats.cleanups_run);
+    ABTS_INT_EQUAL(tc, 1, stats.nodes);
+    ABTS_ASSERT(tc, "high-water mark lost", stats.bytes_high > 100 * 1000);
+
+    /* the nodes freed by the clear get reused */
+    for (i = 0; i < 100; i++)
+        apr_palloc(pool, 1000);
+    apr_allocator_stats_get(alloc, &astats);
+    ABTS_ASSERT(tc, "no node reused", astats.nodes_reused > 0);
+
+    apr_pool_create(&child, pool);
+    apr_pool_tag(child, "child");
+    apr_palloc(child, 100000);
+    apr_pool_stats_get(pool, &stats);
+    ABTS_INT_EQUAL(tc, 1, stats.children);
+
+    apr_pool_walk(pool, walk_count, depths);
+    ABTS_INT_EQUAL(tc, 1, depths[0]);
+    ABTS_INT_EQUAL(tc, 1, depths[1]);
+    ABTS_INT_EQUAL(tc, 0, depths[2]);
+
+    summary = apr_pool_summary(pool, 0, p);
+    ABTS_ASSERT(tc, "pool missing from summary",
+                strncmp(summary, "stats [", 7) == 0);
+    ABTS_ASSERT(tc, "subpool missing from summary",
+                strstr(summary, "\n  child [") != NULL);
+    summary = apr_pool_summary(pool, 100000, p);
+    ABTS_ASSERT(tc, "big subpool missing from summary",
+                strstr(summary, "\n  child [") != NULL);
+    summary = apr_pool_summary(pool, 1024 * 1024 * 1024, p);
+    ABTS_STR_EQUAL(tc, "", summary);
+
+    apr_pool_destroy(pool);
+}
+
+static void pool_small_objects(abts_case *tc, void *data)
+{
+    apr_pool_t *pool;
+    apr_pool_stats_t stats;
+    char *a, *b, *c, *big;
+    apr_size_t used;
+    int i;
+
+    apr_pool_create(&pool, p);
+
+    a = apr_pool_alloc_small(pool, 24);
+    b = apr_pool_alloc_small(pool, 24);
+    ABTS_PTR_NOTNULL(tc, a);
+    ABTS_ASSERT(tc, "objects overlap", b >= a + 24 || a >= b + 24);
+    memset(a, 'a', 24);
+    memset(b, 'b', 24);
+
+    big = apr_pool_alloc_small(pool, APR_POOL_SMALL_MAX + 1);
+    memset(big, 'x', APR_POOL_SMALL_MAX + 1);
+    apr_pool_free_small(pool, big, APR_POOL_SMALL_MAX + 1);
+    apr_pool_free_small(pool, NULL, 8);
+
+    apr_pool_free_small(pool, a, 24);
+    apr_pool_free_small(pool, b, 24);
+#if !APR_POOL_DEBUG
+    /* the last freed comes back first, from any size in its class */
+    c = apr_pool_alloc_small(pool, 17);
+    ABTS_PTR_EQUAL(tc, b, c);
+    c = apr_pool_alloc_small(pool, 24);
+    ABTS_PTR_EQUAL(tc, a, c);
+#endif
+    c = apr_pool_alloc_small(pool, 24);
+    ABTS_ASSERT(tc, "live object handed out", c != a && c != b);
+
+    /* churning one size does not grow the pool */
+    apr_pool_stats_get(pool, &stats);
+    used = stats.bytes_used;
+    for (i = 0; i < 10000; i++) {
+        a = apr_pool_alloc_small(pool, 100);
+        memset(a, 0, 100);
+        apr_pool_free_small(pool, a, 100);
+    }
+    apr_pool_stats_get(pool, &stats);
+#if !APR_POOL_DEBUG
+    ABTS_ASSERT(tc, "churn grew the pool", stats.bytes_used <= used + 104
+                                           + APR_POOL_SMALL_MAX);
+#endif
+
+    /* the free lists go away with the memory on clear */
+    apr_pool_clear(pool);
+    a = apr_pool_alloc_small(pool, 0);
+    ABTS_PTR_NOTNULL(tc, a);
+    apr_pool_free_small(pool, a, 0);
+    b = apr_pool_alloc_small(pool, 8);
+#if !APR_POOL_DEBUG
+    ABTS_PTR_EQUAL(tc, a, b);
+#endif
+
+    apr_pool_destroy(pool);
+}
+
+#define CHURN_ROUNDS 100000
+#define CHURN_OBJECTS 64
+
+static void pool_small_churn(abts_case *tc, void *data)
+{
+    apr_pool_t *pool;
+    apr_pool_stats_t stats;
+    void *live[CHURN_OBJECTS];
+    int i;
+
+    apr_pool_create(&pool, p);
+
+    /* a long-lived pool recycling a working set of objects */
+    memset(live, 0, sizeof(live));
+    for (i = 0; i < CHURN_ROUNDS; i++) {
+        apr_pool_free_small(pool, live[i % CHURN_OBJECTS], 48);
+        live[i % CHURN_OBJECTS] = apr_pool_alloc_small(pool, 48);
+        ABTS_PTR_NOTNULL(tc, live[i % CHURN_OBJECTS]);
+    }
+
+    apr_pool_stats_get(pool, &stats);
+#if !APR_POOL_DEBUG
+    ABTS_ASSERT(tc, "recycled objects not reused",
+                stats.bytes_used < 2 * CHURN_OBJECTS * 48
+                                   + APR_POOL_SMALL_MAX + 1024);
+#endif
+
+    apr_pool_destroy(pool);
+}
+
 abts_suite *testpool(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -150,6 +418,11 @@ abts_suite *testpool(abts_suite *suite)
     abts_run_test(suite, alloc_bytes, NULL);
     abts_run_test(suite, calloc_bytes, NULL);
     abts_run_test(suite, test_cleanups, NULL);
+    abts_run_test(suite, allocator_stats, NULL);
+    abts_run_test(suite, allocator_regions, NULL);
+    abts_run_test(suite, pool_stats, NULL);
+    abts_run_test(suite, pool_small_objects, NULL);
+    abts_run_test(suite, pool_small_churn, NULL);
 
     return suite;
 }
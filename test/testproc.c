@@ -51,6 +51,9 @@ static void test_create_proc(abts_case *tc, void *data)
     rv = apr_procattr_cmdtype_set(attr, APR_PROGRAM_ENV);
     ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
 
+    rv = apr_procattr_spawn_set(attr, data != NULL);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
     args[0] = "proc_child" EXTENSION;
     args[1] = NULL;
     
@@ -160,6 +163,83 @@ static void test_file_redir(abts_case *tc, void *data)
     ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
 }
 
+#ifndef WIN32
+static void test_spawn_eof(abts_case *tc, void *data)
+{
+    const char *args[2];
+    apr_procattr_t *attr;
+    apr_proc_t proc;
+    apr_status_t rv;
+    apr_size_t length;
+    char buf[256];
+    int exitcode;
+    apr_exit_why_e why;
+
+    rv = apr_procattr_create(&attr, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_procattr_io_set(attr, APR_FULL_BLOCK, APR_FULL_BLOCK,
+                             APR_NO_PIPE);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_procattr_cmdtype_set(attr, APR_SHELLCMD_ENV);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_procattr_spawn_set(attr, 1);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    args[0] = "cat";
+    args[1] = NULL;
+    rv = apr_proc_create(&proc, "cat", args, NULL, attr, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+
+    length = strlen(TESTSTR);
+    rv = apr_file_write_full(proc.in, TESTSTR, length, NULL);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    /* the child only sees EOF if it holds no copy of the write end */
+    apr_file_close(proc.in);
+
+    rv = apr_file_read_full(proc.out, buf, sizeof(buf), &length);
+    ABTS_INT_EQUAL(tc, APR_EOF, rv);
+    ABTS_SIZE_EQUAL(tc, strlen(TESTSTR), length);
+    buf[length] = '\0';
+    ABTS_STR_EQUAL(tc, TESTSTR, buf);
+
+    rv = apr_proc_wait(&proc, &exitcode, &why, APR_WAIT);
+    ABTS_INT_EQUAL(tc, APR_CHILD_DONE, rv);
+    ABTS_INT_EQUAL(tc, APR_PROC_EXIT, why);
+    ABTS_INT_EQUAL(tc, 0, exitcode);
+}
+
+static void test_spawn_fallback(abts_case *tc, void *data)
+{
+    const char *args[2];
+    apr_procattr_t *attr;
+    apr_proc_t proc;
+    apr_status_t rv;
+    int exitcode;
+    apr_exit_why_e why;
+
+    rv = apr_procattr_create(&attr, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_procattr_spawn_set(attr, 1);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    /* a failed exec is still the child's to report, as with fork() */
+    args[0] = "no-such-program";
+    args[1] = NULL;
+    rv = apr_proc_create(&proc, "/no/such/program", args, NULL, attr, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    if (rv != APR_SUCCESS)
+        return;
+
+    rv = apr_proc_wait(&proc, &exitcode, &why, APR_WAIT);
+    ABTS_INT_EQUAL(tc, APR_CHILD_DONE, rv);
+    ABTS_INT_EQUAL(tc, APR_PROC_EXIT, why);
+    ABTS_INT_EQUAL(tc, 255, exitcode);
+}
+#endif
+
 abts_suite *testproc(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -168,6 +248,12 @@ abts_suite *testproc(abts_suite *suite)
     abts_run_test(suite, test_create_proc, NULL);
     abts_run_test(suite, test_proc_wait, NULL);
     abts_run_test(suite, test_file_redir, NULL);
+    abts_run_test(suite, test_create_proc, (void *)1);
+    abts_run_test(suite, test_proc_wait, NULL);
+#ifndef WIN32
+    abts_run_test(suite, test_spawn_eof, NULL);
+    abts_run_test(suite, test_spawn_fallback, NULL);
+#endif
 
     return suite;
 }
@@ -0,0 +1,138 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "apr_sha1.h"
+#include "apr_general.h"
+
+#include "abts.h"
+#include "testutil.h"
+
+static struct {
+    const char *string;
+    const char *digest;
+} sha1sums[] =
+{
+    {"",
+     "\xda\x39\xa3\xee\x5e\x6b\x4b\x0d\x32\x55"
+     "\xbf\xef\x95\x60\x18\x90\xaf\xd8\x07\x09"},
+    {"abc",
+     "\xa9\x99\x3e\x36\x47\x06\x81\x6a\xba\x3e"
+     "\x25\x71\x78\x50\xc2\x6c\x9c\xd0\xd8\x9d"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+     "\x84\x98\x3e\x44\x1c\x3b\xd2\x6e\xba\xae"
+     "\x4a\xa1\xf9\x51\x29\xe5\xe5\x46\x70\xf1"},
+    {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+     "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+     "\xa4\x9b\x24\x46\xa0\x2c\x64\x5b\xf4\x19"
+     "\xf9\x95\xb6\x70\x91\x25\x3a\x04\xa2\x59"}
+};
+
+static int num_sums = sizeof(sha1sums) / sizeof(sha1sums[0]);
+
+static void test_sha1sum(abts_case *tc, void *data)
+{
+    unsigned char digest[APR_SHA1_DIGESTSIZE];
+    apr_sha1_ctx_t context;
+    int i;
+
+    for (i = 0; i < num_sums; i++) {
+        apr_sha1_init(&context);
+        apr_sha1_update(&context, sha1sums[i].string,
+                        strlen(sha1sums[i].string));
+        apr_sha1_final(digest, &context);
+        ABTS_ASSERT(tc, "check for correct sha1 digest",
+                    memcmp(digest, sha1sums[i].digest,
+                           APR_SHA1_DIGESTSIZE) == 0);
+    }
+}
+
+static void test_sha1_million(abts_case *tc, void *data)
+{
+    const unsigned char expected[] =
+        "\x34\xaa\x97\x3c\xd4\xc4\xda\xa4\xf6\x1e"
+        "\xeb\x2b\xdb\xad\x27\x31\x65\x34\x01\x6f";
+    unsigned char digest[APR_SHA1_DIGESTSIZE];
+    unsigned char chunk[1000];
+    apr_sha1_ctx_t context;
+    int i;
+
+    memset(chunk, 'a', sizeof(chunk));
+    apr_sha1_init(&context);
+    for (i = 0; i < 1000; i++) {
+        /* odd split to exercise the partial block paths */
+        apr_sha1_update_binary(&context, chunk, 333);
+        apr_sha1_update_binary(&context, chunk, 667);
+    }
+    apr_sha1_final(digest, &context);
+    ABTS_ASSERT(tc, "sha1 of a million 'a'",
+                memcmp(digest, expected, APR_SHA1_DIGESTSIZE) == 0);
+}
+
+#define NUM_MSGS 19
+
+static void test_sha1_multi(abts_case *tc, void *data)
+{
+    static unsigned char buf[NUM_MSGS * 1024];
+    unsigned char digests[NUM_MSGS][APR_SHA1_DIGESTSIZE];
+    unsigned char digest[APR_SHA1_DIGESTSIZE];
+    unsigned char *outs[NUM_MSGS];
+    const unsigned char *ins[NUM_MSGS];
+    apr_size_t lens[NUM_MSGS];
+    apr_sha1_ctx_t context;
+    int i, n;
+
+    srand(29);
+    for (i = 0; i < sizeof(buf); i++) {
+        buf[i] = rand() & 0xff;
+    }
+
+    /* lengths around the padding boundaries and messages that finish at
+     * very different times
+     */
+    for (n = 1; n <= NUM_MSGS; n++) {
+        for (i = 0; i < n; i++) {
+            ins[i] = buf + i * 1024;
+            lens[i] = (i * 37 + n * 11) % 130;
+            if (i % 5 == 4) {
+                lens[i] += 700;
+            }
+            outs[i] = digests[i];
+        }
+        apr_sha1_multi(outs, ins, lens, n);
+
+        for (i = 0; i < n; i++) {
+            apr_sha1_init(&context);
+            apr_sha1_update_binary(&context, ins[i], (unsigned int)lens[i]);
+            apr_sha1_final(digest, &context);
+            ABTS_ASSERT(tc, "apr_sha1_multi matches apr_sha1_final",
+                        memcmp(digest, digests[i], APR_SHA1_DIGESTSIZE) == 0);
+        }
+    }
+}
+
+abts_suite *testsha1(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite);
+
+    abts_run_test(suite, test_sha1sum, NULL);
+    abts_run_test(suite, test_sha1_million, NULL);
+    abts_run_test(suite, test_sha1_multi, NULL);
+
+    return suite;
+}
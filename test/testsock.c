@@ -23,6 +23,8 @@
 #include "apr_lib.h"
 #include "apr_strings.h"
 #include "apr_poll.h"
+#include "apr_thread_pool.h"
+#include "apr_thread_cond.h"
 
 #define UNIX_SOCKET_NAME    "/tmp/apr-socket"
 #define IPV4_SOCKET_NAME    "127.0.0.1"
@@ -496,6 +498,259 @@ static void test_wait(abts_case *tc, void *data)
     APR_ASSERT_SUCCESS(tc, "couldn't close server socket", rv);
 }
 
+static void connect_clients(abts_case *tc, apr_socket_t *server, int n)
+{
+    apr_status_t rv;
+    apr_sockaddr_t *sa;
+    apr_socket_t *client;
+    int i;
+
+    rv = apr_socket_addr_get(&sa, APR_LOCAL, server);
+    APR_ASSERT_SUCCESS(tc, "Problem getting listener address", rv);
+
+    for (i = 0; i < n; i++) {
+        rv = apr_socket_create(&client, sa->family, SOCK_STREAM,
+                               APR_PROTO_TCP, p);
+        APR_ASSERT_SUCCESS(tc, "Problem creating client socket", rv);
+        rv = apr_socket_connect(client, sa);
+        APR_ASSERT_SUCCESS(tc, "Problem connecting client", rv);
+    }
+}
+
+static void test_accept_batch(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_socket_t *server;
+    apr_socket_t *accepted[4];
+    apr_pool_t *pools[4];
+    apr_sockaddr_t *sa;
+    apr_interval_time_t timeout;
+    apr_int32_t on;
+    char *ip;
+    int i, n;
+
+    rv = apr_sockaddr_info_get(&sa, "127.0.0.1", APR_INET, 0, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Problem generating sockaddr", rv);
+    rv = apr_socket_create(&server, sa->family, SOCK_STREAM, APR_PROTO_TCP, p);
+    APR_ASSERT_SUCCESS(tc, "Problem creating socket", rv);
+    rv = apr_socket_bind(server, sa);
+    APR_ASSERT_SUCCESS(tc, "Problem binding to port", rv);
+    rv = apr_socket_listen(server, 8);
+    APR_ASSERT_SUCCESS(tc, "Problem listening on socket", rv);
+
+    for (i = 0; i < 4; i++) {
+        pools[i] = p;
+    }
+    connect_clients(tc, server, 3);
+
+    /* a blocking listener only blocks for the first connection */
+    rv = apr_socket_accept_batch(accepted, server, pools, 2, &n);
+    APR_ASSERT_SUCCESS(tc, "Problem accepting a batch", rv);
+    ABTS_INT_EQUAL(tc, 2, n);
+
+    rv = apr_socket_accept_batch(accepted, server, pools, 4, &n);
+    APR_ASSERT_SUCCESS(tc, "Problem accepting a batch", rv);
+    ABTS_INT_EQUAL(tc, 1, n);
+
+    /* the listener is left blocking */
+    apr_socket_timeout_get(server, &timeout);
+    ABTS_ASSERT(tc, "listener timeout changed", timeout < 0);
+    rv = apr_socket_opt_get(server, APR_SO_NONBLOCK, &on);
+    APR_ASSERT_SUCCESS(tc, "Problem getting the listener options", rv);
+    ABTS_INT_EQUAL(tc, 0, on);
+
+    rv = apr_socket_addr_get(&sa, APR_REMOTE, accepted[0]);
+    APR_ASSERT_SUCCESS(tc, "Problem getting peer address", rv);
+    rv = apr_sockaddr_ip_get(&ip, sa);
+    APR_ASSERT_SUCCESS(tc, "Problem getting peer IP", rv);
+    ABTS_STR_EQUAL(tc, "127.0.0.1", ip);
+
+    rv = apr_socket_timeout_set(server, 0);
+    APR_ASSERT_SUCCESS(tc, "Problem making the listener non-blocking", rv);
+    rv = apr_socket_accept_batch(accepted, server, pools, 4, &n);
+    ABTS_INT_EQUAL(tc, 1, APR_STATUS_IS_EAGAIN(rv));
+    ABTS_INT_EQUAL(tc, 0, n);
+
+    apr_socket_close(server);
+}
+
+static void test_listen_group(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_socket_t *group[2];
+    apr_socket_t *accepted[8];
+    apr_pool_t *pools[8];
+    apr_sockaddr_t *sa, *sa0, *sa1;
+    int i, n, total;
+
+    rv = apr_sockaddr_info_get(&sa, "127.0.0.1", APR_INET, 0, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Problem generating sockaddr", rv);
+
+    rv = apr_socket_listen_group_create(group, 2, sa, SOCK_STREAM,
+                                        APR_PROTO_TCP, 8, 0, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "SO_REUSEPORT");
+        return;
+    }
+    APR_ASSERT_SUCCESS(tc, "Problem creating listener group", rv);
+
+    apr_socket_addr_get(&sa0, APR_LOCAL, group[0]);
+    apr_socket_addr_get(&sa1, APR_LOCAL, group[1]);
+    ABTS_ASSERT(tc, "group was given an ephemeral port", sa0->port != 0);
+    ABTS_INT_EQUAL(tc, sa0->port, sa1->port);
+
+    for (i = 0; i < 8; i++) {
+        pools[i] = p;
+    }
+    connect_clients(tc, group[0], 6);
+
+    /* the kernel decides which listener queues each connection */
+    total = 0;
+    for (i = 0; i < 2; i++) {
+        apr_socket_timeout_set(group[i], 0);
+        rv = apr_socket_accept_batch(accepted, group[i], pools, 8, &n);
+        if (rv != APR_SUCCESS) {
+            ABTS_INT_EQUAL(tc, 1, APR_STATUS_IS_EAGAIN(rv));
+        }
+        total += n;
+    }
+    ABTS_INT_EQUAL(tc, 6, total);
+
+    apr_socket_close(group[0]);
+    apr_socket_close(group[1]);
+
+    rv = apr_socket_listen_group_create(group, 2, sa, SOCK_STREAM,
+                                        APR_PROTO_TCP, 8,
+                                        APR_LISTEN_GROUP_STEER_CPU, p);
+    if (rv != APR_ENOTIMPL) {
+        APR_ASSERT_SUCCESS(tc, "Problem creating steered listener group", rv);
+        apr_socket_close(group[0]);
+        apr_socket_close(group[1]);
+    }
+}
+
+static void test_addr_cache(abts_case *tc, void *data)
+{
+    apr_status_t rv, rv2;
+    apr_sockaddr_t *sa;
+    apr_size_t hits, misses;
+
+    rv = apr_sockaddr_cache_set(apr_time_from_sec(60), apr_time_from_sec(60),
+                                16);
+    APR_ASSERT_SUCCESS(tc, "Problem enabling the resolver cache", rv);
+
+    rv = apr_sockaddr_info_get(&sa, "localhost", APR_INET, 80, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Problem resolving localhost", rv);
+    ABTS_INT_EQUAL(tc, 80, sa->port);
+
+    /* the port is not part of what is cached */
+    rv = apr_sockaddr_info_get(&sa, "localhost", APR_INET, 8021, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Problem resolving localhost", rv);
+    ABTS_STR_EQUAL(tc, "localhost", sa->hostname);
+    ABTS_INT_EQUAL(tc, 8021, sa->port);
+    ABTS_INT_EQUAL(tc, 8021, ntohs(sa->sa.sin.sin_port));
+    ABTS_INT_EQUAL(tc, APR_INET, sa->family);
+
+    rv = apr_sockaddr_info_get(&sa, "localhost", APR_INET, 0, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Problem resolving localhost", rv);
+    ABTS_INT_EQUAL(tc, 0, sa->port);
+    ABTS_INT_EQUAL(tc, 0, ntohs(sa->sa.sin.sin_port));
+
+    apr_sockaddr_cache_stats(&hits, &misses);
+    ABTS_INT_EQUAL(tc, 2, (int)hits);
+    ABTS_INT_EQUAL(tc, 1, (int)misses);
+
+    /* an IPv6 literal can never be an IPv4 address */
+    rv = apr_sockaddr_info_get(&sa, "::1", APR_INET, 80, 0, p);
+    ABTS_ASSERT(tc, "IPv6 literal resolved as IPv4", rv != APR_SUCCESS);
+    rv2 = apr_sockaddr_info_get(&sa, "::1", APR_INET, 80, 0, p);
+    ABTS_INT_EQUAL(tc, rv, rv2);
+    apr_sockaddr_cache_stats(&hits, &misses);
+    ABTS_INT_EQUAL(tc, 3, (int)hits);
+    ABTS_INT_EQUAL(tc, 2, (int)misses);
+
+    apr_sockaddr_cache_flush();
+    rv = apr_sockaddr_info_get(&sa, "localhost", APR_INET, 80, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Problem resolving localhost", rv);
+    apr_sockaddr_cache_stats(&hits, &misses);
+    ABTS_INT_EQUAL(tc, 3, (int)misses);
+
+    /* entries expire */
+    rv = apr_sockaddr_cache_set(apr_time_from_msec(50), 0, 16);
+    APR_ASSERT_SUCCESS(tc, "Problem enabling the resolver cache", rv);
+    rv = apr_sockaddr_info_get(&sa, "localhost", APR_INET, 80, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Problem resolving localhost", rv);
+    apr_sleep(apr_time_from_msec(100));
+    rv = apr_sockaddr_info_get(&sa, "localhost", APR_INET, 80, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Problem resolving localhost", rv);
+    apr_sockaddr_cache_stats(&hits, &misses);
+    ABTS_INT_EQUAL(tc, 0, (int)hits);
+    ABTS_INT_EQUAL(tc, 2, (int)misses);
+
+    rv = apr_sockaddr_cache_set(0, 0, 0);
+    APR_ASSERT_SUCCESS(tc, "Problem disabling the resolver cache", rv);
+}
+
+#if APR_HAS_THREADS
+
+typedef struct {
+    apr_thread_mutex_t *lock;
+    apr_thread_cond_t *cond;
+    apr_status_t status;
+    apr_port_t port;
+    int done;
+} async_lookup_t;
+
+static void addr_info_done(void *baton, apr_status_t status,
+                           apr_sockaddr_t *sa)
+{
+    async_lookup_t *lookup = baton;
+
+    apr_thread_mutex_lock(lookup->lock);
+    lookup->status = status;
+    lookup->port = sa ? sa->port : 0;
+    lookup->done = 1;
+    apr_thread_cond_signal(lookup->cond);
+    apr_thread_mutex_unlock(lookup->lock);
+}
+
+static void test_addr_info_async(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_thread_pool_t *tp;
+    apr_allocator_t *allocator;
+    apr_pool_t *subp;
+    async_lookup_t lookup = { 0 };
+
+    rv = apr_thread_pool_create(&tp, 1, 1, p);
+    APR_ASSERT_SUCCESS(tc, "Problem creating thread pool", rv);
+    apr_thread_mutex_create(&lookup.lock, APR_THREAD_MUTEX_DEFAULT, p);
+    apr_thread_cond_create(&lookup.cond, p);
+
+    /* the lookup allocates from its pool on the other thread */
+    apr_allocator_create(&allocator);
+    apr_pool_create_ex(&subp, p, NULL, allocator);
+    apr_allocator_owner_set(allocator, subp);
+
+    rv = apr_sockaddr_info_get_async(tp, "127.0.0.1", APR_INET, 8021, 0,
+                                     addr_info_done, &lookup, subp);
+    APR_ASSERT_SUCCESS(tc, "Problem queueing lookup", rv);
+
+    apr_thread_mutex_lock(lookup.lock);
+    while (!lookup.done) {
+        apr_thread_cond_wait(lookup.cond, lookup.lock);
+    }
+    apr_thread_mutex_unlock(lookup.lock);
+
+    APR_ASSERT_SUCCESS(tc, "Problem resolving 127.0.0.1", lookup.status);
+    ABTS_INT_EQUAL(tc, 8021, lookup.port);
+
+    apr_thread_pool_destroy(tp);
+    apr_pool_destroy(subp);
+}
+
+#endif /* APR_HAS_THREADS */
+
 abts_suite *testsock(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -510,6 +765,12 @@ abts_suite *testsock(abts_suite *suite)
     abts_run_test(suite, test_print_addr, NULL);
     abts_run_test(suite, test_get_addr, NULL);
     abts_run_test(suite, test_wait, NULL);
+    abts_run_test(suite, test_accept_batch, NULL);
+    abts_run_test(suite, test_listen_group, NULL);
+    abts_run_test(suite, test_addr_cache, NULL);
+#if APR_HAS_THREADS
+    abts_run_test(suite, test_addr_info_async, NULL);
+#endif
 #if APR_HAVE_SOCKADDR_UN
     socket_name = UNIX_SOCKET_NAME;
     socket_type = APR_UNIX;
@@ -190,6 +190,87 @@ static void sendto_receivefrom6(abts_case *tc, void *data)
 }
 #endif
 
+static void sendmmsg_recvmmsg(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    apr_socket_t *sock, *sock2;
+    apr_sockaddr_t *to, *from, *other;
+    apr_sockaddr_t peers[16];
+    apr_socket_msg_t out[8], in[16];
+    char sendbuf[8][128], recvbuf[16][256];
+    char *ip_addr;
+    int i, n;
+
+    rv = apr_socket_create(&sock, APR_INET, SOCK_DGRAM, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Could not create socket", rv);
+    rv = apr_socket_create(&sock2, APR_INET, SOCK_DGRAM, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Could not create second socket", rv);
+
+    rv = apr_sockaddr_info_get(&to, "127.0.0.1", APR_INET, 7774, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Could not get address", rv);
+    rv = apr_sockaddr_info_get(&from, "127.0.0.1", APR_INET, 7773, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Could not get address", rv);
+    /* the same destination, in a separate apr_sockaddr_t */
+    rv = apr_sockaddr_info_get(&other, "127.0.0.1", APR_INET, 7774, 0, p);
+    APR_ASSERT_SUCCESS(tc, "Could not get address", rv);
+
+    apr_socket_opt_set(sock, APR_SO_REUSEADDR, 1);
+    apr_socket_opt_set(sock2, APR_SO_REUSEADDR, 1);
+    rv = apr_socket_bind(sock, to);
+    APR_ASSERT_SUCCESS(tc, "Could not bind socket", rv);
+    rv = apr_socket_bind(sock2, from);
+    APR_ASSERT_SUCCESS(tc, "Could not bind second socket", rv);
+
+    /* five equal datagrams and a short one, which may be sent as one
+     * segmented datagram, then two more of other sizes */
+    for (i = 0; i < 8; i++) {
+        memset(sendbuf[i], 'a' + i, sizeof(sendbuf[i]));
+        out[i].addr = i % 2 ? other : to;
+        out[i].buf = sendbuf[i];
+        out[i].len = i < 5 ? 100 : i == 5 ? 40 : 120 + i;
+    }
+    rv = apr_socket_sendmmsg(sock2, out, 8, 0, &n);
+    APR_ASSERT_SUCCESS(tc, "Could not send datagrams", rv);
+    ABTS_INT_EQUAL(tc, 8, n);
+
+    memset(peers, 0, sizeof(peers));
+    for (i = 0; i < 16; i++) {
+        peers[i].pool = p;
+        in[i].addr = &peers[i];
+        in[i].buf = recvbuf[i];
+        in[i].len = sizeof(recvbuf[i]);
+    }
+    n = 0;
+    while (n < 8) {
+        int got;
+
+        rv = apr_socket_recvmmsg(sock, in + n, 16 - n, 0, &got);
+        APR_ASSERT_SUCCESS(tc, "Could not receive datagrams", rv);
+        if (rv != APR_SUCCESS)
+            break;
+        n += got;
+    }
+    ABTS_INT_EQUAL(tc, 8, n);
+
+    for (i = 0; i < n; i++) {
+        ABTS_SIZE_EQUAL(tc, out[i].len, in[i].len);
+        ABTS_INT_EQUAL(tc, 'a' + i, recvbuf[i][0]);
+        ABTS_INT_EQUAL(tc, 'a' + i, recvbuf[i][in[i].len - 1]);
+        apr_sockaddr_ip_get(&ip_addr, in[i].addr);
+        ABTS_STR_EQUAL(tc, "127.0.0.1", ip_addr);
+        ABTS_INT_EQUAL(tc, 7773, in[i].addr->port);
+    }
+
+    /* nothing is left, and a non-blocking socket says so */
+    apr_socket_timeout_set(sock, 0);
+    rv = apr_socket_recvmmsg(sock, in, 16, 0, &n);
+    ABTS_INT_EQUAL(tc, 1, APR_STATUS_IS_EAGAIN(rv));
+    ABTS_INT_EQUAL(tc, 0, n);
+
+    apr_socket_close(sock);
+    apr_socket_close(sock2);
+}
+
 static void socket_userdata(abts_case *tc, void *data)
 {
     apr_socket_t *sock1, *sock2;
@@ -223,6 +304,7 @@ abts_suite *testsockets(abts_suite *suite)
     abts_run_test(suite, udp_socket, NULL);
 
     abts_run_test(suite, sendto_receivefrom, NULL);
+    abts_run_test(suite, sendmmsg_recvmmsg, NULL);
 
 #if APR_HAVE_IPV6
     abts_run_test(suite, tcp6_socket, NULL);
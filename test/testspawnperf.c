@@ -0,0 +1,98 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apr.h"
+#include "apr_thread_proc.h"
+#include "apr_time.h"
+#include "apr_general.h"
+#include "apr_errno.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPAWNS     500
+#define CHILD      "/bin/true"
+
+static void fail(const char *what, apr_status_t rv)
+{
+    char msg[256];
+
+    fprintf(stderr, "%s: %s\n", what, apr_strerror(rv, msg, sizeof(msg)));
+    exit(-1);
+}
+
+static void bench(apr_pool_t *pool, const char *what, int spawn)
+{
+    const char *args[2] = { CHILD, NULL };
+    apr_procattr_t *attr;
+    apr_proc_t proc;
+    apr_time_t start, elapsed;
+    apr_status_t rv;
+    int i;
+
+    if ((rv = apr_procattr_create(&attr, pool)) != APR_SUCCESS)
+        fail("apr_procattr_create", rv);
+    apr_procattr_io_set(attr, APR_NO_PIPE, APR_FULL_BLOCK, APR_NO_PIPE);
+    apr_procattr_spawn_set(attr, spawn);
+
+    start = apr_time_now();
+    for (i = 0; i < SPAWNS; i++) {
+        if ((rv = apr_proc_create(&proc, CHILD, args, NULL, attr, pool))
+                != APR_SUCCESS)
+            fail("apr_proc_create", rv);
+        if ((rv = apr_proc_wait(&proc, NULL, NULL, APR_WAIT))
+                != APR_CHILD_DONE)
+            fail("apr_proc_wait", rv);
+        /* the pipe for the next child */
+        apr_file_close(proc.out);
+        apr_procattr_io_set(attr, APR_NO_PIPE, APR_FULL_BLOCK, APR_NO_PIPE);
+    }
+    elapsed = apr_time_now() - start;
+
+    printf("%-32s %8.0f spawns/sec %8.1f usec/spawn\n", what,
+           (double)SPAWNS * APR_USEC_PER_SEC / elapsed,
+           (double)elapsed / SPAWNS);
+}
+
+int main(int argc, const char * const *argv)
+{
+    apr_pool_t *pool;
+    apr_size_t mb = argc > 1 ? atoi(argv[1]) : 512;
+    char *heap;
+
+    printf("APR Process Creation Performance Test\n"
+           "=====================================\n\n");
+
+    apr_initialize();
+    atexit(apr_terminate);
+    apr_pool_create(&pool, NULL);
+
+    /* a large resident parent makes fork() copy more page tables */
+    heap = malloc(mb * 1024 * 1024);
+    if (heap == NULL) {
+        fprintf(stderr, "cannot allocate %" APR_SIZE_T_FMT " MB\n", mb);
+        return -1;
+    }
+    memset(heap, 1, mb * 1024 * 1024);
+    printf("%d children of a %" APR_SIZE_T_FMT " MB parent\n\n", SPAWNS, mb);
+
+    bench(pool, "fork", 0);
+    bench(pool, "posix_spawn", 1);
+
+    free(heap);
+    apr_pool_destroy(pool);
+    return 0;
+}
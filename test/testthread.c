@@ -18,6 +18,7 @@
 #include "apr_errno.h"
 #include "apr_general.h"
 #include "apr_time.h"
+#include "apr_thread_pool.h"
 #include "testutil.h"
 
 #if APR_HAS_THREADS
@@ -104,6 +105,144 @@ static void check_thread_once(abts_case *tc, void *data)
     ABTS_INT_EQUAL(tc, 1, value);
 }
 
+static void check_cpu_topology(abts_case *tc, void *data)
+{
+    apr_cpu_topology_t *topo;
+    apr_status_t rv;
+    int i;
+
+    rv = apr_cpu_topology_get(&topo, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "CPU topology not available");
+        return;
+    }
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_ASSERT(tc, "no online CPU", topo->ncpus > 0);
+    ABTS_ASSERT(tc, "no NUMA node", topo->nnodes > 0);
+    for (i = 0; i < topo->ncpus; i++) {
+        ABTS_ASSERT(tc, "negative node", topo->nodes[i] >= 0);
+        if (i) {
+            ABTS_ASSERT(tc, "CPUs not in order",
+                        topo->cpus[i] > topo->cpus[i - 1]);
+        }
+    }
+}
+
+static void check_thread_name(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+    char *saved, *name;
+
+    rv = apr_thread_name_get(&saved, NULL, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "Thread names not implemented on this platform");
+        return;
+    }
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+
+    /* too long a name gets truncated */
+    rv = apr_thread_name_set("apr-test-thread-name", NULL, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_thread_name_get(&name, NULL, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_STR_EQUAL(tc, "apr-test-thread", name);
+
+    rv = apr_thread_name_set(saved, NULL, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+}
+
+static int pinned_cpu;
+static volatile apr_status_t pinned_rv;
+
+static apr_status_t check_pinned(apr_thread_t *thd)
+{
+    apr_status_t rv;
+    int *cpus, ncpus;
+
+    rv = apr_thread_affinity_get(&cpus, &ncpus, NULL,
+                                 apr_thread_pool_get(thd));
+    if (rv == APR_SUCCESS && (ncpus != 1 || cpus[0] != pinned_cpu)) {
+        rv = APR_EGENERAL;
+    }
+    return rv;
+}
+
+static void * APR_THREAD_FUNC pinned_func(apr_thread_t *thd, void *data)
+{
+    apr_thread_exit(thd, check_pinned(thd));
+    return NULL;
+}
+
+static void * APR_THREAD_FUNC pinned_task(apr_thread_t *thd, void *data)
+{
+    pinned_rv = check_pinned(thd);
+    return NULL;
+}
+
+static void check_thread_affinity(abts_case *tc, void *data)
+{
+    apr_status_t rv, retval;
+    apr_threadattr_t *attr;
+    apr_thread_t *thd;
+    apr_thread_pool_t *tp;
+    int *saved, nsaved, *cpus, ncpus, bad = -1, i;
+
+    rv = apr_thread_affinity_get(&saved, &nsaved, NULL, p);
+    if (rv == APR_ENOTIMPL) {
+        ABTS_NOT_IMPL(tc, "Thread affinity not implemented on this platform");
+        return;
+    }
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_ASSERT(tc, "no CPU to run on", nsaved > 0);
+    pinned_cpu = saved[nsaved - 1];
+
+    rv = apr_thread_affinity_set(NULL, &pinned_cpu, 1);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_thread_affinity_get(&cpus, &ncpus, NULL, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, 1, ncpus);
+    ABTS_INT_EQUAL(tc, pinned_cpu, cpus[0]);
+
+    rv = apr_thread_affinity_set(NULL, saved, nsaved);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_thread_affinity_get(&cpus, &ncpus, NULL, p);
+    ABTS_INT_EQUAL(tc, nsaved, ncpus);
+    for (i = 0; i < ncpus && i < nsaved; i++) {
+        ABTS_INT_EQUAL(tc, saved[i], cpus[i]);
+    }
+
+    rv = apr_thread_affinity_set(NULL, &bad, 1);
+    ABTS_INT_EQUAL(tc, APR_EINVAL, rv);
+
+    /* threads created pinned */
+    rv = apr_threadattr_create(&attr, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_threadattr_affinity_set(attr, &pinned_cpu, 1);
+    if (rv != APR_ENOTIMPL) {
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        rv = apr_thread_create(&thd, attr, pinned_func, NULL, p);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        rv = apr_thread_join(&retval, thd);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+        ABTS_INT_EQUAL(tc, APR_SUCCESS, retval);
+    }
+
+    /* and pinned thread pool workers */
+    rv = apr_thread_pool_create(&tp, 1, 1, p);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    rv = apr_thread_pool_affinity_set(tp, &pinned_cpu, 1);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    pinned_rv = APR_EINIT;
+    rv = apr_thread_pool_push(tp, pinned_task, NULL,
+                              APR_THREAD_TASK_PRIORITY_NORMAL, NULL);
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, rv);
+    for (i = 0; i < 500 && pinned_rv == APR_EINIT; i++) {
+        apr_sleep(apr_time_from_msec(10));
+    }
+    ABTS_INT_EQUAL(tc, APR_SUCCESS, pinned_rv);
+    apr_thread_pool_destroy(tp);
+}
+
 #else
 
 static void threads_not_impl(abts_case *tc, void *data)
@@ -125,6 +264,9 @@ abts_suite *testthread(abts_suite *suite)
     abts_run_test(suite, join_threads, NULL);
     abts_run_test(suite, check_locks, NULL);
     abts_run_test(suite, check_thread_once, NULL);
+    abts_run_test(suite, check_cpu_topology, NULL);
+    abts_run_test(suite, check_thread_name, NULL);
+    abts_run_test(suite, check_thread_affinity, NULL);
 #endif
 
     return suite;
@@ -118,6 +118,7 @@ abts_suite *testpass(abts_suite *suite);
 abts_suite *testbase64(abts_suite *suite);
 abts_suite *testmd4(abts_suite *suite);
 abts_suite *testmd5(abts_suite *suite);
+abts_suite *testsha1(abts_suite *suite);
 abts_suite *testcrypto(abts_suite *suite);
 abts_suite *testdbd(abts_suite *suite);
 abts_suite *testdate(abts_suite *suite);
@@ -16,6 +16,7 @@
 
 #include "apr.h"
 #include "apr_general.h"
+#include "apr_strings.h"
 #include "apr_xml.h"
 #include "abts.h"
 #include "testutil.h"
@@ -165,12 +166,210 @@ static void test_billion_laughs(abts_case *tc, void *data)
     apr_file_close(fd);
 }
 
+static const char reader_doc[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<D:propfind xmlns:D=\"DAV:\" xmlns=\"urn:x\">"
+    "<D:prop a=\"1\" D:b=\"2\"><getetag/>"
+    "<x:y xmlns:x=\"urn:y\" xml:lang=\"en\">t&amp;u</x:y></D:prop>"
+    "<empty xmlns=\"\"/></D:propfind>\n";
+
+static const char reader_trace[] =
+    "<{DAV:}propfind><{DAV:}prop a=1 {DAV:}b=2>"
+    "<{urn:x}getetag></{urn:x}getetag>"
+    "<{urn:y}y xml:lang=en>t&u</{urn:y}y></{DAV:}prop>"
+    "<empty></empty></{DAV:}propfind>";
+
+static const char *qualify(apr_xml_reader *reader, int ns, const char *name)
+{
+    if (ns < 0)
+        return name;
+    return apr_psprintf(p, "{%s}%s", APR_XML_GET_URI_ITEM(
+                        apr_xml_reader_namespaces(reader), ns), name);
+}
+
+/* feed the document chunk bytes at a time, describing the events */
+static const char *read_doc(abts_case *tc, const char *doc, apr_size_t chunk,
+                            apr_status_t *status)
+{
+    apr_xml_reader *reader;
+    apr_xml_event ev;
+    const apr_xml_attr *attr;
+    apr_size_t len = strlen(doc), off = 0;
+    const char *trace = "";
+    int depth = 0;
+    apr_status_t rv;
+
+    rv = apr_xml_reader_create(&reader, p);
+    APR_ASSERT_SUCCESS(tc, "create reader", rv);
+
+    for (;;) {
+        rv = apr_xml_reader_next(reader, &ev);
+        if (rv == APR_INCOMPLETE) {
+            apr_size_t n = len - off < chunk ? len - off : chunk;
+
+            rv = apr_xml_reader_feed(reader, doc + off, n, off + n == len);
+            APR_ASSERT_SUCCESS(tc, "feed reader", rv);
+            ABTS_INT_EQUAL(tc, APR_EBUSY,
+                           apr_xml_reader_feed(reader, doc, 1, 0));
+            off += n;
+            continue;
+        }
+        if (rv != APR_SUCCESS)
+            break;
+
+        switch (ev.type) {
+        case APR_XML_EVENT_START:
+            ABTS_INT_EQUAL(tc, depth++, ev.depth);
+            trace = apr_pstrcat(p, trace, "<",
+                                qualify(reader, ev.ns, ev.name), NULL);
+            for (attr = ev.attr; attr; attr = attr->next)
+                trace = apr_pstrcat(p, trace, " ",
+                                    qualify(reader, attr->ns, attr->name),
+                                    "=", attr->value, NULL);
+            trace = apr_pstrcat(p, trace, ">", NULL);
+            break;
+        case APR_XML_EVENT_END:
+            ABTS_INT_EQUAL(tc, --depth, ev.depth);
+            trace = apr_pstrcat(p, trace, "</",
+                                qualify(reader, ev.ns, ev.name), ">", NULL);
+            break;
+        case APR_XML_EVENT_TEXT:
+            ABTS_INT_EQUAL(tc, depth - 1, ev.depth);
+            trace = apr_pstrcat(p, trace,
+                                apr_pstrmemdup(p, ev.text, ev.len), NULL);
+            break;
+        }
+    }
+
+    *status = rv;
+    return trace;
+}
+
+static void test_xml_reader(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+
+    ABTS_STR_EQUAL(tc, reader_trace,
+                   read_doc(tc, reader_doc, sizeof(reader_doc), &rv));
+    ABTS_INT_EQUAL(tc, APR_EOF, rv);
+
+    ABTS_STR_EQUAL(tc, reader_trace, read_doc(tc, reader_doc, 7, &rv));
+    ABTS_INT_EQUAL(tc, APR_EOF, rv);
+
+    ABTS_STR_EQUAL(tc, reader_trace, read_doc(tc, reader_doc, 1, &rv));
+    ABTS_INT_EQUAL(tc, APR_EOF, rv);
+}
+
+static void test_xml_reader_text(abts_case *tc, void *data)
+{
+    static const char latin1[] =
+        "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+        "<a t=\"caf\xE9\">caf\xE9 cr\xE8me</a>";
+    apr_size_t chunks[] = { 64, 3, 1 };
+    char *long1, *long8;
+    apr_status_t rv;
+    int i;
+
+    /* expat hands these over in short-lived buffers of its own */
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        ABTS_STR_EQUAL(tc, "<a>x\n&A\n\ny&lt;\"</a>",
+                       read_doc(tc, "<a>x\n&amp;&#65;\r\n\r"
+                                    "y&#x26;lt;&quot;</a>", chunks[i], &rv));
+        ABTS_INT_EQUAL(tc, APR_EOF, rv);
+
+        ABTS_STR_EQUAL(tc, "<a t=caf\xC3\xA9>caf\xC3\xA9 cr\xC3\xA8me</a>",
+                       read_doc(tc, latin1, chunks[i], &rv));
+        ABTS_INT_EQUAL(tc, APR_EOF, rv);
+    }
+
+    /* re-encoded text runs longer than expat's conversion buffer */
+    long1 = apr_palloc(p, 3000 + 1);
+    long8 = apr_palloc(p, 2 * 3000 + 1);
+    for (i = 0; i < 3000; i++) {
+        long1[i] = (char)(0xC0 + i % 37);
+        long8[2 * i] = '\xC3';
+        long8[2 * i + 1] = (char)(0x80 + i % 37);
+    }
+    long1[3000] = long8[2 * 3000] = '\0';
+    ABTS_STR_EQUAL(tc, apr_pstrcat(p, "<a>", long8, "</a>", NULL),
+                   read_doc(tc, apr_pstrcat(p, "<?xml version=\"1.0\" "
+                                            "encoding=\"ISO-8859-1\"?>"
+                                            "<a>", long1, "</a>", NULL),
+                            8192, &rv));
+    ABTS_INT_EQUAL(tc, APR_EOF, rv);
+}
+
+static void test_xml_reader_errors(abts_case *tc, void *data)
+{
+    apr_status_t rv;
+
+    /* the events before the error are still delivered */
+    ABTS_STR_EQUAL(tc, "<a>", read_doc(tc, "<a><b:c/></a>", 64, &rv));
+    ABTS_INT_EQUAL(tc, APR_EGENERAL, rv);
+
+    read_doc(tc, "<a xmlns:b=\"\"/>", 64, &rv);
+    ABTS_INT_EQUAL(tc, APR_EGENERAL, rv);
+
+    ABTS_STR_EQUAL(tc, "<a><b>", read_doc(tc, "<a><b></a>", 64, &rv));
+    ABTS_INT_EQUAL(tc, APR_EGENERAL, rv);
+
+    read_doc(tc, "<a>", 64, &rv);
+    ABTS_INT_EQUAL(tc, APR_EGENERAL, rv);
+}
+
+static void test_xml_reader_large(abts_case *tc, void *data)
+{
+    apr_file_t *fd;
+    apr_xml_reader *reader;
+    apr_xml_event ev;
+    char buf[2000];
+    apr_size_t len = 0;
+    int starts = 0, roast = 0;
+    apr_status_t rv;
+
+    rv = create_dummy_file(tc, p, &fd);
+    if (rv != APR_SUCCESS)
+        return;
+    rv = apr_xml_reader_create(&reader, p);
+    APR_ASSERT_SUCCESS(tc, "create reader", rv);
+
+    while ((rv = apr_xml_reader_next(reader, &ev)) != APR_EOF) {
+        if (rv == APR_INCOMPLETE) {
+            len = sizeof(buf);
+            rv = apr_file_read(fd, buf, &len);
+            if (rv == APR_EOF)
+                len = 0;
+            rv = apr_xml_reader_feed(reader, buf, len, len == 0);
+            APR_ASSERT_SUCCESS(tc, "feed reader", rv);
+            continue;
+        }
+        APR_ASSERT_SUCCESS(tc, "next event", rv);
+        if (rv != APR_SUCCESS)
+            break;
+        if (ev.type == APR_XML_EVENT_START) {
+            starts++;
+            if (ev.attr && !strcmp(ev.attr->name, "roast")
+                && !strcmp(ev.attr->value, "lamb")
+                && !strcmp(ev.attr->next->value, "dinner <>="))
+                roast++;
+        }
+    }
+    ABTS_INT_EQUAL(tc, 5001, starts);
+    ABTS_INT_EQUAL(tc, 5000, roast);
+
+    apr_file_close(fd);
+}
+
 abts_suite *testxml(abts_suite *suite)
 {
     suite = ADD_SUITE(suite);
 
     abts_run_test(suite, test_xml_parser, NULL);
     abts_run_test(suite, test_billion_laughs, NULL);
+    abts_run_test(suite, test_xml_reader, NULL);
+    abts_run_test(suite, test_xml_reader_text, NULL);
+    abts_run_test(suite, test_xml_reader_errors, NULL);
+    abts_run_test(suite, test_xml_reader_large, NULL);
 
     return suite;
 }
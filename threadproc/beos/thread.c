@@ -62,6 +62,13 @@ APR_DECLARE(apr_status_t) apr_threadattr_guardsize_set(apr_threadattr_t *attr,
     return APR_ENOTIMPL;
 }
 
+APR_DECLARE(apr_status_t) apr_threadattr_affinity_set(apr_threadattr_t *attr,
+                                                      const int *cpus,
+                                                      int ncpus)
+{
+    return APR_ENOTIMPL;
+}
+
 static void *dummy_worker(void *opaque)
 {
     apr_thread_t *thd = (apr_thread_t*)opaque;
@@ -234,4 +241,38 @@ APR_DECLARE(apr_status_t) apr_thread_once(apr_thread_once_t *control,
     return APR_SUCCESS;
 }
 
+APR_DECLARE(apr_status_t) apr_thread_affinity_set(apr_thread_t *thread,
+                                                  const int *cpus,
+                                                  int ncpus)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_thread_affinity_get(int **cpus, int *ncpus,
+                                                  apr_thread_t *thread,
+                                                  apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_thread_name_set(const char *name,
+                                              apr_thread_t *thread,
+                                              apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_thread_name_get(char **name,
+                                              apr_thread_t *thread,
+                                              apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_cpu_topology_get(apr_cpu_topology_t **topology,
+                                               apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
 APR_POOL_IMPLEMENT_ACCESSOR(thread)
@@ -293,6 +293,13 @@ APR_DECLARE(apr_status_t) apr_procattr_addrspace_set(apr_procattr_t *attr,
     return APR_SUCCESS;
 }
 
+APR_DECLARE(apr_status_t) apr_procattr_spawn_set(apr_procattr_t *attr,
+                                                 apr_int32_t spawn)
+{
+    /* won't ever be used on this platform, so don't save the flag */
+    return APR_SUCCESS;
+}
+
 
 
 APR_DECLARE(apr_status_t) apr_proc_create(apr_proc_t *proc, const char *progname,
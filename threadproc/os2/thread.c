@@ -66,6 +66,13 @@ APR_DECLARE(apr_status_t) apr_threadattr_guardsize_set(apr_threadattr_t *attr,
     return APR_ENOTIMPL;
 }
 
+APR_DECLARE(apr_status_t) apr_threadattr_affinity_set(apr_threadattr_t *attr,
+                                                      const int *cpus,
+                                                      int ncpus)
+{
+    return APR_ENOTIMPL;
+}
+
 static void apr_thread_begin(void *arg)
 {
   apr_thread_t *thread = (apr_thread_t *)arg;
@@ -216,6 +223,40 @@ APR_DECLARE(apr_status_t) apr_thread_data_set(void *data, const char *key,
     return apr_pool_userdata_set(data, key, cleanup, thread->pool);
 }
 
+APR_DECLARE(apr_status_t) apr_thread_affinity_set(apr_thread_t *thread,
+                                                  const int *cpus,
+                                                  int ncpus)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_thread_affinity_get(int **cpus, int *ncpus,
+                                                  apr_thread_t *thread,
+                                                  apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_thread_name_set(const char *name,
+                                              apr_thread_t *thread,
+                                              apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_thread_name_get(char **name,
+                                              apr_thread_t *thread,
+                                              apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
+APR_DECLARE(apr_status_t) apr_cpu_topology_get(apr_cpu_topology_t **topology,
+                                               apr_pool_t *pool)
+{
+    return APR_ENOTIMPL;
+}
+
 APR_POOL_IMPLEMENT_ACCESSOR(thread)
 
 
@@ -20,6 +20,17 @@
 #include "apr_signal.h"
 #include "apr_random.h"
 
+#if defined(HAVE_POSIX_SPAWN) && defined(HAVE_SPAWN_H)
+#define APR_PROC_SPAWN 1
+#include <spawn.h>
+#ifdef __APPLE__
+#include <crt_externs.h>
+#define environ (*_NSGetEnviron())
+#else
+extern char **environ;
+#endif
+#endif
+
 /* Heavy on no'ops, here's what we want to pass if there is APR_NO_FILE
  * requested for a specific child handle;
  */
@@ -311,6 +322,13 @@ APR_DECLARE(apr_status_t) apr_procattr_addrspace_set(apr_procattr_t *attr,
     return APR_SUCCESS;
 }
 
+APR_DECLARE(apr_status_t) apr_procattr_spawn_set(apr_procattr_t *attr,
+                                                 apr_int32_t spawn)
+{
+    attr->spawn = spawn;
+    return APR_SUCCESS;
+}
+
 APR_DECLARE(apr_status_t) apr_procattr_user_set(apr_procattr_t *attr,
                                                 const char *username,
                                                 const char *password)
@@ -341,6 +359,225 @@ APR_DECLARE(apr_status_t) apr_procattr_group_set(apr_procattr_t *attr,
     return rv;
 }
 
+/* build the arguments of SHELL_PATH for APR_SHELLCMD[_ENV] */
+static void shell_args(const char *newargs[4], const char * const *args,
+                       apr_pool_t *pool)
+{
+    int onearg_len = 0;
+    int i;
+
+    newargs[0] = SHELL_PATH;
+    newargs[1] = "-c";
+
+    i = 0;
+    while (args[i]) {
+        onearg_len += strlen(args[i]);
+        onearg_len++; /* for space delimiter */
+        i++;
+    }
+
+    switch(i) {
+    case 0:
+        /* bad parameters; we're doomed */
+        break;
+    case 1:
+        /* no args, or caller already built a single string from
+         * progname and args
+         */
+        newargs[2] = args[0];
+        break;
+    default:
+    {
+        char *ch, *onearg;
+
+        ch = onearg = apr_palloc(pool, onearg_len);
+        i = 0;
+        while (args[i]) {
+            size_t len = strlen(args[i]);
+
+            memcpy(ch, args[i], len);
+            ch += len;
+            *ch = ' ';
+            ++ch;
+            ++i;
+        }
+        --ch; /* back up to trailing blank */
+        *ch = '\0';
+        newargs[2] = onearg;
+    }
+    }
+
+    newargs[3] = NULL;
+}
+
+#if APR_PROC_SPAWN
+
+/* true if nothing asked of attr needs code to run in the child */
+static int proc_can_spawn(apr_procattr_t *attr)
+{
+    if (!attr->spawn || attr->detached) {
+        return 0;
+    }
+#ifdef RLIMIT_CPU
+    if (attr->limit_cpu) {
+        return 0;
+    }
+#endif
+#if defined (RLIMIT_DATA) || defined (RLIMIT_VMEM) || defined(RLIMIT_AS)
+    if (attr->limit_mem) {
+        return 0;
+    }
+#endif
+#ifdef RLIMIT_NPROC
+    if (attr->limit_nproc) {
+        return 0;
+    }
+#endif
+#ifdef RLIMIT_NOFILE
+    if (attr->limit_nofile) {
+        return 0;
+    }
+#endif
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+    if (attr->currdir) {
+        return 0;
+    }
+#endif
+    /* the user and group only change when running as root */
+    if (!geteuid() && (attr->uid != -1 || attr->gid != -1
+                       || attr->perms_set_callbacks)) {
+        return 0;
+    }
+    return 1;
+}
+
+/* make file the child's descriptor fd, as the fork() path does */
+static int spawn_stdio(posix_spawn_file_actions_t *actions, apr_file_t *file,
+                       int fd)
+{
+    int rv = 0;
+
+    if (file == NULL) {
+        return 0;
+    }
+    if (file->filedes == -1) {
+        return posix_spawn_file_actions_addclose(actions, fd);
+    }
+    if (file->filedes != fd) {
+        rv = posix_spawn_file_actions_adddup2(actions, file->filedes, fd);
+        if (rv == 0) {
+            rv = posix_spawn_file_actions_addclose(actions, file->filedes);
+        }
+    }
+    return rv;
+}
+
+/* close what only a child cleanup of the pipe would have closed */
+static int spawn_close(posix_spawn_file_actions_t *actions, apr_file_t *file)
+{
+    if (file == NULL || file->filedes <= STDERR_FILENO) {
+        return 0;
+    }
+    return posix_spawn_file_actions_addclose(actions, file->filedes);
+}
+
+static apr_status_t proc_spawn(apr_proc_t *new, const char *progname,
+                               const char * const *args,
+                               const char * const *env,
+                               apr_procattr_t *attr, apr_pool_t *pool)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t sattr;
+    sigset_t sigs;
+    const char *newargs[4];
+    short flags = POSIX_SPAWN_SETSIGDEF;
+    pid_t pid;
+    int rv;
+
+    if (attr->cmdtype == APR_SHELLCMD || attr->cmdtype == APR_SHELLCMD_ENV) {
+        shell_args(newargs, args, pool);
+        progname = SHELL_PATH;
+        args = newargs;
+    }
+    if (attr->cmdtype != APR_PROGRAM && attr->cmdtype != APR_SHELLCMD) {
+        /* as execv() and execvp() would */
+        env = (const char * const *)environ;
+    }
+
+    if ((rv = posix_spawn_file_actions_init(&actions)) != 0) {
+        return rv;
+    }
+    if ((rv = posix_spawnattr_init(&sattr)) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return rv;
+    }
+
+    if ((rv = spawn_stdio(&actions, attr->child_in, STDIN_FILENO)) == 0
+        && (rv = spawn_stdio(&actions, attr->child_out, STDOUT_FILENO)) == 0
+        && (rv = spawn_stdio(&actions, attr->child_err, STDERR_FILENO)) == 0
+        && (rv = spawn_close(&actions, attr->parent_in)) == 0
+        && (rv = spawn_close(&actions, attr->parent_out)) == 0
+        && (rv = spawn_close(&actions, attr->parent_err)) == 0) {
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+        if (attr->currdir) {
+            rv = posix_spawn_file_actions_addchdir_np(&actions,
+                                                      attr->currdir);
+        }
+#endif
+    }
+
+    if (rv == 0) {
+        sigemptyset(&sigs);
+        sigaddset(&sigs, SIGCHLD);
+        rv = posix_spawnattr_setsigdefault(&sattr, &sigs);
+    }
+#ifdef POSIX_SPAWN_USEVFORK
+    /* older glibc only avoids copying the address space when asked */
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    if (rv == 0) {
+        rv = posix_spawnattr_setflags(&sattr, flags);
+    }
+
+    if (rv == 0) {
+        if (attr->cmdtype == APR_PROGRAM_PATH) {
+            rv = posix_spawnp(&pid, progname, &actions, &sattr,
+                              (char * const *)args, (char * const *)env);
+        }
+        else {
+            rv = posix_spawn(&pid, progname, &actions, &sattr,
+                             (char * const *)args, (char * const *)env);
+        }
+    }
+
+    posix_spawnattr_destroy(&sattr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (rv != 0) {
+        return rv;
+    }
+
+    new->pid = pid;
+    return APR_SUCCESS;
+}
+
+#endif /* APR_PROC_SPAWN */
+
+/* the parent's copies of the child's ends of the pipes */
+static void close_child_ends(apr_procattr_t *attr)
+{
+    if (attr->child_in && (attr->child_in->filedes != -1)) {
+        apr_file_close(attr->child_in);
+    }
+
+    if (attr->child_out && (attr->child_out->filedes != -1)) {
+        apr_file_close(attr->child_out);
+    }
+
+    if (attr->child_err && (attr->child_err->filedes != -1)) {
+        apr_file_close(attr->child_err);
+    }
+}
+
 APR_DECLARE(apr_status_t) apr_proc_create(apr_proc_t *new,
                                           const char *progname,
                                           const char * const *args,
@@ -348,7 +585,6 @@ APR_DECLARE(apr_status_t) apr_proc_create(apr_proc_t *new,
                                           apr_procattr_t *attr,
                                           apr_pool_t *pool)
 {
-    int i;
     const char * const empty_envp[] = {NULL};
 
     if (!env) { /* Specs require an empty array instead of NULL;
@@ -388,6 +624,15 @@ APR_DECLARE(apr_status_t) apr_proc_create(apr_proc_t *new,
         }
     }
 
+#if APR_PROC_SPAWN
+    /* if posix_spawn() fails, fork() finds and reports the error */
+    if (proc_can_spawn(attr)
+        && proc_spawn(new, progname, args, env, attr, pool) == APR_SUCCESS) {
+        close_child_ends(attr);
+        return APR_SUCCESS;
+    }
+#endif
+
     if ((new->pid = fork()) < 0) {
         return errno;
     }
@@ -502,51 +747,9 @@ APR_DECLARE(apr_status_t) apr_proc_create(apr_proc_t *new,
 
         if (attr->cmdtype == APR_SHELLCMD ||
             attr->cmdtype == APR_SHELLCMD_ENV) {
-            int onearg_len = 0;
             const char *newargs[4];
 
-            newargs[0] = SHELL_PATH;
-            newargs[1] = "-c";
-
-            i = 0;
-            while (args[i]) {
-                onearg_len += strlen(args[i]);
-                onearg_len++; /* for space delimiter */
-                i++;
-            }
-
-            switch(i) {
-            case 0:
-                /* bad parameters; we're doomed */
-                break;
-            case 1:
-                /* no args, or caller already built a single string from
-                 * progname and args
-                 */
-                newargs[2] = args[0];
-                break;
-            default:
-            {
-                char *ch, *onearg;
-                
-                ch = onearg = apr_palloc(pool, onearg_len);
-                i = 0;
-                while (args[i]) {
-                    size_t len = strlen(args[i]);
-
-                    memcpy(ch, args[i], len);
-                    ch += len;
-                    *ch = ' ';
-                    ++ch;
-                    ++i;
-                }
-                --ch; /* back up to trailing blank */
-                *ch = '\0';
-                newargs[2] = onearg;
-            }
-            }
-
-            newargs[3] = NULL;
+            shell_args(newargs, args, pool);
 
             if (attr->detached) {
                 apr_proc_detach(APR_PROC_DETACH_DAEMONIZE);
@@ -594,17 +797,7 @@ APR_DECLARE(apr_status_t) apr_proc_create(apr_proc_t *new,
     }
 
     /* Parent process */
-    if (attr->child_in && (attr->child_in->filedes != -1)) {
-        apr_file_close(attr->child_in);
-    }
-
-    if (attr->child_out && (attr->child_out->filedes != -1)) {
-        apr_file_close(attr->child_out);
-    }
-
-    if (attr->child_err && (attr->child_err->filedes != -1)) {
-        apr_file_close(attr->child_err);
-    }
+    close_child_ends(attr);
 
     return APR_SUCCESS;
 }
@@ -16,8 +16,17 @@
 
 #include "apr.h"
 #include "apr_portable.h"
+#include "apr_strings.h"
+#include "apr_tables.h"
 #include "apr_arch_threadproc.h"
 
+#if APR_HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#if APR_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #if APR_HAS_THREADS
 
 #if APR_HAVE_PTHREAD_H
@@ -136,6 +145,50 @@ APR_DECLARE(apr_status_t) apr_threadattr_guardsize_set(apr_threadattr_t *attr,
 #endif
 }
 
+#if !defined(CPU_SET) || !defined(CPU_SETSIZE)
+/* no cpu_set_t to describe an affinity with */
+#undef HAVE_PTHREAD_SETAFFINITY_NP
+#undef HAVE_PTHREAD_GETAFFINITY_NP
+#undef HAVE_PTHREAD_ATTR_SETAFFINITY_NP
+#endif
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) \
+    || defined(HAVE_PTHREAD_ATTR_SETAFFINITY_NP)
+static apr_status_t cpu_set_fill(cpu_set_t *set, const int *cpus, int ncpus)
+{
+    int i;
+
+    if (ncpus <= 0) {
+        return APR_EINVAL;
+    }
+    CPU_ZERO(set);
+    for (i = 0; i < ncpus; i++) {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) {
+            return APR_EINVAL;
+        }
+        CPU_SET(cpus[i], set);
+    }
+    return APR_SUCCESS;
+}
+#endif
+
+APR_DECLARE(apr_status_t) apr_threadattr_affinity_set(apr_threadattr_t *attr,
+                                                      const int *cpus,
+                                                      int ncpus)
+{
+#ifdef HAVE_PTHREAD_ATTR_SETAFFINITY_NP
+    cpu_set_t set;
+    apr_status_t rv;
+
+    if ((rv = cpu_set_fill(&set, cpus, ncpus)) != APR_SUCCESS) {
+        return rv;
+    }
+    return pthread_attr_setaffinity_np(&attr->attr, sizeof(set), &set);
+#else
+    return APR_ENOTIMPL;
+#endif
+}
+
 static void *dummy_worker(void *opaque)
 {
     apr_thread_t *thread = (apr_thread_t*)opaque;
@@ -248,6 +301,101 @@ APR_DECLARE(apr_status_t) apr_thread_detach(apr_thread_t *thd)
     }
 }
 
+/* The thread to act on, NULL meaning the calling one */
+#define THREAD_HANDLE(thread) ((thread) ? *(thread)->td : pthread_self())
+
+APR_DECLARE(apr_status_t) apr_thread_affinity_set(apr_thread_t *thread,
+                                                  const int *cpus,
+                                                  int ncpus)
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    cpu_set_t set;
+    apr_status_t rv;
+
+    if ((rv = cpu_set_fill(&set, cpus, ncpus)) != APR_SUCCESS) {
+        return rv;
+    }
+    return pthread_setaffinity_np(THREAD_HANDLE(thread), sizeof(set), &set);
+#else
+    return APR_ENOTIMPL;
+#endif
+}
+
+APR_DECLARE(apr_status_t) apr_thread_affinity_get(int **cpus, int *ncpus,
+                                                  apr_thread_t *thread,
+                                                  apr_pool_t *pool)
+{
+#ifdef HAVE_PTHREAD_GETAFFINITY_NP
+    cpu_set_t set;
+    apr_status_t rv;
+    int i, n;
+
+    rv = pthread_getaffinity_np(THREAD_HANDLE(thread), sizeof(set), &set);
+    if (rv) {
+        return rv;
+    }
+    for (i = n = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &set)) {
+            n++;
+        }
+    }
+    *cpus = apr_palloc(pool, n * sizeof(int));
+    *ncpus = n;
+    for (i = n = 0; n < *ncpus; i++) {
+        if (CPU_ISSET(i, &set)) {
+            (*cpus)[n++] = i;
+        }
+    }
+    return APR_SUCCESS;
+#else
+    return APR_ENOTIMPL;
+#endif
+}
+
+/* Linux limits names to 16 bytes, including the terminating NUL */
+#define THREAD_NAME_MAX 16
+
+APR_DECLARE(apr_status_t) apr_thread_name_set(const char *name,
+                                              apr_thread_t *thread,
+                                              apr_pool_t *pool)
+{
+#ifdef HAVE_PTHREAD_SETNAME_NP
+    char buf[THREAD_NAME_MAX];
+
+    apr_cpystrn(buf, name, sizeof(buf));
+#ifdef DARWIN
+    /* only ever names the calling thread */
+    if (thread && !pthread_equal(*thread->td, pthread_self())) {
+        return APR_ENOTIMPL;
+    }
+    return pthread_setname_np(buf);
+#else
+    return pthread_setname_np(THREAD_HANDLE(thread), buf);
+#endif
+#else
+    return APR_ENOTIMPL;
+#endif
+}
+
+APR_DECLARE(apr_status_t) apr_thread_name_get(char **name,
+                                              apr_thread_t *thread,
+                                              apr_pool_t *pool)
+{
+#ifdef HAVE_PTHREAD_GETNAME_NP
+    char buf[64];
+    apr_status_t rv;
+
+    rv = pthread_getname_np(THREAD_HANDLE(thread), buf, sizeof(buf));
+    if (rv) {
+        return rv;
+    }
+    *name = apr_pstrdup(pool, buf);
+    return APR_SUCCESS;
+#else
+    return APR_ENOTIMPL;
+#endif
+}
+
 APR_DECLARE(void) apr_thread_yield(void)
 {
 #ifdef HAVE_PTHREAD_YIELD
@@ -321,6 +469,113 @@ APR_POOL_IMPLEMENT_ACCESSOR(thread)
 #endif  /* HAVE_PTHREAD_H */
 #endif  /* APR_HAS_THREADS */
 
+/* Parse a Linux cpulist such as "0-3,8,10-11" */
+static void parse_cpulist(apr_array_header_t *ids, const char *list)
+{
+    while (*list) {
+        char *end;
+        long first, last;
+
+        first = last = strtol(list, &end, 10);
+        if (end == list) {
+            break;
+        }
+        if (*end == '-') {
+            list = end + 1;
+            last = strtol(list, &end, 10);
+            if (end == list) {
+                break;
+            }
+        }
+        for (; first <= last; first++) {
+            APR_ARRAY_PUSH(ids, int) = (int)first;
+        }
+        if (*end != ',') {
+            break;
+        }
+        list = end + 1;
+    }
+}
+
+static apr_status_t read_cpulist(apr_array_header_t *ids, const char *fname,
+                                 apr_pool_t *pool)
+{
+    apr_file_t *f;
+    char buf[4096];
+    apr_status_t rv;
+
+    rv = apr_file_open(&f, fname, APR_FOPEN_READ, APR_OS_DEFAULT, pool);
+    if (rv != APR_SUCCESS) {
+        return rv;
+    }
+    rv = apr_file_gets(buf, sizeof(buf), f);
+    apr_file_close(f);
+    if (rv == APR_SUCCESS) {
+        parse_cpulist(ids, buf);
+    }
+    return rv;
+}
+
+APR_DECLARE(apr_status_t) apr_cpu_topology_get(apr_cpu_topology_t **topology,
+                                               apr_pool_t *pool)
+{
+    apr_cpu_topology_t *t;
+    apr_array_header_t *cpus, *nodes, *node_cpus;
+    int i, j, k;
+
+    cpus = apr_array_make(pool, 64, sizeof(int));
+    if (read_cpulist(cpus, "/sys/devices/system/cpu/online", pool)
+            != APR_SUCCESS) {
+        apr_array_clear(cpus);
+    }
+#ifdef _SC_NPROCESSORS_ONLN
+    if (!cpus->nelts) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+        for (i = 0; i < n; i++) {
+            APR_ARRAY_PUSH(cpus, int) = i;
+        }
+    }
+#endif
+    if (!cpus->nelts) {
+        return APR_ENOTIMPL;
+    }
+
+    t = apr_palloc(pool, sizeof(*t));
+    t->ncpus = cpus->nelts;
+    t->cpus = (int *)cpus->elts;
+    t->nodes = apr_pcalloc(pool, t->ncpus * sizeof(int));
+    t->nnodes = 1;
+
+    nodes = apr_array_make(pool, 8, sizeof(int));
+    node_cpus = apr_array_make(pool, 64, sizeof(int));
+    if (read_cpulist(nodes, "/sys/devices/system/node/online", pool)
+            == APR_SUCCESS && nodes->nelts > 0) {
+        t->nnodes = nodes->nelts;
+        for (i = 0; i < nodes->nelts; i++) {
+            int node = APR_ARRAY_IDX(nodes, i, int);
+
+            apr_array_clear(node_cpus);
+            read_cpulist(node_cpus,
+                         apr_psprintf(pool, "/sys/devices/system/node/"
+                                      "node%d/cpulist", node), pool);
+            for (j = 0; j < node_cpus->nelts; j++) {
+                int cpu = APR_ARRAY_IDX(node_cpus, j, int);
+
+                for (k = 0; k < t->ncpus; k++) {
+                    if (t->cpus[k] == cpu) {
+                        t->nodes[k] = node;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    *topology = t;
+    return APR_SUCCESS;
+}
+
 #if !APR_HAS_THREADS
 
 /* avoid warning for no prototype */
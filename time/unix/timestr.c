@@ -17,6 +17,7 @@
 #include "apr_portable.h"
 #include "apr_time.h"
 #include "apr_lib.h"
+#include "apr_atomic.h"
 #include "apr_private.h"
 /* System Headers required for time library */
 #if APR_HAVE_SYS_TIME_H
@@ -39,12 +40,62 @@ APR_DECLARE_DATA const char apr_day_snames[7][4] =
     "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
 };
 
+/*
+ * A cache of the last string formatted by apr_rfc822_date(), keyed by
+ * second.  Servers stamp the current time on every response, so nearly
+ * all calls within a second produce the same string.
+ *
+ * The entry is protected by a sequence count which is odd while a writer
+ * updates it; readers discard their copy if the count changed meanwhile.
+ * Writers never wait, a writer that loses the race leaves the cache alone.
+ */
+static struct {
+    volatile apr_uint32_t seq;
+    apr_time_t sec;
+    char str[APR_RFC822_DATE_LEN];
+} rfc822_cache;
+
+static int rfc822_cache_get(char *date_str, apr_time_t sec)
+{
+    apr_uint32_t seq = apr_atomic_read32_ex(&rfc822_cache.seq,
+                                            APR_ATOMIC_ACQUIRE);
+
+    if ((seq & 1) || rfc822_cache.sec != sec || !rfc822_cache.str[0]) {
+        return 0;
+    }
+    memcpy(date_str, rfc822_cache.str, APR_RFC822_DATE_LEN);
+    /* the string must be read before the count is checked again */
+    apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+    return apr_atomic_read32_ex(&rfc822_cache.seq, APR_ATOMIC_RELAXED) == seq;
+}
+
+static void rfc822_cache_set(const char *date_str, apr_time_t sec)
+{
+    apr_uint32_t seq = apr_atomic_read32_ex(&rfc822_cache.seq,
+                                            APR_ATOMIC_RELAXED);
+
+    if ((seq & 1)
+        || apr_atomic_cas32(&rfc822_cache.seq, seq + 1, seq) != seq) {
+        return;
+    }
+    /* the odd count must be visible before the entry changes */
+    apr_atomic_fence(APR_ATOMIC_RELEASE);
+    rfc822_cache.sec = sec;
+    memcpy(rfc822_cache.str, date_str, APR_RFC822_DATE_LEN);
+    apr_atomic_add32_ex(&rfc822_cache.seq, 1, APR_ATOMIC_RELEASE);
+}
+
 apr_status_t apr_rfc822_date(char *date_str, apr_time_t t)
 {
     apr_time_exp_t xt;
     const char *s;
+    char *start = date_str;
     int real_year;
 
+    if (rfc822_cache_get(date_str, apr_time_sec(t))) {
+        return APR_SUCCESS;
+    }
+
     apr_time_exp_gmt(&xt, t);
 
     /* example: "Sat, 08 Jan 2000 18:31:41 GMT" */
@@ -84,6 +135,8 @@ apr_status_t apr_rfc822_date(char *date_str, apr_time_t t)
     *date_str++ = 'M';
     *date_str++ = 'T';
     *date_str++ = 0;
+
+    rfc822_cache_set(start, apr_time_sec(t));
     return APR_SUCCESS;
 }
 
@@ -27,6 +27,7 @@
 
 #include "apr.h"
 #include "apr_lib.h"
+#include "apr_atomic.h"
 
 #define APR_WANT_STRFUNC
 #include "apr_want.h"
@@ -95,6 +96,76 @@ APR_DECLARE(int) apr_date_checkmask(const char *data, const char *mask)
     return 0;          /* We only get here if mask is corrupted (exceeds 256) */
 }
 
+/*
+ * The unrolled equivalent of apr_date_checkmask(d, "## @$$ #### ##:##:## *"),
+ * which is the layout of the date following the weekday of an IMF-fixdate
+ * (RFC 1123) string, and what nearly every HTTP client sends.
+ */
+#define IMF_FIXDATE_MATCH(d)                                            \
+    (apr_isdigit((d)[0]) && apr_isdigit((d)[1]) && (d)[2] == ' '        \
+     && apr_isupper((d)[3]) && apr_islower((d)[4])                      \
+     && apr_islower((d)[5]) && (d)[6] == ' '                            \
+     && apr_isdigit((d)[7]) && apr_isdigit((d)[8])                      \
+     && apr_isdigit((d)[9]) && apr_isdigit((d)[10]) && (d)[11] == ' '   \
+     && apr_isdigit((d)[12]) && apr_isdigit((d)[13]) && (d)[14] == ':'  \
+     && apr_isdigit((d)[15]) && apr_isdigit((d)[16]) && (d)[17] == ':'  \
+     && apr_isdigit((d)[18]) && apr_isdigit((d)[19]) && (d)[20] == ' ')
+
+/* Only the "06 Nov 1994 08:49:37" part of an IMF-fixdate determines the
+ * parsed value, the weekday and the timezone are ignored.
+ */
+#define IMF_FIXDATE_KEY_LEN 20
+
+/*
+ * A cache of the last IMF-fixdate parsed by apr_date_parse_http().
+ * Conditional requests of a busy server mostly carry the same handful
+ * of Last-Modified values back, so the last one is worth remembering.
+ *
+ * The entry is protected by a sequence count: it is odd while a writer
+ * updates the entry, and readers discard anything they copied if the
+ * count changed underneath them.  Writers never wait, a writer that
+ * loses the race simply does not update the cache.
+ */
+static struct {
+    volatile apr_uint32_t seq;
+    char key[IMF_FIXDATE_KEY_LEN];
+    apr_time_t result;
+} parse_cache;
+
+static int parse_cache_get(const char *key, apr_time_t *result)
+{
+    apr_uint32_t seq = apr_atomic_read32_ex(&parse_cache.seq,
+                                            APR_ATOMIC_ACQUIRE);
+    apr_time_t t;
+
+    if ((seq & 1) || memcmp(parse_cache.key, key, IMF_FIXDATE_KEY_LEN)) {
+        return 0;
+    }
+    t = parse_cache.result;
+    /* the entry must be read before the count is checked again */
+    apr_atomic_fence(APR_ATOMIC_ACQUIRE);
+    if (apr_atomic_read32_ex(&parse_cache.seq, APR_ATOMIC_RELAXED) != seq) {
+        return 0;
+    }
+    *result = t;
+    return 1;
+}
+
+static void parse_cache_set(const char *key, apr_time_t result)
+{
+    apr_uint32_t seq = apr_atomic_read32_ex(&parse_cache.seq,
+                                            APR_ATOMIC_RELAXED);
+
+    if ((seq & 1) || apr_atomic_cas32(&parse_cache.seq, seq + 1, seq) != seq) {
+        return;
+    }
+    /* the odd count must be visible before the entry changes */
+    apr_atomic_fence(APR_ATOMIC_RELEASE);
+    memcpy(parse_cache.key, key, IMF_FIXDATE_KEY_LEN);
+    parse_cache.result = result;
+    apr_atomic_add32_ex(&parse_cache.seq, 1, APR_ATOMIC_RELEASE);
+}
+
 /*
  * Parses an HTTP date in one of three standard forms:
  *
@@ -147,6 +218,7 @@ APR_DECLARE(apr_time_t) apr_date_parse_http(const char *date)
     apr_time_exp_t ds;
     apr_time_t result;
     int mint, mon;
+    int imf_fixdate = 0;
     const char *monstr, *timstr;
     static const int months[12] =
     {
@@ -160,20 +232,30 @@ APR_DECLARE(apr_time_t) apr_date_parse_http(const char *date)
     if (!date)
         return APR_DATE_BAD;
 
-    while (*date && apr_isspace(*date))    /* Find first non-whitespace char */
-        ++date;
+    /* Fast path for the IMF-fixdate, "Sun, 06 Nov 1994 08:49:37 GMT" */
+    if (date[0] && date[1] && date[2] && date[3] == ',' && date[4] == ' '
+        && IMF_FIXDATE_MATCH(date + 5)) {
+        date += 5;
+        imf_fixdate = 1;
+        if (parse_cache_get(date, &result))
+            return result;
+    }
+    else {
+        while (*date && apr_isspace(*date)) /* Find first non-whitespace char */
+            ++date;
 
-    if (*date == '\0') 
-        return APR_DATE_BAD;
+        if (*date == '\0') 
+            return APR_DATE_BAD;
 
-    if ((date = strchr(date, ' ')) == NULL)       /* Find space after weekday */
-        return APR_DATE_BAD;
+        if ((date = strchr(date, ' ')) == NULL)   /* Find space after weekday */
+            return APR_DATE_BAD;
 
-    ++date;        /* Now pointing to first char after space, which should be */
+        ++date;    /* Now pointing to first char after space, which should be */
+    }
 
     /* start of the actual date information for all 4 formats. */
 
-    if (apr_date_checkmask(date, "## @$$ #### ##:##:## *")) {
+    if (imf_fixdate || IMF_FIXDATE_MATCH(date)) {
         /* RFC 1123 format with two days */
         ds.tm_year = ((date[7] - '0') * 10 + (date[8] - '0') - 19) * 100;
         if (ds.tm_year < 0)
@@ -276,6 +358,9 @@ APR_DECLARE(apr_time_t) apr_date_parse_http(const char *date)
     ds.tm_gmtoff = 0;
     if (apr_time_exp_get(&result, &ds) != APR_SUCCESS) 
         return APR_DATE_BAD;
+
+    if (imf_fixdate)
+        parse_cache_set(date, result);
     
     return result;
 }
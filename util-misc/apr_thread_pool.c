@@ -21,6 +21,7 @@
 #include "apr_ring.h"
 #include "apr_thread_cond.h"
 #include "apr_portable.h"
+#include "apr_strings.h"
 
 #if APR_HAS_THREADS
 
@@ -77,6 +78,9 @@ struct apr_thread_pool
     struct apr_thread_pool_tasks *recycled_tasks;
     struct apr_thread_list *recycled_thds;
     apr_thread_pool_task_t *task_idx[TASK_PRIORITY_SEGS];
+    int *cpus;
+    int ncpus;
+    apr_size_t next_cpu;
 };
 
 static apr_status_t thread_pool_construct(apr_thread_pool_t * me,
@@ -227,6 +231,21 @@ static struct apr_thread_list_elt *elt_new(apr_thread_pool_t * me,
     return elt;
 }
 
+/*
+ * Pin a worker to the next CPU in turn, if asked to.
+ * NOTE: This function is not thread safe by itself. Caller should hold the lock
+ */
+static apr_status_t pin_thread(apr_thread_pool_t *me, apr_thread_t *t)
+{
+    int cpu;
+
+    if (!me->ncpus) {
+        return APR_SUCCESS;
+    }
+    cpu = me->cpus[me->next_cpu++ % me->ncpus];
+    return apr_thread_affinity_set(t, &cpu, 1);
+}
+
 /*
  * The worker thread function. Take a task from the queue and perform it if
  * there is any. Otherwise, put itself into the idle thread list and waiting
@@ -248,6 +267,7 @@ static void *APR_THREAD_FUNC thread_pool_func(apr_thread_t * t, void *param)
         apr_thread_mutex_unlock(me->lock);
         apr_thread_exit(t, APR_ENOMEM);
     }
+    pin_thread(me, t);
 
     while (!me->terminated && elt->state != TH_STOP) {
         /* Test if not new element, it is awakened from idle */
@@ -770,6 +790,40 @@ APR_DECLARE(apr_interval_time_t)
     return me->idle_wait;
 }
 
+APR_DECLARE(apr_status_t) apr_thread_pool_affinity_set(apr_thread_pool_t *me,
+                                                       const int *cpus,
+                                                       int ncpus)
+{
+    struct apr_thread_list_elt *elt;
+    apr_status_t rv = APR_SUCCESS, rv2;
+
+    apr_thread_mutex_lock(me->lock);
+    if (cpus && ncpus > 0) {
+        me->cpus = apr_pmemdup(me->pool, cpus, ncpus * sizeof(int));
+        me->ncpus = ncpus;
+    }
+    else {
+        me->cpus = NULL;
+        me->ncpus = 0;
+    }
+    me->next_cpu = 0;
+
+    /* the running workers are pinned now, later ones as they start */
+    APR_RING_FOREACH(elt, me->idle_thds, apr_thread_list_elt, link) {
+        if ((rv2 = pin_thread(me, elt->thd)) != APR_SUCCESS && !rv) {
+            rv = rv2;
+        }
+    }
+    APR_RING_FOREACH(elt, me->busy_thds, apr_thread_list_elt, link) {
+        if ((rv2 = pin_thread(me, elt->thd)) != APR_SUCCESS && !rv) {
+            rv = rv2;
+        }
+    }
+    apr_thread_mutex_unlock(me->lock);
+
+    return rv;
+}
+
 /*
  * This function stop extra idle threads to the cnt.
  * @return the number of threads stopped
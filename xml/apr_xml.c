@@ -33,17 +33,6 @@ typedef unsigned char XML_Char;
 static const char APR_KW_xmlns[] = { 0x78, 0x6D, 0x6C, 0x6E, 0x73, '\0' };
 static const char APR_KW_xmlns_lang[] = { 0x78, 0x6D, 0x6C, 0x3A, 0x6C, 0x61, 0x6E, 0x67, '\0' };
 
-/* errors related to namespace processing */
-#define APR_XML_NS_ERROR_UNKNOWN_PREFIX (-1000)
-#define APR_XML_NS_ERROR_INVALID_DECL (-1001)
-
-/* test for a namespace prefix that begins with [Xx][Mm][Ll] */
-#define APR_XML_NS_IS_RESERVED(name) \
-        ( (name[0] == 0x58 || name[0] == 0x78) && \
-          (name[1] == 0x4D || name[1] == 0x6D) && \
-          (name[2] == 0x4C || name[2] == 0x6C) )
-
-
 /* struct for scoping namespace declarations */
 typedef struct apr_xml_ns_scope {
     const char *prefix;         /* prefix used for this ns */
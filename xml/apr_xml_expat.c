@@ -52,6 +52,9 @@ static apr_status_t do_parse(apr_xml_parser *parser,
     else {
         int rv = XML_Parse(parser->xp, data, (int)len, is_final);
 
+#ifdef XML_STATUS_SUSPENDED
+        parser->suspended = (rv == XML_STATUS_SUSPENDED);
+#endif
         if (rv == 0) {
             parser->error = APR_XML_ERROR_EXPAT;
             parser->xp_err = XML_GetErrorCode(parser->xp);
@@ -64,9 +67,44 @@ static apr_status_t do_parse(apr_xml_parser *parser,
 }
 
 
+#ifdef XML_STATUS_SUSPENDED
+static apr_status_t do_suspend(apr_xml_parser *parser)
+{
+    if (parser->suspended)
+        return APR_SUCCESS;
+    if (XML_StopParser(parser->xp, XML_TRUE) != XML_STATUS_OK)
+        return APR_EGENERAL;
+
+    parser->suspended = 1;
+    return APR_SUCCESS;
+}
+
+static apr_status_t do_resume(apr_xml_parser *parser)
+{
+    int rv;
+
+    parser->suspended = 0;
+    rv = XML_ResumeParser(parser->xp);
+    parser->suspended = (rv == XML_STATUS_SUSPENDED);
+    if (rv == 0) {
+        parser->error = APR_XML_ERROR_EXPAT;
+        parser->xp_err = XML_GetErrorCode(parser->xp);
+        parser->xp_msg = XML_ErrorString(parser->xp_err);
+    }
+
+    return parser->error ? APR_EGENERAL : APR_SUCCESS;
+}
+#else
+/* expat 1.x cannot pause; the pull parser copies what it queues */
+#define do_suspend NULL
+#define do_resume NULL
+#endif
+
 static XMLParserImpl xml_parser_expat = {
     do_parse,
-    cleanup_parser
+    cleanup_parser,
+    do_suspend,
+    do_resume
 };
 
 XMLParserImpl* apr_xml_get_parser_impl(void) { return &xml_parser_expat; }
@@ -21,11 +21,24 @@
 struct XMLParserImpl {
     apr_status_t (*Parse)(apr_xml_parser*, const char*, apr_size_t, int);
     apr_status_t (*cleanup)(void*);
+    /* pause the parse from within a handler, or NULL if not possible */
+    apr_status_t (*Suspend)(apr_xml_parser*);
+    apr_status_t (*Resume)(apr_xml_parser*);
 };
 typedef struct XMLParserImpl XMLParserImpl;
 XMLParserImpl* apr_xml_get_parser_impl(void);
 
 
+/* errors related to namespace processing */
+#define APR_XML_NS_ERROR_UNKNOWN_PREFIX (-1000)
+#define APR_XML_NS_ERROR_INVALID_DECL (-1001)
+
+/* test for a namespace prefix that begins with [Xx][Mm][Ll] */
+#define APR_XML_NS_IS_RESERVED(name) \
+        ( (name[0] == 0x58 || name[0] == 0x78) && \
+          (name[1] == 0x4D || name[1] == 0x6D) && \
+          (name[2] == 0x4C || name[2] == 0x6C) )
+
 /* the real (internal) definition of the parser context */
 struct apr_xml_parser {
     apr_xml_doc *doc;           /* the doc we're parsing */
@@ -41,6 +54,9 @@ struct apr_xml_parser {
     XML_Error xp_err;      /* stored Expat error code */
     const char *xp_msg;
     XMLParserImpl *impl;
+
+    int suspended;              /* stopped by impl->Suspend */
+    struct apr_xml_reader *reader;      /* for the pull parser, or NULL */
 };
 
 apr_xml_parser* apr_xml_parser_create_internal(apr_pool_t*, void*, void*, void*);
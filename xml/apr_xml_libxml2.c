@@ -48,9 +48,12 @@ static int libxml2_parse(apr_xml_parser* parser, const char* data,
     }
     return parser->xp_err;
 }
+/* xmlStopParser() cannot be undone, so there is no Suspend/Resume */
 static XMLParserImpl xml_parser_libxml2 = {
     libxml2_parse,
-    cleanup_parser
+    cleanup_parser,
+    NULL,
+    NULL
 };
 
 static const char APR_KW_DAV[] = { 0x44, 0x41, 0x56, 0x3A, '\0' };
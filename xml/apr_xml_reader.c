@@ -0,0 +1,345 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The pull parser drives the same backends as apr_xml_parser, but its
+ * handlers queue events instead of building a tree.  When the backend
+ * can pause (expat 2.x), the first handler of a batch suspends it, so
+ * the queued names still point into the backend's buffers when they
+ * are handed out; the parse resumes once the queue drains.  Otherwise
+ * every event of a fed chunk is queued with copies in a scratch pool,
+ * which is cleared as the queue drains.  Text is always copied: expat
+ * passes newlines, references and re-encoded input in buffers that
+ * only live for the duration of the handler.
+ */
+
+#include "apr.h"
+#include "apr_strings.h"
+#include "apr_hash.h"
+
+#define APR_WANT_STRFUNC
+#include "apr_want.h"
+
+#include "apr_xml.h"
+typedef void* XML_Parser;
+typedef int XML_Error;
+typedef unsigned char XML_Char;
+#include "apr_xml_internal.h"
+
+static const char APR_KW_xmlns[] = { 0x78, 0x6D, 0x6C, 0x6E, 0x73, '\0' };
+
+/* a namespace declaration in scope */
+typedef struct {
+    const char *prefix;         /* interned, "" for the default namespace */
+    apr_size_t len;
+    int ns;                     /* APR_XML_NS_NONE for xmlns="" */
+} reader_scope;
+
+struct apr_xml_reader {
+    apr_pool_t *pool;
+    apr_pool_t *scratch;        /* event data, cleared as the queue drains */
+    apr_xml_parser *parser;
+
+    apr_array_header_t *events; /* queued apr_xml_event */
+    int head;                   /* next event to hand out */
+
+    apr_array_header_t *scopes; /* reader_scope, innermost last */
+    apr_array_header_t *elems;  /* scopes->nelts at each open element */
+    apr_hash_t *prefixes;       /* every prefix declared so far */
+
+    const char *data;           /* input not yet given to the backend */
+    apr_size_t len;
+    int pending;
+    int final;                  /* the last input has been fed */
+    int failed;
+};
+
+/*
+ * Called on entry to each handler: nonzero if what the backend passed in
+ * stays put until the queue drains, zero if it has to be copied.
+ */
+static int reader_keep(apr_xml_parser *parser)
+{
+    return parser->impl->Suspend != NULL
+           && parser->impl->Suspend(parser) == APR_SUCCESS;
+}
+
+static apr_xml_event *push_event(apr_xml_reader *r, apr_xml_event_e type)
+{
+    apr_xml_event *ev = apr_array_push(r->events);
+
+    memset(ev, 0, sizeof(*ev));
+    ev->type = type;
+    ev->depth = r->elems->nelts - 1;
+    return ev;
+}
+
+static int is_decl(const char *name)
+{
+    return strncmp(name, APR_KW_xmlns, 5) == 0
+           && (name[5] == '\0' || name[5] == 0x3A);
+}
+
+static int find_prefix(apr_xml_reader *r, const char *prefix, apr_size_t len)
+{
+    const reader_scope *scope = (const reader_scope *)r->scopes->elts;
+    int i;
+
+    for (i = r->scopes->nelts - 1; i >= 0; i--) {
+        if (scope[i].len == len && memcmp(scope[i].prefix, prefix, len) == 0)
+            return scope[i].ns;
+    }
+
+    /* no prefix and no default namespace: "no namespace" */
+    return len ? APR_XML_NS_ERROR_UNKNOWN_PREFIX : APR_XML_NS_NONE;
+}
+
+/* split a qualified name, returning the local part */
+static const char *resolve(apr_xml_reader *r, const char *qname, int *ns,
+                           int is_attr)
+{
+    const char *colon = strchr(qname, 0x3A);
+
+    if (colon == NULL) {
+        /* attributes do NOT use the default namespace */
+        *ns = is_attr ? APR_XML_NS_NONE : find_prefix(r, "", 0);
+        return qname;
+    }
+    if (APR_XML_NS_IS_RESERVED(qname)) {
+        *ns = APR_XML_NS_NONE;
+        return qname;
+    }
+    *ns = find_prefix(r, qname, colon - qname);
+    return colon + 1;
+}
+
+static const char *intern_prefix(apr_xml_reader *r, const char *prefix)
+{
+    const char *s = apr_hash_get(r->prefixes, prefix, APR_HASH_KEY_STRING);
+
+    if (s == NULL) {
+        s = apr_pstrdup(r->pool, prefix);
+        apr_hash_set(r->prefixes, s, APR_HASH_KEY_STRING, s);
+    }
+    return s;
+}
+
+static int insert_uri(apr_xml_reader *r, const char *uri)
+{
+    apr_array_header_t *namespaces = r->parser->doc->namespaces;
+    int n = namespaces->nelts;
+    int i;
+
+    i = apr_xml_insert_uri(namespaces, apr_xml_quote_string(r->scratch, uri, 1));
+
+    /* the table outlives the event, so a new entry needs its own copy */
+    if (i == n)
+        APR_ARRAY_IDX(namespaces, i, const char *) =
+            apr_pstrdup(r->pool, APR_ARRAY_IDX(namespaces, i, const char *));
+    return i;
+}
+
+static void reader_start(void *userdata, const char *name, const char **attrs)
+{
+    apr_xml_parser *parser = userdata;
+    apr_xml_reader *r = parser->reader;
+    apr_xml_event *ev;
+    apr_xml_attr *attr, **last;
+    const char **a;
+    int keep;
+
+    /* punt once we find an error */
+    if (parser->error)
+        return;
+
+    keep = reader_keep(parser);
+    *(int *)apr_array_push(r->elems) = r->scopes->nelts;
+
+    /* declarations apply to the element's own name, so take them first */
+    for (a = attrs; a && *a; a += 2) {
+        const char *prefix = a[0] + 5;
+        reader_scope *scope;
+
+        if (!is_decl(a[0]))
+            continue;
+        if (*prefix == 0x3A) {
+            /* a namespace prefix declaration must have a non-empty value */
+            if (*a[1] == '\0') {
+                parser->error = APR_XML_NS_ERROR_INVALID_DECL;
+                return;
+            }
+            ++prefix;
+        }
+
+        scope = apr_array_push(r->scopes);
+        scope->prefix = intern_prefix(r, prefix);
+        scope->len = strlen(prefix);
+        scope->ns = *a[1] ? insert_uri(r, a[1]) : APR_XML_NS_NONE;
+    }
+
+    ev = push_event(r, APR_XML_EVENT_START);
+    ev->name = resolve(r, keep ? name : apr_pstrdup(r->scratch, name),
+                       &ev->ns, 0);
+    if (APR_XML_NS_IS_ERROR(ev->ns)) {
+        parser->error = ev->ns;
+        return;
+    }
+
+    last = (apr_xml_attr **)&ev->attr;
+    for (a = attrs; a && *a; a += 2) {
+        if (is_decl(a[0]))
+            continue;
+
+        attr = apr_palloc(r->scratch, sizeof(*attr));
+        attr->name = resolve(r, keep ? a[0] : apr_pstrdup(r->scratch, a[0]),
+                             &attr->ns, 1);
+        if (APR_XML_NS_IS_ERROR(attr->ns)) {
+            parser->error = attr->ns;
+            return;
+        }
+        attr->value = keep ? a[1] : apr_pstrdup(r->scratch, a[1]);
+        attr->next = NULL;
+        *last = attr;
+        last = &attr->next;
+    }
+}
+
+static void reader_end(void *userdata, const char *name)
+{
+    apr_xml_parser *parser = userdata;
+    apr_xml_reader *r = parser->reader;
+    apr_xml_event *ev;
+    int keep;
+
+    /* punt once we find an error */
+    if (parser->error)
+        return;
+
+    keep = reader_keep(parser);
+    ev = push_event(r, APR_XML_EVENT_END);
+    ev->name = resolve(r, keep ? name : apr_pstrdup(r->scratch, name),
+                       &ev->ns, 0);
+
+    /* pop up one level, along with its declarations */
+    r->scopes->nelts = *(int *)apr_array_pop(r->elems);
+}
+
+static void reader_cdata(void *userdata, const char *data, int len)
+{
+    apr_xml_parser *parser = userdata;
+    apr_xml_reader *r = parser->reader;
+    apr_xml_event *ev;
+
+    /* punt once we find an error */
+    if (parser->error)
+        return;
+
+    ev = push_event(r, APR_XML_EVENT_TEXT);
+    reader_keep(parser);
+    ev->text = apr_pstrmemdup(r->scratch, data, len);
+    ev->len = len;
+}
+
+APR_DECLARE(apr_status_t) apr_xml_reader_create(apr_xml_reader **reader,
+                                                apr_pool_t *pool)
+{
+    apr_xml_reader *r = apr_pcalloc(pool, sizeof(*r));
+    apr_status_t rv;
+
+    r->pool = pool;
+    if ((rv = apr_pool_create(&r->scratch, pool)) != APR_SUCCESS)
+        return rv;
+
+    r->parser = apr_xml_parser_create_internal(pool, &reader_start,
+                                               &reader_end, &reader_cdata);
+    if (r->parser == NULL)
+        return APR_ENOMEM;
+    r->parser->reader = r;
+
+    r->events = apr_array_make(pool, 4, sizeof(apr_xml_event));
+    r->scopes = apr_array_make(pool, 4, sizeof(reader_scope));
+    r->elems = apr_array_make(pool, 16, sizeof(int));
+    r->prefixes = apr_hash_make(pool);
+
+    *reader = r;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_xml_reader_feed(apr_xml_reader *r,
+                                              const char *data,
+                                              apr_size_t len,
+                                              int is_final)
+{
+    if (r->pending || r->parser->suspended)
+        return APR_EBUSY;
+    if (r->final)
+        return APR_EINVAL;
+
+    r->data = len ? data : "";
+    r->len = len;
+    r->pending = 1;
+    r->final = is_final;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_status_t) apr_xml_reader_next(apr_xml_reader *r,
+                                              apr_xml_event *event)
+{
+    apr_xml_parser *parser = r->parser;
+    apr_status_t rv;
+
+    while (r->head == r->events->nelts) {
+        /* everything handed out so far may now go */
+        r->events->nelts = r->head = 0;
+        apr_pool_clear(r->scratch);
+
+        if (r->failed)
+            return APR_EGENERAL;
+
+        if (parser->suspended) {
+            rv = parser->impl->Resume(parser);
+        }
+        else if (r->pending) {
+            r->pending = 0;
+            rv = parser->impl->Parse(parser, r->data, r->len, r->final);
+        }
+        else {
+            return r->final ? APR_EOF : APR_INCOMPLETE;
+        }
+
+        if (rv != APR_SUCCESS || parser->error) {
+            r->failed = 1;
+            return APR_EGENERAL;
+        }
+    }
+
+    *event = APR_ARRAY_IDX(r->events, r->head, apr_xml_event);
+    r->head++;
+    return APR_SUCCESS;
+}
+
+APR_DECLARE(apr_array_header_t *) apr_xml_reader_namespaces(
+                                                      apr_xml_reader *r)
+{
+    return r->parser->doc->namespaces;
+}
+
+APR_DECLARE(char *) apr_xml_reader_geterror(apr_xml_reader *r,
+                                            char *errbuf,
+                                            apr_size_t errbufsize)
+{
+    return apr_xml_parser_geterror(r->parser, errbuf, errbufsize);
+}